@@ -0,0 +1,366 @@
+/*
+ * compbench.c
+ *
+ * Isolation benchmarking program for hierarchical scheduling.
+ * Two components share a CPU: "perception" with tasks that deliberately
+ * overrun at the higher priority, and "planning" with a periodic task at
+ * the lower priority. The benchmark is run first without and then with
+ * the budget of perception, and reports the deadlines missed by planning
+ * and the CPU time taken by perception in each run.
+ */
+
+#define _GNU_SOURCE
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <resch/api.h>
+#include "compbench.h"
+
+/* the timeout to run (ms). */
+#define DEFAULT_TIMEOUT	1000
+
+/* results of the planning task, shared with the parent. */
+typedef struct planning_result_struct {
+	int nr_jobs;			/* the jobs completed. */
+	int nr_misses;			/* the jobs completed after the deadlines. */
+	long long max_response;	/* by nsecs */
+} planning_result_t;
+
+static struct timespec ms_to_timespec(unsigned long ms)
+{
+	struct timespec ts;
+	ts.tv_sec = ms / 1000;
+	ts.tv_nsec = (ms - ts.tv_sec*1000) * 1000000LL;
+	return ts;
+}
+
+static long long timespec_to_ns(struct timespec *ts)
+{
+	return ts->tv_sec * 1000000000LL + ts->tv_nsec;
+}
+
+/**
+ * execute on the CPU for @ms milliseconds, not counting preemptions.
+ */
+static void consume(int ms)
+{
+	struct timespec ts;
+	long long end;
+
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+	end = timespec_to_ns(&ts) + ms * 1000000LL;
+	do {
+		clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+	} while (timespec_to_ns(&ts) < end);
+}
+
+/**
+ * attach the caller to RESCH at @prio on @cpu, in the component of @cid.
+ * if @period is not zero, the caller executes for @work ms every @period
+ * ms.
+ */
+static int setup_task(int cid, int prio, int cpu, int period, int work)
+{
+	struct rt_attr attr;
+
+	if (rt_init() < 0) {
+		printf("Error: cannot begin!\n");
+		return FALSE;
+	}
+	memset(&attr, 0, sizeof(attr));
+	attr.mask = RT_ATTR_POLICY | RT_ATTR_PRIORITY | RT_ATTR_AFFINITY;
+	if (period) {
+		attr.mask |= RT_ATTR_WCET | RT_ATTR_PERIOD;
+		attr.wcet = ms_to_timespec(work);
+		attr.period = ms_to_timespec(period);
+	}
+	attr.policy = SCHED_FP;
+	attr.priority = prio;
+	attr.affinity = 1UL << cpu;
+	rt_set_attr(&attr);
+	if (!rt_compose(cid)) {
+		printf("Error: cannot compose the task into component %d\n", cid);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/**
+ * a perception task, which never stops executing.
+ */
+void exec_perception(int cid, int cpu)
+{
+	if (setup_task(cid, PRIO_PERCEPTION, cpu, 0, 0)) {
+		for (;;) {
+			consume(1000);
+		}
+	}
+	_exit(1);
+}
+
+/**
+ * the planning task, which executes for @work ms every @period ms.
+ */
+void exec_planning(int cid, int cpu, int period, int work, int time,
+				   planning_result_t *r)
+{
+	int k;
+	int nr_jobs = time / period;
+	struct timespec ts;
+	long long release, response;
+
+	if (!setup_task(cid, PRIO_PLANNING, cpu, period, work)) {
+		_exit(1);
+	}
+	rt_run(ms_to_timespec(DEFAULT_TIMEOUT));
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	release = timespec_to_ns(&ts);
+	for (k = 0; k < nr_jobs; k++) {
+		consume(work);
+		clock_gettime(CLOCK_MONOTONIC, &ts);
+		response = timespec_to_ns(&ts) - release;
+		if (response > period * 1000000LL) {
+			r->nr_misses++;
+		}
+		if (response > r->max_response) {
+			r->max_response = response;
+		}
+		r->nr_jobs++;
+		rt_wait_period();
+		release += period * 1000000LL;
+	}
+
+	rt_exit();
+	_exit(0);
+}
+
+/**
+ * run perception and planning for @time ms, with the perception budget
+ * of @budget ms, or without the budget if @budget is zero.
+ * return the CPU time of perception by ms, or -1 on error.
+ */
+int run(int period, int budget, int work, int hogs, int cpu, int time,
+		planning_result_t *r)
+{
+	int i, status;
+	int cid_perception, cid_planning;
+	pid_t *pids;
+	struct rusage ru;
+	long long cputime = 0;
+
+	cid_perception = rt_component_create(RT_COMPONENT_ANY);
+	cid_planning = rt_component_create(RT_COMPONENT_ANY);
+	if (cid_perception < 0 || cid_planning < 0) {
+		printf("Error: cannot create components.\n");
+		return -1;
+	}
+	rt_component_period(cid_perception, ms_to_timespec(period));
+	rt_component_budget(cid_perception, ms_to_timespec(budget));
+	rt_component_period(cid_planning, ms_to_timespec(period));
+
+	memset(r, 0, sizeof(*r));
+	pids = (pid_t *)calloc(hogs + 1, sizeof(pid_t));
+	fflush(stdout);
+	for (i = 0; i < hogs; i++) {
+		if ((pids[i] = fork()) == 0) {
+			exec_perception(cid_perception, cpu);
+		}
+	}
+	if ((pids[hogs] = fork()) == 0) {
+		exec_planning(cid_planning, cpu, period, work, time, r);
+	}
+
+	/* planning may never finish if perception is not limited. */
+	usleep((useconds_t)time * 1000);
+	for (i = 0; i <= hogs; i++) {
+		kill(pids[i], SIGKILL);
+		wait4(pids[i], &status, 0, &ru);
+		if (i < hogs) {
+			cputime += ru.ru_utime.tv_sec * 1000LL +
+				ru.ru_utime.tv_usec / 1000 +
+				ru.ru_stime.tv_sec * 1000LL + ru.ru_stime.tv_usec / 1000;
+		}
+	}
+	free(pids);
+
+	rt_component_destroy(cid_perception);
+	rt_component_destroy(cid_planning);
+
+	return (int)cputime;
+}
+
+void help(void)
+{
+	printf("Options:\n");
+	printf("--period=	the period of both components (by milliseconds). default: 100.\n");
+	printf("--budget=	the budget of perception (by milliseconds). default: 30.\n");
+	printf("--work=		the execution time of planning every period (by milliseconds). default: 40.\n");
+	printf("--hogs=		the number of perception tasks. default: 1.\n");
+	printf("--cpu=		the CPU shared by the components. default: 0.\n");
+	printf("--time=		the length of each run (by milliseconds). default: 10000.\n");
+	printf("--result=	the file name, in which benchmarking results are saved.\n");
+	printf("--print		print the progress of benchmarking.\n");
+}
+
+/* entry point. */
+int main(int argc, char *argv[])
+{
+	int i, k;
+	/* temporary vaiables. */
+	int tmp;
+	FILE *fp;
+	/* the period of the components (ms). */
+	int period = 100;
+	/* the budget of perception (ms). */
+	int budget = 30;
+	/* the execution time of planning (ms). */
+	int work = 40;
+	/* the number of perception tasks. */
+	int hogs = 1;
+	/* the CPU to run the tasks. */
+	int cpu = 0;
+	/* the length of each run (ms). */
+	int time = 10000;
+	/* file name that outputs benchmarking results. */
+	char result[MAX_BUF] = "./result";
+	/* print flag. */
+	int print = 0;
+	/* without and with the budget. */
+	int budgets[2];
+	int cputimes[2];
+	planning_result_t *r;
+
+	/***********************************************************************
+	 * Options:
+	 * --period=	the period of both components (by milliseconds).
+	 * --budget=	the budget of perception (by milliseconds).
+	 * --work=		the execution time of planning every period
+	 *				(by milliseconds).
+	 * --hogs=		the number of perception tasks.
+	 * --cpu=		the CPU shared by the components.
+	 * --time=		the length of each run (by milliseconds).
+	 * --result=	the file name, in which benchmarking results are saved.
+	 * --print		print the progress of benchmarking.
+	 ***********************************************************************/
+	for (i = 1; i < argc; i++) {
+		if (strncmp(argv[i], "--period", (tmp = strlen("--period"))) == 0) {
+			if (argv[i][tmp] != '=') {
+				printf("option \"%s\" is invalid.\n", argv[i]);
+				exit(1);
+			}
+			period = atoi(&argv[i][tmp+1]);
+		}
+		else if (strncmp(argv[i], "--budget", (tmp = strlen("--budget"))) == 0) {
+			if (argv[i][tmp] != '=') {
+				printf("option \"%s\" is invalid.\n", argv[i]);
+				exit(1);
+			}
+			budget = atoi(&argv[i][tmp+1]);
+		}
+		else if (strncmp(argv[i], "--work", (tmp = strlen("--work"))) == 0) {
+			if (argv[i][tmp] != '=') {
+				printf("option \"%s\" is invalid.\n", argv[i]);
+				exit(1);
+			}
+			work = atoi(&argv[i][tmp+1]);
+		}
+		else if (strncmp(argv[i], "--hogs", (tmp = strlen("--hogs"))) == 0) {
+			if (argv[i][tmp] != '=') {
+				printf("option \"%s\" is invalid.\n", argv[i]);
+				exit(1);
+			}
+			hogs = atoi(&argv[i][tmp+1]);
+		}
+		else if (strncmp(argv[i], "--cpu", (tmp = strlen("--cpu"))) == 0) {
+			if (argv[i][tmp] != '=') {
+				printf("option \"%s\" is invalid.\n", argv[i]);
+				exit(1);
+			}
+			cpu = atoi(&argv[i][tmp+1]);
+		}
+		else if (strncmp(argv[i], "--time", (tmp = strlen("--time"))) == 0) {
+			if (argv[i][tmp] != '=') {
+				printf("option \"%s\" is invalid.\n", argv[i]);
+				exit(1);
+			}
+			time = atoi(&argv[i][tmp+1]);
+		}
+		else if (strncmp(argv[i], "--result",
+						 (tmp = strlen("--result"))) == 0) {
+			if (argv[i][tmp] != '=') {
+				printf("option \"%s\" is invalid.\n", argv[i]);
+				exit(1);
+			}
+			strncpy(result, &argv[i][tmp+1], MAX_BUF - 1);
+		}
+		else if (strncmp(argv[i], "--print", (tmp = strlen("--print"))) == 0) {
+			print = 1;
+		}
+		else if (strncmp(argv[i], "--help", (tmp = strlen("--help"))) == 0) {
+			help();
+			exit(0);
+		}
+		else {
+			printf("option \"%s\" is invalid.\n", argv[i]);
+			exit(1);
+		}
+	}
+
+	if (period <= 0 || budget < 0 || work <= 0 || hogs < 1 ||
+		cpu < 0 || cpu >= NR_RT_CPUS || time < period) {
+		printf("the options are invalid.\n");
+		exit(1);
+	}
+
+	/* the planning results are written by the child process. */
+	r = (planning_result_t *)mmap(NULL, sizeof(planning_result_t) * 2,
+								  PROT_READ | PROT_WRITE,
+								  MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if (r == MAP_FAILED) {
+		printf("Cannot map memory.\n");
+		exit(1);
+	}
+
+	budgets[0] = 0;
+	budgets[1] = budget;
+	for (k = 0; k < 2; k++) {
+		if (print) {
+			printf("running %s the budget...\n", k ? "with" : "without");
+		}
+		cputimes[k] = run(period, budgets[k], work, hogs, cpu, time, &r[k]);
+		if (cputimes[k] < 0) {
+			exit(1);
+		}
+	}
+
+	/* budget, CPU time of perception, and jobs, misses and the worst
+	   response time of planning. */
+	if ((fp = fopen(result, "w")) == NULL) {
+		printf("Cannot open file %s\n", result);
+		exit(1);
+	}
+	fprintf(fp, "budget,perception_ms,planning_jobs,planning_misses,"
+			"planning_max_response_ms\n");
+	for (k = 0; k < 2; k++) {
+		/* jobs that never completed missed their deadlines. */
+		r[k].nr_misses += time / period - r[k].nr_jobs;
+		fprintf(fp, "%d,%d,%d,%d,%f\n", budgets[k], cputimes[k],
+				r[k].nr_jobs, r[k].nr_misses,
+				(double)r[k].max_response / 1000000);
+		printf("%s budget: perception %d ms, planning %d/%d jobs missed\n",
+			   k ? "with" : "without", cputimes[k], r[k].nr_misses,
+			   time / period);
+	}
+	fclose(fp);
+	munmap(r, sizeof(planning_result_t) * 2);
+
+	return 0;
+}
@@ -0,0 +1,15 @@
+#ifndef __COMPBENCH_H__
+#define __COMPBENCH_H__
+
+#include <config.h>
+
+#define TRUE 		1
+#define FALSE		0
+
+#define MAX_BUF 256
+
+/* perception overruns at the higher priority. */
+#define PRIO_PERCEPTION	(RESCH_APP_PRIO_MAX)
+#define PRIO_PLANNING	(RESCH_APP_PRIO_MAX - 1)
+
+#endif
@@ -0,0 +1,39 @@
+#ifndef __STATS_H__
+#define __STATS_H__
+
+#include <math.h>
+
+/* z-score of the 95% confidence level. */
+#define Z_95 1.959964
+
+/**
+ * Wilson score interval of the success ratio @k/@n at the 95% confidence
+ * level, by percentage. unlike the normal approximation, it stays in
+ * [0, 100] and is not degenerate when all or none of the tasksets
+ * succeed, which is common at light and heavy workloads.
+ */
+static inline void wilson_interval(int k, int n, double *lo, double *hi)
+{
+	double p, z2, denom, center, half;
+
+	if (n <= 0) {
+		*lo = 0;
+		*hi = 100;
+		return;
+	}
+	p = (double)k / n;
+	z2 = Z_95 * Z_95;
+	denom = 1 + z2 / n;
+	center = (p + z2 / (2 * n)) / denom;
+	half = Z_95 * sqrt(p * (1 - p) / n + z2 / (4.0 * n * n)) / denom;
+	*lo = (center - half) * 100;
+	*hi = (center + half) * 100;
+	if (*lo < 0) {
+		*lo = 0;
+	}
+	if (*hi > 100) {
+		*hi = 100;
+	}
+}
+
+#endif
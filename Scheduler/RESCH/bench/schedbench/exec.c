@@ -41,12 +41,14 @@ task_t *tasks;
 /* the number of tasks. */
 int nr_tasks;
 
-void exec_task(task_t *task, int loop_1ms, int time, int policy)
+void exec_task(task_t *task, int loop_1ms, int time, int policy,
+			   unsigned long affinity)
 {
 	int k; /* do not use i! */
 	int ret = RET_SUCCESS;
 	int nr_jobs = time / task->T;
 	struct timespec C, T, D, timeout;
+	struct rt_attr attr;
 
 	C = ms_to_timespec(task->C);
 	T = ms_to_timespec(task->T);
@@ -71,6 +73,12 @@ void exec_task(task_t *task, int loop_1ms, int time, int policy)
 	if (policy == SCHED_FP) {
 		rt_set_priority(task->prio);
 	}
+	/* keep the task in the group of CPUs running this taskset. */
+	if (affinity) {
+		attr.mask = RT_ATTR_AFFINITY;
+		attr.affinity = affinity;
+		rt_set_attr(&attr);
+	}
 	rt_run(timeout);
 
 	/* busy loop. */
@@ -191,7 +199,13 @@ void deadline_monotonic_priority(void)
 	}
 }
 
-int schedule(FILE *fp, int m, int loop_1ms, int time, int policy)
+/**
+ * execute the taskset in @fp for @time ms, and return TRUE if no task
+ * misses deadlines. the tasks run on the CPUs in @affinity, or on any
+ * CPUs if 0.
+ */
+int schedule(FILE *fp, int m, int loop_1ms, int time, int policy,
+			 unsigned long affinity)
 {
 	int i, j, ret, status;
 	pid_t pid;
@@ -207,7 +221,7 @@ int schedule(FILE *fp, int m, int loop_1ms, int time, int policy)
 		if (pid == 0) { /* the child process. */
 			/* execute the task. 
 			   note that the funtion never returns. */
-			exec_task(&tasks[i], loop_1ms, time, policy);
+			exec_task(&tasks[i], loop_1ms, time, policy, affinity);
 		}
 	}
 
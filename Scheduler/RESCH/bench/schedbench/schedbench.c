@@ -4,39 +4,200 @@
  * Schedulability benchmarking program.
  */
 
+#define _GNU_SOURCE
+#include <limits.h>
+#include <sched.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
+#include <sys/wait.h>
+#include <unistd.h>
 #include <resch/api.h>
 #include "schedbench.h"
+#include "simbench.h"
+#include "stats.h"
 #include "config.h"
 
-/* gain for P-controller to obtain loop_1ms. */
-#define Kp 3
+/* taskset.c */
+extern unsigned int taskset_seed;
+/* exec.c */
+extern int schedule(FILE *fp, int m, int loop_1ms, int time, int policy,
+					unsigned long affinity);
 
-int measure_1ms(void)
+/* every calibration sample runs the loop at least this long (ns). */
+#define CALIB_MIN_NS	20000000LL
+/* the number of calibration samples. */
+#define CALIB_SAMPLES	5
+
+static long long elapsed_ns(struct timespec *t0, struct timespec *t1)
+{
+	return (t1->tv_sec - t0->tv_sec) * 1000000000LL +
+		(t1->tv_nsec - t0->tv_nsec);
+}
+
+static void pin_cpus(int first, int nr_cpus)
+{
+	int cpu;
+	cpu_set_t cpuset;
+
+	CPU_ZERO(&cpuset);
+	for (cpu = first; cpu < first + nr_cpus; cpu++) {
+		CPU_SET(cpu, &cpuset);
+	}
+	if (sched_setaffinity(0, sizeof(cpuset), &cpuset) == -1) {
+		printf("Failed to set the affinity to CPU %d-%d\n",
+			   first, first + nr_cpus - 1);
+	}
+}
+
+/**
+ * count the loops that consume 1ms, on CPU 0.
+ * the loop is timed by CLOCK_MONOTONIC, which reads the cycle counter
+ * on x86, for long enough to make the clock resolution negligible.
+ * the fastest sample is taken, since interference only makes the loop
+ * look slower. unlike the P-controller that used to retry until
+ * gettimeofday() showed exactly 1000 usecs, this always finishes in
+ * about CALIB_SAMPLES * CALIB_MIN_NS.
+ */
+int calibrate_1ms(void)
+{
+	int k, loops = 1000;
+	long long ns, min_ns = 0;
+	struct timespec t0, t1;
+
+	pin_cpus(0, 1);
+
+	/* find the loop count that runs long enough. */
+	do {
+		loops *= 2;
+		clock_gettime(CLOCK_MONOTONIC, &t0);
+		LOOP(loops);
+		clock_gettime(CLOCK_MONOTONIC, &t1);
+	} while (elapsed_ns(&t0, &t1) < CALIB_MIN_NS && loops < INT_MAX / 2);
+
+	for (k = 0; k < CALIB_SAMPLES; k++) {
+		clock_gettime(CLOCK_MONOTONIC, &t0);
+		LOOP(loops);
+		clock_gettime(CLOCK_MONOTONIC, &t1);
+		ns = elapsed_ns(&t0, &t1);
+		if (k == 0 || ns < min_ns) {
+			min_ns = ns;
+		}
+	}
+
+	pin_cpus(0, NR_RT_CPUS);
+	if (min_ns <= 0) {
+		min_ns = 1;
+	}
+
+	printf("%d times loop consumes %d usec\n",
+		   (int)(loops * 1000000LL / min_ns), USEC_1MS);
+
+	return (int)(loops * 1000000LL / min_ns);
+}
+
+/**
+ * execute the tasksets of @workload, running up to @groups tasksets at
+ * once, each on its own group of @m CPUs, and return the number of the
+ * tasksets that meet all the deadlines, or -1 on error.
+ * every taskset is executed by a worker process, so that the tasks of
+ * different tasksets never share CPUs.
+ */
+int run_tasksets(char *path, int workload, int quantity, int m, int groups,
+				 int loop_1ms, int time, int policy, int print)
 {
-	struct timeval tv_start, tv_end, tv_interval;
-	/* the number of loop that consume 1ms. */
-	int loop_1ms = 1000; /* just a random initial value. */
-
- retry:	
-	gettimeofday(&tv_start, NULL);
-	LOOP(loop_1ms);
-	gettimeofday(&tv_end, NULL);
-
-	timeval_sub(&tv_end, &tv_start, &tv_interval);
-	/* hope it will not deverge... */
-	if (tv_interval.tv_usec != USEC_1MS) {
-		/* P-control. */
-		loop_1ms += Kp * (USEC_1MS - tv_interval.tv_usec);
-		goto retry;
+	int k, g, status;
+	int nr_success = 0, nr_running = 0;
+	unsigned long affinity;
+	char tsfile[MAX_BUF];
+	pid_t pid, *worker;
+	FILE *fp;
+
+	worker = (pid_t *)calloc(groups, sizeof(pid_t));
+	k = 1;
+	while (k <= quantity || nr_running > 0) {
+		/* start the next taskset on a free group. */
+		if (k <= quantity && nr_running < groups) {
+			for (g = 0; worker[g]; g++)
+				;
+			sprintf(tsfile, "%s/workload%d/ts%d", path, workload, k);
+			if ((fp = fopen(tsfile, "r")) == NULL) {
+				printf("Cannot open file %s\n", tsfile);
+				nr_success = -1;
+				quantity = 0;
+				continue;
+			}
+			if (print) {
+				printf("scheduling %s...\n", tsfile);
+			}
+			affinity = groups > 1 ? ((1UL << m) - 1) << (g * m) : 0;
+			fflush(stdout);
+			if ((pid = fork()) == 0) {
+				_exit(schedule(fp, m, loop_1ms, time, policy, affinity) ?
+					  RET_SUCCESS : RET_MISS);
+			}
+			fclose(fp);
+			worker[g] = pid;
+			nr_running++;
+			k++;
+			continue;
+		}
+
+		/* wait for any taskset to finish. */
+		pid = wait(&status);
+		for (g = 0; g < groups && worker[g] != pid; g++)
+			;
+		if (g == groups) {
+			continue;
+		}
+		worker[g] = 0;
+		nr_running--;
+		if (nr_success >= 0 && WIFEXITED(status) &&
+			WEXITSTATUS(status) == RET_SUCCESS) {
+			nr_success++;
+		}
+	}
+	free(worker);
+
+	return nr_success;
+}
+
+/**
+ * admit and simulate the tasksets of @workload by the plugins, instead
+ * of executing them. return FALSE on error.
+ */
+int analyze_tasksets(char *path, int workload, int quantity, int m,
+					 int time, int *plugins, sim_result_t *result, int print)
+{
+	int k;
+	char tsfile[MAX_BUF];
+	FILE *fp;
+
+	for (k = 1; k <= quantity; k++) {
+		sprintf(tsfile, "%s/workload%d/ts%d", path, workload, k);
+		if ((fp = fopen(tsfile, "r")) == NULL) {
+			printf("Cannot open file %s\n", tsfile);
+			return FALSE;
+		}
+		if (print) {
+			printf("analyzing %s...\n", tsfile);
+		}
+		sim_schedule(fp, m, time, plugins, result, print);
+		fclose(fp);
 	}
 
-	printf("%d times loop consumes %d usec\n", 
-		   loop_1ms, tv_interval.tv_usec);
+	return TRUE;
+}
+
+void print_csv(FILE *fp, int workload, char *policy, int nr_success,
+			   int quantity)
+{
+	double lo, hi;
 
-	return loop_1ms;
+	wilson_interval(nr_success, quantity, &lo, &hi);
+	fprintf(fp, "%d,%s,%d,%d,%f,%f,%f\n", workload, policy, quantity,
+			nr_success, (double)nr_success / (double)quantity * 100, lo, hi);
 }
 
 void help(void)
@@ -58,7 +219,11 @@ void help(void)
 	printf("--end=		benchmarking ends at this system load [0, 100].\n");
 	printf("--step=		the distance of every successive sampling system load to be tested by benchmarking.\n");
 	printf("--quantity=	the number of tasksets tested per workload.\n");
-	printf("--result=	the file name, in which benchmarking results are saved.\n");
+	printf("--seed=		the seed to generate tasksets, which makes them reproducible. default: the time.\n");
+	printf("--groups=	the number of tasksets executed at once, each on its own --cpus CPUs. default: 1.\n");
+	printf("--analytical	admit and simulate the tasksets by the plugins (see simbench) instead of executing them.\n");
+	printf("--plugins=	the comma-separated plugins for --analytical. default: all.\n");
+	printf("--result=	the file name, in which benchmarking results are saved. they are also saved in CSV with 95%% confidence intervals to the file name plus \".csv\".\n");
 	printf("--print		print the progress of benchmarking.\n");
 }
 
@@ -73,8 +238,8 @@ int main(int argc, char *argv[])
 	int m = NR_RT_CPUS; 
 	/* path to a directory where a taskset file is located. */
 	char path[MAX_BUF];
-	/* path to a taskset file. */
-	char tsfile[MAX_BUF];
+	/* path to a result file. */
+	char resfile[MAX_BUF];
 	FILE *fp;
 	/* minimum/maximum utilization of individual task [0, 1.0]. 
 	   default: umin=0.1, umax=1.0. */
@@ -107,6 +272,13 @@ int main(int argc, char *argv[])
 	char result[MAX_BUF] = "./result";
 	/* scheduling policy. */
 	int policy = SCHED_FP;
+	/* the number of tasksets executed at once. default: 1. */
+	int groups = 1;
+	/* simulate the tasksets by the plugins instead of executing them. */
+	int analytical = 0;
+	/* plugins for the analytical mode. default: all. */
+	int plugins[NR_SIM_PLUGINS] = {[0 ... NR_SIM_PLUGINS-1] = TRUE};
+	sim_result_t *sim_results = NULL;
 	/* print flag. */
 	int print = 0;
 	/* loop counts that consume 1ms. */
@@ -115,7 +287,8 @@ int main(int argc, char *argv[])
 	int workload;
 	/* success ratio. */
 	int nr_success;
-	double *success_ratios;
+	int *nr_successes;
+	char *policy_name;
 
 	/***********************************************************************
 	 * Options:
@@ -150,6 +323,12 @@ int main(int argc, char *argv[])
 	 * --step=		the distance of every successive sampling system load
 	 *				to be tested by benchmarking.
 	 * --quantity=	the number of tasksets tested per workload.
+	 * --seed=		the seed to generate tasksets.
+	 * --groups=	the number of tasksets executed at once, each on its
+	 *				own group of --cpus processors.
+	 * --analytical	admit and simulate tasksets by the plugins instead of
+	 *				executing them.
+	 * --plugins=	the comma-separated plugins for --analytical.
 	 * --result=	the file name, in which benchmarking results are saved.
 	 * --print		print the progress of benchmarking.
 	 ***********************************************************************/
@@ -270,6 +449,32 @@ int main(int argc, char *argv[])
 			}
 			quantity = atoi(&argv[i][tmp+1]);
 		}
+		else if (strncmp(argv[i], "--seed", (tmp = strlen("--seed"))) == 0) {
+			if (argv[i][tmp] != '=') {
+				printf("option \"%s\" is invalid.\n", argv[i]);
+				exit(1);
+			}
+			taskset_seed = strtoul(&argv[i][tmp+1], NULL, 10);
+		}
+		else if (strncmp(argv[i], "--groups", (tmp = strlen("--groups"))) == 0) {
+			if (argv[i][tmp] != '=') {
+				printf("option \"%s\" is invalid.\n", argv[i]);
+				exit(1);
+			}
+			groups = atoi(&argv[i][tmp+1]);
+		}
+		else if (strncmp(argv[i], "--analytical",
+						 (tmp = strlen("--analytical"))) == 0) {
+			analytical = 1;
+		}
+		else if (strncmp(argv[i], "--plugins",
+						 (tmp = strlen("--plugins"))) == 0) {
+			if (argv[i][tmp] != '=' ||
+				!sim_parse_plugins(&argv[i][tmp+1], plugins)) {
+				printf("option \"%s\" is invalid.\n", argv[i]);
+				exit(1);
+			}
+		}
 		else if (strncmp(argv[i], "--result", 
 						 (tmp = strlen("--result"))) == 0) {
 			if (argv[i][tmp] != '=') {
@@ -297,17 +502,28 @@ int main(int argc, char *argv[])
 		}
 	}
 
-	/* measure the cycles that consume 1 millisecond. 
-	   note that this procedure has to be done in real-time mode
-	   with the highest priority. otherwise, the loop count will
-	   be much less than what we expect... */
-	rt_init();
-	rt_set_priority(99);
-	loop_1ms = measure_1ms();
-	rt_exit();
+	if (groups < 1 || groups * m > NR_RT_CPUS) {
+		printf("%d groups of %d CPUs are not available.\n", groups, m);
+		exit(1);
+	}
+
+	if (analytical) {
+		sim_results = (sim_result_t *)
+			calloc(((end-start)/step+1) * NR_SIM_PLUGINS, sizeof(sim_result_t));
+	}
+	else {
+		/* measure the cycles that consume 1 millisecond.
+		   note that this procedure has to be done in real-time mode
+		   with the highest priority. otherwise, the loop count will
+		   be much less than what we expect... */
+		rt_init();
+		rt_set_priority(99);
+		loop_1ms = calibrate_1ms();
+		rt_exit();
+	}
 
-	/* arrays to store the success ratios. */
-	success_ratios = (double*) malloc(sizeof(double) * ((end-start)/step+1));
+	/* arrays to store the numbers of successful tasksets. */
+	nr_successes = (int*) malloc(sizeof(int) * ((end-start)/step+1));
 
 	/* benchmarking range of system utilization. */
 	start *= m;
@@ -320,50 +536,70 @@ int main(int argc, char *argv[])
 						 atof(sep), atof(prob), atof(mean),
 						 atof(umin), atof(umax), 
 						 atoi(pmin), atoi(pmax));
-		/* success counter. */
-		nr_success = 0;
 
 		/* schedule 1,000 tasksets, each of which include tasks with
 		   total workload = @workload. 
 		   dont use @i! */
-		for (k = 1; k <= quantity; k++) {
-			/* path to the taskset file. */
-			sprintf(tsfile, "%s/workload%d/ts%d", 
-					path, workload, k);
-
-			if ((fp = fopen(tsfile, "r")) == NULL) {
-				printf("Cannot open file %s\n", tsfile);
+		if (analytical) {
+			if (!analyze_tasksets(path, workload, quantity, m, time, plugins,
+								  &sim_results[i * NR_SIM_PLUGINS], print)) {
 				goto end;
 			}
-
-			/* schedule this taskset. */
-			if (print) {
-				printf("scheduling %s...\n", tsfile);
-			}
-			if (schedule(fp, m, loop_1ms, time, policy)) {
-				nr_success++;
-			}
-
-			fclose(fp);
+			i++;
+			continue;
 		}
-		/* success ratio. */
-		success_ratios[i] = (double)nr_success / (double)quantity;
+		nr_success = run_tasksets(path, workload, quantity, m, groups,
+								  loop_1ms, time, policy, print);
+		if (nr_success < 0) {
+			goto end;
+		}
+		nr_successes[i] = nr_success;
 		if (print) {
-			printf("%d %f\n", workload, success_ratios[i] * 100);
+			printf("%d %f\n", workload,
+				   (double)nr_success / (double)quantity * 100);
 		}
 		i++;
 	}
 
+	/* the success ratios, also in CSV with confidence intervals. */
+	sprintf(resfile, "%s.csv", result);
+	if ((fp = fopen(resfile, "w")) == NULL) {
+		printf("Cannot open file %s\n", resfile);
+		goto end;
+	}
+	if (analytical) {
+		sim_print_csv_header(fp);
+		for (workload = start, i = 0; workload <= end; workload += step, i++) {
+			for (k = 0; k < NR_SIM_PLUGINS; k++) {
+				if (plugins[k]) {
+					sim_print_csv(fp, workload, k,
+								  &sim_results[i * NR_SIM_PLUGINS + k], quantity);
+				}
+			}
+		}
+		fclose(fp);
+		goto end;
+	}
+	policy_name = policy == SCHED_EDF ? "edf" :
+		policy == SCHED_FAIR ? "fair" : "fp";
+	fprintf(fp, "workload,policy,quantity,success,ratio,ci_low,ci_high\n");
+	for (workload = start, i = 0; workload <= end; workload += step, i++) {
+		print_csv(fp, workload, policy_name, nr_successes[i], quantity);
+	}
+	fclose(fp);
+
 	fp = fopen(result, "w");
 	i = 0;
 	for (workload = start; workload <= end; workload += step) {
-		fprintf(fp, "%d %f\n", workload, success_ratios[i] * 100);
+		fprintf(fp, "%d %f\n", workload,
+				(double)nr_successes[i] / (double)quantity * 100);
 		i++;
 	}
 	fclose(fp);
 
  end:
-	free(success_ratios);
+	free(nr_successes);
+	free(sim_results);
 
 	return 0;
 }
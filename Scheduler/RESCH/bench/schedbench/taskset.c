@@ -6,6 +6,8 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <time.h>
 #include <math.h>
 
 #define MAX_BUF 256
@@ -51,6 +53,10 @@ static inline double exponential_dist(double mean)
 	return -mean * (double) log(1.0 - drand(0.0, 1.0));
 }
 
+/* seed of the generator, or 0 to seed by the time.
+   a fixed seed reproduces the same taskset files. */
+unsigned int taskset_seed = 0;
+
 int *harmonic_periods = NULL;
 int nr_periods = 0;
 static inline void make_harmonic_periods(int pmin, int pmax)
@@ -89,34 +95,34 @@ void generate_taskset(char *path, int nr_tasksets,
 	taskdata_t *taskdata;
 
 	/* create taskset files, only if they do not exist. */
-	system("mkdir ./taskset >& .error.log");
+	system("mkdir ./taskset > .error.log 2>&1");
 	/* create taskset/@dist. */
 	sprintf(path, "./taskset/%s", dist);
-	sprintf(cmd, "mkdir %s >& .error.log", path);;
+	sprintf(cmd, "mkdir %s > .error.log 2>&1", path);;
 	system(cmd);
 	/* create taskset/@dist/@deadline. */
 	sprintf(path, "%s/%s", path, deadline);
-	sprintf(cmd, "mkdir %s >& .error.log", path);;
+	sprintf(cmd, "mkdir %s > .error.log 2>&1", path);;
 	system(cmd);
 	/* create taskset/@dist/@deadline/@period. */
 	sprintf(path, "%s/%s", path, period);
-	sprintf(cmd, "mkdir %s >& .error.log", path);
+	sprintf(cmd, "mkdir %s > .error.log 2>&1", path);
 	system(cmd);
 	/* create taskset/@dist/@deadline/@parameters. */
 	if (strcmp(dist, "uniform") == 0) {
 		sprintf(path, "%s/pmin%d_pmax%d_umin%.2f_umax%.2f", 
 				path, pmin, pmax, umin, umax);
-		sprintf(cmd, "mkdir %s >& .error.log", path);
+		sprintf(cmd, "mkdir %s > .error.log 2>&1", path);
 	}
 	else if (strcmp(dist, "bimodal") == 0) {
 		sprintf(path, "%s/pmin%d_pmax%d_umin%.2f_umax%.2f_sep%.2f_prob%.2f", 
 				path, pmin, pmax, umin, umax, sep, prob);
-		sprintf(cmd, "mkdir %s >& .error.log", path);
+		sprintf(cmd, "mkdir %s > .error.log 2>&1", path);
 	}
 	else if (strcmp(deadline, "arbitrary") == 0) {
 		sprintf(path, "%s/pmin%d_pmax%d_mean%.2f", path, 
 				pmin, pmax, mean);
-		sprintf(cmd, "mkdir %s >& .error.log", path);
+		sprintf(cmd, "mkdir %s > .error.log 2>&1", path);
 	}
 	else {
 		printf("Error: undefined deadline type!\n");
@@ -125,10 +131,11 @@ void generate_taskset(char *path, int nr_tasksets,
 	system(cmd);
 	/* create taskset/@dist/@deadline/@period/workload?. */
 	sprintf(dir, "%s/workload%d", path, workload);
-	sprintf(cmd, "mkdir %s >& .error.log", dir);
+	sprintf(cmd, "mkdir %s > .error.log 2>&1", dir);
 	if (system(cmd) == 0) {
 		/* initialize random function seed. */
-		srand((unsigned int)time(NULL) + workload);
+		srand((taskset_seed ? taskset_seed : (unsigned int)time(NULL)) +
+			  workload);
 
 		/* if --period=harmonic is chosen, make harmonic periods. */
 		if (strcmp(period, "harmonic") == 0) {
@@ -0,0 +1,237 @@
+/*
+ * plugin.c		Copyright (C) Shinpei Kato
+ *
+ * Admission and simulation of a task set file by the plugins, shared by
+ * simbench and the analytical mode of schedbench.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "simbench.h"
+#include "stats.h"
+
+/* the number of column in taskset files. */
+#define NR_COLS 	4
+
+/**
+ * read a taskset file into @task[], which is allocated here, in the
+ * deadline-monotonic order, and return the number of tasks.
+ * the timing properties are converted from milliseconds to microseconds.
+ */
+int sim_read_taskset(FILE *fp, sa_task_t **task)
+{
+	char line[MAX_BUF], s[MAX_BUF];
+	char props[NR_COLS][MAX_BUF];
+	int n; /* # of tasks */
+	int i, j;
+	char *token;
+	sa_task_t tmp;
+
+	/* skip comments and empty lines */
+	while (fgets(line, MAX_BUF, fp)) {
+		if (line[0] != '\n'	&& line[0] != '#')
+			break;
+	}
+
+	/* get the number of tasks */
+	n = atoi(line);
+	*task = (sa_task_t *)malloc(sizeof(sa_task_t) * n);
+
+	/* skip comments and empty lines */
+	while (fgets(line, MAX_BUF, fp)) {
+		if (line[0] != '\n'	&& line[0] != '#')
+			break;
+	}
+
+	for (i = 0; i < n; i++) {
+		strcpy(s, line);
+		token = strtok(s, ",\t ");
+		/* get task name, exec. time, period, and relative deadline. */
+		for (j = 0; j < NR_COLS; j++) {
+			if (!token) {
+				printf("Error: invalid format: %s!\n", line);
+				exit(1);
+			}
+			strncpy(props[j], token, MAX_BUF);
+			token = strtok(NULL, ",\t ");
+		}
+		sa_task_init(&(*task)[i], atoi(props[1]) * USEC_1MS,
+					 atoi(props[2]) * USEC_1MS, atoi(props[3]) * USEC_1MS, 0);
+
+		/* get line for the next task.  */
+		fgets(line, MAX_BUF, fp);
+	}
+
+	/* bable sort such that task[j-1].D <= task[j].D. */
+	for (i = 0; i < n - 1; i++) {
+		for (j = n - 1; j > i; j--) {
+			if ((*task)[j-1].D > (*task)[j].D) {
+				tmp = (*task)[j];
+				(*task)[j] = (*task)[j-1];
+				(*task)[j-1] = tmp;
+			}
+		}
+	}
+
+	/* set deadline-monotonic priorities. */
+	for (i = 0; i < n; i++) {
+		(*task)[i].prio = n - i;
+	}
+
+	return n;
+}
+
+/**
+ * assign the tasks to CPUs one by one in the priority order, in the same
+ * way as task_run() of the plugin.
+ * return TRUE if all the tasks are admitted.
+ */
+int sim_admit(sa_taskset_t *ts, int plugin)
+{
+	int i, cpu;
+	sa_task_t *t;
+
+	for (i = 0; i < ts->nr_tasks; i++) {
+		sa_clear_split(&ts->task[i]);
+		ts->task[i].cpu = SA_CPU_UNDEFINED;
+	}
+	/* rebuild the per-CPU lists from scratch. */
+	sa_taskset_init(ts, ts->task, ts->nr_tasks, ts->nr_cpus);
+
+	for (i = 0; i < ts->nr_tasks; i++) {
+		t = &ts->task[i];
+		for (cpu = 0; cpu < SA_NR_CPUS; cpu++) {
+			ts->cpu_available[cpu] = TRUE;
+		}
+
+		switch (plugin) {
+		case SIM_FP_FF:
+			cpu = sa_fp_first_fit(ts, t);
+			break;
+		case SIM_EDF_FF:
+			cpu = sa_edf_worst_fit(ts, t);
+			break;
+		case SIM_FP_PM:
+			if ((cpu = sa_fp_first_fit(ts, t)) == SA_CPU_UNDEFINED &&
+				(cpu = sa_fp_pm_split(ts, t)) != SA_CPU_UNDEFINED &&
+				t->first_cpu != t->last_cpu) {
+				t->prio = SIM_PRIO_MIGRATORY;
+			}
+			break;
+		case SIM_EDF_WM:
+			if ((cpu = sa_edf_worst_fit(ts, t)) == SA_CPU_UNDEFINED) {
+				cpu = sa_edf_wm_split(ts, t, FALSE);
+			}
+			break;
+		default:
+			/* global scheduling has no admission test. */
+			continue;
+		}
+
+		if (cpu == SA_CPU_UNDEFINED) {
+			return FALSE;
+		}
+		sa_assign(ts, t, cpu);
+	}
+
+	return TRUE;
+}
+
+/**
+ * admit and simulate the given taskset by every plugin.
+ */
+void sim_schedule(FILE *fp, int m, int time, int *plugins,
+				  sim_result_t *result, int print)
+{
+	int i, j, n, admitted;
+	sa_task_t *task;
+	sa_taskset_t ts;
+	sim_stat_t stat;
+
+	n = sim_read_taskset(fp, &task);
+	sa_taskset_init(&ts, task, n, m);
+
+	for (i = 0; i < NR_SIM_PLUGINS; i++) {
+		if (!plugins[i]) {
+			continue;
+		}
+
+		if ((admitted = sim_admit(&ts, i))) {
+			sim_run(&ts, i, (unsigned long long)time * USEC_1MS, &stat);
+			result[i].nr_jobs += stat.nr_jobs;
+			result[i].nr_preemptions += stat.nr_preemptions;
+			result[i].nr_migrations += stat.nr_migrations;
+			if (!stat.missed) {
+				result[i].nr_success++;
+			}
+			else if (i != SIM_G_FP && i != SIM_G_EDF) {
+				/* the analysis of the plugin is unsafe, or the
+				   simulation does not behave as the plugin. */
+				result[i].nr_admitted_missed++;
+			}
+		}
+		if (print) {
+			printf("  %-8s %s\n", sim_plugin_name[i], !admitted ?
+				   "rejected" : stat.missed ? "missed" : "scheduled");
+		}
+
+		/* FP-PM may have raised the priorities of split tasks. */
+		for (j = 0; j < n; j++) {
+			task[j].prio = n - j;
+		}
+	}
+
+	free(task);
+}
+
+/**
+ * parse the comma-separated plugin names into @plugins[].
+ */
+int sim_parse_plugins(char *str, int *plugins)
+{
+	int i;
+	char *token;
+
+	for (i = 0; i < NR_SIM_PLUGINS; i++) {
+		plugins[i] = FALSE;
+	}
+	for (token = strtok(str, ","); token; token = strtok(NULL, ",")) {
+		for (i = 0; i < NR_SIM_PLUGINS; i++) {
+			if (strcmp(token, sim_plugin_name[i]) == 0) {
+				plugins[i] = TRUE;
+				break;
+			}
+		}
+		if (i == NR_SIM_PLUGINS) {
+			printf("plugin \"%s\" is unknown.\n", token);
+			return FALSE;
+		}
+	}
+
+	return TRUE;
+}
+
+void sim_print_csv_header(FILE *fp)
+{
+	fprintf(fp, "workload,plugin,quantity,success,ratio,ci_low,ci_high,"
+			"admitted_missed,preemptions_per_job,migrations_per_job\n");
+}
+
+/**
+ * one CSV line of the results of @plugin at @workload, with the 95%
+ * confidence interval of the success ratio.
+ */
+void sim_print_csv(FILE *fp, int workload, int plugin, sim_result_t *r,
+				   int quantity)
+{
+	double lo, hi;
+
+	wilson_interval(r->nr_success, quantity, &lo, &hi);
+	fprintf(fp, "%d,%s,%d,%d,%f,%f,%f,%d,%f,%f\n", workload,
+			sim_plugin_name[plugin], quantity, r->nr_success,
+			(double)r->nr_success / (double)quantity * 100, lo, hi,
+			r->nr_admitted_missed,
+			r->nr_jobs ? (double)r->nr_preemptions / r->nr_jobs : 0,
+			r->nr_jobs ? (double)r->nr_migrations / r->nr_jobs : 0);
+}
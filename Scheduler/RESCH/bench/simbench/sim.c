@@ -0,0 +1,377 @@
+/*
+ * sim.c		Copyright (C) Shinpei Kato
+ *
+ * Discrete-event simulation of periodic tasks scheduled by the plugins.
+ * Every job executes for its full execution time, and no overhead is
+ * taken into account. The time advances from an event to the next one,
+ * i.e., a job release, the completion of a job or a piece, or the window
+ * of a piece in EDF-WM.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "simbench.h"
+
+#define NO_CPU	(-1)
+
+typedef unsigned long long simtime_t;
+
+/* simulation state of a task. */
+typedef struct sim_task_struct {
+	sa_task_t *t;
+	simtime_t next_release;	/* release of the next job. */
+	simtime_t release;		/* release of the current job. */
+	int nr_pending;			/* released but not completed jobs. */
+	int piece;				/* pieces completed in the current job. */
+	int cpu;				/* CPU of the current piece, NO_CPU if global. */
+	simtime_t ready;		/* the current piece is ready at this time. */
+	simtime_t remain;		/* remaining time of the current piece. */
+	long long key;			/* smaller value is higher priority. */
+	int running;			/* CPU running the task, or NO_CPU. */
+	int last_cpu;			/* CPU the current job ran last, or NO_CPU. */
+} sim_task_t;
+
+typedef struct sim_struct {
+	int plugin;
+	int nr_tasks;
+	int nr_cpus;
+	sim_task_t *task;
+	int *cpu_task;			/* task running on each CPU, or -1. */
+	char *selected;
+	sim_stat_t *stat;
+} sim_t;
+
+const char *sim_plugin_name[NR_SIM_PLUGINS] = {
+	"fp-ff", "edf-ff", "fp-pm", "edf-wm", "g-fp", "g-edf"
+};
+
+static inline int plugin_is_edf(int plugin)
+{
+	return plugin == SIM_EDF_FF || plugin == SIM_EDF_WM || plugin == SIM_G_EDF;
+}
+
+static inline int plugin_is_global(int plugin)
+{
+	return plugin == SIM_G_FP || plugin == SIM_G_EDF;
+}
+
+/**
+ * true iff @t is split in the same sense as task_is_split() of the plugin.
+ */
+static inline int task_is_split(sa_task_t *t, int plugin)
+{
+	if (plugin == SIM_EDF_WM) {
+		return t->window > 0;
+	}
+	if (plugin == SIM_FP_PM) {
+		return t->first_cpu != t->last_cpu;
+	}
+	return FALSE;
+}
+
+/**
+ * return the CPU of the @k-th piece of split @t, or NO_CPU if none.
+ * pieces are executed in order of CPU IDs.
+ */
+static int piece_cpu(sa_task_t *t, int k, int nr_cpus)
+{
+	int cpu;
+
+	for (cpu = 0; cpu < nr_cpus; cpu++) {
+		if (t->runtime[cpu] > 0 && k-- == 0) {
+			return cpu;
+		}
+	}
+	return NO_CPU;
+}
+
+static inline int runnable(sim_task_t *s, simtime_t now)
+{
+	return s->nr_pending > 0 && s->ready <= now && s->remain > 0;
+}
+
+/**
+ * set up the current piece, or the whole job if not split, of @s.
+ */
+static void start_piece(sim_t *sim, sim_task_t *s)
+{
+	sa_task_t *t = s->t;
+
+	if (task_is_split(t, sim->plugin)) {
+		s->cpu = piece_cpu(t, s->piece, sim->nr_cpus);
+		s->remain = t->runtime[s->cpu];
+		if (sim->plugin == SIM_EDF_WM) {
+			/* every piece is released at its window. */
+			s->ready = s->release + (simtime_t)s->piece * t->window;
+			s->key = s->release + (simtime_t)(s->piece + 1) * t->window;
+		}
+		else {
+			/* the next piece follows immediately. */
+			s->ready = s->release;
+			s->key = -(long long)t->prio;
+		}
+	}
+	else {
+		s->cpu = plugin_is_global(sim->plugin) ? NO_CPU : t->cpu;
+		s->remain = t->C;
+		s->ready = s->release;
+		s->key = plugin_is_edf(sim->plugin) ?
+			(long long)(s->release + t->D) : -(long long)t->prio;
+	}
+}
+
+/**
+ * assign task @i (or nothing if -1) to @cpu.
+ */
+static void switch_to(sim_t *sim, int cpu, int i)
+{
+	int cur = sim->cpu_task[cpu];
+	sim_task_t *s;
+
+	if (cur == i) {
+		return;
+	}
+	if (cur >= 0) {
+		sim->task[cur].running = NO_CPU;
+		sim->stat->nr_preemptions++;
+	}
+
+	sim->cpu_task[cpu] = i;
+	if (i >= 0) {
+		s = &sim->task[i];
+		s->running = cpu;
+		if (s->last_cpu != NO_CPU && s->last_cpu != cpu) {
+			sim->stat->nr_migrations++;
+		}
+		s->last_cpu = cpu;
+	}
+}
+
+/**
+ * each CPU runs the highest-priority task assigned to it.
+ * a tie is broken in favor of the running task.
+ */
+static void dispatch_partitioned(sim_t *sim, simtime_t now)
+{
+	int i, cpu, b;
+	int best[SA_NR_CPUS];
+	sim_task_t *s;
+
+	for (cpu = 0; cpu < sim->nr_cpus; cpu++) {
+		best[cpu] = -1;
+	}
+	for (i = 0; i < sim->nr_tasks; i++) {
+		s = &sim->task[i];
+		if (!runnable(s, now)) {
+			continue;
+		}
+		b = best[s->cpu];
+		if (b < 0 || s->key < sim->task[b].key ||
+			(s->key == sim->task[b].key && s->running == s->cpu)) {
+			best[s->cpu] = i;
+		}
+	}
+	for (cpu = 0; cpu < sim->nr_cpus; cpu++) {
+		switch_to(sim, cpu, best[cpu]);
+	}
+}
+
+/**
+ * the m highest-priority tasks run on the m CPUs. running tasks stay
+ * on their CPUs, and the others prefer the CPUs they ran last.
+ */
+static void dispatch_global(sim_t *sim, simtime_t now)
+{
+	int i, k, b, cpu;
+	sim_task_t *s;
+
+	memset(sim->selected, 0, (unsigned int)sim->nr_tasks);
+	for (k = 0; k < sim->nr_cpus; k++) {
+		b = -1;
+		for (i = 0; i < sim->nr_tasks; i++) {
+			s = &sim->task[i];
+			if (sim->selected[i] || !runnable(s, now)) {
+				continue;
+			}
+			if (b < 0 || s->key < sim->task[b].key ||
+				(s->key == sim->task[b].key && s->running != NO_CPU &&
+				 sim->task[b].running == NO_CPU)) {
+				b = i;
+			}
+		}
+		if (b < 0) {
+			break;
+		}
+		sim->selected[b] = TRUE;
+	}
+
+	/* preempt the running tasks not selected. */
+	for (cpu = 0; cpu < sim->nr_cpus; cpu++) {
+		i = sim->cpu_task[cpu];
+		if (i >= 0 && !sim->selected[i]) {
+			switch_to(sim, cpu, -1);
+		}
+	}
+
+	/* put the selected tasks on free CPUs. */
+	for (i = 0; i < sim->nr_tasks; i++) {
+		s = &sim->task[i];
+		if (!sim->selected[i] || s->running != NO_CPU) {
+			continue;
+		}
+		if (s->last_cpu != NO_CPU && sim->cpu_task[s->last_cpu] < 0) {
+			cpu = s->last_cpu;
+		}
+		else {
+			for (cpu = 0; sim->cpu_task[cpu] >= 0; cpu++)
+				;
+		}
+		switch_to(sim, cpu, i);
+	}
+}
+
+/**
+ * complete the pieces and jobs of @s that have no remaining time.
+ * return TRUE if a deadline is missed.
+ */
+static int settle(sim_t *sim, sim_task_t *s, simtime_t now)
+{
+	sa_task_t *t = s->t;
+
+	while (s->nr_pending > 0 && s->remain == 0 && s->ready <= now) {
+		/* the current piece is completed. */
+		if (s->running != NO_CPU) {
+			sim->cpu_task[s->running] = -1;
+			s->running = NO_CPU;
+		}
+		s->piece++;
+		if (task_is_split(t, sim->plugin) &&
+			piece_cpu(t, s->piece, sim->nr_cpus) != NO_CPU) {
+			start_piece(sim, s);
+			continue;
+		}
+
+		/* the job is completed. */
+		sim->stat->nr_jobs++;
+		if (now > s->release + t->D) {
+			return TRUE;
+		}
+		s->release += t->T;
+		s->piece = 0;
+		s->last_cpu = NO_CPU;
+		if (--s->nr_pending > 0) {
+			start_piece(sim, s);
+		}
+	}
+
+	return FALSE;
+}
+
+/**
+ * simulate the tasks in @ts, which have been assigned to CPUs by the
+ * given plugin, until the first deadline miss or @horizon (usecs).
+ * all the tasks release their first jobs at time 0.
+ */
+void sim_run(sa_taskset_t *ts, int plugin, unsigned long long horizon,
+			 sim_stat_t *stat)
+{
+	int i;
+	simtime_t now, next;
+	sim_task_t *s;
+	sim_t sim;
+
+	sim.plugin = plugin;
+	sim.nr_tasks = ts->nr_tasks;
+	sim.nr_cpus = ts->nr_cpus;
+	sim.task = (sim_task_t *)calloc(ts->nr_tasks, sizeof(sim_task_t));
+	sim.cpu_task = (int *)malloc(sizeof(int) * ts->nr_cpus);
+	sim.selected = (char *)malloc(ts->nr_tasks);
+	sim.stat = stat;
+	memset(stat, 0, sizeof(sim_stat_t));
+
+	for (i = 0; i < ts->nr_cpus; i++) {
+		sim.cpu_task[i] = -1;
+	}
+	for (i = 0; i < ts->nr_tasks; i++) {
+		sim.task[i].t = &ts->task[i];
+		sim.task[i].running = NO_CPU;
+		sim.task[i].last_cpu = NO_CPU;
+	}
+
+	now = 0;
+	while (1) {
+		/* release jobs. */
+		for (i = 0; i < sim.nr_tasks; i++) {
+			s = &sim.task[i];
+			while (s->next_release <= now) {
+				if (s->nr_pending++ == 0) {
+					s->release = s->next_release;
+					s->piece = 0;
+					start_piece(&sim, s);
+				}
+				s->next_release += s->t->T;
+			}
+		}
+
+		/* complete jobs and pieces. */
+		for (i = 0; i < sim.nr_tasks; i++) {
+			if (settle(&sim, &sim.task[i], now)) {
+				stat->missed = TRUE;
+				goto out;
+			}
+		}
+
+		if (now >= horizon) {
+			break;
+		}
+
+		if (plugin_is_global(plugin)) {
+			dispatch_global(&sim, now);
+		}
+		else {
+			dispatch_partitioned(&sim, now);
+		}
+
+		/* find the next event. */
+		next = horizon;
+		for (i = 0; i < sim.nr_tasks; i++) {
+			s = &sim.task[i];
+			if (s->next_release < next) {
+				next = s->next_release;
+			}
+			if (s->nr_pending == 0) {
+				continue;
+			}
+			if (s->ready > now) {
+				if (s->ready < next) {
+					next = s->ready;
+				}
+			}
+			else if (s->running != NO_CPU && now + s->remain < next) {
+				next = now + s->remain;
+			}
+		}
+
+		/* run the tasks until the next event. */
+		for (i = 0; i < sim.nr_tasks; i++) {
+			s = &sim.task[i];
+			if (s->running != NO_CPU) {
+				s->remain -= next - now;
+			}
+		}
+		now = next;
+	}
+
+	/* jobs that are left behind their deadlines. */
+	for (i = 0; i < sim.nr_tasks; i++) {
+		s = &sim.task[i];
+		if (s->nr_pending > 0 && s->release + s->t->D < horizon) {
+			stat->missed = TRUE;
+		}
+	}
+
+ out:
+	free(sim.task);
+	free(sim.cpu_task);
+	free(sim.selected);
+}
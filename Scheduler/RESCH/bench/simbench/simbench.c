@@ -0,0 +1,496 @@
+/*
+ * simbench.c		Copyright (C) Shinpei Kato
+ *
+ * Schedulability benchmarking by simulation.
+ * The same task set files as schedbench are assigned to CPUs by the
+ * analysis of the plugins (core/analysis.c), and are then simulated
+ * in user space instead of being executed in real time.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "simbench.h"
+#include "config.h"
+
+extern void generate_taskset(char *path, int nr_tasksets,
+							 char *dist, char *deadline, char *period,
+							 int workload, double sep, double prob,
+							 double mean, double umin, double umax,
+							 int pmin, int pmax);
+extern unsigned int taskset_seed;
+
+/* admission tests compared at a workload. */
+typedef struct admission_struct {
+	unsigned long long nr_tests;
+	unsigned long long nr_mismatches;
+	double dbf_usec;
+	double qpa_usec;
+} admission_t;
+
+void help(void)
+{
+	printf("Options:\n");
+	printf("--cpus=		the number of processors used.\n");
+	printf("--umin=		the minimum utilization [0, 1.0] of every individual task.\n");
+	printf("--umax=		the maximum utilization [0, 1.0] of every individual task.\n");
+	printf("--pmin=		the minimum period of every individual task (by milliseconds).\n");
+	printf("--pmax=		the maximum period of every individual task (by milliseconds).\n");
+	printf("--dist=		the distribution of utilizations of tasks (by uniform, bimodal, or exponential).\n");
+	printf("--sep=		the utilization separator [0, 1.0] between light tasks and heavy tasks in a bimodal distribution.\n");
+	printf("--prob=		the probability [0, 1.0] of being heavy tasks in a bimodal distribution.\n");
+	printf("--mean=		the mean value [0, 1.0] in an exponetial distribution.\n");
+	printf("--deadline=	the type of relative deadlines (by implicit, constrained, or arbitrary).\n");
+	printf("--period=	the type of periods (by arbitrary or harmonic).\n");
+	printf("--time=		the length of simulated time (by millisecond).\n");
+	printf("--start=	benchmarking starts from this system load [0, 100].\n");
+	printf("--end=		benchmarking ends at this system load [0, 100].\n");
+	printf("--step=		the distance of every successive sampling system load to be tested by benchmarking.\n");
+	printf("--quantity=	the number of tasksets tested per workload.\n");
+	printf("--seed=		the seed to generate tasksets, which makes them reproducible. default: the time.\n");
+	printf("--plugins=	the comma-separated plugins to be simulated (fp-ff, edf-ff, fp-pm, edf-wm, g-fp, g-edf). default: all.\n");
+	printf("--file=		simulate only the given taskset file and print the result.\n");
+	printf("--result=	the prefix of the file names, in which benchmarking results are saved per plugin, and in one CSV file with 95%% confidence intervals.\n");
+	printf("--admission	compare the time and verdicts of the EDF admission tests (DBF and QPA) instead of simulation.\n");
+	printf("--print		print the progress of benchmarking.\n");
+}
+
+/**
+ * elapsed time from @t0 to @t1 by microseconds.
+ */
+double elapsed_usec(struct timespec *t0, struct timespec *t1)
+{
+	return (t1->tv_sec - t0->tv_sec) * 1000000.0 +
+		(t1->tv_nsec - t0->tv_nsec) / 1000.0;
+}
+
+/**
+ * assign the given taskset to CPUs by EDF first fit, and measure the
+ * exhaustive DBF test and QPA on every CPU probed. the task is assigned
+ * by the verdict of the DBF test, so that both tests see the same state.
+ */
+void compare_admission(FILE *fp, int m, admission_t *adm)
+{
+	int i, n, cpu, dbf, qpa;
+	sa_task_t *task, *t;
+	sa_taskset_t ts;
+	struct timespec t0, t1, t2;
+
+	n = sim_read_taskset(fp, &task);
+	sa_taskset_init(&ts, task, n, m);
+
+	for (i = 0; i < n; i++) {
+		t = &task[i];
+		for (cpu = 0; cpu < m; cpu++) {
+			clock_gettime(CLOCK_MONOTONIC, &t0);
+			dbf = sa_dbf_test(&ts, t, cpu);
+			clock_gettime(CLOCK_MONOTONIC, &t1);
+			qpa = sa_qpa_test(&ts, t, cpu);
+			clock_gettime(CLOCK_MONOTONIC, &t2);
+
+			adm->nr_tests++;
+			adm->dbf_usec += elapsed_usec(&t0, &t1);
+			adm->qpa_usec += elapsed_usec(&t1, &t2);
+			if (!dbf != !qpa) {
+				adm->nr_mismatches++;
+			}
+			if (dbf) {
+				sa_assign(&ts, t, cpu);
+				break;
+			}
+		}
+		if (cpu == m) {
+			break;
+		}
+	}
+
+	free(task);
+}
+
+void print_admission(FILE *fp, int workload, admission_t *a)
+{
+	fprintf(fp, "%d %f %f %llu\n", workload,
+			a->nr_tests ? a->dbf_usec / a->nr_tests : 0,
+			a->nr_tests ? a->qpa_usec / a->nr_tests : 0,
+			a->nr_mismatches);
+}
+
+void print_result(FILE *fp, int workload, sim_result_t *r, int quantity)
+{
+	fprintf(fp, "%d %f %d %f %f\n", workload,
+			(double)r->nr_success / (double)quantity * 100,
+			r->nr_admitted_missed,
+			r->nr_jobs ? (double)r->nr_preemptions / r->nr_jobs : 0,
+			r->nr_jobs ? (double)r->nr_migrations / r->nr_jobs : 0);
+}
+
+/* entry point. */
+int main(int argc, char *argv[])
+{
+	int i, k;
+	/* temporary vaiables. */
+	int tmp;
+	/* the number of processors. */
+	int m = NR_RT_CPUS;
+	/* path to a directory where a taskset file is located. */
+	char path[MAX_BUF];
+	/* path to a taskset file. */
+	char tsfile[MAX_BUF] = "";
+	FILE *fp;
+	/* minimum/maximum utilization of individual task [0, 1.0].
+	   default: umin=0.1, umax=1.0. */
+	char umin[MAX_BUF] = "0.1", umax[MAX_BUF] = "1.0";
+	/* minimum/maximum period of individual task (milliseconds).
+	   default: pmin=10, pmax=1000. */
+	char pmin[MAX_BUF] = "10", pmax[MAX_BUF] = "1000";
+	/* distribution of utilization of tasks.
+	   default: uniform distribution. */
+	char dist[MAX_BUF] = "uniform";
+	/* parameters for bimodal & exponential distributions.
+	   default: all 0.5. */
+	char sep[MAX_BUF] = "0.5";
+	char prob[MAX_BUF] = "0.5";
+	char mean[MAX_BUF] = "0.5";
+	/* type of deadlines. default: implicit. */
+	char deadline[MAX_BUF] = "implicit";
+	/* type of periods. default: nonharmonic. */
+	char period[MAX_BUF] = "nonharmonic";
+	/* the length of simulated time (ms). default: 10 seconds. */
+	int time = 10000;
+	/* benchmarking range [0, 100]
+	   default: from system utilization 50% to 100% at every 5%. */
+	int start = 50;
+	int end = 100;
+	int step = 5;
+	/* the number of tasksets per workload testing. */
+	int quantity = 1000;
+	/* prefix of the files that output benchmarking results. */
+	char result[MAX_BUF] = "./result";
+	char resfile[MAX_BUF];
+	/* plugins to be simulated. default: all. */
+	int plugins[NR_SIM_PLUGINS] = {[0 ... NR_SIM_PLUGINS-1] = TRUE};
+	/* print flag. */
+	int print = 0;
+	/* admission flag: compare the EDF admission tests only. */
+	int admission = 0;
+	/* benchmarking workload. */
+	int workload;
+	/* results per workload and plugin. */
+	sim_result_t *results;
+	/* results of comparing the admission tests per workload. */
+	admission_t *adms;
+	clock_t clk;
+
+	for (i = 1; i < argc; i++) {
+		if (strncmp(argv[i], "--cpus", (tmp = strlen("--cpus"))) == 0) {
+			if (argv[i][tmp] != '=') {
+				printf("option \"%s\" is invalid.\n", argv[i]);
+				exit(1);
+			}
+			m = atoi(&argv[i][tmp+1]);
+		}
+		else if (strncmp(argv[i], "--umin", (tmp = strlen("--umin"))) == 0) {
+			if (argv[i][tmp] != '=') {
+				printf("option \"%s\" is invalid.\n", argv[i]);
+				exit(1);
+			}
+			strncpy(umin, &argv[i][tmp+1], MAX_BUF);
+		}
+		else if (strncmp(argv[i], "--umax", (tmp = strlen("--umax"))) == 0) {
+			if (argv[i][tmp] != '=') {
+				printf("option \"%s\" is invalid.\n", argv[i]);
+				exit(1);
+			}
+			strncpy(umax, &argv[i][tmp+1], MAX_BUF);
+		}
+		else if (strncmp(argv[i], "--pmin", (tmp = strlen("--pmin"))) == 0) {
+			if (argv[i][tmp] != '=') {
+				printf("option \"%s\" is invalid.\n", argv[i]);
+				exit(1);
+			}
+			strncpy(pmin, &argv[i][tmp+1], MAX_BUF);
+		}
+		else if (strncmp(argv[i], "--pmax", (tmp = strlen("--pmax"))) == 0) {
+			if (argv[i][tmp] != '=') {
+				printf("option \"%s\" is invalid.\n", argv[i]);
+				exit(1);
+			}
+			strncpy(pmax, &argv[i][tmp+1], MAX_BUF);
+		}
+		else if (strncmp(argv[i], "--dist", (tmp = strlen("--dist"))) == 0) {
+			if (argv[i][tmp] != '=') {
+				printf("option \"%s\" is invalid.\n", argv[i]);
+				exit(1);
+			}
+			strncpy(dist, &argv[i][tmp+1], MAX_BUF);
+		}
+		else if (strncmp(argv[i], "--sep", (tmp = strlen("--sep"))) == 0) {
+			if (argv[i][tmp] != '=') {
+				printf("option \"%s\" is invalid.\n", argv[i]);
+				exit(1);
+			}
+			strncpy(sep, &argv[i][tmp+1], MAX_BUF);
+		}
+		else if (strncmp(argv[i], "--prob", (tmp = strlen("--prob"))) == 0) {
+			if (argv[i][tmp] != '=') {
+				printf("option \"%s\" is invalid.\n", argv[i]);
+				exit(1);
+			}
+			strncpy(prob, &argv[i][tmp+1], MAX_BUF);
+		}
+		else if (strncmp(argv[i], "--mean", (tmp = strlen("--mean"))) == 0) {
+			if (argv[i][tmp] != '=') {
+				printf("option \"%s\" is invalid.\n", argv[i]);
+				exit(1);
+			}
+			strncpy(mean, &argv[i][tmp+1], MAX_BUF);
+		}
+		else if (strncmp(argv[i], "--deadline",
+						 (tmp = strlen("--deadline"))) == 0) {
+			if (argv[i][tmp] != '=') {
+				printf("option \"%s\" is invalid.\n", argv[i]);
+				exit(1);
+			}
+			strncpy(deadline, &argv[i][tmp+1], MAX_BUF);
+		}
+		else if (strncmp(argv[i], "--period",
+						 (tmp = strlen("--period"))) == 0) {
+			if (argv[i][tmp] != '=') {
+				printf("option \"%s\" is invalid.\n", argv[i]);
+				exit(1);
+			}
+			strncpy(period, &argv[i][tmp+1], MAX_BUF);
+		}
+		else if (strncmp(argv[i], "--time",
+						 (tmp = strlen("--time"))) == 0) {
+			if (argv[i][tmp] != '=') {
+				printf("option \"%s\" is invalid.\n", argv[i]);
+				exit(1);
+			}
+			time = atoi(&argv[i][tmp+1]);
+		}
+		else if (strncmp(argv[i], "--start", (tmp = strlen("--start"))) == 0) {
+			if (argv[i][tmp] != '=') {
+				printf("option \"%s\" is invalid.\n", argv[i]);
+				exit(1);
+			}
+			start = atoi(&argv[i][tmp+1]);
+		}
+		else if (strncmp(argv[i], "--end", (tmp = strlen("--end"))) == 0) {
+			if (argv[i][tmp] != '=') {
+				printf("option \"%s\" is invalid.\n", argv[i]);
+				exit(1);
+			}
+			end = atoi(&argv[i][tmp+1]);
+		}
+		else if (strncmp(argv[i], "--step", (tmp = strlen("--step"))) == 0) {
+			if (argv[i][tmp] != '=') {
+				printf("option \"%s\" is invalid.\n", argv[i]);
+				exit(1);
+			}
+			step = atoi(&argv[i][tmp+1]);
+		}
+		else if (strncmp(argv[i], "--quantity",
+						 (tmp = strlen("--quantity"))) == 0) {
+			if (argv[i][tmp] != '=') {
+				printf("option \"%s\" is invalid.\n", argv[i]);
+				exit(1);
+			}
+			quantity = atoi(&argv[i][tmp+1]);
+		}
+		else if (strncmp(argv[i], "--seed", (tmp = strlen("--seed"))) == 0) {
+			if (argv[i][tmp] != '=') {
+				printf("option \"%s\" is invalid.\n", argv[i]);
+				exit(1);
+			}
+			taskset_seed = strtoul(&argv[i][tmp+1], NULL, 10);
+		}
+		else if (strncmp(argv[i], "--plugins",
+						 (tmp = strlen("--plugins"))) == 0) {
+			if (argv[i][tmp] != '=' ||
+				!sim_parse_plugins(&argv[i][tmp+1], plugins)) {
+				printf("option \"%s\" is invalid.\n", argv[i]);
+				exit(1);
+			}
+		}
+		else if (strncmp(argv[i], "--file", (tmp = strlen("--file"))) == 0) {
+			if (argv[i][tmp] != '=') {
+				printf("option \"%s\" is invalid.\n", argv[i]);
+				exit(1);
+			}
+			strncpy(tsfile, &argv[i][tmp+1], MAX_BUF);
+		}
+		else if (strncmp(argv[i], "--result",
+						 (tmp = strlen("--result"))) == 0) {
+			if (argv[i][tmp] != '=') {
+				printf("option \"%s\" is invalid.\n", argv[i]);
+				exit(1);
+			}
+			strncpy(result, &argv[i][tmp+1], MAX_BUF);
+		}
+		else if (strncmp(argv[i], "--admission",
+						 (tmp = strlen("--admission"))) == 0) {
+			admission = 1;
+		}
+		else if (strncmp(argv[i], "--print", (tmp = strlen("--print"))) == 0) {
+			print = 1;
+		}
+		else if (strncmp(argv[i], "--help", (tmp = strlen("--help"))) == 0) {
+			help();
+			exit(0);
+		}
+		else {
+			printf("option \"%s\" is invalid.\n", argv[i]);
+			exit(1);
+		}
+	}
+
+	if (m < 1 || m > SA_NR_CPUS) {
+		printf("the number of processors must be 1 to %d.\n", SA_NR_CPUS);
+		exit(1);
+	}
+
+	/* arrays to store the results. */
+	results = (sim_result_t *)calloc(((end-start)/step+1) * NR_SIM_PLUGINS,
+								 sizeof(sim_result_t));
+	adms = (admission_t *)calloc((end-start)/step+1, sizeof(admission_t));
+
+	/* only the given taskset. */
+	if (tsfile[0]) {
+		if ((fp = fopen(tsfile, "r")) == NULL) {
+			printf("Cannot open file %s\n", tsfile);
+			goto end;
+		}
+		if (admission) {
+			compare_admission(fp, m, adms);
+			fclose(fp);
+			printf("dbf %f usecs qpa %f usecs per test, %llu mismatches\n",
+				   adms->nr_tests ? adms->dbf_usec / adms->nr_tests : 0,
+				   adms->nr_tests ? adms->qpa_usec / adms->nr_tests : 0,
+				   adms->nr_mismatches);
+			goto end;
+		}
+		printf("scheduling %s...\n", tsfile);
+		sim_schedule(fp, m, time, plugins, results, 1);
+		fclose(fp);
+		for (i = 0; i < NR_SIM_PLUGINS; i++) {
+			if (plugins[i]) {
+				printf("%-8s jobs %llu preemptions %llu migrations %llu\n",
+					   sim_plugin_name[i], results[i].nr_jobs,
+					   results[i].nr_preemptions, results[i].nr_migrations);
+			}
+		}
+		goto end;
+	}
+
+	/* benchmarking range of system utilization. */
+	start *= m;
+	end *= m;
+	step *= m;
+	clk = clock();
+	for (workload = start, k = 0; workload <= end; workload += step, k++) {
+		/* generate task set files, if necessary. */
+		generate_taskset(path, quantity, dist, deadline, period, workload,
+						 atof(sep), atof(prob), atof(mean),
+						 atof(umin), atof(umax),
+						 atoi(pmin), atoi(pmax));
+
+		for (i = 1; i <= quantity; i++) {
+			/* path to the taskset file. */
+			sprintf(tsfile, "%s/workload%d/ts%d", path, workload, i);
+
+			if ((fp = fopen(tsfile, "r")) == NULL) {
+				printf("Cannot open file %s\n", tsfile);
+				goto end;
+			}
+			if (admission) {
+				compare_admission(fp, m, &adms[k]);
+				fclose(fp);
+				continue;
+			}
+			if (print) {
+				printf("scheduling %s...\n", tsfile);
+			}
+			sim_schedule(fp, m, time, plugins, &results[k * NR_SIM_PLUGINS],
+						 print);
+			fclose(fp);
+		}
+
+		if (print && admission) {
+			printf("admission ");
+			print_admission(stdout, workload, &adms[k]);
+		}
+		else if (print) {
+			for (i = 0; i < NR_SIM_PLUGINS; i++) {
+				if (plugins[i]) {
+					printf("%-8s ", sim_plugin_name[i]);
+					print_result(stdout, workload,
+								 &results[k * NR_SIM_PLUGINS + i], quantity);
+				}
+			}
+		}
+	}
+	if (print) {
+		printf("%f seconds elapsed\n",
+			   (double)(clock() - clk) / CLOCKS_PER_SEC);
+	}
+
+	/* workload, time of the DBF test and QPA per test (usecs), and the
+	   number of different verdicts. */
+	if (admission) {
+		sprintf(resfile, "%s.admission", result);
+		if ((fp = fopen(resfile, "w")) == NULL) {
+			printf("Cannot open file %s\n", resfile);
+			goto end;
+		}
+		for (workload = start, k = 0; workload <= end; workload += step, k++) {
+			print_admission(fp, workload, &adms[k]);
+		}
+		fclose(fp);
+		goto end;
+	}
+
+	/* all the plugins in one CSV file, with confidence intervals. */
+	sprintf(resfile, "%s.csv", result);
+	if ((fp = fopen(resfile, "w")) == NULL) {
+		printf("Cannot open file %s\n", resfile);
+	}
+	else {
+		sim_print_csv_header(fp);
+		for (workload = start, k = 0; workload <= end; workload += step, k++) {
+			for (i = 0; i < NR_SIM_PLUGINS; i++) {
+				if (plugins[i]) {
+					sim_print_csv(fp, workload, i,
+								  &results[k * NR_SIM_PLUGINS + i], quantity);
+				}
+			}
+		}
+		fclose(fp);
+	}
+
+	/* one file per plugin:
+	   workload, success ratio, the number of tasksets that are admitted
+	   but miss deadlines, preemptions per job, and migrations per job. */
+	for (i = 0; i < NR_SIM_PLUGINS; i++) {
+		if (!plugins[i]) {
+			continue;
+		}
+		sprintf(resfile, "%s.%s", result, sim_plugin_name[i]);
+		if ((fp = fopen(resfile, "w")) == NULL) {
+			printf("Cannot open file %s\n", resfile);
+			continue;
+		}
+		for (workload = start, k = 0; workload <= end; workload += step, k++) {
+			print_result(fp, workload, &results[k * NR_SIM_PLUGINS + i],
+						 quantity);
+		}
+		fclose(fp);
+	}
+
+ end:
+	free(results);
+	free(adms);
+
+	return 0;
+}
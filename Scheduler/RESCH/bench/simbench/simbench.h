@@ -0,0 +1,59 @@
+#ifndef __SIMBENCH_H__
+#define __SIMBENCH_H__
+
+#include <stdio.h>
+#include <resch-analysis.h>
+
+#define TRUE 		1
+#define FALSE		0
+
+#define MAX_BUF 256
+
+/* 1000usec = 1ms. */
+#define USEC_1MS 1000
+
+/* the priority of split tasks in FP-PM, higher than any other task. */
+#define SIM_PRIO_MIGRATORY	0x7fffffff
+
+/* plugins that can be simulated. */
+#define SIM_FP_FF	0
+#define SIM_EDF_FF	1
+#define SIM_FP_PM	2
+#define SIM_EDF_WM	3
+#define SIM_G_FP	4
+#define SIM_G_EDF	5
+#define NR_SIM_PLUGINS	6
+
+/* statistics of a simulation run. */
+typedef struct sim_stat_struct {
+	unsigned long long nr_jobs;
+	unsigned long long nr_preemptions;
+	unsigned long long nr_migrations;
+	int missed;
+} sim_stat_t;
+
+/* results accumulated for every plugin at a workload. */
+typedef struct sim_result_struct {
+	int nr_success;
+	int nr_admitted_missed;
+	unsigned long long nr_jobs;
+	unsigned long long nr_preemptions;
+	unsigned long long nr_migrations;
+} sim_result_t;
+
+extern const char *sim_plugin_name[NR_SIM_PLUGINS];
+
+extern void sim_run(sa_taskset_t *ts, int plugin, unsigned long long horizon,
+					sim_stat_t *stat);
+
+/* plugin.c */
+extern int sim_read_taskset(FILE *fp, sa_task_t **task);
+extern int sim_admit(sa_taskset_t *ts, int plugin);
+extern void sim_schedule(FILE *fp, int m, int time, int *plugins,
+						 sim_result_t *result, int print);
+extern int sim_parse_plugins(char *str, int *plugins);
+extern void sim_print_csv_header(FILE *fp);
+extern void sim_print_csv(FILE *fp, int workload, int plugin,
+						  sim_result_t *r, int quantity);
+
+#endif
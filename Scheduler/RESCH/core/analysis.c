@@ -0,0 +1,985 @@
+/*
+ * analysis.c		Copyright (C) Shinpei Kato
+ *
+ * Schedulability analysis and CPU assignment of the partitioned and
+ * semi-partitioned plugins (FP-FF, EDF-FF, FP-PM, and EDF-WM).
+ * This file is compiled into the RESCH core module, which exports the
+ * functions to the plugins, and is also compiled as it is into the
+ * user-space simulator in bench/simbench.
+ * Nothing but the sa_global_*() functions depends on the kernel.
+ */
+
+#ifdef __KERNEL__
+#include <linux/jiffies.h>
+#include <linux/module.h>
+#include <resch-core.h>
+#else
+#include <stddef.h>
+#define EXPORT_SYMBOL(sym)
+#define true	1
+#define false	0
+#endif
+#include <resch-analysis.h>
+
+static inline unsigned long max_ulong(unsigned long x, unsigned long y)
+{
+	return x > y ? x : y;
+}
+
+static inline unsigned long min_ulong(unsigned long x, unsigned long y)
+{
+	return x < y ? x : y;
+}
+
+/**
+ * utilization of @c per @T by parts per million, rounded up so that
+ * the analysis stays on the safe side.
+ */
+static inline unsigned long util(unsigned long c, unsigned long T)
+{
+	return (c * SA_UTIL_ONE + T - 1) / T;
+}
+
+/**
+ * execution time of @t on @cpu: the piece if split, otherwise the whole.
+ */
+static inline unsigned long exec_on_cpu(sa_task_t *t, int cpu)
+{
+	return sa_split_is_on_cpu(t, cpu) ? t->runtime[cpu] : t->C;
+}
+
+/**
+ * relative deadline of @t on @cpu: the window if split.
+ */
+static inline unsigned long deadline_on_cpu(sa_task_t *t, int cpu)
+{
+	return sa_split_is_on_cpu(t, cpu) ? t->window : t->D;
+}
+
+static inline unsigned long overhead(sa_taskset_t *ts, sa_task_t *t,
+									 int cpu, unsigned long L)
+{
+	return ts->overhead ? ts->overhead(t, cpu, L) : 0;
+}
+
+void sa_task_init(sa_task_t *t, unsigned long C, unsigned long T,
+				  unsigned long D, int prio)
+{
+	t->C = C;
+	t->T = T;
+	t->D = D;
+	t->prio = prio;
+	t->cpu = SA_CPU_UNDEFINED;
+	t->cpus = 0;
+	t->priv = NULL;
+	sa_clear_split(t);
+}
+EXPORT_SYMBOL(sa_task_init);
+
+void sa_clear_split(sa_task_t *t)
+{
+	int cpu;
+
+	t->first_cpu = SA_CPU_UNDEFINED;
+	t->last_cpu = SA_CPU_UNDEFINED;
+	t->window = 0;
+	for (cpu = 0; cpu < SA_NR_CPUS; cpu++) {
+		t->runtime[cpu] = 0;
+	}
+}
+EXPORT_SYMBOL(sa_clear_split);
+
+void sa_taskset_init(sa_taskset_t *ts, sa_task_t *task, int nr_tasks,
+					 int nr_cpus)
+{
+	int cpu;
+
+	ts->task = task;
+	ts->nr_tasks = nr_tasks;
+	ts->nr_cpus = min_ulong(nr_cpus, SA_NR_CPUS);
+	ts->overhead = NULL;
+	ts->indexed = false;
+	for (cpu = 0; cpu < SA_NR_CPUS; cpu++) {
+		ts->cpu_available[cpu] = true;
+	}
+}
+EXPORT_SYMBOL(sa_taskset_init);
+
+/**
+ * insert @t into the list of @cpu in order of priority, and add its
+ * utilization to @cpu.
+ */
+static void index_insert(sa_taskset_t *ts, sa_task_t *t, int cpu)
+{
+	sa_task_t **pp = &ts->cpu_head[cpu];
+
+	while (*pp && (*pp)->prio >= t->prio) {
+		pp = &(*pp)->cpu_next[cpu];
+	}
+	t->cpu_next[cpu] = *pp;
+	*pp = t;
+	ts->util[cpu] += util(exec_on_cpu(t, cpu), t->T);
+}
+
+/**
+ * remove @t from the list of @cpu, and subtract its utilization from
+ * @cpu. nothing is done if @t is not in the list.
+ */
+static void index_remove(sa_taskset_t *ts, sa_task_t *t, int cpu)
+{
+	sa_task_t **pp = &ts->cpu_head[cpu];
+
+	while (*pp && *pp != t) {
+		pp = &(*pp)->cpu_next[cpu];
+	}
+	if (*pp) {
+		*pp = t->cpu_next[cpu];
+		ts->util[cpu] -= util(exec_on_cpu(t, cpu), t->T);
+	}
+}
+
+/**
+ * build the per-CPU lists and utilization, if not yet.
+ * this is done at the first analysis rather than in sa_taskset_init(),
+ * since the callers often fill in the tasks after initialization.
+ */
+static void index_build(sa_taskset_t *ts)
+{
+	int i, cpu;
+	sa_task_t *p;
+
+	if (ts->indexed) {
+		return;
+	}
+
+	for (cpu = 0; cpu < SA_NR_CPUS; cpu++) {
+		ts->cpu_head[cpu] = NULL;
+		ts->util[cpu] = 0;
+	}
+	for (i = 0; i < ts->nr_tasks; i++) {
+		p = &ts->task[i];
+		for (cpu = 0; cpu < ts->nr_cpus; cpu++) {
+			if (sa_task_is_assigned(p, cpu)) {
+				index_insert(ts, p, cpu);
+			}
+		}
+	}
+	ts->indexed = true;
+}
+
+/* iterate over the tasks and pieces on @cpu in order of priority. */
+#define for_each_task_on_cpu(ts, p, cpu) \
+	for (p = (ts)->cpu_head[cpu]; p; p = p->cpu_next[cpu])
+
+/**
+ * assign @t, which has not yet been assigned, to @cpu_dst. if @t has been
+ * split, it is also assigned to the CPUs of its pieces.
+ */
+void sa_assign(sa_taskset_t *ts, sa_task_t *t, int cpu_dst)
+{
+	int cpu;
+
+	t->cpu = cpu_dst;
+	if (!ts->indexed) {
+		return;
+	}
+	for (cpu = 0; cpu < ts->nr_cpus; cpu++) {
+		if (sa_task_is_assigned(t, cpu)) {
+			index_insert(ts, t, cpu);
+		}
+	}
+}
+EXPORT_SYMBOL(sa_assign);
+
+/**
+ * take @t, which has been assigned by sa_assign(), out of the CPUs, so
+ * that its properties can be changed and it can be assigned again.
+ * the pieces of split @t are kept as they are.
+ */
+void sa_unassign(sa_taskset_t *ts, sa_task_t *t)
+{
+	int cpu;
+
+	if (ts->indexed) {
+		for (cpu = 0; cpu < ts->nr_cpus; cpu++) {
+			if (sa_task_is_assigned(t, cpu)) {
+				index_remove(ts, t, cpu);
+			}
+		}
+	}
+	t->cpu = SA_CPU_UNDEFINED;
+}
+EXPORT_SYMBOL(sa_unassign);
+
+/**
+ * total utilization of the tasks and pieces assigned to @cpu.
+ */
+unsigned long sa_util_cpu(sa_taskset_t *ts, int cpu)
+{
+	index_build(ts);
+	return ts->util[cpu];
+}
+EXPORT_SYMBOL(sa_util_cpu);
+
+/**
+ * the maximum amount of time for which a task with execution time @c
+ * and period @T can interfere in an interval of @L.
+ */
+static inline unsigned long fp_workload(unsigned long c, unsigned long T,
+										unsigned long L)
+{
+	unsigned long F = L / T;
+
+	if (L >= T * F + c) {
+		return c * (F + 1);
+	}
+	else {
+		return L - F * (T - c);
+	}
+}
+
+/**
+ * compute the worst-case response time of @t on the given CPU, taking
+ * into account the pieces of split tasks.
+ * a CPU that runs a non-last piece of a higher-priority split task is
+ * marked unavailable for further splitting (FP-PM).
+ */
+unsigned long sa_fp_response_time(sa_taskset_t *ts, sa_task_t *t, int cpu)
+{
+	unsigned long ret = 0;
+	unsigned long Ck;
+	unsigned long L = t->D;
+	sa_task_t *hp;
+
+	index_build(ts);
+	for_each_task_on_cpu(ts, hp, cpu) {
+		if (hp->prio < t->prio) {
+			break;
+		}
+		if (hp == t) {
+			continue;
+		}
+
+		if (sa_split_is_on_cpu(hp, cpu)) {
+			Ck = hp->runtime[cpu];
+			/* this CPU becomes unavailable if not the last CPU of @hp */
+			if (hp->last_cpu != cpu) {
+				ts->cpu_available[cpu] = false;
+			}
+		}
+		else if (sa_task_is_on_cpu(hp, cpu)) {
+			Ck = hp->C;
+		}
+		else {
+			continue;
+		}
+
+		ret += fp_workload(Ck, hp->T, L);
+	}
+
+	return ret + t->C + overhead(ts, t, cpu, L);
+}
+EXPORT_SYMBOL(sa_fp_response_time);
+
+/**
+ * true iff @t and all the lower-priority tasks on @cpu meet deadlines
+ * when @t is assigned to @cpu.
+ */
+int sa_fp_test(sa_taskset_t *ts, sa_task_t *t, int cpu)
+{
+	unsigned long Rk, Dk;
+	sa_task_t *lp;
+
+	/* first, get the response time of the task on this cpu. */
+	if (sa_fp_response_time(ts, t, cpu) > t->D) {
+		return false;
+	}
+
+	/* for the tasks with priorities lower than or equal to @t. */
+	for_each_task_on_cpu(ts, lp, cpu) {
+		if (lp == t || lp->prio > t->prio) {
+			continue;
+		}
+
+		/* take also into account @t. */
+		Dk = lp->D;
+		Rk = sa_fp_response_time(ts, lp, cpu) + fp_workload(t->C, t->T, Dk);
+
+		/* get unschedulable? */
+		if (Rk > Dk) {
+			return false;
+		}
+	}
+
+	return true;
+}
+EXPORT_SYMBOL(sa_fp_test);
+
+/**
+ * try to assign @t to the first CPU that passes the response time test.
+ */
+int sa_fp_first_fit(sa_taskset_t *ts, sa_task_t *t)
+{
+	int cpu;
+
+	for (cpu = 0; cpu < ts->nr_cpus; cpu++) {
+		/* check the default CPU mask. */
+		if (!sa_cpu_is_allowed(t, cpu)) {
+			continue;
+		}
+		if (sa_fp_test(ts, t, cpu)) {
+			return cpu;
+		}
+	}
+
+	return SA_CPU_UNDEFINED;
+}
+EXPORT_SYMBOL(sa_fp_first_fit);
+
+/**
+ * try to split @t across multiple CPUs in the order of CPU IDs, where
+ * each piece runs with the highest priority (FP-PM).
+ * on success, @t->runtime[] holds the pieces and the first CPU is
+ * returned. ts->cpu_available[] must be set by sa_fp_first_fit() before.
+ */
+int sa_fp_pm_split(sa_taskset_t *ts, sa_task_t *t)
+{
+	int cpu, found;
+	long F, tmp;
+	unsigned long split_runtime, sum_split_runtime;
+	unsigned long Pi = t->T;
+	long Rk, Dk;
+	sa_task_t *lp;
+
+	sa_clear_split(t);
+	index_build(ts);
+
+	/* the pieces are executed one after another. */
+	if (t->C > t->D) {
+		return SA_CPU_UNDEFINED;
+	}
+
+	sum_split_runtime = 0;
+	for (cpu = 0; cpu < ts->nr_cpus; cpu++) {
+		if (!ts->cpu_available[cpu] || !sa_cpu_is_allowed(t, cpu)) {
+			continue;
+		}
+
+		/* a CPU with no tasks can run a piece for the whole deadline. */
+		split_runtime = t->D;
+		found = false;
+		for_each_task_on_cpu(ts, lp, cpu) {
+			if (lp == t) {
+				continue;
+			}
+
+			Rk = sa_fp_response_time(ts, lp, cpu);
+			Dk = lp->D;
+
+			/* task @lp should be schedulable... */
+			if (Dk < Rk) {
+				split_runtime = 0;
+				break;
+			}
+
+			/* compute the upper bound of execution capacity that
+			   can be assigned to task @t on each CPU. */
+			F = Dk / Pi;
+			if (F == 0) {
+				tmp = (Dk - Rk) / (F + 1);
+			}
+			else {
+				/* just reduce divisions as many as possible. */
+				if (F * (Dk - Rk) >= (F * (long)Pi - Rk) * (F + 1)) {
+					tmp = (Dk - Rk) / (F + 1);
+				}
+				else {
+					tmp = Pi - Rk / F;
+				}
+			}
+			if (tmp < 0) {
+				tmp = 0;
+			}
+
+			/* find the minimum value. */
+			if (!found || split_runtime > (unsigned long)tmp) {
+				split_runtime = tmp;
+				found = true;
+			}
+		}
+
+		t->runtime[cpu] = split_runtime;
+		sum_split_runtime += split_runtime;
+
+		/* set first cpu if necessary. */
+		if (t->first_cpu == SA_CPU_UNDEFINED && split_runtime > 0) {
+			t->first_cpu = cpu;
+		}
+
+		/* if successfully split, break a loop. */
+		if (sum_split_runtime >= t->C) {
+			t->runtime[cpu] -= (sum_split_runtime - t->C);
+			t->last_cpu = cpu;
+			break;
+		}
+	}
+
+	if (t->last_cpu == SA_CPU_UNDEFINED) {
+		sa_clear_split(t);
+		return SA_CPU_UNDEFINED;
+	}
+
+	return t->first_cpu;
+}
+EXPORT_SYMBOL(sa_fp_pm_split);
+
+/**
+ * compute the demand bound of @t on @cpu in the given interval.
+ */
+static inline unsigned long dbf_task(sa_task_t *t, unsigned long L, int cpu)
+{
+	unsigned long d = deadline_on_cpu(t, cpu);
+
+	if (L < d) {
+		return 0;
+	}
+	return ((L - d) / t->T + 1) * exec_on_cpu(t, cpu);
+}
+
+/**
+ * compute the total demand bound of the tasks other than @t assigned to
+ * @cpu in the given interval.
+ */
+unsigned long sa_dbf_cpu(sa_taskset_t *ts, sa_task_t *t, unsigned long L,
+						 int cpu)
+{
+	sa_task_t *p;
+	unsigned long dbf_sum = 0;
+
+	index_build(ts);
+	for_each_task_on_cpu(ts, p, cpu) {
+		if (p != t) {
+			dbf_sum += dbf_task(p, L, cpu);
+		}
+	}
+
+	return dbf_sum;
+}
+EXPORT_SYMBOL(sa_dbf_cpu);
+
+static inline void dbf_len_add(sa_task_t *p, int cpu, unsigned long *x,
+							   unsigned long *u, unsigned long *d)
+{
+	unsigned long c = exec_on_cpu(p, cpu);
+	unsigned long dl = deadline_on_cpu(p, cpu);
+	unsigned long up = util(c, p->T);
+
+	if (p->T > dl) {
+		*x += ((p->T - dl) * up + SA_UTIL_ONE - 1) / SA_UTIL_ONE;
+	}
+	*u += up;
+	*d = max_ulong(*d, dl);
+}
+
+/**
+ * return the time length, during which DBF should be tested on the
+ * given CPU when @t is assigned to it, or 0 if overloaded.
+ */
+unsigned long sa_dbf_len(sa_taskset_t *ts, sa_task_t *t, int cpu)
+{
+	sa_task_t *p;
+	unsigned long x = 0, u = 0, d = 0;
+
+	/* compute for tasks assigned to @cpu. */
+	index_build(ts);
+	for_each_task_on_cpu(ts, p, cpu) {
+		if (p != t) {
+			dbf_len_add(p, cpu, &x, &u, &d);
+		}
+	}
+
+	/* compute for @t. */
+	dbf_len_add(t, cpu, &x, &u, &d);
+
+	/* if total utilization is equal to 100%, the tasks are schedulable
+	   only with implicit deadlines, which need no more than the max
+	   deadline to be tested. */
+	if (u > SA_UTIL_ONE || (u == SA_UTIL_ONE && x > 0)) {
+		return 0;
+	}
+	else if (u == SA_UTIL_ONE) {
+		return d;
+	}
+	else {
+		return max_ulong(x * SA_UTIL_ONE / (SA_UTIL_ONE - u), d);
+	}
+}
+EXPORT_SYMBOL(sa_dbf_len);
+
+/**
+ * true iff the demand does not exceed the supply at @L.
+ */
+static inline int dbf_ok(sa_taskset_t *ts, sa_task_t *t, unsigned long L,
+						 int cpu)
+{
+	return sa_dbf_cpu(ts, t, L, cpu) + dbf_task(t, L, cpu) +
+		overhead(ts, t, cpu, L) <= L;
+}
+
+/**
+ * schedulability test based on the demand bound function (DBF).
+ */
+int sa_dbf_test(sa_taskset_t *ts, sa_task_t *t, int cpu)
+{
+	sa_task_t *p;
+	unsigned long L, Lmax;
+
+	/* if the execution time is zero, it is obviously schedulable. */
+	if (exec_on_cpu(t, cpu) == 0) {
+		return true;
+	}
+
+	/* length of dbf test. */
+	if ((Lmax = sa_dbf_len(ts, t, cpu)) == 0) {
+		return false;
+	}
+
+	/* check for deadlines of tasks assigned to @cpu. */
+	for_each_task_on_cpu(ts, p, cpu) {
+		if (p == t) {
+			continue;
+		}
+		for (L = deadline_on_cpu(p, cpu); L <= Lmax; L += p->T) {
+			if (!dbf_ok(ts, t, L, cpu)) {
+				return false;
+			}
+		}
+	}
+
+	/* check for deadlines of @t. */
+	for (L = deadline_on_cpu(t, cpu); L <= Lmax; L += t->T) {
+		if (!dbf_ok(ts, t, L, cpu)) {
+			return false;
+		}
+	}
+
+	return true;
+}
+EXPORT_SYMBOL(sa_dbf_test);
+
+/**
+ * total demand of @t and the tasks on @cpu, including the overhead, at @L.
+ */
+static unsigned long qpa_demand(sa_taskset_t *ts, sa_task_t *t,
+								unsigned long L, int cpu)
+{
+	return sa_dbf_cpu(ts, t, L, cpu) + dbf_task(t, L, cpu) +
+		overhead(ts, t, cpu, L);
+}
+
+/**
+ * the latest absolute deadline of @p on @cpu before @L, or 0 if none.
+ */
+static inline unsigned long prev_deadline(sa_task_t *p, unsigned long L,
+										  int cpu)
+{
+	unsigned long d = deadline_on_cpu(p, cpu);
+
+	if (d >= L) {
+		return 0;
+	}
+	return d + (L - d - 1) / p->T * p->T;
+}
+
+/**
+ * the latest absolute deadline of @t and the tasks on @cpu before @L,
+ * or 0 if there is no such deadline.
+ */
+static unsigned long qpa_prev_deadline(sa_taskset_t *ts, sa_task_t *t,
+									   unsigned long L, int cpu)
+{
+	sa_task_t *p;
+	unsigned long dl = prev_deadline(t, L, cpu);
+
+	for_each_task_on_cpu(ts, p, cpu) {
+		if (p != t) {
+			dl = max_ulong(dl, prev_deadline(p, L, cpu));
+		}
+	}
+
+	return dl;
+}
+
+/**
+ * the same test as sa_dbf_test() by Quick Processor-demand Analysis.
+ * instead of checking every deadline up to the length of the test, it
+ * iterates backwards from the length, and jumps to the demand at each
+ * point whenever the demand is less than the point, because no deadline
+ * in between can be missed.
+ */
+int sa_qpa_test(sa_taskset_t *ts, sa_task_t *t, int cpu)
+{
+	sa_task_t *p;
+	unsigned long L, Lmax, h, dmin;
+
+	/* if the execution time is zero, it is obviously schedulable. */
+	if (exec_on_cpu(t, cpu) == 0) {
+		return true;
+	}
+
+	/* length of dbf test. */
+	if ((Lmax = sa_dbf_len(ts, t, cpu)) == 0) {
+		return false;
+	}
+
+	dmin = deadline_on_cpu(t, cpu);
+	for_each_task_on_cpu(ts, p, cpu) {
+		dmin = min_ulong(dmin, deadline_on_cpu(p, cpu));
+	}
+
+	/* start from the last deadline within the length. */
+	L = qpa_prev_deadline(ts, t, Lmax + 1, cpu);
+	h = qpa_demand(ts, t, L, cpu);
+	while (h <= L && h > dmin) {
+		if (h < L) {
+			L = h;
+		}
+		else {
+			L = qpa_prev_deadline(ts, t, L, cpu);
+		}
+		h = qpa_demand(ts, t, L, cpu);
+	}
+
+	return h <= dmin;
+}
+EXPORT_SYMBOL(sa_qpa_test);
+
+int sa_edf_first_fit(sa_taskset_t *ts, sa_task_t *t)
+{
+	int cpu;
+
+	for (cpu = 0; cpu < ts->nr_cpus; cpu++) {
+		/* check the default CPU mask. */
+		if (!sa_cpu_is_allowed(t, cpu)) {
+			continue;
+		}
+		/* demand bound function test. */
+		if (sa_qpa_test(ts, t, cpu)) {
+			return cpu;
+		}
+	}
+
+	return SA_CPU_UNDEFINED;
+}
+EXPORT_SYMBOL(sa_edf_first_fit);
+
+int sa_edf_worst_fit(sa_taskset_t *ts, sa_task_t *t)
+{
+	int cpu, cpu_dst = SA_CPU_UNDEFINED;
+	unsigned long u, u_dst = SA_UTIL_ONE;
+
+	for (cpu = 0; cpu < ts->nr_cpus; cpu++) {
+		/* check the default CPU mask. */
+		if (!sa_cpu_is_allowed(t, cpu)) {
+			continue;
+		}
+		/* demand bound function test. */
+		if (sa_qpa_test(ts, t, cpu)) {
+			u = sa_util_cpu(ts, cpu);
+			if (u < u_dst) {
+				u_dst = u;
+				cpu_dst = cpu;
+			}
+		}
+	}
+
+	return cpu_dst;
+}
+EXPORT_SYMBOL(sa_edf_worst_fit);
+
+/**
+ * reduce @*runtime of a piece of @t on @cpu such that no deadline of @p
+ * up to @*Lmax is missed. @*Lmax is also reduced as the runtime.
+ * return false if no runtime is left.
+ */
+static int edf_wm_limit_runtime(sa_taskset_t *ts, sa_task_t *t,
+								sa_task_t *p, int cpu,
+								unsigned long *runtime, unsigned long *Lmax)
+{
+	unsigned long L, demand, r;
+
+	for (L = deadline_on_cpu(p, cpu); L <= *Lmax; L += p->T) {
+		/* @t has no demand before its first deadline. */
+		if (L < t->window) {
+			continue;
+		}
+		demand = sa_dbf_cpu(ts, t, L, cpu) + overhead(ts, t, cpu, L);
+		if (demand >= L) {
+			*runtime = 0;
+			return false;
+		}
+		r = (L - demand) / ((L - t->window) / t->T + 1);
+		/* renew runtime and reduce Lmax. */
+		if (r < *runtime) {
+			*runtime = r;
+			if (r == 0) {
+				return false;
+			}
+			t->runtime[cpu] = r;
+			*Lmax = sa_dbf_len(ts, t, cpu);
+		}
+	}
+
+	return true;
+}
+
+/**
+ * compute the largest runtime of a piece of @t with the relative deadline
+ * of @t->window, which can be assigned to @cpu without any deadline miss.
+ */
+static unsigned long edf_wm_split_runtime(sa_taskset_t *ts, sa_task_t *t,
+										  int cpu)
+{
+	unsigned long Lmax, runtime;
+	unsigned long u = sa_util_cpu(ts, cpu);
+	sa_task_t *p;
+
+	if (u + 1 >= SA_UTIL_ONE) {
+		return 0;
+	}
+
+	/* the remaining capacity, which is also bounded by the window.
+	   the total utilization is kept below 100%, since the window is
+	   a constrained deadline. */
+	runtime = min_ulong((SA_UTIL_ONE - u - 1) * t->T / SA_UTIL_ONE,
+						t->window);
+	if (runtime == 0) {
+		return 0;
+	}
+	t->runtime[cpu] = runtime;
+	Lmax = sa_dbf_len(ts, t, cpu);
+
+	/* check for deadlines of tasks assigned to @cpu, and then for the
+	   deadlines of @t. */
+	for_each_task_on_cpu(ts, p, cpu) {
+		if (p != t &&
+			!edf_wm_limit_runtime(ts, t, p, cpu, &runtime, &Lmax)) {
+			goto out;
+		}
+	}
+	edf_wm_limit_runtime(ts, t, t, cpu, &runtime, &Lmax);
+
+ out:
+	t->runtime[cpu] = 0;
+	return runtime;
+}
+
+/**
+ * try to split @t across multiple CPUs with window-constrained migration
+ * (EDF-WM): the deadline is divided into equal windows, and a piece runs
+ * on each of the CPUs with the largest capacities in order of CPU IDs.
+ * if @fair is true, the surplus of the capacities is taken fairly from
+ * every piece, otherwise from the last piece.
+ * on success, @t->runtime[] and @t->window hold the pieces and the first
+ * CPU is returned.
+ */
+int sa_edf_wm_split(sa_taskset_t *ts, sa_task_t *t, int fair)
+{
+	int i, j, tmp;
+	int num, cpu;
+	int cpu_id[SA_NR_CPUS];
+	unsigned long runtime[SA_NR_CPUS];
+	unsigned long sum_runtime, over;
+
+	for (num = 2; num <= ts->nr_cpus; num++) {
+		sa_clear_split(t);
+		if ((t->window = t->D / num) == 0) {
+			break;
+		}
+
+		for (cpu = 0; cpu < ts->nr_cpus; cpu++) {
+			cpu_id[cpu] = cpu;
+			runtime[cpu] = sa_cpu_is_allowed(t, cpu) ?
+				edf_wm_split_runtime(ts, t, cpu) : 0;
+		}
+
+		/* select the largest num values. */
+		for (i = 0; i < num; i++) {
+			for (j = ts->nr_cpus - 1; j > i; j--) {
+				if (runtime[cpu_id[j]] > runtime[cpu_id[j-1]]) {
+					tmp = cpu_id[j];
+					cpu_id[j] = cpu_id[j-1];
+					cpu_id[j-1] = tmp;
+				}
+			}
+		}
+		sum_runtime = 0;
+		for (i = 0; i < num; i++) {
+			sum_runtime += runtime[cpu_id[i]];
+		}
+		if (sum_runtime < t->C) {
+			continue;
+		}
+
+		for (i = 0; i < num; i++) {
+			t->runtime[cpu_id[i]] = runtime[cpu_id[i]];
+		}
+
+		/* give back the surplus. */
+		over = sum_runtime - t->C;
+		if (fair) {
+			for (i = 0; i < num; i++) {
+				tmp = cpu_id[i];
+				sum_runtime = min_ulong(over / num, t->runtime[tmp]);
+				t->runtime[tmp] -= sum_runtime;
+				over -= sum_runtime;
+			}
+		}
+		for (cpu = ts->nr_cpus - 1; cpu >= 0 && over > 0; cpu--) {
+			sum_runtime = min_ulong(over, t->runtime[cpu]);
+			t->runtime[cpu] -= sum_runtime;
+			over -= sum_runtime;
+		}
+
+		for (cpu = 0; cpu < ts->nr_cpus; cpu++) {
+			if (t->runtime[cpu] > 0) {
+				if (t->first_cpu == SA_CPU_UNDEFINED) {
+					t->first_cpu = cpu;
+				}
+				t->last_cpu = cpu;
+			}
+		}
+		return t->first_cpu;
+	}
+
+	sa_clear_split(t);
+	return SA_CPU_UNDEFINED;
+}
+EXPORT_SYMBOL(sa_edf_wm_split);
+
+#ifdef __KERNEL__
+static unsigned long sa_overhead(sa_task_t *t, int cpu, unsigned long L)
+{
+	return sched_overhead_cpu(cpu, L) +
+		sched_overhead_task((resch_task_t *)t->priv, L);
+}
+
+/* the tasks in the global list seen by the analysis, by RESCH ID.
+   the per-CPU lists follow the lists of the core, which calls
+   sa_global_insert() and sa_global_remove(), so that admission touches
+   only the tasks on the CPUs being analyzed. */
+static sa_task_t sa_global_task[NR_RT_TASKS];
+static sa_taskset_t sa_global_ts;
+/* true if the tasks are analyzed by their WCETs. */
+static int sa_global_wcet = false;
+
+/**
+ * copy the timing properties of @rt to @t. the CPUs and the pieces of
+ * split @t are left as they are.
+ */
+static void sa_task_from_resch(sa_task_t *t, resch_task_t *rt)
+{
+	int cpu;
+
+	t->C = sa_global_wcet ? rt->wcet : rt->runtime;
+	t->T = jiffies_to_usecs(rt->period);
+	t->D = jiffies_to_usecs(rt->deadline);
+	t->prio = rt->prio;
+	t->cpus = 0;
+	for (cpu = 0; cpu < NR_RT_CPUS; cpu++) {
+		if (cpu_isset(cpu, rt->task->cpus_allowed)) {
+			t->cpus |= 1UL << cpu;
+		}
+	}
+	t->priv = rt;
+}
+
+/**
+ * called by the core when @rt is inserted into the list of @cpu, which
+ * may be RESCH_CPU_UNDEFINED. the properties of @rt are renewed here.
+ * the global list must be locked.
+ */
+void sa_global_insert(resch_task_t *rt, int cpu)
+{
+	sa_task_t *t = &sa_global_task[rt->rid];
+
+	/* a task with no CPU has no pieces, but may have stale ones of the
+	   task that had the same RESCH ID. */
+	if (cpu == RESCH_CPU_UNDEFINED) {
+		sa_clear_split(t);
+	}
+	sa_task_from_resch(t, rt);
+	sa_assign(&sa_global_ts, t, cpu);
+}
+
+/**
+ * called by the core when @rt is removed from the list of its CPU.
+ * the global list must be locked.
+ */
+void sa_global_remove(resch_task_t *rt)
+{
+	sa_unassign(&sa_global_ts, &sa_global_task[rt->rid]);
+}
+
+/**
+ * analyze the tasks by their WCETs if @wcet is true, otherwise by the
+ * execution times of the configuration. the tasks in the global list are
+ * indexed again, so this should be called only when a plugin is loaded.
+ */
+void sa_global_use_wcet(int wcet)
+{
+	resch_task_t *p;
+
+	global_list_down();
+	if (sa_global_wcet != wcet) {
+		for (p = global_highest_prio_task(); p; p = global_next_prio_task(p)) {
+			sa_global_remove(p);
+		}
+		sa_global_wcet = wcet;
+		for (p = global_highest_prio_task(); p; p = global_next_prio_task(p)) {
+			sa_global_insert(p, p->assigned.cpu);
+		}
+	}
+	global_list_up();
+}
+EXPORT_SYMBOL(sa_global_use_wcet);
+
+/**
+ * take @rt out of the analysis with its pieces cleared, and return its
+ * entry in the tasks seen by the analysis, which is pointed to by @*ts.
+ * the plugin then assigns @rt by assign_task_cpu(), which puts it back
+ * to the analysis, with the pieces if they are set to the entry.
+ * the global list must be locked.
+ */
+sa_task_t *sa_global_admit(sa_taskset_t **ts, resch_task_t *rt)
+{
+	int cpu;
+	sa_task_t *t = &sa_global_task[rt->rid];
+
+	sa_unassign(&sa_global_ts, t);
+	sa_clear_split(t);
+	sa_task_from_resch(t, rt);
+	for (cpu = 0; cpu < SA_NR_CPUS; cpu++) {
+		sa_global_ts.cpu_available[cpu] = true;
+	}
+
+	*ts = &sa_global_ts;
+	return t;
+}
+EXPORT_SYMBOL(sa_global_admit);
+
+/**
+ * initialize the tasks seen by the analysis, with no tasks assigned.
+ */
+void sa_global_init(void)
+{
+	int i;
+
+	for (i = 0; i < NR_RT_TASKS; i++) {
+		sa_task_init(&sa_global_task[i], 0, 0, 0, 0);
+	}
+	sa_taskset_init(&sa_global_ts, sa_global_task, NR_RT_TASKS, NR_RT_CPUS);
+	sa_global_ts.overhead = sa_overhead;
+	index_build(&sa_global_ts);
+}
+#endif
@@ -0,0 +1,169 @@
+/*
+ * callback.c		Copyright (C) Shinpei Kato
+ *
+ * Accounting of ROS callbacks.
+ * Each CPU updates only its own statistics, with preemption disabled,
+ * and a sequence count per node lets readers in user space see
+ * consistent values without locks. callback_area_init() and
+ * callback_account() are also compiled into the user-space tests.
+ */
+
+#ifdef __KERNEL__
+#include <linux/mm.h>
+#include <linux/module.h>
+#include <linux/vmalloc.h>
+#define callback_wmb()	smp_wmb()
+#else
+#include <string.h>
+#define callback_wmb()	__sync_synchronize()
+#define true	1
+#define false	0
+#endif
+#include "callback.h"
+
+static inline int hash_index(int index)
+{
+	return (int)(((unsigned int)index * 2654435761U) &
+				 (RESCH_CB_MAX_NODES - 1));
+}
+
+static inline int hist_bucket(unsigned long long ns)
+{
+	int k = 0;
+
+	while (k < RESCH_CB_NR_BUCKETS - 1 && (ns >> (k + 1)) != 0) {
+		k++;
+	}
+	return k;
+}
+
+/**
+ * return the statistics of the node with @index on the CPU, which are
+ * newly taken if not yet, or NULL if no statistics are left.
+ */
+static struct resch_cb_stat *find_stat(struct resch_cb_cpu *c, int index)
+{
+	int i, h = hash_index(index);
+	struct resch_cb_stat *s;
+
+	for (i = 0; i < RESCH_CB_MAX_NODES; i++) {
+		s = &c->stat[h];
+		if (s->index == index) {
+			return s;
+		}
+		if (s->index == -1) {
+			s->index = index;
+			return s;
+		}
+		h = (h + 1) & (RESCH_CB_MAX_NODES - 1);
+	}
+	return NULL;
+}
+
+/**
+ * clear @area for @nr_cpus CPUs.
+ */
+void callback_area_init(struct resch_cb_area *area, unsigned int nr_cpus)
+{
+	unsigned int cpu, i;
+	struct resch_cb_cpu *c;
+
+	area->nr_cpus = nr_cpus;
+	area->nr_nodes = RESCH_CB_MAX_NODES;
+	area->nr_buckets = RESCH_CB_NR_BUCKETS;
+	area->reserved = 0;
+	for (cpu = 0; cpu < NR_RT_CPUS; cpu++) {
+		c = &area->cpu[cpu];
+		c->nr_dropped = 0;
+		for (i = 0; i < RESCH_CB_MAX_NODES; i++) {
+			memset(&c->stat[i], 0, sizeof(struct resch_cb_stat));
+			c->stat[i].index = -1;
+		}
+	}
+}
+
+/**
+ * account a callback of the node with @index that has executed for
+ * @exec nsecs on the CPU of @c. @budget is in nsecs, and 0 means none.
+ * the caller must not be preempted by another caller on the same CPU.
+ * return true if the callback exceeded the budget.
+ */
+int callback_account(struct resch_cb_cpu *c, int index,
+					 unsigned long long exec, unsigned long long budget)
+{
+	int overrun = budget > 0 && exec > budget;
+	struct resch_cb_stat *s = find_stat(c, index);
+
+	if (!s) {
+		c->nr_dropped++;
+		return overrun;
+	}
+
+	s->seq++;
+	callback_wmb();
+	if (s->count == 0 || exec < s->min) {
+		s->min = exec;
+	}
+	if (exec > s->max) {
+		s->max = exec;
+	}
+	s->count++;
+	s->total += exec;
+	s->last = exec;
+	s->hist[hist_bucket(exec)]++;
+	if (overrun) {
+		s->overruns++;
+	}
+	callback_wmb();
+	s->seq++;
+
+	return overrun;
+}
+
+#ifdef __KERNEL__
+/* the statistics mapped by user applications, or NULL if none. */
+struct resch_cb_area *callback_area = NULL;
+
+static inline unsigned long callback_area_size(void)
+{
+	return PAGE_ALIGN(sizeof(struct resch_cb_area));
+}
+
+/**
+ * map the statistics to @vma read-only.
+ */
+int callback_mmap(struct vm_area_struct *vma)
+{
+	if (!callback_area) {
+		return -ENODEV;
+	}
+	if (vma->vm_flags & VM_WRITE) {
+		return -EPERM;
+	}
+	if (vma->vm_pgoff != 0 ||
+		vma->vm_end - vma->vm_start > callback_area_size()) {
+		return -EINVAL;
+	}
+	vma->vm_flags &= ~VM_MAYWRITE;
+
+	return remap_vmalloc_range(vma, callback_area, 0);
+}
+
+void callback_init(void)
+{
+	callback_area = vmalloc_user(callback_area_size());
+	if (!callback_area) {
+		printk(KERN_WARNING "RESCH: failed to allocate callback area.\n");
+		return;
+	}
+	callback_area_init(callback_area, NR_RT_CPUS);
+}
+
+void callback_exit(void)
+{
+	if (callback_area) {
+		vfree(callback_area);
+		callback_area = NULL;
+	}
+}
+#endif
@@ -0,0 +1,19 @@
+#ifndef __RESCH_CALLBACK__
+#define __RESCH_CALLBACK__
+
+#include <resch-callback.h>
+
+/* accounting, shared with the user-space tests. */
+void callback_area_init(struct resch_cb_area *, unsigned int);
+int callback_account(struct resch_cb_cpu *, int,
+					 unsigned long long, unsigned long long);
+
+#ifdef __KERNEL__
+struct vm_area_struct;
+extern struct resch_cb_area *callback_area;
+int callback_mmap(struct vm_area_struct *);
+void callback_init(void);
+void callback_exit(void);
+#endif
+
+#endif
@@ -1,11 +1,97 @@
+/*
+ * component.c		Copyright (C) Shinpei Kato
+ *
+ * Hierarchical scheduling by components.
+ * Each component has a budget replenished at every period, and all the
+ * tasks composed into it are charged their execution time every tick.
+ * Once the budget runs out, the tasks are scheduled in background until
+ * the next replenishment, so that the component cannot steal the CPU
+ * time of the others. component_budget_init(), component_budget_charge()
+ * and component_budget_replenish() are also compiled into the user-space
+ * tests.
+ */
+
+#ifdef __KERNEL__
 #include <asm/current.h>
+#include <linux/kthread.h>
+#include <linux/ktime.h>
 #include <linux/list.h>
+#include <linux/sched.h>
 #include <linux/semaphore.h>
+#include <linux/timer.h>
 #include "resch-api.h"
 #include "resch-core.h"
 #include "bitops.h"
 #include "component.h"
 #include "sched.h"
+#else
+#include "component.h"
+#define true	1
+#define false	0
+#endif
+
+/**
+ * set up @b with @period and @budget, starting a period at @now.
+ * all by nsecs.
+ */
+void component_budget_init(struct component_budget *b,
+						   unsigned long long period,
+						   unsigned long long budget,
+						   unsigned long long now)
+{
+	b->period = period;
+	b->budget = budget;
+	b->remaining = budget;
+	b->replenish_time = now + period;
+	b->nr_depleted = 0;
+	b->depleted = false;
+}
+
+/**
+ * charge @exec nsecs to @b.
+ * return true if the budget has just run out.
+ */
+int component_budget_charge(struct component_budget *b,
+							unsigned long long exec)
+{
+	if (b->period == 0 || b->budget == 0 || b->depleted) {
+		return false;
+	}
+	if (exec < b->remaining) {
+		b->remaining -= exec;
+		return false;
+	}
+	b->remaining = 0;
+	b->depleted = true;
+	b->nr_depleted++;
+
+	return true;
+}
+
+/**
+ * replenish @b, if a new period has started by @now.
+ * periods that passed without being noticed are skipped.
+ * return true if the budget had run out.
+ */
+int component_budget_replenish(struct component_budget *b,
+							   unsigned long long now)
+{
+	int depleted = b->depleted;
+
+	if (b->period == 0 || now < b->replenish_time) {
+		return false;
+	}
+	b->replenish_time += ((now - b->replenish_time) / b->period + 1) *
+		b->period;
+	b->remaining = b->budget;
+	b->depleted = false;
+
+	return depleted;
+}
+
+#ifdef __KERNEL__
+/* the interval to charge the budgets, by jiffies. */
+#define COMPONENT_TICK	1
 
 struct cid_map_struct cid_map;
 
@@ -21,44 +107,229 @@ struct cid_map_struct {
 
 /**
  * component control block.
+ * the task list is changed holding both @sem and @lock, so that it can
+ * be walked holding either of them.
  */
 struct component_struct {
 	unsigned long priority;
-	unsigned long period;
-	unsigned long budget;
+	unsigned long period;			/* by microseconds */
+	unsigned long budget;			/* by microseconds */
 	struct semaphore sem;
 	struct list_head task_list;
+	spinlock_t lock;
+	struct component_budget account;
+	struct timer_list timer;
+	/* the tasks have to be throttled or resumed. */
+	int dirty;
 } component[NR_RT_COMPONENTS];
 
+/* the thread to change the priorities of throttled tasks. */
+static struct task_struct *component_thread = NULL;
+
+static inline int component_valid(int cid)
+{
+	return cid >= 0 && cid < NR_RT_COMPONENTS &&
+		test_bit(cid, cid_map.bitmap);
+}
+
+static inline void component_wake(struct component_struct *c)
+{
+	if (c->dirty && component_thread) {
+		wake_up_process(component_thread);
+	}
+}
+
 /**
- * API: create a new component in hierarchical scheduling. 
- * return the ID of the created component. 
+ * schedule @rt in background, saving the original priority.
  */
-int api_component_create(void)
+static void component_throttle(resch_task_t *rt)
+{
+	if (rt->comp_prio < 0 && rt->prio > RESCH_PRIO_BACKGROUND) {
+		rt->comp_prio = rt->prio;
+		set_scheduler(rt, rt->policy, RESCH_PRIO_BACKGROUND);
+	}
+}
+
+/**
+ * put back the original priority of @rt.
+ */
+static void component_resume(resch_task_t *rt)
+{
+	if (rt->comp_prio >= 0) {
+		set_scheduler(rt, rt->policy, rt->comp_prio);
+		rt->comp_prio = -1;
+	}
+}
+
+/**
+ * throttle or resume all the tasks of @c, according to the budget.
+ */
+static void component_apply(struct component_struct *c)
+{
+	int depleted;
+	unsigned long flags;
+	resch_task_t *rt;
+
+	down(&c->sem);
+	spin_lock_irqsave(&c->lock, flags);
+	depleted = c->account.depleted;
+	c->dirty = false;
+	spin_unlock_irqrestore(&c->lock, flags);
+
+	list_for_each_entry(rt, &c->task_list, component_entry) {
+		if (depleted) {
+			component_throttle(rt);
+		}
+		else {
+			component_resume(rt);
+		}
+	}
+	up(&c->sem);
+}
+
+static int component_thread_main(void *__data)
 {
 	int cid;
 
+	while (!kthread_should_stop()) {
+		set_current_state(TASK_INTERRUPTIBLE);
+		for (cid = 0; cid < NR_RT_COMPONENTS; cid++) {
+			if (component[cid].dirty) {
+				break;
+			}
+		}
+		if (cid == NR_RT_COMPONENTS) {
+			schedule();
+			continue;
+		}
+		__set_current_state(TASK_RUNNING);
+		for (; cid < NR_RT_COMPONENTS; cid++) {
+			if (component[cid].dirty) {
+				component_apply(&component[cid]);
+			}
+		}
+	}
+	__set_current_state(TASK_RUNNING);
+
+	return 0;
+}
+
+/**
+ * called every tick while the component pointed to by @__data has tasks.
+ * the tasks are charged the time they executed since the last tick.
+ */
+static void component_tick(unsigned long __data)
+{
+	struct component_struct *c = (struct component_struct *)__data;
+	unsigned long long now = ktime_to_ns(ktime_get());
+	unsigned long long runtime, exec = 0;
+	resch_task_t *rt;
+
+	spin_lock(&c->lock);
+	list_for_each_entry(rt, &c->task_list, component_entry) {
+		runtime = rt->task->se.sum_exec_runtime;
+		exec += runtime - rt->comp_runtime;
+		rt->comp_runtime = runtime;
+	}
+	if (component_budget_charge(&c->account, exec)) {
+		c->dirty = true;
+	}
+	if (component_budget_replenish(&c->account, now)) {
+		c->dirty = true;
+	}
+	if (!list_empty(&c->task_list)) {
+		mod_timer(&c->timer, jiffies + COMPONENT_TICK);
+	}
+	spin_unlock(&c->lock);
+
+	component_wake(c);
+}
+
+/**
+ * restart the budget of @c, and the tick if it has tasks.
+ * the caller must hold @c->lock.
+ */
+static void component_restart(struct component_struct *c)
+{
+	if (c->account.depleted) {
+		c->dirty = true;
+	}
+	component_budget_init(&c->account, (unsigned long long)c->period * 1000,
+						  (unsigned long long)c->budget * 1000,
+						  ktime_to_ns(ktime_get()));
+	if (c->period > 0 && !list_empty(&c->task_list) &&
+		!timer_pending(&c->timer)) {
+		mod_timer(&c->timer, jiffies + COMPONENT_TICK);
+	}
+}
+
+/**
+ * API: create a new component in hierarchical scheduling.
+ * if @cid is not negative, the component of @cid is created unless it
+ * already exists. tasks of different processes can still be composed
+ * into an existing component, but only its creator should configure it.
+ * return the ID of the component, or -1 if none is available.
+ */
+int api_component_create(int cid)
+{
+	struct component_struct *c;
+
 	spin_lock_irq(&cid_map.lock);
-	/* get the available component ID. */
-	if ((cid = resch_ffz(cid_map.bitmap, CID_MAP_LONG)) < 0) {
-		cid = RES_FAULT;
+	if (cid < 0) {
+		/* get the available component ID. */
+		cid = resch_ffz(cid_map.bitmap, CID_MAP_LONG);
+	}
+	else if (cid < NR_RT_COMPONENTS && test_bit(cid, cid_map.bitmap)) {
+		cid = -1;
+		goto unlock;
+	}
+	if (cid < 0 || cid >= NR_RT_COMPONENTS) {
+		cid = -1;
 		goto unlock;
 	}
 	__set_bit(cid, cid_map.bitmap);
- unlock:
-	spin_unlock_irq(&cid_map.lock);
 
 	/* initialize the component. */
-	INIT_LIST_HEAD(&component[cid].task_list);
+	c = &component[cid];
+	INIT_LIST_HEAD(&c->task_list);
+	c->priority = 0;
+	c->period = 0;
+	c->budget = 0;
+	c->dirty = false;
+	component_budget_init(&c->account, 0, 0, 0);
+ unlock:
+	spin_unlock_irq(&cid_map.lock);
 
 	return cid;
 }
 
 /**
- * API: destroy the given component in hierarchical scheduling. 
+ * API: destroy the given component in hierarchical scheduling.
+ * the tasks are decomposed from it.
  */
 int api_component_destroy(int cid)
 {
+	unsigned long flags;
+	struct component_struct *c;
+	resch_task_t *rt, *next;
+
+	if (!component_valid(cid)) {
+		return RES_FAULT;
+	}
+	c = &component[cid];
+
+	down(&c->sem);
+	del_timer_sync(&c->timer);
+	list_for_each_entry_safe(rt, next, &c->task_list, component_entry) {
+		component_resume(rt);
+		spin_lock_irqsave(&c->lock, flags);
+		list_del_init(&rt->component_entry);
+		spin_unlock_irqrestore(&c->lock, flags);
+		rt->comp_id = -1;
+	}
+	c->dirty = false;
+	up(&c->sem);
+
 	spin_lock_irq(&cid_map.lock);
 	__clear_bit(cid, cid_map.bitmap);
 	spin_unlock_irq(&cid_map.lock);
@@ -67,49 +338,159 @@ int api_component_destroy(int cid)
 }
 
 /**
- * API: compose the current task into the given component. 
+ * API: set the period of the given component by microseconds.
+ * the budget starts over.
+ */
+int api_component_period(int cid, unsigned long period)
+{
+	unsigned long flags;
+	struct component_struct *c;
+
+	if (!component_valid(cid)) {
+		return RES_FAULT;
+	}
+	c = &component[cid];
+
+	spin_lock_irqsave(&c->lock, flags);
+	c->period = period;
+	component_restart(c);
+	spin_unlock_irqrestore(&c->lock, flags);
+	component_wake(c);
+
+	return RES_SUCCESS;
+}
+
+/**
+ * API: set the budget of the given component by microseconds.
+ * the budget starts over.
+ */
+int api_component_budget(int cid, unsigned long budget)
+{
+	unsigned long flags;
+	struct component_struct *c;
+
+	if (!component_valid(cid)) {
+		return RES_FAULT;
+	}
+	c = &component[cid];
+
+	spin_lock_irqsave(&c->lock, flags);
+	c->budget = budget;
+	component_restart(c);
+	spin_unlock_irqrestore(&c->lock, flags);
+	component_wake(c);
+
+	return RES_SUCCESS;
+}
+
+/**
+ * API: compose the current task into the given component.
+ * the component must have been given a period by its creator, which
+ * sets the budget first. RES_ILLEGAL is returned until then, so that
+ * tasks of other processes can wait for the component to be configured.
  */
 int api_compose(int rid, int cid)
 {
+	unsigned long flags;
+	struct component_struct *c;
 	resch_task_t *rt = resch_task_ptr(rid);
-	if (cid >= NR_RT_COMPONENTS) {
+
+	if (!component_valid(cid)) {
 		return RES_FAULT;
 	}
-	if (test_bit(cid, cid_map.bitmap)) {
-		return RES_FAULT;
+	if (component[cid].period == 0) {
+		return RES_ILLEGAL;
 	}
-	if (!list_empty(&rt->component_entry)) {
+	if (rt->comp_id >= 0) {
 		return RES_FAULT;
 	}
+	c = &component[cid];
+
+	down(&c->sem);
+	spin_lock_irqsave(&c->lock, flags);
+	rt->comp_id = cid;
+	rt->comp_prio = -1;
+	rt->comp_runtime = rt->task->se.sum_exec_runtime;
+	list_add_tail(&rt->component_entry, &c->task_list);
+	if (c->account.depleted) {
+		c->dirty = true;
+	}
+	if (c->period > 0 && !timer_pending(&c->timer)) {
+		mod_timer(&c->timer, jiffies + COMPONENT_TICK);
+	}
+	spin_unlock_irqrestore(&c->lock, flags);
+	up(&c->sem);
+	component_wake(c);
 
-	list_add_tail(&rt->component_entry, 
-				  &component[cid].task_list);
 	return RES_SUCCESS;
 }
 
 /**
- * API: decompose the current task from the associated component. 
+ * API: decompose the current task from the associated component.
  */
 int api_decompose(int rid)
 {
+	unsigned long flags;
+	struct component_struct *c;
 	resch_task_t *rt = resch_task_ptr(rid);
-	if (list_empty(&rt->component_entry)) {
+
+	if (rt->comp_id < 0) {
 		return RES_FAULT;
 	}
-	else {
-		list_del_init(&rt->component_entry);
-		return RES_SUCCESS;
-	}
+	c = &component[rt->comp_id];
+
+	down(&c->sem);
+	component_resume(rt);
+	spin_lock_irqsave(&c->lock, flags);
+	list_del_init(&rt->component_entry);
+	spin_unlock_irqrestore(&c->lock, flags);
+	rt->comp_id = -1;
+	up(&c->sem);
+
+	return RES_SUCCESS;
 }
 
 void component_init(void)
 {
 	int i;
+	struct sched_param sp = { .sched_priority = RESCH_PRIO_KTHREAD };
+
 	for (i = 0; i < CID_MAP_LONG; i++) {
 		cid_map.bitmap[i] = 0;
 	}
+	spin_lock_init(&cid_map.lock);
+
+	for (i = 0; i < NR_RT_COMPONENTS; i++) {
+		sema_init(&component[i].sem, 1);
+		spin_lock_init(&component[i].lock);
+		INIT_LIST_HEAD(&component[i].task_list);
+		setup_timer(&component[i].timer, component_tick,
+					(unsigned long)&component[i]);
+		component[i].dirty = false;
+	}
+
+	/* it must preempt the tasks to be throttled. */
+	component_thread = kthread_create(component_thread_main, NULL,
+									  "resch-component");
+	if (IS_ERR(component_thread)) {
+		printk(KERN_INFO "RESCH: failed to create a kernel thread\n");
+		component_thread = NULL;
+		return;
+	}
+	sched_setscheduler(component_thread, SCHED_FIFO, &sp);
+	wake_up_process(component_thread);
 }
 
 void component_exit(void)
 {
+	int i;
+
+	for (i = 0; i < NR_RT_COMPONENTS; i++) {
+		del_timer_sync(&component[i].timer);
+	}
+	if (component_thread) {
+		kthread_stop(component_thread);
+		component_thread = NULL;
+	}
 }
+#endif /* __KERNEL__ */
@@ -1,12 +1,36 @@
 #ifndef __RESCH_COMPONENT_H__
 #define __RESCH_COMPONENT_H__
 
-int api_component_create(void);
+/**
+ * the budget of a component, replenished at every period.
+ * a component without the period or the budget is not limited.
+ */
+struct component_budget {
+	unsigned long long period;			/* by nsecs */
+	unsigned long long budget;			/* by nsecs */
+	unsigned long long remaining;		/* by nsecs */
+	unsigned long long replenish_time;	/* by nsecs */
+	unsigned long long nr_depleted;	/* periods in which it ran out. */
+	int depleted;
+};
+
+/* accounting, shared with the user-space tests. */
+void component_budget_init(struct component_budget *,
+						   unsigned long long, unsigned long long,
+						   unsigned long long);
+int component_budget_charge(struct component_budget *, unsigned long long);
+int component_budget_replenish(struct component_budget *, unsigned long long);
+
+#ifdef __KERNEL__
+int api_component_create(int);
 int api_component_destroy(int);
+int api_component_period(int, unsigned long);
+int api_component_budget(int, unsigned long);
 int api_compose(int, int);
 int api_decompose(int);
 
 void component_init(void);
 void component_exit(void);
+#endif
 
 #endif
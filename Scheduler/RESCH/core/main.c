@@ -15,15 +15,19 @@
 #include <linux/cdev.h>
 #include <linux/fs.h>
 #include <linux/module.h>
+#include <linux/slab.h>
 #include <resch-api.h>
 #include <resch-config.h>
 #include <resch-core.h>
 #include <resch-gpu-core.h>
+#include "callback.h"
 #include "component.h"
 #include "event.h"
 #include "main.h"
 #include "reservation.h"
 #include "sched.h"
+#include "sched_ros.h"
+#include "switch_trace.h"
 #include "test.h"
 
 /* device number. */
@@ -38,6 +42,97 @@ static inline unsigned long timespec_to_usecs(struct timespec *ts)
 	return s * 1000000 + ns / 1000;
 }
 
+/**
+ * apply the attributes in the same order as the separate APIs are
+ * usually called: timing parameters first, then the policy before the
+ * priority since the priority is refused for EDF and FAIR.
+ */
+static int resch_set_attr(int rid, struct api_attr_struct *attr)
+{
+	int res = RES_SUCCESS;
+	unsigned long us;
+
+	if (attr->mask & API_ATTR_WCET) {
+		us = timespec_to_usecs(&attr->wcet);
+		res |= api_set_wcet(rid, us);
+	}
+	if (attr->mask & API_ATTR_PERIOD) {
+		us = timespec_to_usecs(&attr->period);
+		res |= api_set_period(rid, usecs_to_jiffies(us));
+	}
+	if (attr->mask & API_ATTR_DEADLINE) {
+		us = timespec_to_usecs(&attr->deadline);
+		res |= api_set_deadline(rid, usecs_to_jiffies(us));
+	}
+	if (attr->mask & API_ATTR_POLICY) {
+		res |= api_set_scheduler(rid, attr->policy);
+	}
+	if (attr->mask & API_ATTR_PRIORITY) {
+		res |= api_set_priority(rid, attr->prio);
+	}
+	if (attr->mask & API_ATTR_AFFINITY) {
+		res |= api_set_affinity(rid, attr->cpus);
+	}
+
+	return res ? RES_FAULT : RES_SUCCESS;
+}
+
+/**
+ * copy the graph of ROS nodes from user space and build it aside, so
+ * that api_set_dag() only has to replace the graph in use.
+ * memory is allocated here, and never in the callbacks.
+ */
+static int resch_set_dag(struct api_dag_struct *arg)
+{
+	int i, res = RES_FAULT;
+	struct api_dag_node_struct *nodes = NULL;
+	struct api_dag_edge_struct *edges = NULL;
+	ros_dag_t *dag;
+
+	if (arg->nr_nodes <= 0 || arg->nr_nodes > ROS_DAG_MAX_NODES ||
+		arg->nr_edges < 0 || arg->nr_edges > ROS_DAG_MAX_EDGES) {
+		return RES_ILLEGAL;
+	}
+
+	dag = kmalloc(sizeof(ros_dag_t), GFP_KERNEL);
+	nodes = kmalloc(sizeof(*nodes) * arg->nr_nodes, GFP_KERNEL);
+	edges = kmalloc(sizeof(*edges) * (arg->nr_edges + 1), GFP_KERNEL);
+	if (!dag || !nodes || !edges) {
+		goto out;
+	}
+	if (copy_from_user(nodes, arg->nodes, sizeof(*nodes) * arg->nr_nodes) ||
+		copy_from_user(edges, arg->edges, sizeof(*edges) * arg->nr_edges)) {
+		printk(KERN_WARNING "RESCH: failed to copy the ROS graph.\n");
+		goto out;
+	}
+
+	res = RES_ILLEGAL;
+	ros_dag_init(dag);
+	for (i = 0; i < arg->nr_nodes; i++) {
+		if (!ros_dag_add_node(dag, nodes[i].index, nodes[i].pid,
+							  timespec_to_usecs(&nodes[i].wcet))) {
+			goto out;
+		}
+		dag->node[i].budget = timespec_to_usecs(&nodes[i].budget);
+	}
+	for (i = 0; i < arg->nr_edges; i++) {
+		if (!ros_dag_add_edge(dag, edges[i].from, edges[i].to)) {
+			goto out;
+		}
+	}
+	if (!ros_dag_build(dag)) {
+		printk(KERN_WARNING "RESCH: the ROS graph has a cycle.\n");
+		goto out;
+	}
+	res = api_set_dag(dag);
+
+ out:
+	kfree(edges);
+	kfree(nodes);
+	kfree(dag);
+	return res;
+}
+
 /* dummy function. */
 static int resch_open(struct inode *inode, struct file *filp)
 {
@@ -50,6 +145,19 @@ static int resch_release(struct inode *inode, struct file *filp)
 	return 0;
 }
 
+/**
+ * the statistics of ROS callbacks, or the context switches traced at
+ * RESCH_TRACE_MMAP_OFFSET, are mapped read-only.
+ * see resch-callback.h and resch-trace.h for details.
+ */
+static int resch_mmap(struct file *filp, struct vm_area_struct *vma)
+{
+	if (vma->vm_pgoff == RESCH_TRACE_MMAP_OFFSET >> PAGE_SHIFT) {
+		return switch_trace_mmap(vma);
+	}
+	return callback_mmap(vma);
+}
+
 /**
  * RESCH APIs are called through write() system call.
  * See api.h for details.
@@ -62,6 +170,12 @@ static ssize_t resch_write
 	struct api_struct a;
 	unsigned long us;
 
+	/* the user structures are prefixes of struct api_struct. */
+	if (count > sizeof(a)) {
+		printk(KERN_WARNING "RESCH: too large data.\n");
+		return -EINVAL;
+	}
+
 	/* copy data to kernel buffer. */
 	if (copy_from_user(&a, buf, count)) {
 		printk(KERN_WARNING "RESCH: failed to copy data.\n");
@@ -177,13 +291,23 @@ static ssize_t resch_write
 		/* PORT IV.*/
 		/* PORT V: hierarchical scheduling.*/
 	case API_COMPONENT_CREATE:
-		res = api_component_create();
+		res = api_component_create(a.arg.val);
 		break;
 
 	case API_COMPONENT_DESTROY:
 		res = api_component_destroy(a.arg.val);
 		break;
 
+	case API_COMPONENT_PERIOD:
+		us = timespec_to_usecs(&a.arg.comp.ts);
+		res = api_component_period(a.arg.comp.cid, us);
+		break;
+
+	case API_COMPONENT_BUDGET:
+		us = timespec_to_usecs(&a.arg.comp.ts);
+		res = api_component_budget(a.arg.comp.cid, us);
+		break;
+
 	case API_COMPOSE:
 		res = api_compose(a.rid, a.arg.val);
 		break;
@@ -192,6 +316,15 @@ static ssize_t resch_write
 		res = api_decompose(a.rid);
 		break;
 
+		/* extensions. */
+	case API_SET_ATTR:
+		res = resch_set_attr(a.rid, &a.arg.attr);
+		break;
+
+	case API_SET_DAG:
+		res = resch_set_dag(&a.arg.dag);
+		break;
+
 	default: /* illegal api identifier. */
 		res = RES_ILLEGAL;
 		printk(KERN_WARNING "RESCH: illegal API identifier.\n");
@@ -283,6 +416,7 @@ static struct file_operations resch_fops = {
 	.release = resch_release, /* do nothing but must exist. */
 	.read = NULL,
 	.write = resch_write,
+	.mmap = resch_mmap,
 #if LINUX_VERSION_CODE >= KERNEL_VERSION(3,7,0)
 	.unlocked_ioctl = resch_ioctl
 #else
@@ -320,6 +454,8 @@ static int __init resch_init(void)
 
 	sched_init();
 	component_init();
+	callback_init();
+	switch_trace_init();
 
 	return 0;
 }
@@ -332,8 +468,10 @@ static void __exit resch_exit(void)
 	gsched_exit();
 #endif /* RTXG */
 
+	switch_trace_exit();
 	sched_exit();
 	component_exit();
+	callback_exit();
 
 	/* delete the char device. */
 	cdev_del(&c_dev);
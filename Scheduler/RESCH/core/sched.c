@@ -18,10 +18,14 @@
 #include <linux/kernel.h>
 #include <linux/kthread.h>
 #include <linux/list.h>
+#include <linux/math64.h>
 #include <linux/module.h>
+#include <linux/string.h>
+#include <resch-analysis.h>
 #include <resch-api.h>
 #include <resch-core.h>
 #include "bitops.h"
+#include "callback.h"
 #include "component.h"
 #include "reservation.h"
 #include "sched_ros.h"
@@ -189,6 +193,82 @@ static void requeue_task(resch_task_t *rt, int prio_old)
 	active_queue_unlock(cpu, &flags);
 }
 
+/**
+ * return the index of the CPU list for the given priority.
+ * the tasks without real-time priorities are put at the lowest level.
+ */
+static inline int cpu_list_index(int prio)
+{
+	return prio_index(max(prio, RESCH_PRIO_MIN));
+}
+
+/**
+ * return the utilization of @rt by parts per million, rounded up.
+ */
+static inline unsigned long task_util(resch_task_t *rt)
+{
+	unsigned long period = jiffies_to_usecs(rt->period);
+
+	if (period == 0) {
+		return 0;
+	}
+	return div_round_up(rt->runtime * 1000000, period);
+}
+
+/**
+ * insert @rt into the list of the given CPU, which may be
+ * RESCH_CPU_UNDEFINED, and add its utilization to the CPU.
+ * the global list must be locked.
+ */
+static void __cpu_list_insert(resch_task_t *rt, int cpu)
+{
+	int idx = cpu_list_index(rt->prio);
+	struct cpu_list_struct *cl = &lo[cpu].assigned;
+
+	list_add_tail(&rt->cpu_entry, &cl->queue[idx]);
+	__set_bit(idx, cl->bitmap);
+	cl->nr_tasks++;
+
+	rt->assigned.cpu = cpu;
+	rt->assigned.prio = rt->prio;
+	rt->assigned.util = task_util(rt);
+	cl->util += rt->assigned.util;
+
+	sa_global_insert(rt, cpu);
+}
+
+/**
+ * remove @rt from the list of the CPU in which it was inserted.
+ * the global list must be locked.
+ */
+static void __cpu_list_remove(resch_task_t *rt)
+{
+	int idx = cpu_list_index(rt->assigned.prio);
+	struct cpu_list_struct *cl = &lo[rt->assigned.cpu].assigned;
+
+	list_del_init(&rt->cpu_entry);
+	if (list_empty(&cl->queue[idx])) {
+		__clear_bit(idx, cl->bitmap);
+	}
+	cl->nr_tasks--;
+	cl->util -= rt->assigned.util;
+
+	sa_global_remove(rt);
+}
+
+/**
+ * renew the timing properties of @rt in the CPU list, if @rt is managed.
+ */
+static void cpu_list_update(resch_task_t *rt)
+{
+	global_list_down();
+	if (!list_empty(&rt->cpu_entry)) {
+		__cpu_list_remove(rt);
+		__cpu_list_insert(rt, rt->assigned.cpu);
+	}
+	global_list_up();
+}
+
 /**
  * insert @rt into the global list in order of priority.
  * the global list must be locked.
@@ -232,33 +312,47 @@ static void __global_list_remove(resch_task_t *rt)
 }
 
 /**
- * insert @rt into the global list safely with spin lock.
+ * insert @rt into the global list and the list of its CPU safely with
+ * spin lock.
  */
 static void global_list_insert(resch_task_t *rt)
 {
 	global_list_down();
 	__global_list_insert(rt);
+	if (list_empty(&rt->cpu_entry)) {
+		__cpu_list_insert(rt, rt->cpu_id);
+	}
 	global_list_up();
 }
 
 /**
- * remove @rt from the global list safely with spin lock.
+ * remove @rt from the global list and the list of its CPU safely with
+ * spin lock.
  */
 static void global_list_remove(resch_task_t *rt)
 {
 	global_list_down();
 	__global_list_remove(rt);
+	if (!list_empty(&rt->cpu_entry)) {
+		__cpu_list_remove(rt);
+	}
 	global_list_up();
 }
 
 /**
- * reinsert @rt into the global list safely with spin lock.
+ * reinsert @rt into the global list and the list of its CPU safely with
+ * spin lock. the CPU list is not changed even if @rt is now running on
+ * another CPU, e.g., as a split task.
  */
 static void global_list_reinsert(resch_task_t *rt)
 {
 	global_list_down();
 	__global_list_remove(rt);
 	__global_list_insert(rt);
+	if (!list_empty(&rt->cpu_entry)) {
+		__cpu_list_remove(rt);
+		__cpu_list_insert(rt, rt->assigned.cpu);
+	}
 	global_list_up();
 }
 
@@ -460,6 +554,7 @@ static void job_complete(resch_task_t *rt)
 	/* renew the WCET if necessary. */
 	if (!rt->wcet_fixed && jiffies_to_usecs(exec_time(rt)) > rt->wcet) {
 		rt->wcet = jiffies_to_usecs(exec_time(rt));
+		cpu_list_update(rt);
 	}
 
 	/* call a plugin function. */
@@ -841,6 +936,78 @@ resch_task_t* global_number_task(int num)
 }
 EXPORT_SYMBOL(global_number_task);
 
+/**
+ * return the highest-priority task assigned to the given CPU, which may
+ * be RESCH_CPU_UNDEFINED, regardless of its running status.
+ * return NULL if the CPU has no tasks.
+ * the global list must be locked.
+ */
+resch_task_t* cpu_highest_prio_task(int cpu)
+{
+	int idx;
+	struct cpu_list_struct *cl = &lo[cpu].assigned;
+
+	if ((idx = resch_ffs(cl->bitmap, RESCH_PRIO_LONG)) < 0) {
+		return NULL;
+	}
+	return list_first_entry(&cl->queue[idx],
+							resch_task_t,
+							cpu_entry);
+}
+EXPORT_SYMBOL(cpu_highest_prio_task);
+
+/**
+ * return the task positioned at the next of @rt in the list of the CPU.
+ * return NULL if there is no next task.
+ * the global list must be locked.
+ */
+resch_task_t* cpu_next_prio_task(resch_task_t *rt)
+{
+	int idx = cpu_list_index(rt->assigned.prio);
+	struct cpu_list_struct *cl = &lo[rt->assigned.cpu].assigned;
+
+	if (rt->cpu_entry.next == &(cl->queue[idx])) {
+		/* find next set bit with offset of idx. */
+		if ((idx = resch_fns(cl->bitmap, idx + 1, RESCH_PRIO_LONG)) < 0) {
+			return NULL;
+		}
+		return list_first_entry(&cl->queue[idx],
+								resch_task_t,
+								cpu_entry);
+	}
+	return list_entry(rt->cpu_entry.next,
+					  resch_task_t,
+					  cpu_entry);
+}
+EXPORT_SYMBOL(cpu_next_prio_task);
+
+/**
+ * return the total utilization of the tasks assigned to the given CPU
+ * by parts per million.
+ * the global list must be locked.
+ */
+unsigned long cpu_util(int cpu)
+{
+	return lo[cpu].assigned.util;
+}
+EXPORT_SYMBOL(cpu_util);
+
+/**
+ * assign @rt to the given CPU, which may be RESCH_CPU_UNDEFINED.
+ * if @rt is managed, it is moved to the list of the CPU. the task is
+ * not migrated here, which is done by migrate_task().
+ * the global list must be locked.
+ */
+void assign_task_cpu(resch_task_t *rt, int cpu)
+{
+	if (!list_empty(&rt->cpu_entry)) {
+		__cpu_list_remove(rt);
+		__cpu_list_insert(rt, cpu);
+	}
+	rt->cpu_id = cpu;
+}
+EXPORT_SYMBOL(assign_task_cpu);
+
 /**
  * lock the active queue on the given CPU.
  */
@@ -926,14 +1093,11 @@ unsigned long sched_overhead_cpu(int cpu, unsigned long interval)
 	resch_task_t *rt;
 	unsigned long nr_jobs;
 	unsigned long overhead = 0;
-	list_for_each_entry(rt, &task_list.head, global_entry) {
-		if (task_is_on_cpu(rt, cpu)) {
-			nr_jobs = div_round_up(interval,
-									jiffies_to_usecs(rt->period));
-			overhead += nr_jobs * (switch_cost + release_cost);
-			if (rt->migratory) {
-				overhead += nr_jobs * migration_cost;
-			}
+	for (rt = cpu_highest_prio_task(cpu); rt; rt = cpu_next_prio_task(rt)) {
+		nr_jobs = div_round_up(interval, jiffies_to_usecs(rt->period));
+		overhead += nr_jobs * (switch_cost + release_cost);
+		if (rt->migratory) {
+			overhead += nr_jobs * migration_cost;
 		}
 	}
 	return overhead + usecs_to_jiffies(interval) * switch_cost / 2;
@@ -986,6 +1150,28 @@ static void set_scheduler_thread(void *__data)
 	}
 }
 
+/**
+ * called when the callback executed by the task pointed to by @__data
+ * may have exceeded its budget. the timer runs by wall-clock time, so
+ * if the task was preempted or blocked, it is checked again when the
+ * rest of the budget could be used up at the earliest. otherwise the
+ * task is notified in the same manner as resource reservation with
+ * RLIMIT_RTTIME.
+ */
+static void callback_expire(unsigned long __data)
+{
+	resch_task_t *rt = (resch_task_t *)__data;
+	unsigned long long exec;
+
+	exec = rt->task->se.sum_exec_runtime - rt->cb_runtime;
+	if (exec < rt->cb_budget) {
+		mod_timer(&rt->cb_timer, jiffies + 1 +
+				  usecs_to_jiffies(div_u64(rt->cb_budget - exec, 1000)));
+		return;
+	}
+	send_sig(SIGXCPU, rt->task, 0);
+}
+
 /**
  * initialize the RESCH task descriptor members.
  */
@@ -1037,9 +1223,15 @@ static void resch_task_init(resch_task_t *rt, int rid)
 	rt->xcpu = false;
 	rt->reserve_time = 0;
 	rt->server = NULL;
+	rt->cb_index = -1;
+	rt->cb_budget = 0;
+	setup_timer(&rt->cb_timer, callback_expire, (unsigned long)rt);
 	INIT_LIST_HEAD(&rt->global_entry);
 	INIT_LIST_HEAD(&rt->active_entry);
+	INIT_LIST_HEAD(&rt->cpu_entry);
 	INIT_LIST_HEAD(&rt->component_entry);
+	rt->comp_id = -1;
+	rt->comp_prio = -1;
 }
 
 /**
@@ -1059,124 +1251,141 @@ static void clear_dead_tasks(void)
 	}
 }
 
+/* the graph of ROS nodes in use, replaced by api_set_dag(). */
+static ros_dag_t ros_dag;
+static DEFINE_SPINLOCK(ros_dag_lock);
+
+/**
+ * API: replace the graph of ROS nodes by @dag, which has been built.
+ * the nodes that remain in the graph keep their RESCH IDs.
+ */
+int api_set_dag(ros_dag_t *dag)
+{
+	int i;
+	unsigned long flags;
+	ros_dag_node_t *old;
+
+	spin_lock_irqsave(&ros_dag_lock, flags);
+	for (i = 0; i < dag->nr_nodes; i++) {
+		old = ros_dag_find(&ros_dag, dag->node[i].index);
+		if (old) {
+			dag->node[i].rid = old->rid;
+		}
+	}
+	memcpy(&ros_dag, dag, sizeof(ros_dag_t));
+	spin_unlock_irqrestore(&ros_dag_lock, flags);
+
+	return RES_SUCCESS;
+}
+
 /**
  * API: set a ROS node index to RESCH.
+ * the node must be in the graph uploaded by api_set_dag().
  */
-node_t* root_node;
 int api_set_node(int rid, unsigned long node_index)
 {
-    printk(KERN_INFO
-           "RESCH: get ROS node index:%d.\n", node_index);
-
-    switch (node_index) {
-    case 0: /* rosout */
-    {
-        /*
-        root_node = make_node(16);
-        node_t* node15 = make_node(15);
-        node_t* node14 = make_node(14);
-        node_t* node13 = make_node(13);
-        node_t* node12 = make_node(12);
-        node_t* node11 = make_node(11);
-        node_t* node21 = make_node(21);
-        node_t* node22 = make_node(22);
-        node_t* node23 = make_node(23);
-        node_t* node31 = make_node(31);
-        node_t* node32 = make_node(32);
-        node_t* node41 = make_node(41);
-        insert_child_node(root_node, node15);
-        insert_child_node(root_node, node41);
-        insert_child_node(node15, node14);
-        insert_child_node(node15, node32);
-        insert_child_node(node14, node13);
-        insert_child_node(node13, node12);
-        insert_child_node(node13, node23);
-        insert_child_node(node12, node11);
-        insert_child_node(node23, node22);
-        insert_child_node(node22, node21);
-        insert_child_node(node32, node31);
-        insert_child_node(node31, node21);
-        insert_child_node(node41, node21);
-        printk(KERN_INFO
-               "Show tree.\n");
-        show_tree_dfs(root_node);
-        break;
-        */
-    }
-    case 1:
-    {
-        /*
-        node_t* result = search_node(root_node, node_index);
-        if(result != NULL) {
-            result->is_exist = 1;
-            printk(KERN_INFO
-                   "node[%d] is found.\n", node_index);
-        } else {
-            printk(KERN_INFO
-                   "node[%d] not found.\n", node_index);
-        }
-        search_leaf_node(root_node);
-        free_tree(root_node);
-        break;
-        */
-    }
-    case 16:
-    case 15:
-    case 14:
-    case 13:
-    case 12:
-    case 11:
-    case 23:
-    case 22:
-    case 21:
-    case 31:
-    {
-        break;
-    }
-    case 41:
-    {
-
-        node_t* result = search_node(root_node, node_index);
-        if(result != NULL) {
-            result->is_exist = 1;
-            printk(KERN_INFO
-                   "node[%d] is found.\n", result->index);
-//            api_set_scheduler(rid, RESCH_SCHED_FP);
-//            api_set_priority(rid, 98);
-        } else {
-            printk(KERN_INFO
-                   "not found.\n");
-        }
-        break;
-    }
-
-    default:
-            break;
-    }
-
-    return rid;
+	int res = RES_ILLEGAL;
+	unsigned long flags;
+	ros_dag_node_t *node;
+
+	spin_lock_irqsave(&ros_dag_lock, flags);
+	node = ros_dag_find(&ros_dag, (int)node_index);
+	if (node) {
+		node->rid = rid;
+		res = RES_SUCCESS;
+	}
+	spin_unlock_irqrestore(&ros_dag_lock, flags);
+
+	return res;
 }
 
 /**
  * API: start callback function on the ROS node.
+ * the callback is accounted only if the caller is attached to RESCH.
+ * the CPU time is that of the task of @rid, so another thread of the
+ * same process is refused.
  */
 int api_start_callback(int rid, unsigned long node_index)
 {
-    printk(KERN_INFO
-           "RESCH: start callback (node index:%d).\n", node_index);
+	int res = RES_ILLEGAL;
+	unsigned long flags;
+	unsigned long budget = 0;
+	ros_dag_node_t *node;
+	resch_task_t *rt = NULL;
+
+	if (rid >= 0 && rid < NR_RT_TASKS) {
+		rt = resch_task_ptr(rid);
+		if (rt->task != current) {
+			return RES_ILLEGAL;
+		}
+	}
+
+	spin_lock_irqsave(&ros_dag_lock, flags);
+	node = ros_dag_find(&ros_dag, (int)node_index);
+	if (node) {
+		ros_dag_start(node);
+		budget = node->budget;
+		res = RES_SUCCESS;
+	}
+	spin_unlock_irqrestore(&ros_dag_lock, flags);
+
+	if (res == RES_SUCCESS && rt) {
+		rt->cb_index = (int)node_index;
+		rt->cb_budget = (unsigned long long)budget * 1000;
+		rt->cb_runtime = rt->task->se.sum_exec_runtime;
+		if (budget > 0) {
+			mod_timer(&rt->cb_timer, jiffies + usecs_to_jiffies(budget));
+		}
+	}
 
-    return rid;
+	return res;
 }
 
 /**
  * API: end callback function on the ROS node.
+ * the successors are made ready in time of the out-degree, and the
+ * execution time is accounted on the current CPU. the execution time is
+ * the CPU time of the task, so preemption and blocking are excluded.
+ * as api_start_callback(), the caller must be the task of @rid.
  */
 int api_end_callback(int rid, unsigned long node_index)
 {
-    printk(KERN_INFO
-           "RESCH: start callback (node index:%d).\n", node_index);
+	int res = RES_ILLEGAL;
+	int cpu;
+	unsigned long flags;
+	unsigned long long exec;
+	ros_dag_node_t *node;
+	resch_task_t *rt;
+
+	if (rid >= 0 && rid < NR_RT_TASKS) {
+		rt = resch_task_ptr(rid);
+		if (rt->task != current) {
+			return RES_ILLEGAL;
+		}
+		if (rt->cb_index == (int)node_index) {
+			if (rt->cb_budget > 0) {
+				del_timer_sync(&rt->cb_timer);
+			}
+			exec = rt->task->se.sum_exec_runtime - rt->cb_runtime;
+			cpu = get_cpu();
+			if (callback_area && cpu < NR_RT_CPUS) {
+				callback_account(&callback_area->cpu[cpu], rt->cb_index,
+								 exec, rt->cb_budget);
+			}
+			put_cpu();
+			rt->cb_index = -1;
+		}
+	}
 
-    return rid;
+	spin_lock_irqsave(&ros_dag_lock, flags);
+	node = ros_dag_find(&ros_dag, (int)node_index);
+	if (node) {
+		ros_dag_complete(&ros_dag, node, NULL, 0);
+		res = RES_SUCCESS;
+	}
+	spin_unlock_irqrestore(&ros_dag_lock, flags);
+
+	return res;
 }
 
 /**
@@ -1231,6 +1440,14 @@ int api_exit(int rid)
 		reserve_stop(rt);
 	}
 
+	/* make sure not to notify the callback budget. */
+	del_timer_sync(&rt->cb_timer);
+
+	/* make sure to remove the task from the component. */
+	if (rt->comp_id >= 0) {
+		api_decompose(rid);
+	}
+
 	/* make sure to remove the task from the task list. */
 	if (task_is_managed(rt)) {
 		global_list_remove(rt);
@@ -1321,6 +1538,7 @@ int api_set_period(int rid, unsigned long period)
 	if (rt->deadline == 0) {
 		rt->deadline = rt->period;
 	}
+	cpu_list_update(rt);
 	return RES_SUCCESS;
 }
 
@@ -1331,6 +1549,7 @@ int api_set_deadline(int rid, unsigned long deadline)
 {
 	resch_task_t *rt = resch_task_ptr(rid);
 	rt->deadline = deadline;
+	cpu_list_update(rt);
 	return RES_SUCCESS;
 }
 
@@ -1346,6 +1565,7 @@ int api_set_wcet(int rid, unsigned long wcet)
 		rt->runtime = wcet;
 	}
 	rt->wcet_fixed = true;
+	cpu_list_update(rt);
 	return RES_SUCCESS;
 }
 
@@ -1360,6 +1580,7 @@ int api_set_runtime(int rid, unsigned long runtime)
 	if (rt->wcet == 0) {
 		rt->wcet = runtime;
 	}
+	cpu_list_update(rt);
 	return RES_SUCCESS;
 }
 
@@ -1401,22 +1622,35 @@ int api_set_scheduler(int rid, unsigned long policy)
 
 /**
  * API: set affinity for the current task.
+ * @cpus is a bitmap of CPUs, so only the first BITS_PER_LONG CPUs
+ * can be given.
  */
-//int api_set_affinity(int rid, size_t cpusetsize, const cpu_set_t *mask)
-//{
-//    resch_task_t *rt = resch_task_ptr(rid);
+int api_set_affinity(int rid, unsigned long cpus)
+{
+	int cpu;
+	resch_task_t *rt = resch_task_ptr(rid);
 
-//    /* dont allow to set the priority for the EDF and FAIR schedulers. */
-//    if (rt->policy == RESCH_SCHED_EDF || rt->policy == RESCH_SCHED_FAIR) {
-//        return RES_FAULT;
-//    }
+#ifdef USE_VIVID_OR_OLDER
+	cpus_clear(rt->cpumask);
+#else
+	cpumask_clear(&rt->cpumask);
+#endif
+	for (cpu = 0; cpu < nr_cpu_ids && cpu < BITS_PER_LONG; cpu++) {
+		if (cpus & (1UL << cpu)) {
+#ifdef USE_VIVID_OR_OLDER
+			cpu_set(cpu, rt->cpumask);
+#else
+			cpumask_set_cpu(cpu, &rt->cpumask);
+#endif
+		}
+	}
 
-//    /* set only the priority by set_scheduler(). */
-//    if (!set_affinity(rt, cpusetsize, mask)) {
-//        return RES_FAULT;
-//    }
-//    return RES_SUCCESS;
-//}
+	if (cpumask_empty(&rt->cpumask) ||
+		set_cpus_allowed_ptr(rt->task, &rt->cpumask)) {
+		return RES_FAULT;
+	}
+	return RES_SUCCESS;
+}
 
 /**
  * API: schedule the current task in background.
@@ -1436,6 +1670,7 @@ void sched_init(void)
 
 	sema_init(&task_list.sem, 1);
 	INIT_LIST_HEAD(&task_list.head);
+	sa_global_init();
 
 	for (i = 0; i < PID_MAP_LONG; i++) {
 		pid_map.bitmap[i] = 0;
@@ -1450,6 +1685,15 @@ void sched_init(void)
 		for (i = 0; i < RESCH_PRIO_MAX; i++) {
 			INIT_LIST_HEAD(lo[cpu].active.queue + i);
 		}
+		/* list of the assigned tasks. */
+		lo[cpu].assigned.nr_tasks = 0;
+		lo[cpu].assigned.util = 0;
+		for (i = 0; i < RESCH_PRIO_LONG; i++) {
+			lo[cpu].assigned.bitmap[i] = 0;
+		}
+		for (i = 0; i < RESCH_PRIO_MAX; i++) {
+			INIT_LIST_HEAD(lo[cpu].assigned.queue + i);
+		}
 #ifdef RESCH_PREEMPT_TRACE
 		/* CPU tick. */
 		lo[cpu].last_tick = jiffies;
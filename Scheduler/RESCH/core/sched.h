@@ -22,6 +22,18 @@ struct prio_array {
 	struct list_head queue[RESCH_PRIO_MAX];
 };
 
+/* priority array which includes the tasks assigned to a CPU regardless
+   of their running status, and their total utilization.
+   this is protected by the semaphore of the global list, so that the
+   admission tests can look at the tasks on a particular CPU without
+   scanning the global list. */
+struct cpu_list_struct {
+	int nr_tasks;
+	unsigned long util;	/* by parts per million */
+	unsigned long bitmap[RESCH_PRIO_LONG];
+	struct list_head queue[RESCH_PRIO_MAX];
+};
+
 /* kernel thread structure that calls sched_setscheduler() exported
    from the Linux kernel to change the scheduling policy and the
    priority of the tasks.
@@ -50,6 +62,7 @@ struct task_list_struct {
 /* local object for each CPU. */
 struct local_object {
 	struct prio_array active;
+	struct cpu_list_struct assigned;
 	struct sched_thread_struct sched_thread;
 #ifdef RESCH_PREEMPT_TRACE
 	struct resch_task_struct *current_task;
@@ -64,6 +77,8 @@ extern struct local_object lo[NR_RT_CPUS + 1];
 
 /* APIs. */
 /* ROS APIs. */
+struct ros_dag;
+int api_set_dag(struct ros_dag *);
 int api_set_node(int, unsigned long);
 int api_start_callback(int, unsigned long);
 int api_end_callback(int, unsigned long);
@@ -79,6 +94,7 @@ int api_set_wcet(int, unsigned long);
 int api_set_runtime(int, unsigned long);
 int api_set_priority(int, unsigned long);
 int api_set_scheduler(int, unsigned long);
+int api_set_affinity(int, unsigned long);
 int api_background(int);
 
 void sched_init(void);
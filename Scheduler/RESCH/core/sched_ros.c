@@ -1,205 +1,275 @@
-#include <asm/current.h>
-#include <linux/slab.h>
-#include "sched_ros.h"
-
-#define DISPLAY_MAX_BUF 32
-#define MAX_LEAF_LIST 16
-#define MAX_FREED_NODE_LIST 32
-
-void node_init(node_t* node)
-{
-    node->name = NULL;
-    node->index = -1;
-    node->pid = -1;
-    node->depth = 0;
-    node->is_exist = 0;
-    node->wcet = -1;
-    node->laxity = -1;
-    node->global_wcet = -1;
-    node->parent = NULL;
-    node->child = NULL;
-    node->next = NULL;
-    /* node->parent_next = NULL; */
-}
+/*
+ * sched_ros.c		Copyright (C) Shinpei Kato
+ *
+ * Graph of ROS nodes used by the ROS APIs.
+ * ros_dag_add_node(), ros_dag_add_edge(), and ros_dag_build() are called
+ * only when the graph is uploaded, while ros_dag_find(), ros_dag_start(),
+ * and ros_dag_complete() are called on every callback, and hence they
+ * never allocate memory and take time bounded by the out-degree.
+ * This file is also compiled as it is into the user-space tests.
+ */
 
-void insert_child_node(node_t* parent_node, node_t* child_node)
-{
-    if (parent_node == NULL || child_node == NULL)
-        return;
-
-    /* Update deepest depth */
-    if(child_node->depth < parent_node->depth + 1 || child_node->depth == 0) {
-        child_node->depth = parent_node->depth + 1;
-    }
-
-    if(parent_node->child == NULL) {
-        parent_node->child = child_node;
-    }
-    else {
-        node_t* next_child = parent_node->child;
-        while (next_child->next != NULL) {
-            next_child = next_child->next;
-        }
-        next_child->next = child_node;
-    }
-}
+#ifdef __KERNEL__
+#include <linux/string.h>
+#else
+#include <string.h>
+#define true	1
+#define false	0
+#endif
+#include "sched_ros.h"
 
-node_t* make_node(int node_index)
+static inline int hash_index(int index)
 {
-    node_t *node = (node_t*)kmalloc(sizeof(node_t), GFP_KERNEL);
-    if (node != NULL) {
-        node_init(node);
-        node->index = node_index;
-        printk(KERN_INFO
-               "create:%d\n", node_index);
-    }
-    return node;
+	return (int)(((unsigned int)index * 2654435761U) &
+				 (ROS_DAG_HASH_SIZE - 1));
 }
 
-node_t* search_node(node_t* node, int node_index)
+/**
+ * return the position of the node with @index, or -1 if none.
+ */
+static int dag_position(ros_dag_t *dag, int index)
 {
-  if (node == NULL)
-      return NULL;
-  if(node->index == node_index)
-      return node;
-
-  if (node->child) {
-      node_t* result = search_node(node->child, node_index);
-      if (result != NULL)
-          return result;
-  }
-
-  if (node->next) {
-      node_t* result = search_node(node->next, node_index);
-      if (result != NULL)
-          return result;
-  }
-
-  return NULL;
+	int h = hash_index(index);
+	int pos;
+
+	while ((pos = dag->hash[h]) != 0) {
+		if (dag->node[pos - 1].index == index) {
+			return pos - 1;
+		}
+		h = (h + 1) & (ROS_DAG_HASH_SIZE - 1);
+	}
+	return -1;
 }
 
-
-
-void _search_leaf_node(node_t* node, node_t** leaf_list, int* i)
+/**
+ * clear @dag to have no nodes.
+ */
+void ros_dag_init(ros_dag_t *dag)
 {
-    /* if (node == NULL) */
-    /*     return; */
-
-    if (node->child) {
-        _search_leaf_node(node->child, leaf_list, i);
-    } else {
-        if (_is_exist_leaf_node(node, leaf_list, *i)) {
-            return;
-        } else {
-            leaf_list[(*i)] = node;
-            ++(*i);
-        }
-    }
-
-    if (node->next)
-        _search_leaf_node(node->next, leaf_list, i);
+	memset(dag, 0, sizeof(ros_dag_t));
 }
 
-int _is_exist_leaf_node(node_t* node, node_t** leaf_list, int list_size)
+/**
+ * add the node with @index that runs callbacks for @wcet usecs.
+ * return false if the graph is full or @index is already used.
+ */
+int ros_dag_add_node(ros_dag_t *dag, int index, int pid, unsigned long wcet)
 {
-    int i;
-    for (i = 0; i < list_size; ++i) {
-        if (leaf_list[i] == node)
-            return 1; // exist(true)
-    }
-    return 0;
+	ros_dag_node_t *node;
+	int h;
+
+	if (dag->nr_nodes >= ROS_DAG_MAX_NODES || dag_position(dag, index) >= 0) {
+		return false;
+	}
+
+	node = &dag->node[dag->nr_nodes];
+	memset(node, 0, sizeof(ros_dag_node_t));
+	node->index = index;
+	node->pid = pid;
+	node->rid = -1;
+	node->wcet = wcet;
+
+	h = hash_index(index);
+	while (dag->hash[h] != 0) {
+		h = (h + 1) & (ROS_DAG_HASH_SIZE - 1);
+	}
+	dag->hash[h] = ++dag->nr_nodes;
+	dag->built = false;
+
+	return true;
 }
 
 /**
- * API: return leaf nodes as node_t**.
- * End of leaf is NULL.
+ * add the edge from the node with @from to the node with @to.
+ * return false if the graph is full, either node is unknown, or the
+ * edge is a self loop or a duplicate.
  */
-node_t** search_leaf_node(node_t* node)
+int ros_dag_add_edge(ros_dag_t *dag, int from, int to)
 {
-    if (node == NULL)
-        return NULL;
-
-    int i = 0;
-    static node_t* leaf_list[MAX_LEAF_LIST];
-
-    _search_leaf_node(node, leaf_list, &i);
-
-    leaf_list[i] = NULL;
-
-    int j;
-    for (j = 0; j < i; ++j) {
-        printk(KERN_INFO
-               "leaf list[%d] is found.\n", leaf_list[j]->index);
-    }
-
-    return leaf_list;
+	int i, u, v;
+
+	if (dag->nr_edges >= ROS_DAG_MAX_EDGES) {
+		return false;
+	}
+	u = dag_position(dag, from);
+	v = dag_position(dag, to);
+	if (u < 0 || v < 0 || u == v) {
+		return false;
+	}
+	for (i = 0; i < dag->nr_edges; i++) {
+		if (dag->edge_from[i] == u && dag->edge_to[i] == v) {
+			return false;
+		}
+	}
+
+	dag->edge_from[dag->nr_edges] = u;
+	dag->edge_to[dag->nr_edges] = v;
+	dag->nr_edges++;
+	dag->built = false;
+
+	return true;
 }
 
-void display(node_t* node)
+/**
+ * group the successors by node, sort the nodes in reverse topological
+ * order, and compute their laxities. all the nodes become waiting for
+ * their first callbacks. return false if the graph has a cycle.
+ */
+int ros_dag_build(ros_dag_t *dag)
 {
-    int i;
-    char buf[DISPLAY_MAX_BUF];
-    for (i = 0; i < node->depth && i < sizeof(buf); ++i) {
-        buf[i] = ' ';
-    }
-    buf[i] = '\0';
-
-    printk(KERN_INFO
-           "%sL %d\n", buf, node->index);
+	int i, k, u, v, n;
+	int tmp[ROS_DAG_MAX_NODES];
+	unsigned long len;
+	ros_dag_node_t *node = dag->node;
+
+	for (u = 0; u < dag->nr_nodes; u++) {
+		node[u].nr_preds = 0;
+		node[u].nr_succs = 0;
+	}
+	for (i = 0; i < dag->nr_edges; i++) {
+		node[dag->edge_from[i]].nr_succs++;
+		node[dag->edge_to[i]].nr_preds++;
+	}
+
+	/* successors of node u are succ[first_succ, first_succ + nr_succs). */
+	k = 0;
+	for (u = 0; u < dag->nr_nodes; u++) {
+		node[u].first_succ = k;
+		tmp[u] = k;
+		k += node[u].nr_succs;
+	}
+	for (i = 0; i < dag->nr_edges; i++) {
+		dag->succ[tmp[dag->edge_from[i]]++] = dag->edge_to[i];
+	}
+
+	/* Kahn's algorithm, using order[] as the queue. */
+	n = 0;
+	for (u = 0; u < dag->nr_nodes; u++) {
+		tmp[u] = node[u].nr_preds;
+		if (tmp[u] == 0) {
+			dag->order[n++] = u;
+		}
+	}
+	for (k = 0; k < n; k++) {
+		u = dag->order[k];
+		for (i = 0; i < node[u].nr_succs; i++) {
+			v = dag->succ[node[u].first_succ + i];
+			if (--tmp[v] == 0) {
+				dag->order[n++] = v;
+			}
+		}
+	}
+	if (n < dag->nr_nodes) {
+		return false;
+	}
+
+	/* longest paths to each node, in topological order. */
+	for (u = 0; u < dag->nr_nodes; u++) {
+		node[u].head = node[u].wcet;
+	}
+	for (k = 0; k < n; k++) {
+		u = dag->order[k];
+		for (i = 0; i < node[u].nr_succs; i++) {
+			v = dag->succ[node[u].first_succ + i];
+			len = node[u].head + node[v].wcet;
+			if (len > node[v].head) {
+				node[v].head = len;
+			}
+		}
+	}
+
+	/* reverse the order so that the successors come first. */
+	for (k = 0; k < n / 2; k++) {
+		u = dag->order[k];
+		dag->order[k] = dag->order[n - 1 - k];
+		dag->order[n - 1 - k] = u;
+	}
+
+	/* longest paths from each node, in reverse topological order. */
+	dag->critical = 0;
+	for (k = 0; k < n; k++) {
+		u = dag->order[k];
+		len = 0;
+		for (i = 0; i < node[u].nr_succs; i++) {
+			v = dag->succ[node[u].first_succ + i];
+			if (node[v].tail > len) {
+				len = node[v].tail;
+			}
+		}
+		node[u].tail = node[u].wcet + len;
+		if (node[u].tail > dag->critical) {
+			dag->critical = node[u].tail;
+		}
+	}
+
+	for (u = 0; u < dag->nr_nodes; u++) {
+		len = node[u].head + node[u].tail - node[u].wcet;
+		node[u].laxity = dag->critical - len;
+		node[u].round = 0;
+		node[u].wait_round = 0;
+		node[u].nr_waiting = node[u].nr_preds;
+		node[u].running = false;
+	}
+	dag->built = true;
+
+	return true;
 }
 
-void show_tree_dfs(node_t* node)
+/**
+ * return the node with @index, or NULL if none.
+ */
+ros_dag_node_t *ros_dag_find(ros_dag_t *dag, int index)
 {
-  if (node == NULL)
-      return;
-  display(node);
-  if (node->child)
-      show_tree_dfs(node->child);
-  if (node->next)
-      show_tree_dfs(node->next);
-}
+	int pos = dag_position(dag, index);
 
-void free_tree(node_t* node)
-{
-    int i = 0;
-    int freed_node_index_list[MAX_FREED_NODE_LIST];
-    _free_tree(node, freed_node_index_list, &i);
+	return pos < 0 ? NULL : &dag->node[pos];
 }
 
-
-void _free_tree(node_t* node, int* freed_node_index_list, int* i)
+/**
+ * true iff all the predecessors of @node have completed as many
+ * callbacks as @node is about to start.
+ */
+int ros_dag_ready(ros_dag_node_t *node)
 {
-    if (node == NULL)
-        return;
-    if (node->child)
-        _free_tree(node->child, freed_node_index_list, i);
-    if (node->next)
-        _free_tree(node->next, freed_node_index_list, i);
-    display(node);
-
-    if(_is_exist_freed_node(node, freed_node_index_list, *i))
-        return;
-
-    freed_node_index_list[(*i)] = node->index;
-    ++(*i);
-    free_node(node);
+	return node->nr_preds == 0 ||
+		(node->wait_round == node->round && node->nr_waiting == 0);
 }
 
-int _is_exist_freed_node(node_t* node, int* freed_node_index_list, int list_size)
+/**
+ * a callback of @node is started.
+ */
+void ros_dag_start(ros_dag_node_t *node)
 {
-    int i;
-    for (i = 0; i < list_size; ++i) {
-        if(freed_node_index_list[i] == node->index) {
-            printk(KERN_INFO
-                   "node[%d] is aleady freed.\n", node->index);
-            return 1; // exist (true)
-        }
-    }
-
-    return 0;
+	node->running = true;
 }
 
-int free_node(node_t* node)
+/**
+ * a callback of @node is completed. the successors that have become
+ * ready are stored in @ready up to @max, and their number is returned.
+ * a predecessor that runs a round ahead of the others restarts the
+ * count of its successors, while one that runs behind is ignored.
+ */
+int ros_dag_complete(ros_dag_t *dag, ros_dag_node_t *node,
+					 ros_dag_node_t **ready, int max)
 {
-    kfree(node);
+	int i, nr_ready = 0;
+	unsigned int r = node->round++;
+	ros_dag_node_t *succ;
+
+	node->running = false;
+	for (i = 0; i < node->nr_succs; i++) {
+		succ = &dag->node[dag->succ[node->first_succ + i]];
+		if (succ->wait_round != r) {
+			if ((int)(r - succ->wait_round) < 0) {
+				continue;
+			}
+			succ->wait_round = r;
+			succ->nr_waiting = succ->nr_preds;
+		}
+		if (--succ->nr_waiting == 0 && nr_ready < max) {
+			ready[nr_ready++] = succ;
+		}
+	}
+
+	return nr_ready;
 }
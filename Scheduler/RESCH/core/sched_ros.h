@@ -1,28 +1,68 @@
+/*
+ * sched_ros.h		Copyright (C) Shinpei Kato
+ *
+ * Graph of ROS nodes, where an edge from a node to another means that
+ * a callback of the former triggers a callback of the latter.
+ * The graph is uploaded at once, and is kept in a flat array so that
+ * the callbacks update the readiness of nodes without any allocation.
+ * Nothing here depends on the kernel, so that the same code can also
+ * be compiled into user-space tests (test/test_dag.c).
+ */
 #ifndef __RESCH_SCHED_ROS__
 #define __RESCH_SCHED_ROS__
 
-typedef struct ros_node {
-    char* name;
-    int index;
-    int pid;
-    int depth;
-    int is_exist;
-    float wcet;
-    float laxity;
-    float global_wcet;
-    struct ros_node* parent;
-    struct ros_node* child;
-    struct ros_node* next;
-    /* struct node* parent_next; */
-} node_t;
+#define ROS_DAG_MAX_NODES	64
+#define ROS_DAG_MAX_EDGES	256
+/* must be a power of two larger than ROS_DAG_MAX_NODES. */
+#define ROS_DAG_HASH_SIZE	128
 
-extern void node_init(node_t* node);
-extern void insert_child_node(node_t* parent_node, node_t* child_node);
-extern node_t* make_node(int node_index);
-extern node_t* search_node(node_t* node, int node_index);
-extern node_t** search_leaf_node(node_t* node);
-extern void show_tree_dfs(node_t* node);
-extern void free_tree(node_t* node);
-extern int free_node(node_t* node);
+typedef struct ros_dag_node {
+	int index;				/* node index given by ROS. */
+	int pid;
+	int rid;				/* RESCH ID set by api_set_node(), or -1. */
+	unsigned long wcet;		/* by microseconds */
+	unsigned long budget;	/* by microseconds, or 0 if none. */
+	/* precomputed when the graph is built: */
+	unsigned long head;		/* longest path from a source to this node. */
+	unsigned long tail;		/* longest path from this node to a sink. */
+	unsigned long laxity;	/* slack against the critical path. */
+	int nr_preds;
+	int first_succ;			/* successors are succ[first_succ...]. */
+	int nr_succs;
+	/* readiness: */
+	unsigned int round;		/* the number of completed callbacks. */
+	unsigned int wait_round;/* the round for which @nr_waiting counts. */
+	int nr_waiting;			/* predecessors not completed in @wait_round. */
+	int running;
+} ros_dag_node_t;
+
+typedef struct ros_dag {
+	int nr_nodes;
+	int nr_edges;
+	int built;
+	ros_dag_node_t node[ROS_DAG_MAX_NODES];
+	/* edges by node positions, as they are added. */
+	int edge_from[ROS_DAG_MAX_EDGES];
+	int edge_to[ROS_DAG_MAX_EDGES];
+	/* successor positions grouped by node. */
+	int succ[ROS_DAG_MAX_EDGES];
+	/* node positions in reverse topological order, sinks first. */
+	int order[ROS_DAG_MAX_NODES];
+	/* open-addressing table from node indices to positions + 1. */
+	int hash[ROS_DAG_HASH_SIZE];
+	/* length of the critical path. */
+	unsigned long critical;
+} ros_dag_t;
+
+extern void ros_dag_init(ros_dag_t *dag);
+extern int ros_dag_add_node(ros_dag_t *dag, int index, int pid,
+							unsigned long wcet);
+extern int ros_dag_add_edge(ros_dag_t *dag, int from, int to);
+extern int ros_dag_build(ros_dag_t *dag);
+extern ros_dag_node_t *ros_dag_find(ros_dag_t *dag, int index);
+extern int ros_dag_ready(ros_dag_node_t *node);
+extern void ros_dag_start(ros_dag_node_t *node);
+extern int ros_dag_complete(ros_dag_t *dag, ros_dag_node_t *node,
+							ros_dag_node_t **ready, int max);
 
 #endif
@@ -0,0 +1,165 @@
+/*
+ * switch_trace.c		Copyright (C) Shinpei Kato
+ *
+ * Tracing of context switches through the sched_switch tracepoint.
+ * Unlike preempt_trace.c, this takes no locks and does not depend on
+ * jiffies: every switch on a CPU is recorded with sched_clock() into
+ * the ring buffer of the CPU, and user applications read it from the
+ * mapped area. switch_trace_area_init() and switch_trace_record() are
+ * also compiled into the user-space tests.
+ */
+
+#ifdef __KERNEL__
+#include <linux/mm.h>
+#include <linux/module.h>
+#include <linux/sched.h>
+#include <linux/tracepoint.h>
+#include <linux/vmalloc.h>
+#include <linux/version.h>
+#define trace_wmb()	smp_wmb()
+#else
+#include <string.h>
+#define trace_wmb()	__sync_synchronize()
+#endif
+#include "switch_trace.h"
+
+/**
+ * clear @area for @nr_cpus CPUs.
+ */
+void switch_trace_area_init(struct resch_trace_area *area,
+							unsigned int nr_cpus)
+{
+	memset(area, 0, sizeof(struct resch_trace_area));
+	area->nr_cpus = nr_cpus;
+	area->nr_entries = RESCH_TRACE_NR_ENTRIES;
+}
+
+/**
+ * record a context switch on the CPU of @c at @time.
+ * the caller must not be preempted by another caller on the same CPU.
+ */
+void switch_trace_record(struct resch_trace_cpu *c, unsigned long long time,
+						 int prev_pid, int next_pid,
+						 int prev_prio, int next_prio, long prev_state)
+{
+	unsigned long long head = c->head;
+	struct resch_trace_entry *e = &c->entry[head & (RESCH_TRACE_NR_ENTRIES - 1)];
+
+	e->time = time;
+	e->prev_pid = prev_pid;
+	e->next_pid = next_pid;
+	e->prev_prio = prev_prio;
+	e->next_prio = next_prio;
+	e->prev_state = prev_state;
+	/* the entry is visible before the head, and the next entry is
+	   not visible before the head. see resch_trace_read(). */
+	trace_wmb();
+	c->head = head + 1;
+	trace_wmb();
+}
+
+#ifdef __KERNEL__
+#ifdef RESCH_SWITCH_TRACE
+static struct resch_trace_area *trace_area = NULL;
+static struct tracepoint *tp_sched_switch = NULL;
+
+static inline unsigned long trace_area_size(void)
+{
+	return PAGE_ALIGN(sizeof(struct resch_trace_area));
+}
+
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(4,4,0)
+static void probe_sched_switch(void *data, bool preempt,
+							   struct task_struct *prev,
+							   struct task_struct *next)
+#else
+static void probe_sched_switch(void *data,
+							   struct task_struct *prev,
+							   struct task_struct *next)
+#endif
+{
+	/* preemption is disabled in the scheduler. */
+	int cpu = smp_processor_id();
+
+	if (cpu < NR_RT_CPUS) {
+		switch_trace_record(&trace_area->cpu[cpu], sched_clock(),
+							prev->pid, next->pid,
+							prev->rt_priority, next->rt_priority,
+							prev->state);
+	}
+}
+
+static void lookup_sched_switch(struct tracepoint *tp, void *ignore)
+{
+	if (strcmp(tp->name, "sched_switch") == 0) {
+		tp_sched_switch = tp;
+	}
+}
+
+/**
+ * map the trace area to @vma read-only.
+ */
+int switch_trace_mmap(struct vm_area_struct *vma)
+{
+	if (!tp_sched_switch) {
+		return -ENODEV;
+	}
+	if (vma->vm_flags & VM_WRITE) {
+		return -EPERM;
+	}
+	if (vma->vm_end - vma->vm_start > trace_area_size()) {
+		return -EINVAL;
+	}
+	vma->vm_flags &= ~VM_MAYWRITE;
+
+	return remap_vmalloc_range(vma, trace_area, 0);
+}
+
+void switch_trace_init(void)
+{
+	trace_area = vmalloc_user(trace_area_size());
+	if (!trace_area) {
+		printk(KERN_WARNING "RESCH: failed to allocate trace area.\n");
+		return;
+	}
+	switch_trace_area_init(trace_area, NR_RT_CPUS);
+
+	/* sched_switch is not exported to modules by symbol. */
+	for_each_kernel_tracepoint(lookup_sched_switch, NULL);
+	if (!tp_sched_switch ||
+		tracepoint_probe_register(tp_sched_switch, probe_sched_switch, NULL)) {
+		printk(KERN_WARNING "RESCH: failed to trace sched_switch.\n");
+		tp_sched_switch = NULL;
+		vfree(trace_area);
+		trace_area = NULL;
+	}
+}
+
+void switch_trace_exit(void)
+{
+	if (tp_sched_switch) {
+		tracepoint_probe_unregister(tp_sched_switch, probe_sched_switch, NULL);
+		/* wait for the probes running on other CPUs. */
+		tracepoint_synchronize_unregister();
+		tp_sched_switch = NULL;
+	}
+	if (trace_area) {
+		vfree(trace_area);
+		trace_area = NULL;
+	}
+}
+#else /* !RESCH_SWITCH_TRACE */
+int switch_trace_mmap(struct vm_area_struct *vma)
+{
+	return -ENODEV;
+}
+
+void switch_trace_init(void)
+{
+}
+
+void switch_trace_exit(void)
+{
+}
+#endif /* RESCH_SWITCH_TRACE */
+#endif /* __KERNEL__ */
@@ -0,0 +1,18 @@
+#ifndef __RESCH_SWITCH_TRACE_H__
+#define __RESCH_SWITCH_TRACE_H__
+
+#include <resch-trace.h>
+
+/* recording, shared with the user-space tests. */
+void switch_trace_area_init(struct resch_trace_area *, unsigned int);
+void switch_trace_record(struct resch_trace_cpu *, unsigned long long,
+						 int, int, int, int, long);
+
+#ifdef __KERNEL__
+struct vm_area_struct;
+int switch_trace_mmap(struct vm_area_struct *);
+void switch_trace_init(void);
+void switch_trace_exit(void);
+#endif
+
+#endif
@@ -0,0 +1,116 @@
+/*
+ * resch-analysis.h	Copyright (C) Shinpei Kato
+ *
+ * Schedulability analysis and CPU assignment used by the partitioned
+ * and semi-partitioned plugins.
+ * The functions work on a plain array of task parameters, and have no
+ * dependency on the kernel, so that the same code can be compiled into
+ * the RESCH core module and into user-space tools like bench/simbench.
+ * All the timing properties are represented by microseconds.
+ */
+#ifndef __RESCH_ANALYSIS_H__
+#define __RESCH_ANALYSIS_H__
+
+#ifdef __KERNEL__
+#include <resch-config.h>
+#define SA_NR_CPUS	NR_RT_CPUS
+#else
+#define SA_NR_CPUS	64
+#endif
+
+/* equal to RESCH_CPU_UNDEFINED in the kernel. */
+#define SA_CPU_UNDEFINED	SA_NR_CPUS
+/* utilization is represented by parts per million. */
+#define SA_UTIL_ONE			1000000UL
+
+/* true iff a piece of split @t is assigned to @cpu. */
+#define sa_split_is_on_cpu(t, cpu) ((t)->runtime[cpu] > 0)
+/* true iff @t is assigned to @cpu as a whole. */
+#define sa_task_is_on_cpu(t, cpu) \
+	((t)->cpu == (cpu) && !sa_split_is_on_cpu(t, cpu))
+/* true iff @t is assigned to @cpu either as a whole or as a piece. */
+#define sa_task_is_assigned(t, cpu) \
+	((t)->cpu == (cpu) || sa_split_is_on_cpu(t, cpu))
+/* true iff @t is allowed to run on @cpu. */
+#define sa_cpu_is_allowed(t, cpu) \
+	((t)->cpus == 0 || ((t)->cpus & (1UL << (cpu))))
+
+/**
+ * task parameters seen by the analysis.
+ */
+typedef struct sa_task_struct {
+	unsigned long C;		/* execution time. */
+	unsigned long T;		/* period. */
+	unsigned long D;		/* relative deadline. */
+	int prio;				/* larger value is higher priority. */
+	int cpu;				/* assigned CPU (the first CPU if split). */
+	unsigned long cpus;		/* CPU mask, 0 means any CPU. */
+	/* properties of split tasks. runtime[] is all zero if not split. */
+	int first_cpu;
+	int last_cpu;
+	unsigned long window;	/* relative deadline of every piece (EDF-WM). */
+	unsigned long runtime[SA_NR_CPUS];
+	/* opaque pointer for the caller, e.g., resch_task_t. */
+	void *priv;
+	/* next lower-priority task in the list of each CPU. */
+	struct sa_task_struct *cpu_next[SA_NR_CPUS];
+} sa_task_t;
+
+/**
+ * the set of tasks to be analyzed.
+ * the task being admitted can be included in @task as long as it is
+ * not yet assigned to any CPU.
+ * the tasks are indexed by per-CPU lists in order of priority, together
+ * with the total utilization of each CPU, when first analyzed. once
+ * indexed, tasks must be assigned to CPUs by sa_assign(), so that the
+ * analysis touches only the tasks on the CPU in question.
+ */
+typedef struct sa_taskset_struct {
+	sa_task_t *task;
+	int nr_tasks;
+	int nr_cpus;
+	/* scheduling overhead of @t on @cpu in the interval @L, or NULL. */
+	unsigned long (*overhead)(sa_task_t *t, int cpu, unsigned long L);
+	/* FP-PM: false if a CPU runs a non-last piece of a split task. */
+	int cpu_available[SA_NR_CPUS];
+	/* per-CPU lists and utilization, valid if @indexed is true. */
+	int indexed;
+	sa_task_t *cpu_head[SA_NR_CPUS];
+	unsigned long util[SA_NR_CPUS];
+} sa_taskset_t;
+
+extern void sa_task_init(sa_task_t *, unsigned long, unsigned long,
+						 unsigned long, int);
+extern void sa_clear_split(sa_task_t *);
+extern void sa_taskset_init(sa_taskset_t *, sa_task_t *, int, int);
+extern void sa_assign(sa_taskset_t *, sa_task_t *, int);
+extern void sa_unassign(sa_taskset_t *, sa_task_t *);
+extern unsigned long sa_util_cpu(sa_taskset_t *, int);
+
+/* fixed-priority scheduling (FP-FF and FP-PM). */
+extern unsigned long sa_fp_response_time(sa_taskset_t *, sa_task_t *, int);
+extern int sa_fp_test(sa_taskset_t *, sa_task_t *, int);
+extern int sa_fp_first_fit(sa_taskset_t *, sa_task_t *);
+extern int sa_fp_pm_split(sa_taskset_t *, sa_task_t *);
+
+/* EDF scheduling (EDF-FF and EDF-WM). */
+extern unsigned long sa_dbf_len(sa_taskset_t *, sa_task_t *, int);
+extern unsigned long sa_dbf_cpu(sa_taskset_t *, sa_task_t *, unsigned long,
+								int);
+extern int sa_dbf_test(sa_taskset_t *, sa_task_t *, int);
+extern int sa_qpa_test(sa_taskset_t *, sa_task_t *, int);
+extern int sa_edf_first_fit(sa_taskset_t *, sa_task_t *);
+extern int sa_edf_worst_fit(sa_taskset_t *, sa_task_t *);
+extern int sa_edf_wm_split(sa_taskset_t *, sa_task_t *, int);
+
+#ifdef __KERNEL__
+/* the tasks managed by the RESCH core, kept for admission. */
+struct resch_task_struct;
+extern void sa_global_init(void);
+extern void sa_global_insert(struct resch_task_struct *, int);
+extern void sa_global_remove(struct resch_task_struct *);
+extern void sa_global_use_wcet(int);
+extern sa_task_t *sa_global_admit(sa_taskset_t **, struct resch_task_struct *);
+#endif
+
+#endif
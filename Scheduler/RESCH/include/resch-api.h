@@ -61,6 +61,12 @@
 #define API_COMPOSE				API_PORT5_OFFSET + 4
 #define API_DECOMPOSE			API_PORT5_OFFSET + 5
 
+#define API_EXT_OFFSET		API_PORT5_OFFSET + 6
+/* extensions: several task attributes in one call. */
+#define API_SET_ATTR			API_EXT_OFFSET + 0
+/* extensions: the whole graph of ROS nodes in one call. */
+#define API_SET_DAG				API_EXT_OFFSET + 1
+
 /* test command numbers. */
 #define TEST_SET_SWITCH_COST	101
 #define TEST_SET_RELEASE_COST	102
@@ -80,9 +86,57 @@
 #define RES_ILLEGAL	2	/* illegal operations. */
 #define RES_MISS	3 	/* deadline miss. */
 
+/* members of api_attr_struct to apply. */
+#define API_ATTR_WCET		0x01
+#define API_ATTR_PERIOD		0x02
+#define API_ATTR_DEADLINE	0x04
+#define API_ATTR_POLICY		0x08
+#define API_ATTR_PRIORITY	0x10
+#define API_ATTR_AFFINITY	0x20
+
+struct api_attr_struct {
+	unsigned int mask;
+	struct timespec wcet;
+	struct timespec period;
+	struct timespec deadline;
+	unsigned long policy;
+	unsigned long prio;
+	unsigned long cpus; /* bitmap of CPUs. */
+};
+
+/* a ROS node and an edge between ROS nodes, by node indices. */
+struct api_dag_node_struct {
+	int index;
+	int pid;
+	struct timespec wcet;
+	struct timespec budget; /* of each callback, or zero if none. */
+};
+
+struct api_dag_edge_struct {
+	int from;
+	int to;
+};
+
+/* the arrays are copied from user space by the core. */
+struct api_dag_struct {
+	int nr_nodes;
+	int nr_edges;
+	const struct api_dag_node_struct *nodes;
+	const struct api_dag_edge_struct *edges;
+};
+
+/* the period or the budget of a component. */
+struct api_comp_struct {
+	int cid;
+	struct timespec ts;
+};
+
 union api_arg_union {
 	int val;
 	struct timespec ts;
+	struct api_attr_struct attr;
+	struct api_dag_struct dag;
+	struct api_comp_struct comp;
 };
 
 struct api_struct {
@@ -108,4 +162,22 @@ struct api_ts_user_struct {
 	struct timespec ts;
 };
 
+struct api_attr_user_struct {
+	int api;
+	int rid;
+	struct api_attr_struct attr;
+};
+
+struct api_dag_user_struct {
+	int api;
+	int rid;
+	struct api_dag_struct dag;
+};
+
+struct api_comp_user_struct {
+	int api;
+	int rid;
+	struct api_comp_struct comp;
+};
+
 #endif
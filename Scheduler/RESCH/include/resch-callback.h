@@ -0,0 +1,70 @@
+/*
+ * resch-callback.h		Copyright (C) Shinpei Kato
+ *
+ * Execution times of ROS callbacks, accounted by the RESCH core between
+ * api_start_callback() and api_end_callback(), by the CPU time of the
+ * task, so that preemption and blocking are not counted.
+ * Both calls are refused with RES_ILLEGAL on any thread but the one
+ * attached to RESCH as the task, whose CPU time is measured.
+ * The statistics are kept per CPU, and each CPU writes only its own
+ * part without locks. User applications map the whole area read-only
+ * through mmap() on /dev/resch, and read it by resch_cb_read().
+ */
+#ifndef __RESCH_CALLBACK_H__
+#define __RESCH_CALLBACK_H__
+
+/* quoted so that it is found next to this file when installed. */
+#include "resch-config.h"
+
+/* the number of ROS nodes accounted on each CPU. */
+#define RESCH_CB_MAX_NODES	64
+/* bucket k of histograms counts callbacks of [2^k, 2^(k+1)) nsecs,
+   except that bucket 0 also counts 0 nsecs and the last one counts
+   all the longer callbacks. */
+#define RESCH_CB_NR_BUCKETS	32
+
+struct resch_cb_stat {
+	unsigned int seq;		/* odd while being updated. */
+	int index;				/* ROS node index, or -1 if unused. */
+	unsigned long long count;
+	unsigned long long overruns;	/* callbacks that exceeded the budget. */
+	unsigned long long total;	/* by nsecs */
+	unsigned long long min;		/* by nsecs */
+	unsigned long long max;		/* by nsecs */
+	unsigned long long last;	/* by nsecs */
+	unsigned int hist[RESCH_CB_NR_BUCKETS];
+};
+
+struct resch_cb_cpu {
+	unsigned long long nr_dropped;	/* callbacks with no slot left. */
+	struct resch_cb_stat stat[RESCH_CB_MAX_NODES];
+};
+
+struct resch_cb_area {
+	unsigned int nr_cpus;
+	unsigned int nr_nodes;
+	unsigned int nr_buckets;
+	unsigned int reserved;
+	struct resch_cb_cpu cpu[NR_RT_CPUS];
+};
+
+#ifndef __KERNEL__
+/**
+ * copy @s to @out, retrying while the RESCH core is updating it.
+ */
+static inline void resch_cb_read(const volatile struct resch_cb_stat *s,
+								 struct resch_cb_stat *out)
+{
+	unsigned int seq;
+
+	do {
+		while ((seq = s->seq) & 1)
+			;
+		__sync_synchronize();
+		*out = *(const struct resch_cb_stat *)s;
+		__sync_synchronize();
+	} while (s->seq != seq);
+}
+#endif
+
+#endif
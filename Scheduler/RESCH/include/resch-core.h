@@ -123,9 +123,17 @@ struct resch_task_struct {
 	/* priority is changed through kernel threads. */
 	struct setscheduler_struct setsched;
 	struct list_head prio_entry;
-	/* we have two types of task lists. */
+	/* we have three types of task lists. */
 	struct list_head global_entry;
 	struct list_head active_entry;
+	struct list_head cpu_entry;
+	/* the CPU list including the task, and the priority and the
+	   utilization with which the task was inserted into it. */
+	struct {
+		int cpu;
+		int prio;
+		unsigned long util;
+	} assigned;
 	/* scheduling class & policy. */
 	const struct resch_sched_class *class;
 	int policy;
@@ -141,8 +149,16 @@ struct resch_task_struct {
 #endif
 	/* aperiodic server. */
 	struct server_struct *server;
+	/* ROS callback being executed. */
+	int cb_index;					/* ROS node index, or -1 if none. */
+	unsigned long long cb_runtime;	/* sum_exec_runtime at the start. */
+	unsigned long long cb_budget;	/* by nsecs, or 0 if none. */
+	struct timer_list cb_timer;
 	/* compositional properties. */
 	struct list_head component_entry;
+	int comp_id;					/* component ID, or -1 if none. */
+	int comp_prio;					/* the priority while throttled. */
+	unsigned long long comp_runtime;	/* by nsecs, at the last tick. */
 #ifdef RESCH_HRTIMER
 	int static_prio_save;
 #endif
@@ -231,6 +247,10 @@ extern void active_queue_double_lock(int, int, unsigned long*);
 extern void active_queue_double_unlock(int, int, unsigned long*);
 extern void global_list_down(void);
 extern void global_list_up(void);
+extern resch_task_t* cpu_highest_prio_task(int);
+extern resch_task_t* cpu_next_prio_task(resch_task_t *);
+extern unsigned long cpu_util(int);
+extern void assign_task_cpu(resch_task_t *, int);
 extern void migrate_task(resch_task_t *, int);
 extern unsigned long sched_overhead_cpu(int, unsigned long);
 extern unsigned long sched_overhead_task(resch_task_t *, unsigned long);
@@ -0,0 +1,97 @@
+/*
+ * resch-trace.h		Copyright (C) Shinpei Kato
+ *
+ * Context switches traced by the RESCH core through the sched_switch
+ * tracepoint, when configured with --enable-switch-trace.
+ * Each CPU has its own ring buffer, which only the CPU writes, without
+ * locks. When the buffer is full, the oldest entries are overwritten,
+ * and hence up to RESCH_TRACE_NR_ENTRIES - 1 entries can be read.
+ * User applications map the whole area read-only through mmap() on
+ * /dev/resch at RESCH_TRACE_MMAP_OFFSET, and read it by
+ * resch_trace_read().
+ */
+#ifndef __RESCH_TRACE_H__
+#define __RESCH_TRACE_H__
+
+/* quoted so that it is found next to this file when installed. */
+#include "resch-config.h"
+
+/* entries of each ring buffer, which must be a power of two. */
+#define RESCH_TRACE_NR_ENTRIES	4096
+/* the offset of mmap() to map the trace area. */
+#define RESCH_TRACE_MMAP_OFFSET	0x10000000
+
+struct resch_trace_entry {
+	unsigned long long time;	/* by nsecs of sched_clock() */
+	int prev_pid;
+	int next_pid;
+	int prev_prio;				/* real-time priority, or 0 if fair. */
+	int next_prio;
+	long prev_state;
+};
+
+struct resch_trace_cpu {
+	/* the number of entries ever written, updated after the entry. */
+	unsigned long long head;
+	/* keep the head alone in its cache line. */
+	unsigned long long reserved[7];
+	struct resch_trace_entry entry[RESCH_TRACE_NR_ENTRIES];
+};
+
+struct resch_trace_area {
+	unsigned int nr_cpus;
+	unsigned int nr_entries;
+	unsigned long long reserved[7];
+	struct resch_trace_cpu cpu[NR_RT_CPUS];
+};
+
+#ifndef __KERNEL__
+/**
+ * copy the entries of @c written since *@tail to @out up to @max, and
+ * advance *@tail. entries overwritten before they are copied are lost,
+ * and their number is stored in @lost. return the number of entries.
+ */
+static inline int resch_trace_read(const volatile struct resch_trace_cpu *c,
+								   unsigned long long *tail,
+								   struct resch_trace_entry *out, int max,
+								   unsigned long long *lost)
+{
+	int i, n = 0;
+	unsigned long long head, t, first;
+
+	head = c->head;
+	__sync_synchronize();
+	/* the slot of the next entry may be being written. */
+	t = *tail;
+	if (head - t > RESCH_TRACE_NR_ENTRIES - 1) {
+		t = head - (RESCH_TRACE_NR_ENTRIES - 1);
+	}
+	for (; t < head && n < max; t++, n++) {
+		out[n] = *(const struct resch_trace_entry *)
+			&c->entry[t & (RESCH_TRACE_NR_ENTRIES - 1)];
+	}
+	__sync_synchronize();
+
+	/* the entries before @first may have been overwritten meanwhile,
+	   including the one being written now. */
+	first = c->head + 1;
+	first = first > RESCH_TRACE_NR_ENTRIES ? first - RESCH_TRACE_NR_ENTRIES : 0;
+	t -= n;
+	if (first > t) {
+		if (first - t >= (unsigned long long)n) {
+			first = t + n;
+		}
+		for (i = 0; i + (int)(first - t) < n; i++) {
+			out[i] = out[i + (first - t)];
+		}
+		n -= (int)(first - t);
+		t = first;
+	}
+	*lost = t - *tail;
+	*tail = t + n;
+
+	return n;
+}
+#endif
+
+#endif
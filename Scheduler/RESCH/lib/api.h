@@ -15,6 +15,38 @@
 /* period value for non-perioid tasks. */
 #define RESCH_PERIOD_INFINITY	0
 
+/* members of struct rt_attr to apply. */
+#define RT_ATTR_WCET		0x01
+#define RT_ATTR_PERIOD		0x02
+#define RT_ATTR_DEADLINE	0x04
+#define RT_ATTR_POLICY		0x08
+#define RT_ATTR_PRIORITY	0x10
+#define RT_ATTR_AFFINITY	0x20
+
+/* task attributes set at once by rt_set_attr(). */
+struct rt_attr {
+	unsigned int mask; /* RT_ATTR_* */
+	struct timespec wcet;
+	struct timespec period;
+	struct timespec deadline;
+	unsigned long policy;
+	unsigned long priority;
+	unsigned long affinity; /* bitmap of CPUs. */
+};
+
+/* a ROS node and an edge between ROS nodes, set by ros_rt_set_dag(). */
+struct rt_dag_node {
+	int index;
+	int pid;
+	struct timespec wcet;
+	struct timespec budget; /* of each callback, or zero if none. */
+};
+
+struct rt_dag_edge {
+	int from; /* node index. */
+	int to; /* node index. */
+};
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -23,7 +55,12 @@ extern "C" {
  * ROS APIs for real-time scheduling.
  ************************************************************/
 int ros_rt_init(const char* node_name);
+int ros_rt_set_dag(const struct rt_dag_node *, int,
+				   const struct rt_dag_edge *, int);
 int ros_rt_set_node(unsigned long node_index);
+/* statistics of callbacks, laid out in <resch/resch-callback.h>. */
+struct resch_cb_area;
+const struct resch_cb_area *ros_rt_map_callbacks(void);
 int ros_rt_start_callback(unsigned long node_index);
 int ros_rt_end_callback(unsigned long node_index);
 int ros_rt_exit(void);
@@ -37,6 +74,7 @@ int ros_rt_set_runtime(struct timespec);
 int ros_rt_set_priority(unsigned long);
 int ros_rt_set_scheduler(unsigned long);
 int ros_rt_background(void);
+int ros_rt_set_attr(const struct rt_attr *);
 
 /************************************************************
  * PORT-I APIs for preemptive periodic real-time scheduling.
@@ -53,6 +91,10 @@ int rt_set_runtime(struct timespec);
 int rt_set_priority(unsigned long);
 int rt_set_scheduler(unsigned long);
 int rt_background(void);
+int rt_set_attr(const struct rt_attr *);
+/* context switches, laid out in <resch/resch-trace.h>. */
+struct resch_trace_area;
+const struct resch_trace_area *rt_map_trace(void);
 
 /*******************************************************
  * PORT-II APIs for event-driven asynchrous scheduling.
@@ -70,6 +112,18 @@ int rt_reserve_expire(void);
 int rt_server_create(struct timespec, struct timespec);
 int rt_server_run(void);
 
+/**************************************************
+ * PORT-V APIs for hierarchical scheduling.
+ **************************************************/
+/* any available component ID for rt_component_create(). */
+#define RT_COMPONENT_ANY	-1
+int rt_component_create(int);
+int rt_component_destroy(int);
+int rt_component_period(int, struct timespec);
+int rt_component_budget(int, struct timespec);
+int rt_compose(int);
+int rt_decompose(void);
+
 /*****************************************************
  *                 test functions                    *
  *****************************************************/
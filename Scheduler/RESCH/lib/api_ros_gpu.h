@@ -12,18 +12,30 @@ extern "C"{
 #include <iostream>
 #include <fstream>
 
+/* maximum number of processes waiting for the launch token at once. */
+#define GSCHED_MAX_WAITERS 64
+/* number of log2 bins of waiting time, bin k covers [2^k, 2^(k+1)) us. */
+#define GSCHED_WAIT_BINS 32
+
+/* waiting-time statistics of the launch token. */
+struct ros_gsched_stat
+{
+  unsigned long nr_launches;  /* tokens acquired. */
+  unsigned long nr_waits;     /* tokens acquired after waiting. */
+  unsigned long long total_wait_ns;
+  unsigned long long max_wait_ns;
+  unsigned long v_histogram[GSCHED_WAIT_BINS];
+};
+
 int ros_gsched_init(void);
 int ros_gsched_enqueue(void);
+int ros_gsched_enqueue_prio(int prio);
 int ros_gsched_dequeue(void);
+int ros_gsched_get_stat(struct ros_gsched_stat *stat);
+int ros_gsched_reset_stat(void);
 int ros_gsched_exit(bool);
 
-extern pthread_mutex_t *launch_mutex;
-extern pthread_mutex_t *value_mutex;
-extern int *maxvalue;
-
-extern int shm_launch_mutex_id;
-extern int shm_value_mutex_id;
-extern int shm_maxvalue_id;
+extern int shm_gsched_queue_id;
 #if 0
 #ifdef __cplusplus
 }
@@ -10,9 +10,12 @@
 #include <string.h>
 #include <stdlib.h>
 #include <sys/ioctl.h>
+#include <sys/mman.h>
 #include <sys/time.h>
 #include <sys/unistd.h>
 #include <resch-api.h>
+#include <resch-callback.h>
+#include <resch-trace.h>
 #include "api.h"
 
 #define discard_arg(arg)	asm("" : : "r"(arg))
@@ -21,6 +24,11 @@
 int rid = UNDEFINED_RID;
 void (*user_xcpu_handler)(void) = NULL;
 
+/* /dev/resch is opened once per process and shared by its threads.
+   the module identifies the task by current, so the descriptor
+   inherited by a forked child can be used as well. */
+static int resch_fd = -1;
+
 static void xcpu_handler(int signum)
 {
 	discard_arg(signum);
@@ -38,6 +46,32 @@ static void kill_handler(int signum)
 	kill(0, SIGINT);
 }
 
+/**
+ * internal function to get the cached descriptor of the device.
+ * it is opened on the first use, usually in rt_init().
+ */
+static inline int __dev(void)
+{
+	int fd = resch_fd;
+
+	if (fd >= 0) {
+		return fd;
+	}
+
+	fd = open(RESCH_DEVNAME, O_RDWR | O_CLOEXEC);
+	if (fd < 0) {
+		printf("Error: failed to access the module!\n");
+		return -1;
+	}
+	/* another thread may have opened it in the meantime. */
+	if (!__sync_bool_compare_and_swap(&resch_fd, -1, fd)) {
+		close(fd);
+		fd = resch_fd;
+	}
+
+	return fd;
+}
+
 /**
  * internal function for APIs with no arguments.
  * it uses write() system call to pass the information to the kernel.
@@ -47,16 +81,13 @@ static inline int __api(int api)
 	int fd, ret;
 	struct api_user_struct a;
 
-	fd = open(RESCH_DEVNAME, O_RDWR);
+	fd = __dev();
 	if (fd < 0) {
-		printf("Error: failed to access the module!\n");
 		return RES_FAULT;
 	}
 	a.api = api;
 	a.rid = rid;
 	ret = write(fd, &a, sizeof(a));
-	close(fd);
-
 	return ret;
 }
 
@@ -69,17 +100,14 @@ static inline int __api_int(int api, int val)
 	int fd, ret;
 	struct api_int_user_struct a;
 
-	fd = open(RESCH_DEVNAME, O_RDWR);
+	fd = __dev();
 	if (fd < 0) {
-		printf("Error: failed to access the module!\n");
 		return RES_FAULT;
 	}
 	a.api = api;
 	a.rid = rid;
 	a.val = val;
 	ret = write(fd, &a, sizeof(a));
-	close(fd);
-
 	return ret;
 }
 
@@ -92,17 +120,88 @@ static inline int __api_ts(int api, struct timespec ts)
 	int fd, ret;
 	struct api_ts_user_struct a;
 
-	fd = open(RESCH_DEVNAME, O_RDWR);
+	fd = __dev();
 	if (fd < 0) {
-		printf("Error: failed to access the module!\n");
 		return RES_FAULT;
 	}
 	a.api = api;
 	a.rid = rid;
 	a.ts = ts;
 	ret = write(fd, &a, sizeof(a));
-	close(fd);
+	return ret;
+}
+
+/**
+ * internal function for the task attributes.
+ * it uses a single write() system call for all of them.
+ */
+static inline int __api_attr(const struct rt_attr *attr)
+{
+	int fd, ret;
+	struct api_attr_user_struct a;
+
+	fd = __dev();
+	if (fd < 0) {
+		return RES_FAULT;
+	}
+	a.api = API_SET_ATTR;
+	a.rid = rid;
+	a.attr.mask = attr->mask;
+	a.attr.wcet = attr->wcet;
+	a.attr.period = attr->period;
+	a.attr.deadline = attr->deadline;
+	a.attr.policy = attr->policy;
+	a.attr.prio = attr->priority;
+	a.attr.cpus = attr->affinity;
+	ret = write(fd, &a, sizeof(a));
+
+	return ret;
+}
+
+/**
+ * internal function for the graph of ROS nodes.
+ * struct rt_dag_node and struct rt_dag_edge have the same layouts as
+ * struct api_dag_node_struct and struct api_dag_edge_struct.
+ */
+static inline int __api_dag(const struct rt_dag_node *nodes, int nr_nodes,
+							const struct rt_dag_edge *edges, int nr_edges)
+{
+	int fd, ret;
+	struct api_dag_user_struct a;
+
+	fd = __dev();
+	if (fd < 0) {
+		return RES_FAULT;
+	}
+	a.api = API_SET_DAG;
+	a.rid = rid;
+	a.dag.nr_nodes = nr_nodes;
+	a.dag.nr_edges = nr_edges;
+	a.dag.nodes = (const struct api_dag_node_struct *)nodes;
+	a.dag.edges = (const struct api_dag_edge_struct *)edges;
+	ret = write(fd, &a, sizeof(a));
+
+	return ret;
+}
+
+/**
+ * internal function for the period and the budget of components.
+ * it uses write() system call to pass the information to the kernel.
+ */
+static inline int __api_comp(int api, int cid, struct timespec ts)
+{
+	int fd, ret;
+	struct api_comp_user_struct a;
 
+	fd = __dev();
+	if (fd < 0) {
+		return RES_FAULT;
+	}
+	a.api = api;
+	a.rid = rid;
+	a.comp.cid = cid;
+	a.comp.ts = ts;
+	ret = write(fd, &a, sizeof(a));
 	return ret;
 }
 
@@ -113,14 +212,11 @@ static inline int __test(unsigned long cmd, unsigned long val)
 {
 	int fd, ret;
 
-	fd = open(RESCH_DEVNAME, O_RDWR);
+	fd = __dev();
 	if (fd < 0) {
-		printf("Error: failed to access the module!\n");
 		return RES_FAULT;
 	}
 	ret = ioctl(fd, cmd, &val);
-	close(fd);
-
 	return ret;
 }
 
@@ -186,17 +282,41 @@ int ros_rt_background(void)
 {
     return rt_background();
 }
+int ros_rt_set_attr(const struct rt_attr *attr)
+{
+    return rt_set_attr(attr);
+}
+int ros_rt_set_dag(const struct rt_dag_node *nodes, int nr_nodes,
+				   const struct rt_dag_edge *edges, int nr_edges)
+{
+    return (__api_dag(nodes, nr_nodes, edges, nr_edges) == RES_SUCCESS) ? 1 : 0;
+}
+/**
+ * map the statistics of callbacks read-only, so that they can be read
+ * by resch_cb_read() without system calls. return NULL on failure.
+ */
+const struct resch_cb_area *ros_rt_map_callbacks(void)
+{
+    void *p;
+    int fd = __dev();
+
+    if (fd < 0) {
+        return NULL;
+    }
+    p = mmap(NULL, sizeof(struct resch_cb_area), PROT_READ, MAP_SHARED, fd, 0);
+    return (p == MAP_FAILED) ? NULL : (const struct resch_cb_area *)p;
+}
 int ros_rt_set_node(unsigned long node_index)
 {
-    return (__api_int(API_SET_NODE, node_index) == RES_FAULT) ? 0 : 1;
+    return (__api_int(API_SET_NODE, node_index) == RES_SUCCESS) ? 1 : 0;
 }
 int ros_rt_start_callback(unsigned long node_index)
 {
-    return (__api_int(API_START_CALLBACK, node_index) == RES_FAULT) ? 0 : 1;
+    return (__api_int(API_START_CALLBACK, node_index) == RES_SUCCESS) ? 1 : 0;
 }
 int ros_rt_end_callback(unsigned long node_index)
 {
-    return (__api_int(API_END_CALLBACK, node_index) == RES_FAULT) ? 0 : 1;
+    return (__api_int(API_END_CALLBACK, node_index) == RES_SUCCESS) ? 1 : 0;
 }
 
 /************************************************************
@@ -222,6 +342,11 @@ int rt_init(void)
 	sa_xcpu.sa_flags = 0;
 	sigaction(SIGXCPU, &sa_xcpu, NULL);
 
+	/* keep the device open for the following APIs. */
+	if (__dev() < 0) {
+		return -1;
+	}
+
 	rid = __api(API_INIT);
 	return rid;
 }
@@ -298,6 +423,29 @@ int rt_background(void)
 	return (__api(API_BACKGROUND) == RES_FAULT) ? 0 : 1;
 }
 
+int rt_set_attr(const struct rt_attr *attr)
+{
+	return (__api_attr(attr) == RES_FAULT) ? 0 : 1;
+}
+
+/**
+ * map the context switches traced by the RESCH core read-only, so that
+ * they can be read by resch_trace_read() without system calls.
+ * return NULL on failure, e.g., if RESCH is not configured to trace.
+ */
+const struct resch_trace_area *rt_map_trace(void)
+{
+	void *p;
+	int fd = __dev();
+
+	if (fd < 0) {
+		return NULL;
+	}
+	p = mmap(NULL, sizeof(struct resch_trace_area), PROT_READ, MAP_SHARED,
+			 fd, RESCH_TRACE_MMAP_OFFSET);
+	return (p == MAP_FAILED) ? NULL : (const struct resch_trace_area *)p;
+}
+
 /*******************************************************
  * PORT-II APIs for event-driven asynchrous scheduling.
  *******************************************************/
@@ -357,6 +505,45 @@ int rt_server_run(void)
 	return (__api(API_SERVER_RUN) == RES_FAULT) ? 0 : 1;
 }
 
+/**************************************************
+ * PORT-V APIs for hierarchical scheduling.
+ **************************************************/
+
+int rt_component_create(int cid)
+{
+	/* the component ID is returned as is, like the RESCH ID. */
+	if (__dev() < 0) {
+		return -1;
+	}
+	return __api_int(API_COMPONENT_CREATE, cid);
+}
+
+int rt_component_destroy(int cid)
+{
+	return (__api_int(API_COMPONENT_DESTROY, cid) == RES_FAULT) ? 0 : 1;
+}
+
+int rt_component_period(int cid, struct timespec ts)
+{
+	return (__api_comp(API_COMPONENT_PERIOD, cid, ts) == RES_FAULT) ? 0 : 1;
+}
+
+int rt_component_budget(int cid, struct timespec ts)
+{
+	return (__api_comp(API_COMPONENT_BUDGET, cid, ts) == RES_FAULT) ? 0 : 1;
+}
+
+int rt_compose(int cid)
+{
+	/* refused also while the component has no period. */
+	return (__api_int(API_COMPOSE, cid) == RES_SUCCESS) ? 1 : 0;
+}
+
+int rt_decompose(void)
+{
+	return (__api(API_DECOMPOSE) == RES_FAULT) ? 0 : 1;
+}
+
 /*****************************************************
  *                 test functions                    *
  *****************************************************/
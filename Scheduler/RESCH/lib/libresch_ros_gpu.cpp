@@ -1,133 +1,287 @@
+#include <errno.h>
+#include <limits.h>
+#include <linux/futex.h>
 #include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <sys/resource.h>
 #include <sys/shm.h>
+#include <sys/syscall.h>
 #include <sys/time.h>
 #include <sys/wait.h>
+#include <time.h>
 #include <unistd.h>
 #include <fstream>
 #include <iostream>
 #include <queue>
 #include "api_ros_gpu.h"
 
-pthread_mutex_t *launch_mutex;
-pthread_mutex_t *value_mutex;
-int *maxvalue;
+/* a process waiting for the launch token.
+   @granted is the futex word the waiter sleeps on. */
+struct gsched_waiter
+{
+  int prio;
+  unsigned int seq;  /* FIFO order among the same priority. */
+  int granted;
+  int in_use;
+};
 
-int shm_launch_mutex_id;
-int shm_value_mutex_id;
-int shm_maxvalue_id;
+/* the launch token and the priority queue of its waiters.
+   it lives in shared memory created by ros_gsched_init() and inherited
+   by the forked processes. */
+struct gsched_queue
+{
+  pthread_mutex_t lock;
+  int busy;  /* the token is held by someone. */
+  int nr_waiters;
+  unsigned int seq;
+  int heap[GSCHED_MAX_WAITERS];  /* indices of waiters, highest priority first. */
+  struct gsched_waiter waiters[GSCHED_MAX_WAITERS];
+  struct ros_gsched_stat stat;
+};
 
-int ros_gsched_init()
+static struct gsched_queue *gsched_queue;
+int shm_gsched_queue_id;
+
+static inline int futex_wait(int *addr, int val)
 {
-  pthread_mutexattr_t mat_l, mat_v;
+  return syscall(SYS_futex, addr, FUTEX_WAIT, val, NULL, NULL, 0);
+}
 
-  shm_launch_mutex_id = shmget(IPC_PRIVATE, sizeof(pthread_mutex_t), 0600);
-  if (shm_launch_mutex_id < 0)
-  {
-    perror("shmget");
-    return 1;
-  }
+static inline int futex_wake(int *addr, int nr)
+{
+  return syscall(SYS_futex, addr, FUTEX_WAKE, nr, NULL, NULL, 0);
+}
 
-  shm_value_mutex_id = shmget(IPC_PRIVATE, sizeof(pthread_mutex_t), 0600);
-  if (shm_value_mutex_id < 0)
-  {
-    perror("shmget");
-    return 1;
-  }
+static inline unsigned long long gettime_ns(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/* true if waiter @a should be given the token before waiter @b. */
+static inline bool waiter_before(struct gsched_queue *q, int a, int b)
+{
+  struct gsched_waiter *wa = &q->waiters[a];
+  struct gsched_waiter *wb = &q->waiters[b];
+
+  if (wa->prio != wb->prio)
+    return wa->prio > wb->prio;
+  return (int)(wa->seq - wb->seq) < 0;
+}
+
+static void heap_push(struct gsched_queue *q, int w)
+{
+  int i = q->nr_waiters++;
 
-  shm_maxvalue_id = shmget(IPC_PRIVATE, sizeof(int), 0666);
-  if (shm_maxvalue_id < 0)
+  while (i > 0)
   {
-    perror("shmget");
-    return 1;
+    int parent = (i - 1) / 2;
+    if (!waiter_before(q, w, q->heap[parent]))
+      break;
+    q->heap[i] = q->heap[parent];
+    i = parent;
   }
+  q->heap[i] = w;
+}
 
-  launch_mutex = (pthread_mutex_t *)shmat(shm_launch_mutex_id, NULL, 0);
-  if (launch_mutex == (void *)-1)
+static int heap_pop(struct gsched_queue *q)
+{
+  int top = q->heap[0];
+  int last = q->heap[--q->nr_waiters];
+  int i = 0;
+
+  while (2 * i + 1 < q->nr_waiters)
   {
-    perror("shmat");
-    return 1;
+    int child = 2 * i + 1;
+    if (child + 1 < q->nr_waiters && waiter_before(q, q->heap[child + 1], q->heap[child]))
+      child++;
+    if (!waiter_before(q, q->heap[child], last))
+      break;
+    q->heap[i] = q->heap[child];
+    i = child;
   }
+  q->heap[i] = last;
+
+  return top;
+}
+
+/* must be called with the lock held. */
+static void account_wait(struct gsched_queue *q, unsigned long long wait_ns)
+{
+  struct ros_gsched_stat *stat = &q->stat;
+  unsigned long long us = wait_ns / 1000;
+  int bin = 0;
 
-  value_mutex = (pthread_mutex_t *)shmat(shm_value_mutex_id, NULL, 0);
-  if (value_mutex == (void *)-1)
+  while (us > 1 && bin < GSCHED_WAIT_BINS - 1)
   {
-    perror("shmat");
-    return 1;
+    us >>= 1;
+    bin++;
   }
 
-  maxvalue = (int *)shmat(shm_maxvalue_id, NULL, 0);
-  if (maxvalue == (void *)-1)
+  stat->nr_launches++;
+  if (wait_ns > 0)
+    stat->nr_waits++;
+  stat->total_wait_ns += wait_ns;
+  if (wait_ns > stat->max_wait_ns)
+    stat->max_wait_ns = wait_ns;
+  stat->v_histogram[bin]++;
+}
+
+int ros_gsched_init()
+{
+  pthread_mutexattr_t mat;
+
+  shm_gsched_queue_id = shmget(IPC_PRIVATE, sizeof(struct gsched_queue), 0600);
+  if (shm_gsched_queue_id < 0)
   {
-    perror("shmat");
+    perror("shmget");
     return 1;
   }
 
-  pthread_mutexattr_init(&mat_l);
-  if (pthread_mutexattr_setpshared(&mat_l, PTHREAD_PROCESS_SHARED) != 0)
+  gsched_queue = (struct gsched_queue *)shmat(shm_gsched_queue_id, NULL, 0);
+  if (gsched_queue == (void *)-1)
   {
-    perror("pthread_mutexattr_setpshared");
+    perror("shmat");
     return 1;
   }
+  memset(gsched_queue, 0, sizeof(struct gsched_queue));
 
-  pthread_mutexattr_init(&mat_v);
-  if (pthread_mutexattr_setpshared(&mat_v, PTHREAD_PROCESS_SHARED) != 0)
+  pthread_mutexattr_init(&mat);
+  if (pthread_mutexattr_setpshared(&mat, PTHREAD_PROCESS_SHARED) != 0)
   {
     perror("pthread_mutexattr_setpshared");
     return 1;
   }
-
-  pthread_mutex_init(launch_mutex, &mat_l);
-  pthread_mutex_init(value_mutex, &mat_v);
-
-  *maxvalue = 0;
+  pthread_mutex_init(&gsched_queue->lock, &mat);
+  pthread_mutexattr_destroy(&mat);
 
   return 0;
 }
 
+/**
+ * wait for the launch token with the nice value of the caller as the
+ * priority. as before, the larger value is served first.
+ */
 int ros_gsched_enqueue()
 {
-  int my_prio;
-  int ret;
+  return ros_gsched_enqueue_prio(getpriority(PRIO_PROCESS, 0));
+}
+
+/**
+ * wait for the launch token. the waiter sleeps on its own futex until
+ * ros_gsched_dequeue() hands the token over, so it neither polls nor
+ * gets woken up for the tokens given to others.
+ */
+int ros_gsched_enqueue_prio(int prio)
+{
+  struct gsched_queue *q = gsched_queue;
+  struct gsched_waiter *waiter;
+  unsigned long long begin;
+  int w;
 
-  my_prio = getpriority(PRIO_PROCESS, 0);
+  pthread_mutex_lock(&q->lock);
 
-  while (1)
+  /* the token is free and nobody is waiting: take it at once. */
+  if (!q->busy)
   {
-    if (my_prio > *maxvalue)
-    {
-      pthread_mutex_lock(value_mutex);
-      *maxvalue = my_prio;
-      pthread_mutex_unlock(value_mutex);
-    }
+    q->busy = 1;
+    account_wait(q, 0);
+    pthread_mutex_unlock(&q->lock);
+    return 0;
+  }
+
+  for (w = 0; w < GSCHED_MAX_WAITERS; w++)
+  {
+    if (!q->waiters[w].in_use)
+      break;
+  }
+  if (w == GSCHED_MAX_WAITERS)
+  {
+    pthread_mutex_unlock(&q->lock);
+    fprintf(stderr, "ros_gsched_enqueue: too many waiters\n");
+    return 1;
+  }
 
-    /* sleep for scheduling bloked launch requirement */
-    usleep(10);
+  begin = gettime_ns();
+  waiter = &q->waiters[w];
+  waiter->in_use = 1;
+  waiter->granted = 0;
+  waiter->prio = prio;
+  waiter->seq = q->seq++;
+  heap_push(q, w);
 
-    if (*maxvalue == my_prio)
+  pthread_mutex_unlock(&q->lock);
+
+  while (!__atomic_load_n(&waiter->granted, __ATOMIC_ACQUIRE))
+  {
+    if (futex_wait(&waiter->granted, 0) < 0 && errno != EAGAIN && errno != EINTR)
     {
-      if (!(ret = pthread_mutex_trylock(launch_mutex)))
-      {
-        pthread_mutex_lock(value_mutex);
-        *maxvalue = -1;
-        pthread_mutex_unlock(value_mutex);
-        break;
-      }
+      perror("futex");
+      return 1;
     }
   }
 
+  /* the token has been passed without being released. */
+  pthread_mutex_lock(&q->lock);
+  waiter->in_use = 0;
+  account_wait(q, gettime_ns() - begin);
+  pthread_mutex_unlock(&q->lock);
+
   return 0;
 }
 
+/**
+ * release the launch token. if someone is waiting, the token goes
+ * directly to the waiter of the highest priority.
+ */
 int ros_gsched_dequeue()
 {
-  if (pthread_mutex_unlock(launch_mutex) != 0)
+  struct gsched_queue *q = gsched_queue;
+  struct gsched_waiter *waiter;
+
+  pthread_mutex_lock(&q->lock);
+
+  if (!q->busy)
   {
-    perror("pthread_mutex_unlock");
+    pthread_mutex_unlock(&q->lock);
+    fprintf(stderr, "ros_gsched_dequeue: the token is not held\n");
     return 1;
   }
+
+  if (q->nr_waiters == 0)
+  {
+    q->busy = 0;
+    pthread_mutex_unlock(&q->lock);
+    return 0;
+  }
+
+  waiter = &q->waiters[heap_pop(q)];
+  __atomic_store_n(&waiter->granted, 1, __ATOMIC_RELEASE);
+  futex_wake(&waiter->granted, 1);
+
+  pthread_mutex_unlock(&q->lock);
+
+  return 0;
+}
+
+int ros_gsched_get_stat(struct ros_gsched_stat *stat)
+{
+  pthread_mutex_lock(&gsched_queue->lock);
+  *stat = gsched_queue->stat;
+  pthread_mutex_unlock(&gsched_queue->lock);
+
+  return 0;
+}
+
+int ros_gsched_reset_stat()
+{
+  pthread_mutex_lock(&gsched_queue->lock);
+  memset(&gsched_queue->stat, 0, sizeof(gsched_queue->stat));
+  pthread_mutex_unlock(&gsched_queue->lock);
+
   return 0;
 }
 
@@ -135,23 +289,11 @@ int ros_gsched_exit(bool option)
 {
   if (option == false)
   {
-    shmdt(launch_mutex);
-    shmdt(value_mutex);
-    shmdt(maxvalue);
+    shmdt(gsched_queue);
   }
   else
   {
-    if (shmctl(shm_launch_mutex_id, IPC_RMID, NULL) != 0)
-    {
-      perror("shmctl");
-      return 1;
-    }
-    if (shmctl(shm_value_mutex_id, IPC_RMID, NULL) != 0)
-    {
-      perror("shmctl");
-      return 1;
-    }
-    if (shmctl(shm_maxvalue_id, IPC_RMID, NULL) != 0)
+    if (shmctl(shm_gsched_queue_id, IPC_RMID, NULL) != 0)
     {
       perror("shmctl");
       return 1;
@@ -12,6 +12,7 @@
 #include <linux/kthread.h>
 #include <linux/module.h>
 #include <linux/time.h>
+#include <resch-analysis.h>
 #include <resch-core.h>
 
 MODULE_LICENSE("Dual BSD/GPL");
@@ -20,24 +21,20 @@ MODULE_AUTHOR("Shinpei Kato");
 
 #define MODULE_NAME	"edf-wm"
 
-#ifdef RESCH_HARD_RT
-#define C wcet
-#else /* RESCH_SOFT_RT */
-#define C runtime
-#endif
 #define task_is_split(rt) (edf_wm_task[(rt)->rid].deadline > 0)
-#define split_is_on_cpu(rt, cpu) (edf_wm_task[(rt)->rid].runtime[cpu] > 0)
-#define edf_wm_task_is_on_cpu(rt, cpu)	\
-	(task_is_on_cpu(rt, cpu) || split_is_on_cpu(rt, cpu))
 #ifdef EDF_WM_FIRST_FIT
-#define partition(rt) cpu_first_fit(rt)
+#define partition(ts, t) sa_edf_first_fit(ts, t)
+#else
+#define partition(ts, t) sa_edf_worst_fit(ts, t)
+#endif
+#ifdef EDF_WM_FAIR_SPLIT
+#define EDF_WM_FAIR	true
 #else
-#define partition(rt) cpu_worst_fit(rt)
+#define EDF_WM_FAIR	false
 #endif
 
 /* available options. */
 //#define EDF_WM_FIRST_FIT
-//#define EDF_WM_ALWAYS_SPLIT
 //#define EDF_WM_FAIR_SPLIT
 
 #ifndef SCHED_DEADLINE
@@ -55,8 +52,9 @@ typedef struct edf_wm_task_struct {
 	int first_cpu;
 	int last_cpu;
 	resch_task_t *rt;
-	unsigned long deadline;
-	unsigned long runtime[NR_RT_CPUS];
+	unsigned long deadline;				/* by jiffies */
+	unsigned long window;				/* by microseconds */
+	unsigned long runtime[NR_RT_CPUS];	/* by microseconds */
 	struct list_head migration_list;
 	struct hrtimer migration_hrtimer;
 	u64 next_release;
@@ -136,454 +134,34 @@ static void clear_split_task(resch_task_t *rt)
 	et->last_cpu = RESCH_CPU_UNDEFINED;
 	et->rt = NULL;
 	et->deadline = 0;
+	et->window = 0;
 	for (cpu = 0; cpu < NR_RT_CPUS; cpu++) {
 		et->runtime[cpu] = 0;
 	}
 }
 
-static inline unsigned long max_ulong(unsigned long x, unsigned long y)
-{
-	return x > y ? x : y;
-}
-
-static inline unsigned long floor_ulong(unsigned long x, unsigned long y)
-{
-	if (x >= 0) {
-		return (unsigned long) (x / y);
-	}
-	else {
-		if (x % y == 0)
-			return (unsigned long)(x / y);
-		else
-			return (unsigned long)(x / y) - 1;
-	}
-}
-
-static inline unsigned long util(resch_task_t *p)
-{
-	return 100 * p->C / jiffies_to_usecs(p->period);
-}
-
-static inline unsigned long util_split(resch_task_t *p, int cpu)
-{
-	return 100 * edf_wm_task[p->rid].runtime[cpu] / jiffies_to_usecs(p->period);
-}
-
-static unsigned long util_cpu(int cpu)
-{
-	resch_task_t *p;
-	unsigned long u = 0;
-
-	/* compute for tasks assigned to @cpu. */
-	p = global_highest_prio_task();
-	while (p) {
-		if (split_is_on_cpu(p, cpu)) {
-			u += util_split(p, cpu);
-		}
-		else if (task_is_on_cpu(p, cpu)) {
-			u += util(p);
-		}
-		p = global_next_prio_task(p);
-	}
-
-	return u;
-}
-
-static inline int cpu_low_util(void)
-{
-	int cpu, cpu_low;
-	resch_task_t *p;
-	unsigned long u[NR_RT_CPUS+1] = {[0 ... NR_RT_CPUS] = 0};
-
-	p = global_highest_prio_task();
-	while (p) {
-		if (split_is_on_cpu(p, cpu)) {
-			u[p->cpu_id] += util_split(p, cpu);
-		}
-		else if (task_is_on_cpu(p, cpu)) {
-			u[p->cpu_id] += util(p);
-		}
-		p = global_next_prio_task(p);
-	}
-	cpu_low = 0;
-	for (cpu = 1; cpu < NR_RT_CPUS; cpu++) {
-		if (u[cpu] < u[cpu_low]) {
-			cpu_low = cpu;
-		}
-	}
-	return cpu_low;
-}
-
-/**
- * return the scheduling overhead by jiffies in the given interval.
- * the global list must be locked.
- */
-static unsigned long overhead(resch_task_t *rt, unsigned long L, int cpu)
-{
-	unsigned long us = sched_overhead_cpu(cpu, L) + sched_overhead_task(rt, L);
-	return usecs_to_jiffies(us); /* always round up. */
-}
-
-/**
- * return the time length by jiffies, during which DBF should be tested 
- * on the give CPU.
- * the global list must be locked.
- */
-static unsigned long dbf_len(int cpu, resch_task_t *rt)
-{
-	resch_task_t *p;
-	unsigned long x = 0, u = 0, d = 0;
-
-	/* compute for tasks assigned to @cpu. */
-	p = global_highest_prio_task();
-	while (p) {
-		if (split_is_on_cpu(p, cpu)) {
-			x += max_ulong(0, p->period - edf_wm_task[p->rid].deadline) * 
-				util_split(p, cpu);
-			u += util_split(p, cpu);
-			d = max_ulong(d, edf_wm_task[p->rid].deadline);
-		}
-		else if (task_is_on_cpu(p, cpu)) {
-			x += max_ulong(0, p->period - p->deadline) * util(p);
-			u += util(p);
-			d = max_ulong(d, p->deadline);
-		}
-		p = global_next_prio_task(p);
-	}
-
-	/* compute for @rt. */
-	if (split_is_on_cpu(rt, cpu)) {
-		unsigned long deadline = edf_wm_task[rt->rid].deadline;
-		x += max_ulong(0, rt->period - deadline) * util_split(rt, cpu);
-		u += util_split(rt, cpu);
-		d = max_ulong(d, deadline);
-	}
-	else {
-		x += max_ulong(0, rt->period - rt->deadline) * util(rt);
-		u += util(rt);
-		d = max_ulong(d, rt->deadline);
-	}
-
-	/* if total utilization is equal to 100%, just return the max deadline.
-	   dbf_test() will anyway reject the given task. */
-	if (100 == u) {
-		return d;
-	}
-	else if (100 < u) {
-		return 0;
-	}
-	else {
-		return max_ulong(x / (100 - u), d);
-	}
-}
-
-/**
- * compute the demand bound of @rt in the given interval. 
- */
-static unsigned long dbf_task(resch_task_t *rt, unsigned long L, int cpu)
-{
-	if (split_is_on_cpu(rt, cpu)) {
-		unsigned long jf;
-		edf_wm_task_t *et = &edf_wm_task[rt->rid];
-		if (L < et->deadline) {
-			return 0;
-		}
-		jf = max_ulong(0, (L - et->deadline) / rt->period + 1) * 
-			et->runtime[cpu];
-		return jf;
-	}
-	else {
-		unsigned long us;
-		if (L < rt->deadline) {
-			return 0;
-		}
-		us = max_ulong(0, (L - rt->deadline) / rt->period + 1) * rt->C;
-		return usecs_to_jiffies(us);
-	}
-}
-
 /**
- * compute the total demand bound on @cpu in the given interval. 
- */
-static inline unsigned long dbf_cpu(unsigned long L, int cpu)
-{
-	resch_task_t *p;
-	unsigned long dbf_sum = 0;
-
-	p = global_highest_prio_task();
-	while (p) {
-		if (edf_wm_task_is_on_cpu(p, cpu)) {
-			dbf_sum += dbf_task(p, L, cpu);
-		}
-		p = global_next_prio_task(p);
-	}
-
-	return dbf_sum;
-}
-
-/**
- * schedulability test based on the demand bound function (DBF). 
+ * try to split the given task across multiple CPUs. 
  */
-static inline int dbf_test(int cpu , resch_task_t *rt)
-{
-	resch_task_t *p;
-	unsigned long L, Lmax;
-
-	/* if the execution time is zero, it is obviously schedulable. */
-	if (rt->C == 0) {
-		return true;
-	}
-
-	/* length of dbf test. */
-	if ((Lmax = dbf_len(cpu, rt)) == 0) {
-		return false;
-	}
-
-	/* check for deadlines of tasks assigned to @cpu. */
-	p = global_highest_prio_task();
-	while (p) {
-		if (split_is_on_cpu(p, cpu)) {
-			L = edf_wm_task[p->rid].deadline;
-		}
-		else if (task_is_on_cpu(p, cpu)) {
-			L = p->deadline;
-		}
-		else {
-			p = global_next_prio_task(p);
-			continue;
-		}
-
-		while (L <= Lmax) {
-			if (dbf_cpu(L, cpu) + dbf_task(rt, L, cpu) + 
-				overhead(rt, L, cpu) > L) {
-				return false;
-			}
-			L += p->period;
-		}
-		p = global_next_prio_task(p);
-	}
-
-	/* check for deadlines of @rt. */
-	L = rt->deadline;
-	while (L <= Lmax) {
-		if (dbf_cpu(L, cpu) + dbf_task(rt, L, cpu) + 
-			overhead(rt, L, cpu) > L) {
-			return false;
-		}
-		L += rt->period;
-	}
-
-	return true;
-}
-
-#ifdef EDF_WM_FIRST_FIT
-static int cpu_first_fit(resch_task_t *rt)
+static int split(sa_taskset_t *ts, resch_task_t *rt, sa_task_t *t)
 {
 	int cpu;
-
-	/* this is a first-fit assignment. */
-	for (cpu = 0; cpu < NR_RT_CPUS; cpu++) {
-		/* check the default CPU mask. */
-		if (!cpu_isset(cpu, rt->task->cpus_allowed)) {
-			continue;
-		}
-
-		/* demand bound function test. */
-		if (dbf_test(cpu, rt)) {
-			return cpu;
-		}
-	}
-
-	return RESCH_CPU_UNDEFINED;
-}
-#else
-static int cpu_worst_fit(resch_task_t *rt)
-{
-	int cpu, cpu_dst = RESCH_CPU_UNDEFINED;
-	unsigned long u, u_dst = 100;
-
-	/* this is a first-fit assignment. */
-	for (cpu = 0; cpu < NR_RT_CPUS; cpu++) {
-		/* check the default CPU mask. */
-		if (!cpu_isset(cpu, rt->task->cpus_allowed)) {
-			continue;
-		}
-
-		/* demand bound function test. */
-		if (dbf_test(cpu, rt)) {
-			u = util_cpu(cpu);
-			if (u < u_dst) {
-				u_dst = u;
-				cpu_dst = cpu;
-			}
-		}
-	}
-
-	return cpu_dst;
-}
-#endif
-
-/**
- * compute the runtime for each split piece of the given task.
- */
-static int set_split_runtime(resch_task_t *rt, int cpu)
-{
-	unsigned long L, Lmax = ~(0UL);
-	unsigned long remain, runtime, runtime_min;
-	resch_task_t *p;
 	edf_wm_task_t *et = &edf_wm_task[rt->rid];
 
-	runtime_min = (100 - util_cpu(cpu)) * rt->period / 100;
-
-	/* check for deadlines of tasks assigned to @cpu. */
-	p = global_highest_prio_task();
-	while (p) {
-		if (split_is_on_cpu(p, cpu)) {
-			L = et->deadline;
-		}
-		else if (task_is_on_cpu(p, cpu)) {
-			L = p->deadline;
-		}
-		else {
-			p = global_next_prio_task(p);
-			continue;
-		}
-
-		while (L <= Lmax) {
-			remain = L - (dbf_cpu(L, cpu) + overhead(rt, L, cpu));
-			runtime = remain / (floor_ulong(L - et->deadline, rt->period) + 1);
-			/* renew runtime and reduce Lmax. */
-			if (runtime <= runtime_min) {
-				runtime_min = runtime;
-				if (runtime_min == 0) {
-					goto out;
-				}
-				et->runtime[cpu] = runtime_min;
-				Lmax = dbf_len(cpu, rt);
-				et->runtime[cpu] = 0;
-			}
-			L += p->period;
-		}
-		p = global_next_prio_task(p);
-	}
-
-	/* check for deadlines of @rt. */
-	L = et->deadline;
-	while (L <= Lmax) {
-		remain = L - (dbf_cpu(L, cpu) + overhead(rt, L, cpu));
-		runtime = remain / (floor_ulong(L - et->deadline, rt->period) + 1);
-		/* renew runtime and reduce Lmax. */
-		if (runtime <= runtime_min) {
-			runtime_min = runtime;
-			if (runtime == 0) {
-				goto out;
-			}
-			et->runtime[cpu] = runtime_min;
-			Lmax = dbf_len(cpu, rt);
-			et->runtime[cpu] = 0;
-		}
-		L += rt->period;
-	}
-
- out:
-	et->runtime[cpu] = runtime_min;
-	return true;
-}
-
-/**
- * sort the the CPU ID in decreasing order of runtimes.
- */
-static void sort_runtime(unsigned long runtime[], int cpu_id[])
-{
-	int i, j;
-
-	for (i = 0; i < NR_RT_CPUS; i++) {
-		cpu_id[i] = i;
+	if (sa_edf_wm_split(ts, t, EDF_WM_FAIR) == RESCH_CPU_UNDEFINED) {
+		return RESCH_CPU_UNDEFINED;
 	}
-	for (i = 0; i < NR_RT_CPUS - 1; i++) {
-		for (j = NR_RT_CPUS - 1; j > i; j--) {
-			if (runtime[cpu_id[j]] > runtime[cpu_id[j-1]]) {
-				int tmp;
-				tmp = cpu_id[j];
-				cpu_id[j] = cpu_id[j-1];
-				cpu_id[j-1] = tmp;
-			}
-		}
-	}
-}
-
-/**
- * try to split the given task across multiple CPUs. 
- */
-static int split(resch_task_t *rt)
-{
-	int i;
-	int num;
-	int cpu, cpu_id[NR_RT_CPUS];
-	unsigned long sum_runtime;
-	edf_wm_task_t *et;
 
-	/* try splitting the task. */
-	num = 2;
-	et = &edf_wm_task[rt->rid];
- try_split:
-	et->deadline = rt->deadline / num;
-	sum_runtime = 0;
+	et->rt = rt;
+	et->first_cpu = t->first_cpu;
+	et->last_cpu = t->last_cpu;
+	et->window = t->window;
+	et->deadline = usecs_to_jiffies(t->window);
 	for (cpu = 0; cpu < NR_RT_CPUS; cpu++) {
-		set_split_runtime(rt, cpu);
-	}
-
-	/* select the largest num values. */
-	sort_runtime(et->runtime, cpu_id);
-	for (i = 0; i < num; i++) {
-		if (et->runtime[cpu_id[i]] > et->deadline) {
-			et->runtime[cpu_id[i]] = et->deadline;
-		}
-		sum_runtime += et->runtime[cpu_id[i]];
-		if (et->runtime[cpu_id[i]] > 0) {
-			if (et->first_cpu == RESCH_CPU_UNDEFINED || 
-				et->first_cpu > cpu_id[i]) {
-				et->first_cpu = cpu_id[i];
-			}
-			if (et->last_cpu == RESCH_CPU_UNDEFINED || 
-				et->last_cpu < cpu_id[i]) {
-				et->last_cpu = cpu_id[i];
-			}
-		}
-	}
-
-	if (jiffies_to_usecs(sum_runtime) >= rt->C) {
-#ifdef EDF_WM_FAIR_SPLIT
-		unsigned long over = (jiffies_to_usecs(sum_runtime) - rt->C) / num;
-		for (i = 0; i < num; i++) {
-			et->runtime[cpu_id[i]] -= over;
-		}
-#else
-		unsigned long over = jiffies_to_usecs(sum_runtime) - rt->C;
-		et->runtime[et->last_cpu] -= usecs_to_jiffies(over);
-#endif
-		et->rt = rt;
-		for (i = num; i < NR_RT_CPUS; i++) {
-			et->runtime[cpu_id[i]] = 0;
-		}
-		return et->first_cpu;
+		et->runtime[cpu] = t->runtime[cpu];
 	}
 
-	/* try to split across more CPUs. */
-	num++;
-	if (num <= NR_RT_CPUS) {
-		clear_split_task(rt);
-		goto try_split;
-	}
-
-#ifdef EDF_WM_ALWAYS_SPLIT
 	return et->first_cpu;
-#else
-	clear_split_task(rt);
-	return RESCH_CPU_UNDEFINED;
-	/* return cpu_low_util(); */
-#endif
-
 }
 
 /**
@@ -594,6 +172,8 @@ static int split(resch_task_t *rt)
 static void task_run(resch_task_t *rt)
 {
 	int cpu_dst;
+	sa_taskset_t *ts;
+	sa_task_t *t;
 
 	/* aperiodic tasks are just skipped. */
 	if (!rt->period) {
@@ -607,16 +187,17 @@ static void task_run(resch_task_t *rt)
 	global_list_down();
 
 	/* try partitioning. */
-	if ((cpu_dst = partition(rt)) != RESCH_CPU_UNDEFINED) {
+	t = sa_global_admit(&ts, rt);
+	if ((cpu_dst = partition(ts, t)) != RESCH_CPU_UNDEFINED) {
 		/* schedulable. */
 		goto out; 
 	}
 
 	/* try splitting. */
-	cpu_dst = split(rt);
+	cpu_dst = split(ts, rt, t);
 
  out:
-	rt->cpu_id = cpu_dst; /* this is safe. */
+	assign_task_cpu(rt, cpu_dst); /* this is safe. */
 	global_list_up();
 
 	/* if partitioning succeeded, migrate @p to the cpu. 
@@ -627,7 +208,7 @@ static void task_run(resch_task_t *rt)
 			unsigned long runtime_save = et->rt->runtime;
 			et->sched_deadline = et->rt->task->dl.sched_deadline;
 			et->rt->deadline = et->deadline;
-			et->rt->runtime = jiffies_to_usecs(et->runtime[et->first_cpu]);
+			et->rt->runtime = et->runtime[et->first_cpu];
 			/* change the deadline. */
 			set_scheduler(et->rt, RESCH_SCHED_EDF, rt->prio);
 			et->sched_split_deadline = et->rt->task->dl.sched_deadline;
@@ -691,7 +272,6 @@ static void migration_thread(void *__data)
 {
 	int cpu = (long) __data;
 	edf_wm_task_t *et;
-	struct timespec ts;
 
 	set_current_state(TASK_INTERRUPTIBLE);
 	while (!kthread_should_stop()) {
@@ -711,8 +291,7 @@ static void migration_thread(void *__data)
 		spin_unlock_irq(&kthread[cpu].lock);
 
 		/* account runtime. */
-		jiffies_to_timespec(et->runtime[cpu], &ts);
-		et->rt->task->dl.sched_runtime = timespec_to_ns(&ts);
+		et->rt->task->dl.sched_runtime = et->runtime[cpu] * NSEC_PER_USEC;
 
 		/* trace precise deadlines. */
 		et->rt->deadline_time += et->deadline;
@@ -730,8 +309,7 @@ static void migration_thread(void *__data)
 		et->rt->task->dl.sched_deadline = et->sched_deadline;
 
 		/* account runtime. */
-		jiffies_to_timespec(et->runtime[cpu], &ts);
-		et->rt->task->dl.runtime = timespec_to_ns(&ts);
+		et->rt->task->dl.runtime = et->runtime[cpu] * NSEC_PER_USEC;
 
 		/* activate the timer for the next migration of this task. */
 		if (et->last_cpu != cpu) {
@@ -35,6 +35,7 @@
 #include <linux/kthread.h>
 #include <linux/module.h>
 #include <linux/sched.h>
+#include <resch-analysis.h>
 #include <resch-core.h>
 
 MODULE_LICENSE("Dual BSD/GPL");
@@ -43,17 +44,8 @@ MODULE_AUTHOR("Shinpei Kato");
 
 #define MODULE_NAME	"fp-pm"
 
-#ifdef RESCH_HARD_RT
-#define C wcet
-#else /* RESCH_SOFT_RT */
-#define C runtime
-#endif
-
 #define task_is_split(rt) \
 	(fppm_task[(rt)->rid].first_cpu != fppm_task[(rt)->rid].last_cpu)
-#define split_is_on_cpu(rt, cpu) (fppm_task[(rt)->rid].runtime[cpu] > 0)
-#define fppm_task_is_on_cpu(rt, cpu)	\
-	(task_is_on_cpu(rt, cpu) || split_is_on_cpu(rt, cpu))
 
 #define FPPM_PRIO_MIGRATORY		(RESCH_PRIO_KTHREAD - 1)
 
@@ -74,8 +66,6 @@ struct kthread_struct {
 	spinlock_t lock;
 } kthread[NR_RT_CPUS];
 
-int cpu_available[NR_RT_CPUS] = {[0 ... NR_RT_CPUS-1] = true};
-
 static void request_migration(fppm_task_t *ft, int cpu_dst)
 {
 	unsigned long flags;
@@ -144,214 +134,27 @@ static inline void clear_split_task(resch_task_t *rt)
 	}
 }
 
-/**
- * compute the worst-case response time of @rt on the given CPU.
- * this is an extension of the original response_time_analysis()
- * defined in resch.c in that it takes into accout the migratory tasks.
- * it also sets cpu_avaialble flags.
- * the global list must be locked.
- */
-static unsigned long fppm_response_time_analysis(resch_task_t *rt, int cpu) 
-{
-	int F;
-	unsigned long ret;
-	unsigned long Pk, Ck;
-	unsigned long L;
-	unsigned long overhead;
-	resch_task_t *hp;
-
-	ret = 0;
-	overhead = 0;
-	L = jiffies_to_usecs(rt->deadline);
-	hp = global_highest_prio_task();
-	while (hp && hp->prio >= rt->prio) {
-		Pk = jiffies_to_usecs(hp->period);
-		Ck = 0;
-
-		if (split_is_on_cpu(hp, cpu)) {
-			fppm_task_t *ft = &fppm_task[hp->rid];
-			Ck = ft->runtime[cpu];
-			/* this CPU becomes unavailable if not the last CPU of @hp */
-			if (ft->last_cpu != cpu) {
-				cpu_available[cpu] = false;
-			}
-		}
-		else if (task_is_on_cpu(hp, cpu) && hp != rt) {
-			Ck = hp->C;
-		}
-
-		if (Ck != 0) {
-			F = L / Pk;
-			if (L >= Pk * F + Ck) {
-				ret += Ck * (F + 1);
-			}
-			else {
-				ret += L - F * (Pk - Ck);
-			}
-		}
-		hp = global_next_prio_task(hp);
-	}
-
-	return ret + rt->C + 
-		sched_overhead_cpu(cpu, L) + sched_overhead_task(rt, L);
-}
-
-/**
- * try to assign the given task to a particular CPU.
- */
-static int partition(resch_task_t *rt)
-{
-	int cpu;
-	int success;
-	int F;
-	unsigned long Ri, Di, Pi, Ci;
-	unsigned long Rk, Dk;
-	resch_task_t *lp;
-
-	/* deadline, period, and execution time. */
-	Di = jiffies_to_usecs(rt->deadline);
-	Pi = jiffies_to_usecs(rt->period);
-	Ci = rt->C;
-
-	for (cpu = 0; cpu < NR_RT_CPUS; cpu++) {
-		/* check the default CPU mask. */
-		if (!cpu_isset(cpu, rt->task->cpus_allowed)) {
-			continue;
-		}
-
-		/* first, get the response time of the task on this cpu. */
-		Ri = fppm_response_time_analysis(rt, cpu);
-		if (Ri > Di) {
-			continue;
-		}
-
-		/* skip all higher-priority tasks, and get the first task whose
-		   priority is less than or equal to @rt. */
-		lp = global_prio_task(rt->prio);
-
-		/* for the tasks with priorities lower than or equal to @rt. */
-		success = true;
-		while (lp) {
-			if (!fppm_task_is_on_cpu(lp, cpu)) {
-				lp = global_next_prio_task(lp);
-				continue;
-			}
-			Rk = fppm_response_time_analysis(lp, cpu);
-			Dk = jiffies_to_usecs(lp->deadline);
-			lp = global_next_prio_task(lp);
-
-			/* take also into account @rt. */
-			F = Dk / Pi;
-			if (Dk >= Pi * F + Ci) {
-				Rk += Ci * (F + 1);
-			}
-			else {
-				Rk += Dk - F * (Pi - Ci);
-			}
-
-			/* get unschedulable? */
-			if (Rk > Dk) {
-				success = false;
-				break;
-			}
-		}
-
-		if (success) {
-			return cpu;
-		}
-	}
-	
-	return RESCH_CPU_UNDEFINED;
-}
-
 /**
  * try to split the given task across multiple CPUs.
  */
-static int split(resch_task_t *rt)
+static int split(sa_taskset_t *ts, resch_task_t *rt, sa_task_t *t)
 {
 	int cpu;
-	int F;
-	unsigned long split_runtime, sum_split_runtime, tmp;
-	unsigned long Di, Pi, Ci;
-	unsigned long Rk, Dk;
-	resch_task_t *lp;
 	fppm_task_t *ft	= &fppm_task[rt->rid];
 
-	/* deadline, period, and execution time. */
-	Di = jiffies_to_usecs(rt->deadline);
-	Pi = jiffies_to_usecs(rt->period);
-	Ci = rt->C;
+	if (sa_fp_pm_split(ts, t) == RESCH_CPU_UNDEFINED) {
+		return RESCH_CPU_UNDEFINED;
+	}
 
-	sum_split_runtime = 0;
+	/* initialize as a migratory task. */
+	ft->rt = rt;
+	ft->first_cpu = t->first_cpu;
+	ft->last_cpu = t->last_cpu;
 	for (cpu = 0; cpu < NR_RT_CPUS; cpu++) {
-		if (cpu_available[cpu]) {
-			split_runtime = 0;
-			lp = global_highest_prio_task();
-			while (lp) {
-				if (!fppm_task_is_on_cpu(lp, cpu)) {
-					lp = global_next_prio_task(lp);
-					continue;
-				}
-
-				Rk = fppm_response_time_analysis(lp, cpu);
-				Dk = jiffies_to_usecs(lp->deadline);
-				lp = global_next_prio_task(lp);
-
-				/* task @lp should be schedulable... */
-				if (unlikely(Dk < Rk)) {
-					split_runtime = 0;
-					break;
-				}
-
-				/* compute the upper bound of execution capacity that 
-				   can be assigned to task @p on each CPU. */
-				F = Dk / Pi;
-				if (F == 0) {
-					tmp = (Dk - Rk) / (F + 1);
-				}
-				else {
-					/* just reduce divisions as many as possible. */
-					if (F * (Dk - Rk) >= (F * Pi - Rk) * (F + 1)) {
-						tmp = (Dk - Rk) / (F + 1);
-					}
-					else {
-						tmp = Pi - Rk / F;
-					}
-				}
-				
-				/* find the minimum value. */
-				if (split_runtime > tmp || split_runtime == 0) {
-					split_runtime = tmp;
-				}
-			}
-
-			ft->runtime[cpu] = split_runtime;
-			sum_split_runtime += split_runtime;
-
-			/* set first cpu if necessary. */
-			if (ft->first_cpu == RESCH_CPU_UNDEFINED && split_runtime > 0) {
-				ft->first_cpu = cpu;
-			}
-
-			/* if successfully split, break a loop. */
-			if (sum_split_runtime >= rt->C) {
-				ft->runtime[cpu] -= (sum_split_runtime - rt->C);
-				ft->last_cpu = cpu;
-				break;
-			}
-		}
+		ft->runtime[cpu] = t->runtime[cpu];
 	}
 
-	/* if @rt was successfully split, initialize as a migratory task.
-	   also set the destination cpu by the first cpu. */
-	if (ft->last_cpu != RESCH_CPU_UNDEFINED) {
-		ft->rt = rt;
-		return ft->first_cpu;
-	}
-	else {
-		clear_split_task(rt);
-		return RESCH_CPU_UNDEFINED;
-	}
+	return ft->first_cpu;
 }
 
 /**
@@ -361,7 +164,9 @@ static int split(resch_task_t *rt)
  */
 static void task_run(resch_task_t *rt)
 {
-	int cpu, cpu_dst;
+	int cpu_dst;
+	sa_taskset_t *ts;
+	sa_task_t *t;
 
 	/* aperiodic tasks are just skipped. */
 	if (!rt->period) {
@@ -371,25 +176,21 @@ static void task_run(resch_task_t *rt)
 	/* first clear the FP-PM properties. */
 	clear_split_task(rt);
 
-	/* reset cpus availability. */
-	for (cpu = 0; cpu < NR_RT_CPUS; cpu++) {
-		cpu_available[cpu] = true;
-	}
-
 	/* this is going to be a big lock! */
 	global_list_down();
 
 	/* try partitioning. */
-	if ((cpu_dst = partition(rt)) != RESCH_CPU_UNDEFINED) {
+	t = sa_global_admit(&ts, rt);
+	if ((cpu_dst = sa_fp_first_fit(ts, t)) != RESCH_CPU_UNDEFINED) {
 		/* schedulable. */
 		goto out; 
 	}
 
 	/* try splitting. */
-	cpu_dst = split(rt);
+	cpu_dst = split(ts, rt, t);
 
  out:
-	rt->cpu_id = cpu_dst;
+	assign_task_cpu(rt, cpu_dst);
 	global_list_up();
 
 	/* if partitioning succeeded, migrate @p to the cpu. 
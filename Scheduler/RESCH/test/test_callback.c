@@ -0,0 +1,133 @@
+/*
+ * test_callback.c: test the accounting of ROS callbacks in user space.
+ *
+ * It is linked with the same core/callback.c as the RESCH core module.
+ * A writer thread plays the role of a CPU accounting callbacks, while
+ * the main thread reads the statistics as the Measurer does through
+ * the mapped area, and checks that it never sees a torn update.
+ */
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "../core/callback.h"
+
+#define NR_WRITES 1000000
+#define EXEC_NS 1000
+
+static int nr_failures = 0;
+
+#define CHECK(cond)												\
+	do {														\
+		if (!(cond)) {											\
+			printf("%s:%d: failed: %s\n", __FILE__, __LINE__, #cond);	\
+			nr_failures++;										\
+		}														\
+	} while (0)
+
+static struct resch_cb_area area;
+
+static struct resch_cb_stat *find(struct resch_cb_cpu *c, int index)
+{
+	int i;
+
+	for (i = 0; i < RESCH_CB_MAX_NODES; i++) {
+		if (c->stat[i].index == index) {
+			return &c->stat[i];
+		}
+	}
+	return NULL;
+}
+
+static void test_account(void)
+{
+	struct resch_cb_cpu *c = &area.cpu[0];
+	struct resch_cb_stat *s;
+
+	callback_area_init(&area, NR_RT_CPUS);
+	CHECK(area.nr_nodes == RESCH_CB_MAX_NODES);
+	CHECK(find(c, 7) == NULL);
+
+	CHECK(!callback_account(c, 7, 1500, 0));
+	CHECK(!callback_account(c, 7, 0, 2000));
+	CHECK(callback_account(c, 7, 3000, 2000));
+	s = find(c, 7);
+	CHECK(s != NULL);
+	CHECK(s->count == 3 && s->overruns == 1);
+	CHECK(s->total == 4500 && s->min == 0 && s->max == 3000);
+	CHECK(s->last == 3000);
+	CHECK(s->seq == 6);
+	/* 1500 and 3000 are in [2^10, 2^11) and [2^11, 2^12). */
+	CHECK(s->hist[0] == 1 && s->hist[10] == 1 && s->hist[11] == 1);
+	CHECK(!callback_account(c, 7, ~0ULL, 0));
+	CHECK(s->hist[RESCH_CB_NR_BUCKETS - 1] == 1);
+
+	/* other CPUs are not touched. */
+	CHECK(find(&area.cpu[1], 7) == NULL);
+}
+
+static void test_full(void)
+{
+	struct resch_cb_cpu *c = &area.cpu[0];
+	int i;
+
+	callback_area_init(&area, NR_RT_CPUS);
+	/* all the indices collide. */
+	for (i = 0; i < RESCH_CB_MAX_NODES; i++) {
+		callback_account(c, i * RESCH_CB_MAX_NODES, 10, 0);
+	}
+	for (i = 0; i < RESCH_CB_MAX_NODES; i++) {
+		CHECK(find(c, i * RESCH_CB_MAX_NODES) != NULL);
+	}
+	CHECK(c->nr_dropped == 0);
+	CHECK(callback_account(c, -5, 10, 5));
+	CHECK(c->nr_dropped == 1);
+	CHECK(find(c, -5) == NULL);
+}
+
+static void *writer(void *arg)
+{
+	int i;
+
+	(void)arg;
+	for (i = 0; i < NR_WRITES; i++) {
+		callback_account(&area.cpu[1], 42, EXEC_NS, 0);
+	}
+	return NULL;
+}
+
+static void test_read(void)
+{
+	pthread_t th;
+	struct resch_cb_stat *s;
+	struct resch_cb_stat copy;
+	int nr_reads = 0;
+
+	callback_area_init(&area, NR_RT_CPUS);
+	pthread_create(&th, NULL, writer, NULL);
+	while ((s = find(&area.cpu[1], 42)) == NULL) {
+		__sync_synchronize();
+	}
+	do {
+		resch_cb_read(s, &copy);
+		CHECK(copy.total == copy.count * EXEC_NS);
+		CHECK(copy.hist[9] == copy.count);
+		nr_reads++;
+	} while (copy.count < NR_WRITES);
+	pthread_join(th, NULL);
+	CHECK(nr_reads > 0);
+}
+
+int main(void)
+{
+	test_account();
+	test_full();
+	test_read();
+
+	if (nr_failures > 0) {
+		printf("%d failures\n", nr_failures);
+		return 1;
+	}
+	printf("OK\n");
+	return 0;
+}
@@ -0,0 +1,130 @@
+/*
+ * test_component.c: test the budgets of components in user space.
+ *
+ * It is linked with the same core/component.c as the RESCH core module.
+ * Besides the budget itself, two components sharing a CPU are simulated
+ * tick by tick in the same manner as the core: the higher-priority one
+ * overruns, and the other must still meet its deadlines only when the
+ * former is limited by its budget.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "../core/component.h"
+
+#define MS 1000000ULL
+
+static int nr_failures = 0;
+
+#define CHECK(cond)												\
+	do {														\
+		if (!(cond)) {											\
+			printf("%s:%d: failed: %s\n", __FILE__, __LINE__, #cond);	\
+			nr_failures++;										\
+		}														\
+	} while (0)
+
+static void test_budget(void)
+{
+	struct component_budget b;
+
+	component_budget_init(&b, 100 * MS, 30 * MS, 5 * MS);
+	CHECK(b.remaining == 30 * MS && b.replenish_time == 105 * MS);
+	CHECK(!component_budget_charge(&b, 10 * MS));
+	CHECK(b.remaining == 20 * MS && !b.depleted);
+	CHECK(component_budget_charge(&b, 25 * MS));
+	CHECK(b.remaining == 0 && b.depleted && b.nr_depleted == 1);
+	/* it runs out only once in a period. */
+	CHECK(!component_budget_charge(&b, 1 * MS));
+	CHECK(b.nr_depleted == 1);
+
+	CHECK(!component_budget_replenish(&b, 104 * MS));
+	CHECK(b.depleted);
+	CHECK(component_budget_replenish(&b, 105 * MS));
+	CHECK(!b.depleted && b.remaining == 30 * MS);
+	CHECK(b.replenish_time == 205 * MS);
+	CHECK(!component_budget_replenish(&b, 205 * MS - 1));
+
+	/* the periods not noticed are skipped. */
+	CHECK(component_budget_charge(&b, 30 * MS));
+	CHECK(component_budget_replenish(&b, 550 * MS));
+	CHECK(b.replenish_time == 605 * MS && b.remaining == 30 * MS);
+	CHECK(!component_budget_replenish(&b, 600 * MS));
+	CHECK(!component_budget_replenish(&b, 605 * MS));
+	CHECK(b.replenish_time == 705 * MS);
+}
+
+static void test_unlimited(void)
+{
+	struct component_budget b;
+
+	component_budget_init(&b, 0, 0, 0);
+	CHECK(!component_budget_charge(&b, ~0ULL));
+	CHECK(!component_budget_replenish(&b, ~0ULL));
+	component_budget_init(&b, 100 * MS, 0, 0);
+	CHECK(!component_budget_charge(&b, ~0ULL));
+	CHECK(!b.depleted);
+}
+
+/**
+ * simulate "perception" overrunning on one CPU at the higher priority,
+ * and "planning" executing 40ms every 100ms at the lower priority.
+ * return the number of deadlines missed by planning.
+ */
+static int simulate(unsigned long long budget, int nr_periods)
+{
+	struct component_budget perception, planning;
+	unsigned long long t, left = 0;
+	int nr_misses = 0;
+
+	component_budget_init(&perception, 100 * MS, budget, 0);
+	component_budget_init(&planning, 100 * MS, 50 * MS, 0);
+	for (t = 0; t < nr_periods * 100 * MS; t += MS) {
+		if (t % (100 * MS) == 0) {
+			if (left > 0) {
+				nr_misses++;
+			}
+			left = 40 * MS;
+		}
+		/* throttled perception runs in background. */
+		if (!perception.depleted) {
+			component_budget_charge(&perception, MS);
+		}
+		else if (left > 0) {
+			component_budget_charge(&planning, MS);
+			left -= MS;
+		}
+		component_budget_replenish(&perception, t + MS);
+		component_budget_replenish(&planning, t + MS);
+	}
+	if (left > 0) {
+		nr_misses++;
+	}
+	CHECK(planning.nr_depleted == 0);
+
+	return nr_misses;
+}
+
+static void test_isolation(void)
+{
+	CHECK(simulate(30 * MS, 10) == 0);
+	CHECK(simulate(60 * MS, 10) == 0);
+	/* without budget, perception takes all. */
+	CHECK(simulate(0, 10) == 10);
+	/* with too much budget, planning misses. */
+	CHECK(simulate(70 * MS, 10) == 10);
+}
+
+int main(void)
+{
+	test_budget();
+	test_unlimited();
+	test_isolation();
+
+	if (nr_failures > 0) {
+		printf("%d failures\n", nr_failures);
+		return 1;
+	}
+	printf("OK\n");
+	return 0;
+}
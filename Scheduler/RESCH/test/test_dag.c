@@ -0,0 +1,174 @@
+/*
+ * test_dag.c: test the graph of ROS nodes in user space.
+ *
+ * It is linked with the same core/sched_ros.c as the RESCH core module,
+ * and checks the laxities, the rejection of broken graphs, and how the
+ * callbacks make the successors ready round by round.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "../core/sched_ros.h"
+
+static int nr_failures = 0;
+
+#define CHECK(cond)												\
+	do {														\
+		if (!(cond)) {											\
+			printf("%s:%d: failed: %s\n", __FILE__, __LINE__, #cond);	\
+			nr_failures++;										\
+		}														\
+	} while (0)
+
+static ros_dag_t dag;
+
+/**
+ * the graph that api_set_node() used to have hard-coded, where every
+ * node runs for 10usecs except that node 41 runs for 100usecs.
+ */
+static void build_sample(void)
+{
+	static const int nodes[] = {16, 15, 14, 13, 12, 11, 21, 22, 23, 31, 32, 41};
+	static const int edges[][2] = {
+		{16, 15}, {16, 41}, {15, 14}, {15, 32}, {14, 13}, {13, 12},
+		{13, 23}, {12, 11}, {23, 22}, {22, 21}, {32, 31}, {31, 21}, {41, 21},
+	};
+	unsigned int i;
+
+	ros_dag_init(&dag);
+	for (i = 0; i < sizeof(nodes) / sizeof(nodes[0]); i++) {
+		CHECK(ros_dag_add_node(&dag, nodes[i], 1000 + nodes[i],
+							   nodes[i] == 41 ? 100 : 10));
+	}
+	for (i = 0; i < sizeof(edges) / sizeof(edges[0]); i++) {
+		CHECK(ros_dag_add_edge(&dag, edges[i][0], edges[i][1]));
+	}
+	CHECK(ros_dag_build(&dag));
+}
+
+static void test_laxity(void)
+{
+	int k, i;
+	ros_dag_node_t *u, *v;
+
+	build_sample();
+	/* 16 -> 41 -> 21 is the critical path. */
+	CHECK(dag.critical == 120);
+	CHECK(ros_dag_find(&dag, 16)->laxity == 0);
+	CHECK(ros_dag_find(&dag, 41)->laxity == 0);
+	CHECK(ros_dag_find(&dag, 21)->laxity == 0);
+	/* 16 -> 15 -> 14 -> 13 -> 23 -> 22 -> 21 takes 70usecs. */
+	CHECK(ros_dag_find(&dag, 23)->laxity == 50);
+	/* 16 -> 15 -> 14 -> 13 -> 12 -> 11 takes 60usecs. */
+	CHECK(ros_dag_find(&dag, 11)->laxity == 60);
+	CHECK(ros_dag_find(&dag, 11)->pid == 1011);
+	CHECK(ros_dag_find(&dag, 11)->rid == -1);
+	CHECK(ros_dag_find(&dag, 99) == NULL);
+
+	/* every successor comes before its predecessors. */
+	for (k = 0; k < dag.nr_nodes; k++) {
+		u = &dag.node[dag.order[k]];
+		for (i = 0; i < u->nr_succs; i++) {
+			v = &dag.node[dag.succ[u->first_succ + i]];
+			CHECK(v->tail < u->tail);
+		}
+	}
+}
+
+static void test_reject(void)
+{
+	ros_dag_init(&dag);
+	CHECK(ros_dag_add_node(&dag, 1, 0, 10));
+	CHECK(ros_dag_add_node(&dag, 2, 0, 10));
+	CHECK(ros_dag_add_node(&dag, 3, 0, 10));
+	CHECK(!ros_dag_add_node(&dag, 2, 0, 10));
+	CHECK(!ros_dag_add_edge(&dag, 1, 4));
+	CHECK(!ros_dag_add_edge(&dag, 1, 1));
+	CHECK(ros_dag_add_edge(&dag, 1, 2));
+	CHECK(!ros_dag_add_edge(&dag, 1, 2));
+	CHECK(ros_dag_add_edge(&dag, 2, 3));
+	CHECK(ros_dag_build(&dag));
+	CHECK(ros_dag_add_edge(&dag, 3, 1));
+	CHECK(!ros_dag_build(&dag));
+}
+
+static void test_full(void)
+{
+	int i;
+
+	ros_dag_init(&dag);
+	for (i = 0; i < ROS_DAG_MAX_NODES; i++) {
+		CHECK(ros_dag_add_node(&dag, i * ROS_DAG_HASH_SIZE, 0, 1));
+	}
+	CHECK(!ros_dag_add_node(&dag, -1, 0, 1));
+	/* all the indices collide in the hash table. */
+	for (i = 0; i < ROS_DAG_MAX_NODES; i++) {
+		CHECK(ros_dag_find(&dag, i * ROS_DAG_HASH_SIZE) == &dag.node[i]);
+	}
+	for (i = 1; i < ROS_DAG_MAX_NODES; i++) {
+		CHECK(ros_dag_add_edge(&dag, (i - 1) * ROS_DAG_HASH_SIZE,
+							   i * ROS_DAG_HASH_SIZE));
+	}
+	CHECK(ros_dag_build(&dag));
+	CHECK(dag.critical == ROS_DAG_MAX_NODES);
+}
+
+static void test_ready(void)
+{
+	ros_dag_node_t *ready[ROS_DAG_MAX_NODES];
+	ros_dag_node_t *n16, *n15, *n41, *n32, *n31, *n21;
+	int round;
+
+	build_sample();
+	n16 = ros_dag_find(&dag, 16);
+	n15 = ros_dag_find(&dag, 15);
+	n41 = ros_dag_find(&dag, 41);
+	n32 = ros_dag_find(&dag, 32);
+	n31 = ros_dag_find(&dag, 31);
+	n21 = ros_dag_find(&dag, 21);
+
+	for (round = 0; round < 3; round++) {
+		CHECK(ros_dag_ready(n16));
+		CHECK(!ros_dag_ready(n15));
+		ros_dag_start(n16);
+		CHECK(n16->running);
+		CHECK(ros_dag_complete(&dag, n16, ready, ROS_DAG_MAX_NODES) == 2);
+		CHECK(!n16->running);
+		CHECK(ready[0] == n15 && ready[1] == n41);
+		CHECK(ros_dag_ready(n15) && ros_dag_ready(n41));
+
+		/* 21 waits for 22, 31, and 41. */
+		CHECK(ros_dag_complete(&dag, n41, ready, ROS_DAG_MAX_NODES) == 0);
+		CHECK(!ros_dag_ready(n21));
+		ros_dag_complete(&dag, n15, ready, ROS_DAG_MAX_NODES);
+		CHECK(ros_dag_complete(&dag, n32, ready, ROS_DAG_MAX_NODES) == 1);
+		CHECK(ready[0] == n31);
+		CHECK(ros_dag_complete(&dag, n31, ready, ROS_DAG_MAX_NODES) == 0);
+		ros_dag_complete(&dag, ros_dag_find(&dag, 14), ready, 0);
+		ros_dag_complete(&dag, ros_dag_find(&dag, 13), ready, 0);
+		ros_dag_complete(&dag, ros_dag_find(&dag, 12), ready, 0);
+		ros_dag_complete(&dag, ros_dag_find(&dag, 11), ready, 0);
+		ros_dag_complete(&dag, ros_dag_find(&dag, 23), ready, 0);
+		CHECK(!ros_dag_ready(n21));
+		CHECK(ros_dag_complete(&dag, ros_dag_find(&dag, 22), ready, 1) == 1);
+		CHECK(ready[0] == n21);
+		CHECK(ros_dag_ready(n21));
+		ros_dag_complete(&dag, n21, ready, 0);
+		CHECK(!ros_dag_ready(n21));
+	}
+}
+
+int main(void)
+{
+	test_laxity();
+	test_reject();
+	test_full();
+	test_ready();
+
+	if (nr_failures > 0) {
+		printf("%d failures\n", nr_failures);
+		return 1;
+	}
+	printf("OK\n");
+	return 0;
+}
@@ -0,0 +1,168 @@
+/*
+ * test_gsched.cpp: test the GPU launch arbitration on CPU only.
+ *
+ * The "kernel launch" is a busy loop between ros_gsched_enqueue_prio()
+ * and ros_gsched_dequeue(). It checks that the launches never overlap,
+ * that waiters are served in priority order, and reports waiting time.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <resch/api_ros_gpu.h>
+
+#define NR_PROCS 8
+#define NR_LAUNCHES 1000
+#define LAUNCH_US 20
+
+struct shared_data
+{
+  int in_launch;
+  int nr_overlaps;
+  int nr_served;
+  int order[NR_PROCS];
+};
+
+static struct shared_data *shared;
+
+static void busy_us(long us)
+{
+  struct timeval tv_begin, tv_now;
+
+  gettimeofday(&tv_begin, NULL);
+  do
+  {
+    gettimeofday(&tv_now, NULL);
+  } while ((tv_now.tv_sec - tv_begin.tv_sec) * 1000000 + (tv_now.tv_usec - tv_begin.tv_usec) < us);
+}
+
+/* synthetic kernel launch inside the critical section. */
+static void launch(void)
+{
+  if (__sync_fetch_and_add(&shared->in_launch, 1) != 0)
+    __sync_fetch_and_add(&shared->nr_overlaps, 1);
+  busy_us(LAUNCH_US);
+  __sync_fetch_and_sub(&shared->in_launch, 1);
+}
+
+static void wait_children(void)
+{
+  int status;
+
+  while (wait(&status) > 0)
+    ;
+}
+
+/* waiters queued behind a held token must be served highest priority first. */
+static int test_priority_order(void)
+{
+  int prio[NR_PROCS] = { 3, 7, 0, 5, 1, 6, 2, 4 };
+  int i;
+
+  shared->nr_served = 0;
+  ros_gsched_enqueue_prio(0);
+
+  for (i = 0; i < NR_PROCS; i++)
+  {
+    if (fork() == 0)
+    {
+      ros_gsched_enqueue_prio(prio[i]);
+      shared->order[__sync_fetch_and_add(&shared->nr_served, 1)] = prio[i];
+      launch();
+      ros_gsched_dequeue();
+      _exit(0);
+    }
+  }
+
+  /* let all the children block on the token. */
+  usleep(200000);
+  ros_gsched_dequeue();
+  wait_children();
+
+  for (i = 0; i < NR_PROCS; i++)
+  {
+    if (shared->order[i] != NR_PROCS - 1 - i)
+      return 0;
+  }
+  return 1;
+}
+
+/* all processes launch repeatedly with their own priority. */
+static int test_contention(void)
+{
+  int i, j;
+
+  shared->nr_overlaps = 0;
+  for (i = 0; i < NR_PROCS; i++)
+  {
+    if (fork() == 0)
+    {
+      for (j = 0; j < NR_LAUNCHES; j++)
+      {
+        ros_gsched_enqueue_prio(i);
+        launch();
+        ros_gsched_dequeue();
+      }
+      _exit(0);
+    }
+  }
+  wait_children();
+
+  return shared->nr_overlaps == 0;
+}
+
+int main(void)
+{
+  struct ros_gsched_stat stat;
+  int ok = 1;
+  int i;
+
+  shared = (struct shared_data *)mmap(NULL, sizeof(struct shared_data), PROT_READ | PROT_WRITE,
+                                      MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  if (shared == MAP_FAILED || ros_gsched_init() != 0)
+  {
+    printf("Error: cannot initialize!\n");
+    return 1;
+  }
+
+  printf("Checking for the priority order... ");
+  fflush(stdout);
+  if (test_priority_order())
+  {
+    printf("OK\n");
+  }
+  else
+  {
+    printf("NG (");
+    for (i = 0; i < NR_PROCS; i++)
+      printf(" %d", shared->order[i]);
+    printf(" )\n");
+    ok = 0;
+  }
+
+  ros_gsched_reset_stat();
+  printf("Checking for the mutual exclusion... ");
+  fflush(stdout);
+  if (test_contention())
+  {
+    printf("OK\n");
+  }
+  else
+  {
+    printf("NG (%d overlaps)\n", shared->nr_overlaps);
+    ok = 0;
+  }
+
+  ros_gsched_get_stat(&stat);
+  printf("launches %lu, waited %lu, average wait %llu us, max wait %llu us\n", stat.nr_launches, stat.nr_waits,
+         stat.nr_launches ? stat.total_wait_ns / stat.nr_launches / 1000 : 0, stat.max_wait_ns / 1000);
+
+  ros_gsched_exit(true);
+  printf("[Done]\n");
+
+  return ok ? 0 : 1;
+}
@@ -12,6 +12,7 @@
 #include <sys/unistd.h>
 #include <resch/api.h>
 #include <resch-config.h>
+#include <resch-trace.h>
 #include "tvops.h"
 
 struct task_data {
@@ -204,11 +205,75 @@ long test_migration(int policy)
 	return cost;
 }
 
+/**
+ * average cost (ns) of setting the task attributes, either by the
+ * separate APIs or by rt_set_attr() in a single call.
+ */
+#define NR_API_LOOPS 10000
+long test_api_cost(int policy, int batched)
+{
+	int i;
+	struct rt_attr attr;
+	struct timeval tv_begin, tv_end, tv_cost;
+	struct timespec wcet = ms_to_timespec(10);
+	struct timespec period = ms_to_timespec(100);
+
+	if (rt_init() < 0) {
+		printf("Error: cannot begin!\n");
+		return 0;
+	}
+
+	memset(&attr, 0, sizeof(attr));
+	attr.mask = RT_ATTR_WCET | RT_ATTR_PERIOD | RT_ATTR_DEADLINE |
+		RT_ATTR_POLICY | RT_ATTR_PRIORITY;
+	attr.wcet = wcet;
+	attr.period = period;
+	attr.deadline = period;
+	attr.policy = policy;
+	attr.priority = RESCH_APP_PRIO_MAX;
+
+	gettimeofday(&tv_begin, NULL);
+	for (i = 0; i < NR_API_LOOPS; i++) {
+		if (batched) {
+			rt_set_attr(&attr);
+		}
+		else {
+			rt_set_wcet(wcet);
+			rt_set_period(period);
+			rt_set_deadline(period);
+			rt_set_scheduler(policy);
+			rt_set_priority(RESCH_APP_PRIO_MAX);
+		}
+	}
+	gettimeofday(&tv_end, NULL);
+
+	rt_exit();
+
+	tvsub(&tv_end, &tv_begin, &tv_cost);
+	return (tv_cost.tv_sec * USEC_1SEC + tv_cost.tv_usec) * 1000 / NR_API_LOOPS;
+}
+
+/**
+ * the number of context switches traced so far on all the CPUs.
+ */
+static unsigned long long nr_traced(const struct resch_trace_area *trace)
+{
+	int cpu;
+	unsigned long long n = 0;
+
+	for (cpu = 0; cpu < NR_RT_CPUS; cpu++) {
+		n += trace->cpu[cpu].head;
+	}
+	return n;
+}
+
 int main(int argc, char* argv[])
 {
 	int i;
 	long cost;
 	int policy = SCHED_FP;
+	unsigned long long nr_switches = 0;
+	const struct resch_trace_area *trace;
 
 	for (i = 1; i < argc; i++) {
 		if (strncmp(argv[i], "--edf", strlen("--edf")) == 0) {
@@ -216,11 +281,23 @@ int main(int argc, char* argv[])
 		}
 	}
 	
+	/* compare the costs with and without --enable-switch-trace. */
+	trace = rt_map_trace();
+	printf("Checking for the context switch trace... %s\n",
+		   trace ? "yes" : "no");
+	if (trace) {
+		nr_switches = nr_traced(trace);
+	}
+
 	printf("Checking for the context switching cost... ");
 	fflush(stdout);
 	cost = test_context_switch(policy);	
 	printf(" %lu microseconds\n", cost);
 	rt_test_set_switch_cost(cost);
+	if (trace) {
+		printf("Context switches traced meanwhile... %llu\n",
+			   nr_traced(trace) - nr_switches);
+	}
 
 	printf("Checking for the job releasing cost... ");
 	fflush(stdout);
@@ -234,6 +311,13 @@ int main(int argc, char* argv[])
 	printf(" %lu microseconds\n", cost);
 	rt_test_set_migration_cost(cost);
 
+	printf("Checking for the API cost of setting attributes... ");
+	fflush(stdout);
+	cost = test_api_cost(policy, 0);
+	printf(" %lu nanoseconds by separate calls,", cost);
+	cost = test_api_cost(policy, 1);
+	printf(" %lu nanoseconds by rt_set_attr()\n", cost);
+
 	printf("[Done]\n");
 
 	return 0;
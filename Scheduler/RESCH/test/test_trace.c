@@ -0,0 +1,123 @@
+/*
+ * test_trace.c: test the ring buffers of context switches in user space.
+ *
+ * It is linked with the same core/switch_trace.c as the RESCH core
+ * module. A writer thread plays the role of a CPU recording switches,
+ * while the main thread reads them by resch_trace_read(), and checks
+ * that every entry is either read intact in order or counted as lost.
+ */
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "../core/switch_trace.h"
+
+#define NR_WRITES 10000000ULL
+#define NR_READS 512
+
+static int nr_failures = 0;
+
+#define CHECK(cond)												\
+	do {														\
+		if (!(cond)) {											\
+			printf("%s:%d: failed: %s\n", __FILE__, __LINE__, #cond);	\
+			nr_failures++;										\
+		}														\
+	} while (0)
+
+static struct resch_trace_area area;
+
+/* every member is derived from @i, so that torn entries are found. */
+static void record(struct resch_trace_cpu *c, unsigned long long i)
+{
+	switch_trace_record(c, i, (int)i, (int)i + 1, (int)(i % 99),
+						(int)(i % 97), (long)i);
+}
+
+static int intact(struct resch_trace_entry *e, unsigned long long i)
+{
+	return e->time == i && e->prev_pid == (int)i && e->next_pid == (int)i + 1 &&
+		e->prev_prio == (int)(i % 99) && e->next_prio == (int)(i % 97) &&
+		e->prev_state == (long)i;
+}
+
+static void test_record(void)
+{
+	struct resch_trace_cpu *c = &area.cpu[0];
+	struct resch_trace_entry out[NR_READS];
+	unsigned long long i, tail = 0, lost;
+	int n;
+
+	switch_trace_area_init(&area, NR_RT_CPUS);
+	CHECK(area.nr_entries == RESCH_TRACE_NR_ENTRIES);
+	CHECK(resch_trace_read(c, &tail, out, NR_READS, &lost) == 0);
+	CHECK(lost == 0 && tail == 0);
+
+	for (i = 0; i < 10; i++) {
+		record(c, i);
+	}
+	n = resch_trace_read(c, &tail, out, 4, &lost);
+	CHECK(n == 4 && lost == 0 && tail == 4);
+	CHECK(intact(&out[0], 0) && intact(&out[3], 3));
+	n = resch_trace_read(c, &tail, out, NR_READS, &lost);
+	CHECK(n == 6 && lost == 0 && tail == 10);
+	CHECK(intact(&out[0], 4) && intact(&out[5], 9));
+
+	/* overwrite the oldest entries. */
+	for (i = 10; i < 10 + RESCH_TRACE_NR_ENTRIES + 5; i++) {
+		record(c, i);
+	}
+	n = resch_trace_read(c, &tail, out, 1, &lost);
+	CHECK(n == 1 && lost == 6);
+	CHECK(intact(&out[0], 16));
+	CHECK(c->head == 10 + RESCH_TRACE_NR_ENTRIES + 5);
+}
+
+static void *writer(void *arg)
+{
+	unsigned long long i;
+
+	(void)arg;
+	for (i = 0; i < NR_WRITES; i++) {
+		record(&area.cpu[1], i);
+	}
+	return NULL;
+}
+
+static void test_concurrent(void)
+{
+	pthread_t th;
+	static struct resch_trace_entry out[NR_READS];
+	unsigned long long tail = 0, lost, nr_read = 0, nr_lost = 0;
+	int i, n;
+
+	switch_trace_area_init(&area, NR_RT_CPUS);
+	pthread_create(&th, NULL, writer, NULL);
+	while (tail < NR_WRITES) {
+		n = resch_trace_read(&area.cpu[1], &tail, out, NR_READS, &lost);
+		nr_lost += lost;
+		for (i = 0; i < n; i++) {
+			if (!intact(&out[i], tail - n + i)) {
+				CHECK(intact(&out[i], tail - n + i));
+				break;
+			}
+		}
+		nr_read += n;
+	}
+	pthread_join(th, NULL);
+	CHECK(nr_read + nr_lost == NR_WRITES);
+	CHECK(nr_read > 0);
+}
+
+int main(void)
+{
+	test_record();
+	test_concurrent();
+
+	if (nr_failures > 0) {
+		printf("%d failures\n", nr_failures);
+		return 1;
+	}
+	printf("OK\n");
+	return 0;
+}
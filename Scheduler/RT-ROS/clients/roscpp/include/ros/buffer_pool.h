@@ -0,0 +1,136 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2016, Yukihiro Saito.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ROSCPP_BUFFER_POOL_H
+#define ROSCPP_BUFFER_POOL_H
+
+#include "common.h"
+
+#include <boost/shared_ptr.hpp>
+#include <boost/weak_ptr.hpp>
+#include <boost/shared_array.hpp>
+#include <boost/enable_shared_from_this.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include <vector>
+
+namespace ros
+{
+
+class BufferPool;
+typedef boost::shared_ptr<BufferPool> BufferPoolPtr;
+
+/**
+ * \brief Recycles buffers by power-of-two size class.
+ *
+ * acquire() hands out a shared_array whose deleter gives the memory back to the pool
+ * once its last reference is released (e.g. by the MessageDeserializer), so that a
+ * stream of large messages of similar sizes is received without going through malloc,
+ * and the mmap()/munmap() and page faults that come with large chunks, each time.
+ * Buffers released after the pool is destroyed are simply freed.
+ *
+ * Each Connection owns a pool for its large frames, so that a 6MB image is received
+ * into the buffer of the previous image of the same stream.  Small buffers are left to
+ * malloc, whose per-thread caches already recycle them faster than a locked pool.
+ */
+class ROSCPP_DECL BufferPool : public boost::enable_shared_from_this<BufferPool>
+{
+public:
+  /**
+   * \brief Counts of the buffers acquired through the pool
+   */
+  struct Stats
+  {
+    Stats()
+    : acquired(0)
+    , allocated(0)
+    , recycled(0)
+    , freed(0)
+    {}
+
+    /// Buffers handed out by acquire()
+    uint64_t acquired;
+    /// Buffers allocated from the heap, because none could be recycled
+    uint64_t allocated;
+    /// Buffers handed out again after being released
+    uint64_t recycled;
+    /// Released buffers given back to the heap, because their class was full
+    uint64_t freed;
+  };
+
+  /**
+   * \param max_cached The number of released buffers kept per size class
+   * \param max_size Buffers larger than this (at most 2GB) are allocated and freed as usual
+   */
+  BufferPool(uint32_t max_cached, uint32_t max_size);
+  ~BufferPool();
+
+  /**
+   * \brief Returns a buffer of at least size bytes, with undefined contents
+   *
+   * acquire() may be called from any thread, and the buffer released from any other.
+   */
+  boost::shared_array<uint8_t> acquire(uint32_t size);
+
+  Stats getStats();
+
+private:
+  struct Release
+  {
+    Release(const boost::weak_ptr<BufferPool>& pool, uint32_t size_class)
+    : pool_(pool)
+    , size_class_(size_class)
+    {}
+
+    void operator()(uint8_t* buffer);
+
+    boost::weak_ptr<BufferPool> pool_;
+    uint32_t size_class_;
+  };
+
+  void release(uint8_t* buffer, uint32_t size_class);
+
+  uint32_t max_cached_;
+  uint32_t max_size_;
+
+  typedef std::vector<uint8_t*> V_Buffer;
+  /// Released buffers, indexed by size class (log2 of their size)
+  std::vector<V_Buffer> free_;
+  Stats stats_;
+  boost::mutex mutex_;
+};
+
+}
+
+#endif // ROSCPP_BUFFER_POOL_H
@@ -57,7 +57,27 @@ namespace ros
 class ROSCPP_DECL CallbackQueue : public CallbackQueueInterface
 {
 public:
+  /**
+   * \brief Order in which queued callbacks are called
+   *
+   * Callbacks report their priority and deadline through CallbackInterface::getSchedParam().
+   * Callbacks which compare equal are called in FIFO order.
+   */
+  enum Order
+  {
+    FIFO,        ///< In the order they were added
+    ByPriority,  ///< Highest priority first, then earliest absolute deadline
+    ByDeadline,  ///< Earliest absolute deadline first, then highest priority
+  };
+
   CallbackQueue(bool enabled = true);
+  /**
+   * \brief Constructs a queue which calls its callbacks in the given order.  Pending callbacks are kept in a
+   * binary heap, so adding one is O(log n) and removing an owner's callbacks stays O(n), as in FIFO order.
+   *
+   * Use NodeHandle::setCallbackQueue() to have the callbacks of a NodeHandle go to such a queue.
+   */
+  CallbackQueue(bool enabled, Order order);
   virtual ~CallbackQueue();
 
   virtual void addCallback(const CallbackInterfacePtr& callback, uint64_t removal_id = 0);
@@ -153,10 +173,17 @@ protected:
     CallbackInfo()
     : removal_id(0)
     , marked_for_removal(false)
+    , priority(0)
+    , seq(0)
     {}
     CallbackInterfacePtr callback;
     uint64_t removal_id;
     bool marked_for_removal;
+
+    // sort keys, when not in FIFO order
+    int32_t priority;
+    WallTime deadline;
+    uint64_t seq;
   };
   typedef std::list<CallbackInfo> L_CallbackInfo;
   typedef std::deque<CallbackInfo> D_CallbackInfo;
@@ -168,6 +195,19 @@ protected:
   boost::mutex id_info_mutex_;
   M_IDInfo id_info_;
 
+  /// Keeps callbacks_ a heap with the most urgent callback in front, when not in FIFO order
+  struct LessUrgent
+  {
+    LessUrgent(Order order) : order(order) {}
+    bool operator()(const CallbackInfo& a, const CallbackInfo& b) const;
+    Order order;
+  };
+
+  void pushCallback(const CallbackInfo& info);
+
+  Order order_;
+  uint64_t next_seq_;
+
   struct TLS
   {
     TLS()
@@ -38,10 +38,26 @@
 #include <boost/shared_ptr.hpp>
 #include "common.h"
 #include "ros/types.h"
+#include "ros/time.h"
 
 namespace ros
 {
 
+/**
+ * \brief Scheduling parameters of a callback, used by queues which call the most urgent callback first
+ */
+struct CallbackSchedParam
+{
+  CallbackSchedParam()
+  : priority(0)
+  {}
+
+  /// Higher is more urgent, as with real-time priorities
+  int32_t priority;
+  /// Deadline relative to when the callback is queued, or zero for none
+  WallDuration deadline;
+};
+
 /**
  * \brief Abstract interface for items which can be added to a CallbackQueueInterface
  */
@@ -70,6 +86,11 @@ public:
    * before call() actually takes place.
    */
   virtual bool ready() { return true; }
+  /**
+   * \brief Returns the priority and deadline of this callback, by which a CallbackQueue which does not
+   * call its callbacks in FIFO order sorts them.  Queried once each time the callback is queued.
+   */
+  virtual CallbackSchedParam getSchedParam() { return CallbackSchedParam(); }
 };
 typedef boost::shared_ptr<CallbackInterface> CallbackInterfacePtr;
 
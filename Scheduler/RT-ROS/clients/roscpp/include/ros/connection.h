@@ -36,6 +36,8 @@
 #define ROSCPP_CONNECTION_H
 
 #include "ros/header.h"
+#include "ros/buffer_pool.h"
+#include "ros/transport/transport.h"
 #include "common.h"
 
 #include <boost/signals2.hpp>
@@ -47,6 +49,8 @@
 #include <boost/thread/mutex.hpp>
 #include <boost/thread/recursive_mutex.hpp>
 
+#include <vector>
+
 #define READ_BUFFER_SIZE (1024*64)
 
 namespace ros
@@ -61,6 +65,21 @@ typedef boost::function<void(const ConnectionPtr&)> WriteFinishedFunc;
 
 typedef boost::function<bool(const ConnectionPtr&, const Header&)> HeaderReceivedFunc;
 
+/**
+ * \brief A buffer of bytes to write, with Connection::writev()
+ */
+struct WriteBuffer
+{
+  WriteBuffer(const boost::shared_array<uint8_t>& buf, uint32_t size)
+  : buf(buf)
+  , size(size)
+  {}
+
+  boost::shared_array<uint8_t> buf;
+  uint32_t size;
+};
+typedef std::vector<WriteBuffer> V_WriteBuffer;
+
 /**
  * \brief Encapsulates a connection to a remote host, independent of the transport type
  *
@@ -143,6 +162,18 @@ public:
    * the data off to the server thread
    */
   void write(const boost::shared_array<uint8_t>& buffer, uint32_t size, const WriteFinishedFunc& finished_callback, bool immedate = true);
+  /**
+   * \brief Write several buffers of bytes back to back, calling a callback when all of them are finished
+   *
+   * Same as write(), except that the transport is given all the buffers left to write at once, so that e.g.
+   * TCPROS sends them with a single writev() system call where the socket accepts them.
+   *
+   * \param buffers The buffers of data to write, in order
+   * \param finished_callback The function to call when the write has finished
+   * \param immediate Whether to immediately try to write as much data as possible to the socket or to pass
+   * the data off to the server thread
+   */
+  void writev(const V_WriteBuffer& buffers, const WriteFinishedFunc& finished_callback, bool immediate = true);
 
   typedef boost::signals2::signal<void(const ConnectionPtr&, DropReason reason)> DropSignal;
   typedef boost::function<void(const ConnectionPtr&, DropReason reason)> DropFunc;
@@ -219,6 +250,8 @@ private:
 
   /// Read buffer that ends up being passed to the read callback
   boost::shared_array<uint8_t> read_buffer_;
+  /// Recycles the read buffers of frames of READ_BUFFER_SIZE or more
+  BufferPoolPtr large_buffer_pool_;
   /// Amount of data currently in the read buffer, in bytes
   uint32_t read_filled_;
   /// Size of the read buffer, in bytes
@@ -234,11 +267,13 @@ private:
   /// to ensure this is done atomically
   volatile uint32_t has_read_callback_;
 
-  /// Buffer to write from
-  boost::shared_array<uint8_t> write_buffer_;
-  /// Amount of data we've written from the write buffer
+  /// Buffers to write from
+  V_WriteBuffer write_buffers_;
+  /// Buffers left to write, handed to the transport
+  std::vector<TransportBuffer> write_vecs_;
+  /// Amount of data we've written from the write buffers
   uint32_t write_sent_;
-  /// Size of the write buffer
+  /// Total size of the write buffers
   uint32_t write_size_;
   /// Function to call when the current write is finished
   WriteFinishedFunc write_callback_;
@@ -60,6 +60,7 @@
     #include <netdb.h>       // getnameinfo in network.cpp
     #include <netinet/in.h>  // sockaddr_in in network.cpp
 	#include <netinet/tcp.h> // TCP_NODELAY in transport/transport_tcp.cpp
+	#include <sys/uio.h>     // writev in transport/transport_tcp.cpp
 #endif
 
 /*****************************************************************************
@@ -146,6 +147,17 @@ ROSCPP_DECL int last_socket_error();
 ROSCPP_DECL const char* last_socket_error_string();
 ROSCPP_DECL bool last_socket_error_is_would_block();
 ROSCPP_DECL int poll_sockets(socket_pollfd *fds, nfds_t nfds, int timeout);
+ROSCPP_DECL int create_socket_watcher();
+ROSCPP_DECL void close_socket_watcher(int watcher);
+ROSCPP_DECL int add_socket_to_watcher(int watcher, socket_fd_t socket, int events);
+ROSCPP_DECL int del_socket_from_watcher(int watcher, socket_fd_t socket);
+ROSCPP_DECL int set_events_on_socket(int watcher, socket_fd_t socket, int events);
+ROSCPP_DECL int wait_socket_watcher(int watcher, socket_pollfd *fds, nfds_t nfds, int timeout);
+ROSCPP_DECL int create_timer_fd();
+ROSCPP_DECL void close_timer_fd(int timer);
+ROSCPP_DECL int set_timer_fd(int timer, int64_t expiry_ns);
+ROSCPP_DECL int read_timer_fd(int timer);
+ROSCPP_DECL int64_t monotonic_time_ns();
 ROSCPP_DECL int set_non_blocking(socket_fd_t &socket);
 ROSCPP_DECL int close_socket(socket_fd_t &socket);
 ROSCPP_DECL int create_signal_pair(signal_fd_t signal_pair[2]);
@@ -0,0 +1,197 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2016, Yukihiro Saito.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ROSCPP_LOCKFREE_QUEUE_H
+#define ROSCPP_LOCKFREE_QUEUE_H
+
+#include "ros/types.h"
+
+#include <boost/noncopyable.hpp>
+
+#include <algorithm>
+#include <vector>
+
+namespace ros
+{
+
+/**
+ * \brief Bounded queue which any number of threads may push to and pop from without locking.
+ *
+ * All the slots are allocated up front, and items are swapped in and out of them, so that
+ * neither push() nor pop() allocate or, for items made of shared_ptrs, touch reference counts.
+ * T must be default constructible and swappable.
+ *
+ * Each slot carries a sequence number telling whether it is ready to be written or read for a
+ * given lap around the ring, so producers and consumers only contend on their own position.
+ */
+template<typename T>
+class LockFreeQueue : boost::noncopyable
+{
+public:
+  /**
+   * \param capacity Number of items the queue holds, rounded up to a power of two
+   */
+  explicit LockFreeQueue(uint32_t capacity)
+  : mask_(roundUp(capacity) - 1)
+  , cells_(mask_ + 1)
+  , enqueue_pos_(0)
+  , dequeue_pos_(0)
+  {
+    for (uint32_t i = 0; i <= mask_; ++i)
+    {
+      cells_[i].seq = i;
+    }
+  }
+
+  /**
+   * \brief Swaps item into the queue, leaving it default constructed
+   * \return false, with item untouched, if the queue is full
+   */
+  bool push(T& item)
+  {
+    Cell* cell;
+    uint32_t pos = enqueue_pos_;
+    for (;;)
+    {
+      cell = &cells_[pos & mask_];
+      uint32_t seq = cell->seq;
+      __sync_synchronize();
+      int32_t dif = (int32_t)(seq - pos);
+      if (dif == 0)
+      {
+        if (__sync_bool_compare_and_swap(&enqueue_pos_, pos, pos + 1))
+        {
+          break;
+        }
+      }
+      else if (dif < 0)
+      {
+        return false;
+      }
+      pos = enqueue_pos_;
+    }
+
+    using std::swap;
+    swap(cell->item, item);
+    __sync_synchronize();
+    cell->seq = pos + 1;
+    return true;
+  }
+
+  /**
+   * \brief Swaps the oldest item out of the queue into item, whose previous value is released
+   * \return false if the queue is empty, or its oldest item is still being pushed
+   */
+  bool pop(T& item)
+  {
+    Cell* cell;
+    uint32_t pos = dequeue_pos_;
+    for (;;)
+    {
+      cell = &cells_[pos & mask_];
+      uint32_t seq = cell->seq;
+      __sync_synchronize();
+      int32_t dif = (int32_t)(seq - (pos + 1));
+      if (dif == 0)
+      {
+        if (__sync_bool_compare_and_swap(&dequeue_pos_, pos, pos + 1))
+        {
+          break;
+        }
+      }
+      else if (dif < 0)
+      {
+        return false;
+      }
+      pos = dequeue_pos_;
+    }
+
+    using std::swap;
+    T empty;
+    swap(item, empty);
+    swap(item, cell->item);
+    __sync_synchronize();
+    cell->seq = pos + mask_ + 1;
+    return true;
+  }
+
+  /**
+   * \brief Number of items pushed and not yet popped.  Only a snapshot when other threads are
+   * using the queue.
+   */
+  uint32_t size() const
+  {
+    uint32_t dequeue_pos = dequeue_pos_;
+    __sync_synchronize();
+    uint32_t enqueue_pos = enqueue_pos_;
+    return enqueue_pos - dequeue_pos;
+  }
+
+  bool empty() const { return size() == 0; }
+
+  uint32_t capacity() const { return mask_ + 1; }
+
+private:
+  static uint32_t roundUp(uint32_t capacity)
+  {
+    uint32_t rounded = 1;
+    while (rounded < capacity)
+    {
+      rounded <<= 1;
+    }
+    return rounded;
+  }
+
+  struct Cell
+  {
+    Cell() : seq(0) {}
+
+    volatile uint32_t seq;
+    T item;
+  };
+
+  uint32_t mask_;
+  std::vector<Cell> cells_;
+
+  // keep the producers and the consumers off each other's cache line
+  char pad0_[64];
+  volatile uint32_t enqueue_pos_;
+  char pad1_[64];
+  volatile uint32_t dequeue_pos_;
+  char pad2_[64];
+};
+
+}
+
+#endif // ROSCPP_LOCKFREE_QUEUE_H
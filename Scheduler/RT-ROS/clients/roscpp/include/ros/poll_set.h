@@ -49,10 +49,14 @@ class Transport;
 typedef boost::shared_ptr<Transport> TransportPtr;
 
 /**
- * \brief Manages a set of sockets being polled through the poll() function call.
+ * \brief Manages a set of sockets being polled through epoll, or the poll() function call
+ * where epoll is not available.
  *
  * PollSet provides thread-safe ways of adding and deleting sockets, as well as adding
- * and deleting events.
+ * and deleting events.  With epoll, sockets and events are registered with the kernel
+ * as they are added and deleted, and update() only visits the sockets which are ready,
+ * so its cost does not grow with the number of idle connections.  Setting the
+ * ROSCPP_USE_POLL environment variable forces the poll() fallback.
  */
 class ROSCPP_DECL PollSet
 {
@@ -99,19 +103,19 @@ public:
   /**
    * \brief Process all socket events
    *
-   * This function will actually call poll() on the available sockets, and allow
-   * them to do their processing.
+   * This function will actually wait on the available sockets (epoll_wait() or poll()),
+   * and allow the ready ones to do their processing.
    *
    * update() may only be called from one thread at a time
    *
-   * \param poll_timeout The time, in milliseconds, for the poll() call to timeout after
+   * \param poll_timeout The time, in milliseconds, for the wait to timeout after
    * if there are no events.  Note that this does not provide an upper bound for the entire
-   * function, just the call to poll()
+   * function, just the wait itself
    */
   void update(int poll_timeout);
 
   /**
-   * \brief Signal our poll() call to finish if it's blocked waiting (see the poll_timeout
+   * \brief Signal our wait to finish if it's blocked waiting (see the poll_timeout
    * option for update()).
    */
   void signal();
@@ -122,6 +126,11 @@ private:
    */
   void createNativePollset();
 
+  /**
+   * \brief Calls the update functions of the sockets with events in ufds_[0, count)
+   */
+  void dispatch(size_t count);
+
   /**
    * \brief Called when events have been triggered on our signal pipe
    */
@@ -145,6 +154,9 @@ private:
 
   std::vector<socket_pollfd> ufds_;
 
+  /// The epoll watcher, or -1 when falling back to poll()
+  int epfd_;
+
   boost::mutex signal_mutex_;
   signal_fd_t signal_pipe_[2];
 };
@@ -49,6 +49,8 @@ namespace ros
 class SubscriberLink;
 typedef boost::shared_ptr<SubscriberLink> SubscriberLinkPtr;
 typedef std::vector<SubscriberLinkPtr> V_SubscriberLink;
+class TransportSHM;
+typedef boost::shared_ptr<TransportSHM> TransportSHMPtr;
 
 struct PriorityComparison{
   bool operator () (SubscriberLinkPtr left, SubscriberLinkPtr right){
@@ -156,8 +158,20 @@ public:
 
   bool validateHeader(const Header& h, std::string& error_msg);
 
+  /**
+   * \brief Returns the shared memory segment for subscribers on this host, creating it on first use.
+   * Its slots hold at least slot_size bytes and the largest message published so far.  A message larger
+   * than the slots abandons the segment, and its subscribers reconnect over TCPROS.
+   * Returns an empty pointer if it cannot be created, or its slots are too small and it is in use
+   */
+  TransportSHMPtr getSHMTransport(uint32_t slot_size);
+
 private:
   void dropAllConnections();
+  /**
+   * \brief Drops the shared memory subscribers which have gone without telling us
+   */
+  void dropDeadSHMLinks();
 
   /**
    * \brief Called when a new peer has connected. Calls the connection callback
@@ -194,6 +208,11 @@ private:
 
   uint32_t intraprocess_subscriber_count_;
 
+  TransportSHMPtr shm_;
+  uint32_t shm_subscriber_count_;
+  /// The largest serialized message published, which shared memory slots are sized for
+  uint32_t largest_message_;
+
   typedef std::vector<SerializedMessage> V_SerializedMessage;
   V_SerializedMessage publish_queue_;
   boost::mutex publish_queue_mutex_;
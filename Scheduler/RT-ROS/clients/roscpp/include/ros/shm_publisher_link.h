@@ -0,0 +1,91 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2016, Yukihiro Saito.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ROSCPP_SHM_PUBLISHER_LINK_H
+#define ROSCPP_SHM_PUBLISHER_LINK_H
+
+#include "publisher_link.h"
+#include "common.h"
+
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+
+namespace ros
+{
+class Subscription;
+typedef boost::shared_ptr<Subscription> SubscriptionPtr;
+typedef boost::weak_ptr<Subscription> SubscriptionWPtr;
+
+class TransportSHM;
+typedef boost::shared_ptr<TransportSHM> TransportSHMPtr;
+
+/**
+ * \brief Handles a connection to a publisher in another process on the same host.  A thread waits on
+ * the shared memory segment of the publisher, and hands off the messages to the subscription without
+ * copying them
+ */
+class ROSCPP_DECL SHMPublisherLink : public PublisherLink
+{
+public:
+  SHMPublisherLink(const SubscriptionPtr& parent, const std::string& xmlrpc_uri, const TransportHints& transport_hints);
+  virtual ~SHMPublisherLink();
+
+  /**
+   * \brief Attaches to the reader reserved by the publisher, and starts receiving
+   */
+  bool initialize(const TransportSHMPtr& transport, int reader, uint32_t generation);
+
+  virtual std::string getTransportType();
+  virtual std::string getTransportInfo();
+  virtual void drop();
+
+  /**
+   * \brief Handles handing off a received message to the subscription, where it will be deserialized and called back
+   */
+  virtual void handleMessage(const SerializedMessage& m, bool ser, bool nocopy);
+
+private:
+  void receiveThread();
+
+  TransportSHMPtr transport_;
+  boost::thread receive_thread_;
+  volatile bool dropping_;
+  bool dropped_;
+  boost::mutex drop_mutex_;
+};
+typedef boost::shared_ptr<SHMPublisherLink> SHMPublisherLinkPtr;
+
+} // namespace ros
+
+#endif // ROSCPP_SHM_PUBLISHER_LINK_H
@@ -0,0 +1,81 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2016, Yukihiro Saito.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ROSCPP_SHM_SUBSCRIBER_LINK_H
+#define ROSCPP_SHM_SUBSCRIBER_LINK_H
+#include "subscriber_link.h"
+#include "common.h"
+
+#include <boost/thread/mutex.hpp>
+
+namespace ros
+{
+
+class TransportSHM;
+typedef boost::shared_ptr<TransportSHM> TransportSHMPtr;
+
+/**
+ * \brief SubscriberLink to a subscriber in another process on the same host.  The Publication writes
+ * each message once into its shared memory segment for all of them, so this only keeps the reader
+ * reserved for the subscriber
+ */
+class ROSCPP_DECL SHMSubscriberLink : public SubscriberLink
+{
+public:
+  SHMSubscriberLink(const PublicationPtr& parent);
+  virtual ~SHMSubscriberLink();
+
+  void initialize(const TransportSHMPtr& transport, int reader, const std::string& caller_id);
+  /**
+   * \brief Returns false once the subscriber has gone, and this link should be dropped
+   */
+  bool isAlive();
+
+  virtual void enqueueMessage(const SerializedMessage& m, bool ser, bool nocopy);
+  virtual void drop();
+  virtual std::string getTransportType();
+  virtual std::string getTransportInfo();
+  virtual bool isSHM() { return true; }
+
+private:
+  TransportSHMPtr transport_;
+  int reader_;
+  bool dropped_;
+  boost::mutex drop_mutex_;
+};
+typedef boost::shared_ptr<SHMSubscriberLink> SHMSubscriberLinkPtr;
+
+} // namespace ros
+
+#endif // ROSCPP_SHM_SUBSCRIBER_LINK_H
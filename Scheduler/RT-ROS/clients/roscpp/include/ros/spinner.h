@@ -33,6 +33,8 @@
 
 #include <boost/shared_ptr.hpp>
 
+#include <string>
+
 namespace ros
 {
 class NodeHandle;
@@ -79,6 +81,40 @@ private:
   uint32_t thread_count_;
 };
 
+/**
+ * \brief Spinner which runs the spinner_threads listed for this node in the ROSCH configuration.
+ *
+ * Each thread is bound to its cores and given its scheduling policy and priority once, when it starts.
+ * A thread which lists topics calls the callbacks of those topics only, from a queue of its own (see
+ * getSchedCallbackQueue()), and the threads which list no topics call the callbacks of the queue passed
+ * to spin().  ros::spin() uses this spinner when the node has spinner_threads.
+ */
+class ROSCPP_DECL SchedSpinner : public Spinner
+{
+public:
+  virtual void spin(CallbackQueue* queue = 0);
+
+  /**
+   * \brief Returns whether spinner_threads are configured for this node
+   */
+  static bool isConfigured();
+};
+
+/**
+ * \brief Returns the queue of the spinner thread which the ROSCH configuration binds the (resolved) topic
+ * to, or NULL if it is not bound to any.
+ *
+ * NodeHandle::subscribe() uses it for subscriptions which are given no queue, neither through their
+ * SubscribeOptions nor through the NodeHandle.  Nothing calls these queues but a SchedSpinner, and
+ * ros::spinOnce().
+ */
+ROSCPP_DECL CallbackQueue* getSchedCallbackQueue(const std::string& topic);
+
+/**
+ * \brief Calls the callbacks available in the queues returned by getSchedCallbackQueue(), for ros::spinOnce()
+ */
+ROSCPP_DECL void spinOnceSched();
+
 class AsyncSpinnerImpl;
 typedef boost::shared_ptr<AsyncSpinnerImpl> AsyncSpinnerImplPtr;
 
@@ -32,19 +32,104 @@
 #include "poll_set.h"
 #include "common.h"
 #include "publisher.h"
+#include "timer.h"
 #include <ros/time.h>
 #include "ros/subscription_callback_helper.h"
-#include <map>
+#include <cmath>
 
 namespace ros
 {
 
+/**
+ * \brief Mean, standard deviation and maximum of a series of durations, kept in constant
+ * memory, along with a histogram of them by powers of two.
+ *
+ * The mean and the variance are updated with Welford's method, so that adding a sample
+ * takes a few arithmetic operations and does not lose precision over long windows.
+ */
+struct ROSCPP_DECL StatisticsMoments
+{
+  enum { HISTOGRAM_SIZE = 24 };
+
+  StatisticsMoments()
+  {
+    reset();
+  }
+
+  void reset()
+  {
+    count = 0;
+    mean = 0.0;
+    m2 = 0.0;
+    max = 0.0;
+    for (int i = 0; i < HISTOGRAM_SIZE; ++i)
+    {
+      histogram[i] = 0;
+    }
+  }
+
+  /**
+   * \brief Adds a sample
+   * \param x The duration, in seconds
+   */
+  void add(double x)
+  {
+    ++count;
+    double delta = x - mean;
+    mean += delta / count;
+    m2 += delta * (x - mean);
+    if (count == 1 || x > max)
+    {
+      max = x;
+    }
+
+    ++histogram[getBucket(x)];
+  }
+
+  double stddev() const
+  {
+    return count > 0 ? std::sqrt(m2 / count) : 0.0;
+  }
+
+  /**
+   * \brief Returns the histogram bucket of a duration.  Bucket 0 counts durations under a
+   * microsecond, bucket i those from 2^(i-1) up to 2^i microseconds, and the last one all
+   * the longer ones.
+   */
+  static int getBucket(double x)
+  {
+    if (!(x >= 1e-6))
+    {
+      return 0;
+    }
+
+    double us = x * 1e6;
+    if (us >= (double)(1ULL << (HISTOGRAM_SIZE - 1)))
+    {
+      return HISTOGRAM_SIZE - 1;
+    }
+
+    // the number of bits of the whole microseconds
+    return 64 - __builtin_clzll((unsigned long long)us);
+  }
+
+  uint64_t count;
+  double mean;
+  double m2;
+  double max;
+  uint32_t histogram[HISTOGRAM_SIZE];
+};
+
 /**
  * \brief This class logs statistics data about a ROS connection and
  * publishs them periodically on a common topic.
  *
  * It provides a callback() function that has to be called everytime
- * a new message arrives on a topic.
+ * a new message arrives on a topic.  The callback only adds to running
+ * aggregates, which a timer on the internal callback queue publishes, so that
+ * statistics can be left enabled on real-time nodes.  With the
+ * /statistics_sample_interval parameter set to N, only one message in N is
+ * timed, while all of them are counted.
  */
 class ROSCPP_DECL StatisticsLogger
 {
@@ -55,6 +140,8 @@ public:
    */
   StatisticsLogger();
 
+  ~StatisticsLogger();
+
   /**
    * Actual initialization. Must be called before the first call to callback()
    */
@@ -67,6 +154,21 @@ public:
 
 private:
 
+  // the most publishers whose connections are logged
+  enum { MAX_CONNECTIONS = 16 };
+
+  struct StatData;
+
+  /**
+   * Returns the statistics of a connection, or NULL if there is no room for them
+   */
+  StatData* getStatData(const std::string& topic, const std::string& callerid);
+
+  /**
+   * Publishes the statistics of the window which ends, called by timer_
+   */
+  void publish(const ros::TimerEvent& event);
+
   // these are hard constrains
   int max_window;
   int min_window;
@@ -77,6 +179,9 @@ private:
 
   bool enable_statistics;
 
+  // time one message in this many
+  int sample_interval_;
+
   // remember, if this message type has a header
   bool hasHeader_;
 
@@ -86,23 +191,35 @@ private:
   // publisher for statistics data
   ros::Publisher pub_;
 
+  // ends the windows, in the internal callback queue thread
+  ros::Timer timer_;
+
   struct StatData {
-    // last time, we published /statistics data
-    ros::Time last_publish;
-    // arrival times of all messages within the current window
-    std::list<ros::Time> arrival_time_list;
-    // age of all messages within the current window (if available)
-    std::list<ros::Duration> age_list;
+    // 0 while free, 1 while being set up, 2 once in use
+    volatile int state;
+    std::string topic;
+    std::string callerid;
+    // taken to update or end the window.  Message arrivals skip the update rather than wait for it.
+    volatile int busy;
+    // start of the current window
+    ros::Time window_start;
+    // number of messages delivered within the current window, timed or not
+    volatile uint64_t delivered_msgs;
     // number of dropped messages
-    uint64_t dropped_msgs;
-    // latest sequence number observered (if available)
-    uint64_t last_seq;
-    // latest total traffic volume observed
+    volatile uint64_t dropped_msgs;
+    // latest total traffic volume observed, and the one when the current window started
+    volatile uint64_t stat_bytes;
     uint64_t stat_bytes_last;
+    // arrival time of the previous message, in nanoseconds
+    volatile int64_t last_arrival;
+    // periods between messages within the current window
+    StatisticsMoments period;
+    // age of messages within the current window (if available)
+    StatisticsMoments age;
   };
 
-  // storage for statistics data
-  std::map<std::string, struct StatData> map_;
+  // storage for statistics data, in constant memory so that it can be updated without locking
+  StatData connections_[MAX_CONNECTIONS];
 };
 
 }
@@ -84,8 +84,9 @@ public:
   /**
    * \brief Negotiates a connection with a publisher
    * \param xmlrpc_uri The XMLRPC URI to connect to to negotiate the connection
+   * \param shm Whether to offer the shared memory transport if hinted, false when falling back from it
    */
-  bool negotiateConnection(const std::string& xmlrpc_uri);
+  bool negotiateConnection(const std::string& xmlrpc_uri, bool shm = true);
 
   void addLocalConnection(const PublicationPtr& pub);
 
@@ -32,10 +32,13 @@
 #include "common.h"
 #include "forwards.h"
 #include "ros/message_event.h"
+#include "ros/lockfree_queue.h"
 
 #include <boost/enable_shared_from_this.hpp>
+#include <boost/scoped_ptr.hpp>
 #include <boost/thread/mutex.hpp>
 #include <boost/thread/recursive_mutex.hpp>
+#include <algorithm>
 #include <deque>
 
 // ROSCHEDULER
@@ -70,14 +73,31 @@ private:
 
     bool nonconst_need_copy;
     ros::Time receipt_time;
+
+    friend void swap(Item &a, Item &b) {
+      a.helper.swap(b.helper);
+      a.deserializer.swap(b.deserializer);
+      std::swap(a.has_tracked_object, b.has_tracked_object);
+      a.tracked_object.swap(b.tracked_object);
+      std::swap(a.nonconst_need_copy, b.nonconst_need_copy);
+      std::swap(a.receipt_time, b.receipt_time);
+    }
   };
   typedef std::deque<Item> D_Item;
+  typedef LockFreeQueue<Item> LF_Item;
 
 public:
   SubscriptionQueue(const std::string &topic, int32_t queue_size,
                     bool allow_concurrent_callbacks);
   ~SubscriptionQueue();
 
+  /**
+   * \brief Queues a message, discarding the oldest one if the queue is full.
+   *
+   * Queues of at most MAX_RING_SIZE messages are kept in a preallocated ring which push() and
+   * call() go through without locking or allocating; larger and unbounded queues use a deque.
+   * Threads pushing at the same time may briefly hold one message each over the queue size.
+   */
   void push(const SubscriptionCallbackHelperPtr &helper,
             const MessageDeserializerPtr &deserializer, bool has_tracked_object,
             const VoidConstWPtr &tracked_object, bool nonconst_need_copy,
@@ -86,17 +106,28 @@ public:
 
   virtual CallbackInterface::CallResult call();
   virtual bool ready();
+  /**
+   * \brief The topics which trigger the job of a ROSCH node get the priority of the node, and the period
+   * of its group as deadline
+   */
+  virtual CallbackSchedParam getSchedParam();
   bool full();
   // ROSCHEDULER
   void appThread(Item i, SubscriptionCallbackHelperCallParams params);
   void waitAppThread();
 
 private:
+  /// Largest queue size kept in a ring, so that a huge queue_size does not preallocate as much
+  static const int32_t MAX_RING_SIZE = 4096;
+
   bool fullNoLock();
+  bool pop(Item &i);
   std::string topic_;
   int32_t size_;
   bool full_;
 
+  boost::scoped_ptr<LF_Item> ring_;
+
   boost::mutex queue_mutex_;
   D_Item queue_;
   uint32_t queue_size_;
@@ -107,6 +138,10 @@ private:
   // ROSCHEDULER
   rosch::EventNotification event_notification;
   rosch::SingletonSchedNodeManager &sched_node_manager_;
+  /// Whether topic_ triggers the job of this node
+  bool sched_topic_;
+  /// Period of the group of this node, as deadline
+  WallDuration sched_deadline_;
 
 #ifdef ROSCH_H
   rosch::Analyzer analyzer;
@@ -31,6 +31,8 @@
 #include "ros/forwards.h"
 #include "ros/time.h"
 #include "ros/file_log.h"
+#include "ros/io.h"
+#include "ros/poll_set.h"
 
 #include <boost/thread/thread.hpp>
 #include <boost/thread/mutex.hpp>
@@ -42,6 +44,7 @@
 
 #include <vector>
 #include <list>
+#include <algorithm>
 
 namespace ros
 {
@@ -83,7 +86,14 @@ private:
   typedef boost::weak_ptr<TimerInfo> TimerInfoWPtr;
   typedef std::vector<TimerInfoPtr> V_TimerInfo;
 
-  typedef std::list<int32_t> L_int32;
+  // orders the waiting heap so that the earliest expected timer is at its front
+  struct LaterExpected
+  {
+    bool operator()(const TimerInfoPtr& lhs, const TimerInfoPtr& rhs) const
+    {
+      return rhs->next_expected < lhs->next_expected;
+    }
+  };
 
 public:
   TimerManager();
@@ -103,11 +113,16 @@ public:
 
 private:
   void threadFunc();
+  void timerFDThreadFunc();
 
-  bool waitingCompare(int32_t lhs, int32_t rhs);
   TimerInfoPtr findTimer(int32_t handle);
   void schedule(const TimerInfoPtr& info);
   void updateNext(const TimerInfoPtr& info, const T& current_time);
+  void pushWaiting(const TimerInfoPtr& info);
+  void checkTimeJumpedBackward(T& current);
+  T dispatch(T current);
+  void armTimerFD();
+  void onTimerFD(int events);
 
   V_TimerInfo timers_;
   boost::mutex timers_mutex_;
@@ -115,7 +130,12 @@ private:
   volatile bool new_timer_;
 
   boost::mutex waiting_mutex_;
-  L_int32 waiting_;
+  V_TimerInfo waiting_;
+
+  // on system time, the timer thread waits on a timer fd armed at the earliest expected time
+  int timer_fd_;
+  bool timer_fd_armed_;
+  T timer_fd_expected_;
 
   uint32_t id_counter_;
   boost::mutex id_mutex_;
@@ -193,6 +213,19 @@ private:
       return Success;
     }
 
+    CallbackSchedParam getSchedParam()
+    {
+      // implicit deadline: a call should be over before the next one is due
+      CallbackSchedParam param;
+      TimerInfoPtr info = info_.lock();
+      if (info && !info->oneshot)
+      {
+        param.deadline = WallDuration(info->period.toSec());
+      }
+
+      return param;
+    }
+
   private:
     TimerManager<T, D, E>* parent_;
     TimerInfoWPtr info_;
@@ -206,7 +239,7 @@ private:
 
 template<class T, class D, class E>
 TimerManager<T, D, E>::TimerManager() :
-  new_timer_(false), id_counter_(0), thread_started_(false), quit_(false)
+  new_timer_(false), timer_fd_(-1), timer_fd_armed_(false), id_counter_(0), thread_started_(false), quit_(false)
 {
 
 }
@@ -218,6 +251,12 @@ TimerManager<T, D, E>::~TimerManager()
   {
     boost::mutex::scoped_lock lock(timers_mutex_);
     timers_cond_.notify_all();
+
+    // expire at once, to wake up the thread
+    if (timer_fd_ >= 0)
+    {
+      set_timer_fd(timer_fd_, 1);
+    }
   }
   if (thread_started_)
   {
@@ -225,19 +264,6 @@ TimerManager<T, D, E>::~TimerManager()
   }
 }
 
-template<class T, class D, class E>
-bool TimerManager<T, D, E>::waitingCompare(int32_t lhs, int32_t rhs)
-{
-  TimerInfoPtr infol = findTimer(lhs);
-  TimerInfoPtr infor = findTimer(rhs);
-  if (!infol || !infor)
-  {
-    return infol < infor;
-  }
-
-  return infol->next_expected < infor->next_expected;
-}
-
 template<class T, class D, class E>
 typename TimerManager<T, D, E>::TimerInfoPtr TimerManager<T, D, E>::findTimer(int32_t handle)
 {
@@ -314,11 +340,7 @@ int32_t TimerManager<T, D, E>::add(const D& period, const boost::function<void(c
       thread_started_ = true;
     }
 
-    {
-      boost::mutex::scoped_lock lock(waiting_mutex_);
-      waiting_.push_back(info->handle);
-      waiting_.sort(boost::bind(&TimerManager::waitingCompare, this, _1, _2));
-    }
+    pushWaiting(info);
 
     new_timer_ = true;
     timers_cond_.notify_all();
@@ -353,11 +375,17 @@ void TimerManager<T, D, E>::remove(int32_t handle)
 
     {
       boost::mutex::scoped_lock lock2(waiting_mutex_);
-      // Remove from the waiting list if it's in it
-      L_int32::iterator it = std::find(waiting_.begin(), waiting_.end(), handle);
-      if (it != waiting_.end())
+      // Remove from the waiting heap if it's in it
+      typename V_TimerInfo::iterator it = waiting_.begin();
+      typename V_TimerInfo::iterator end = waiting_.end();
+      for (; it != end; ++it)
       {
-        waiting_.erase(it);
+        if ((*it)->handle == handle)
+        {
+          waiting_.erase(it);
+          std::make_heap(waiting_.begin(), waiting_.end(), LaterExpected());
+          break;
+        }
       }
     }
   }
@@ -379,13 +407,7 @@ void TimerManager<T, D, E>::schedule(const TimerInfoPtr& info)
   }
 
   updateNext(info, T::now());
-  {
-    boost::mutex::scoped_lock lock(waiting_mutex_);
-
-    waiting_.push_back(info->handle);
-    // waitingCompare requires a lock on the timers_mutex_
-    waiting_.sort(boost::bind(&TimerManager::waitingCompare, this, _1, _2));
-  }
+  pushWaiting(info);
 
   new_timer_ = true;
   timers_cond_.notify_one();
@@ -402,7 +424,8 @@ void TimerManager<T, D, E>::updateNext(const TimerInfoPtr& info, const T& curren
   {
     // Protect against someone having called setPeriod()
     // If the next expected time is already past the current time
-    // don't update it
+    // don't update it.  Periodic timers are expected at their start time
+    // plus a whole number of periods, however late their callbacks are.
     if (info->next_expected <= current_time)
     {
       info->last_expected = info->next_expected;
@@ -434,82 +457,182 @@ void TimerManager<T, D, E>::setPeriod(int32_t handle, const D& period)
     info->period = period;
     info->next_expected = T::now() + period;
 
-    waiting_.sort(boost::bind(&TimerManager::waitingCompare, this, _1, _2));
+    std::make_heap(waiting_.begin(), waiting_.end(), LaterExpected());
+    armTimerFD();
   }
 
   new_timer_ = true;
   timers_cond_.notify_one();
 }
 
+// requires a lock on the timers_mutex_
 template<class T, class D, class E>
-void TimerManager<T, D, E>::threadFunc()
+void TimerManager<T, D, E>::pushWaiting(const TimerInfoPtr& info)
 {
-  T current;
-  while (!quit_)
+  boost::mutex::scoped_lock lock(waiting_mutex_);
+
+  waiting_.push_back(info);
+  std::push_heap(waiting_.begin(), waiting_.end(), LaterExpected());
+  armTimerFD();
+}
+
+// requires a lock on the timers_mutex_
+template<class T, class D, class E>
+void TimerManager<T, D, E>::checkTimeJumpedBackward(T& current)
+{
+  if (T::now() < current)
   {
-    T sleep_end;
+    ROSCPP_LOG_DEBUG("Time jumped backward, resetting timers");
 
-    boost::mutex::scoped_lock lock(timers_mutex_);
+    current = T::now();
 
-    // detect time jumping backwards
-    if (T::now() < current)
+    typename V_TimerInfo::iterator it = timers_.begin();
+    typename V_TimerInfo::iterator end = timers_.end();
+    for (; it != end; ++it)
     {
-      ROSCPP_LOG_DEBUG("Time jumped backward, resetting timers");
-
-      current = T::now();
+      const TimerInfoPtr& info = *it;
 
-      typename V_TimerInfo::iterator it = timers_.begin();
-      typename V_TimerInfo::iterator end = timers_.end();
-      for (; it != end; ++it)
+      // Timer may have been added after the time jump, so also check if time has jumped past its last call time
+      if (current < info->last_expected)
       {
-        const TimerInfoPtr& info = *it;
-
-        // Timer may have been added after the time jump, so also check if time has jumped past its last call time
-        if (current < info->last_expected)
-        {
-          info->last_expected = current;
-          info->next_expected = current + info->period;
-        }
+        info->last_expected = current;
+        info->next_expected = current + info->period;
       }
     }
 
+    boost::mutex::scoped_lock waitlock(waiting_mutex_);
+    std::make_heap(waiting_.begin(), waiting_.end(), LaterExpected());
+  }
+}
+
+// Queues the callbacks of the timers which are due, and returns when the next one is.  Requires a lock on the
+// timers_mutex_
+template<class T, class D, class E>
+T TimerManager<T, D, E>::dispatch(T current)
+{
+  boost::mutex::scoped_lock waitlock(waiting_mutex_);
+
+  while (!waiting_.empty() && waiting_.front()->next_expected <= current)
+  {
+    TimerInfoPtr info = waiting_.front();
+    std::pop_heap(waiting_.begin(), waiting_.end(), LaterExpected());
+    waiting_.pop_back();
+
+    //ROS_DEBUG("Scheduling timer callback for timer [%d] of period [%f], [%f] off expected", info->handle, info->period.toSec(), (current - info->next_expected).toSec());
+    CallbackInterfacePtr cb(new TimerQueueCallback(this, info, info->last_expected, info->last_real, info->next_expected));
+    info->callback_queue->addCallback(cb, (uint64_t)info.get());
+
     current = T::now();
+  }
+
+  if (waiting_.empty())
+  {
+    return current + D(0.1);
+  }
+
+  return waiting_.front()->next_expected;
+}
+
+// Arms the timer fd at the next expected time, unless it already is.  Requires a lock on the waiting_mutex_
+template<class T, class D, class E>
+void TimerManager<T, D, E>::armTimerFD()
+{
+  if (timer_fd_ < 0)
+  {
+    return;
+  }
+
+  if (waiting_.empty())
+  {
+    return;
+  }
+
+  const T& next_expected = waiting_.front()->next_expected;
+  if (timer_fd_armed_ && next_expected == timer_fd_expected_)
+  {
+    return;
+  }
+
+  // the timer fd runs on the monotonic clock, which does not jump with the system time
+  int64_t remaining = std::max((next_expected - T::now()).toNSec(), (int64_t)0);
+  set_timer_fd(timer_fd_, monotonic_time_ns() + remaining);
+  timer_fd_armed_ = true;
+  timer_fd_expected_ = next_expected;
+}
+
+template<class T, class D, class E>
+void TimerManager<T, D, E>::onTimerFD(int events)
+{
+  read_timer_fd(timer_fd_);
+
+  boost::mutex::scoped_lock lock(waiting_mutex_);
+  timer_fd_armed_ = false;
+}
 
+template<class T, class D, class E>
+void TimerManager<T, D, E>::timerFDThreadFunc()
+{
+  PollSet poll_set;
+  poll_set.addSocket(timer_fd_, boost::bind(&TimerManager::onTimerFD, this, _1));
+  poll_set.addEvents(timer_fd_, POLLIN);
+
+  T current = T::now();
+  while (!quit_ && T::isSystemTime())
+  {
     {
-      boost::mutex::scoped_lock waitlock(waiting_mutex_);
+      boost::mutex::scoped_lock lock(timers_mutex_);
 
-      if (waiting_.empty())
-      {
-        sleep_end = current + D(0.1);
-      }
-      else
-      {
-        TimerInfoPtr info = findTimer(waiting_.front());
+      checkTimeJumpedBackward(current);
+      current = T::now();
+      dispatch(current);
 
-        while (!waiting_.empty() && info && info->next_expected <= current)
-        {
-          current = T::now();
+      boost::mutex::scoped_lock waitlock(waiting_mutex_);
+      armTimerFD();
+    }
 
-          //ROS_DEBUG("Scheduling timer callback for timer [%d] of period [%f], [%f] off expected", info->handle, info->period.toSec(), (current - info->next_expected).toSec());
-          CallbackInterfacePtr cb(new TimerQueueCallback(this, info, info->last_expected, info->last_real, info->next_expected));
-          info->callback_queue->addCallback(cb, (uint64_t)info.get());
+    // add(), schedule() and setPeriod() arm the timer fd again for timers expected earlier, so the timeout only
+    // bounds how long a jump of the system time goes unnoticed
+    poll_set.update(100);
+  }
 
-          waiting_.pop_front();
+  poll_set.delSocket(timer_fd_);
 
-          if (waiting_.empty())
-          {
-            break;
-          }
+  boost::mutex::scoped_lock lock(timers_mutex_);
+  boost::mutex::scoped_lock waitlock(waiting_mutex_);
+  close_timer_fd(timer_fd_);
+  timer_fd_ = -1;
+  timer_fd_armed_ = false;
+}
 
-          info = findTimer(waiting_.front());
-        }
+template<class T, class D, class E>
+void TimerManager<T, D, E>::threadFunc()
+{
+  if (T::isSystemTime())
+  {
+    {
+      boost::mutex::scoped_lock lock(timers_mutex_);
+      boost::mutex::scoped_lock waitlock(waiting_mutex_);
+      timer_fd_ = create_timer_fd();
+      armTimerFD();
+    }
 
-        if (info)
-        {
-          sleep_end = info->next_expected;
-        }
-      }
+    if (timer_fd_ >= 0)
+    {
+      // returns once quitting, or if simulation time is enabled
+      timerFDThreadFunc();
     }
+  }
+
+  T current;
+  while (!quit_)
+  {
+    T sleep_end;
+
+    boost::mutex::scoped_lock lock(timers_mutex_);
+
+    checkTimeJumpedBackward(current);
+    current = T::now();
+    sleep_end = dispatch(current);
 
     while (!new_timer_ && T::now() < sleep_end && !quit_)
     {
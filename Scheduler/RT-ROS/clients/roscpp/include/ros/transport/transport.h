@@ -49,6 +49,15 @@ typedef boost::shared_ptr<Transport> TransportPtr;
 
 class Header;
 
+/**
+ * \brief A buffer passed to Transport::writev()
+ */
+struct TransportBuffer
+{
+  uint8_t* data;
+  uint32_t size;
+};
+
 /**
  * \brief Abstract base class that allows abstraction of the transport type, eg. TCP, shared memory, UDP...
  */
@@ -72,6 +81,16 @@ public:
    * \return The number of bytes actually written, or -1 if there was an error
    */
   virtual int32_t write(uint8_t* buffer, uint32_t size) = 0;
+  /**
+   * \brief Write the supplied buffers in order, as if they were one.  Not guaranteed to actually write all of them.
+   *
+   * Transports which can gather buffers (e.g. with the writev() system call) write several of them at once.  By
+   * default only the first non-empty buffer is written, with write(), so that each buffer is written separately as before.
+   * \param buffers Buffers to write from
+   * \param count Number of buffers
+   * \return The number of bytes actually written, or -1 if there was an error
+   */
+  virtual int32_t writev(const TransportBuffer* buffers, uint32_t count);
 
   /**
    * \brief Enable writing on this transport.  Allows derived classes to, for example, enable write polling for asynchronous sockets
@@ -0,0 +1,187 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2016, Yukihiro Saito.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ROSCPP_TRANSPORT_SHM_H
+#define ROSCPP_TRANSPORT_SHM_H
+
+#include <ros/types.h>
+#include <ros/serialized_message.h>
+#include <ros/time.h>
+#include <ros/common.h>
+
+#include <boost/thread/mutex.hpp>
+#include <boost/enable_shared_from_this.hpp>
+
+#include <sys/types.h>
+
+namespace ros
+{
+
+class TransportSHM;
+typedef boost::shared_ptr<TransportSHM> TransportSHMPtr;
+
+struct TransportSHMHeader;
+struct TransportSHMSlot;
+
+#define ROS_SHM_SLOT_COUNT 16
+#define ROS_SHM_SLOT_SIZE (1024 * 1024)
+#define ROS_SHM_MAX_READERS 32
+
+/**
+ * \brief A shared memory segment through which a publication reaches its subscribers on the same host.
+ *
+ * Unlike TransportTCP and TransportUDP this is not a byte stream.  The publisher copies each serialized
+ * message once into a slot of a ring shared by all of its local subscribers, and the subscribers
+ * deserialize it in place.  A slot keeps one bit per subscriber that has not released it yet; the
+ * publisher skips the slots still in use, and drops the message only when all of them are.  A message
+ * larger than the slots makes the publisher abandon the segment, and its subscribers reconnect without it.
+ * Subscribers sleep on a futex in the segment, so no descriptor has to be passed between the processes.
+ *
+ * The publisher creates one segment per publication and reserves a reader for each subscriber; the
+ * subscriber opens the segment by name and attaches to its reader.
+ */
+class ROSCPP_DECL TransportSHM : public boost::enable_shared_from_this<TransportSHM>
+{
+public:
+  TransportSHM();
+  ~TransportSHM();
+
+  /**
+   * \brief Returns a string which is the same for every process on this host, and differs between hosts
+   */
+  static const std::string& getHostID();
+
+  /**
+   * \brief Creates and maps a new segment to publish through
+   * \param slot_count The number of slots in the ring, a power of two
+   * \param slot_size The largest serialized message, in bytes, a slot can hold
+   */
+  bool create(uint32_t slot_count, uint32_t slot_size);
+  /**
+   * \brief Maps the segment of a publisher to subscribe through
+   */
+  bool open(const std::string& name);
+
+  const std::string& getName() { return name_; }
+  uint32_t getSlotSize();
+  /**
+   * \brief Returns the number of messages the publisher could not write because every slot was in use
+   */
+  uint32_t getDrops();
+
+  /**
+   * \brief Reserves a reader for a subscriber process.  Returns its index, or -1 if all readers are in use
+   * \param generation Set to the value the subscriber must pass to attach()
+   */
+  int reserveReader(pid_t pid, uint32_t& generation);
+  /**
+   * \brief Frees a reader and every slot it holds, whichever side has closed it
+   */
+  void releaseReader(int reader);
+  /**
+   * \brief Returns false once the subscriber of a reader has closed it, exited or failed to attach in time
+   */
+  bool isReaderAlive(int reader);
+  /**
+   * \brief Copies a serialized message, including its length, into the next slot for every attached reader
+   * \return false if the message was dropped
+   */
+  bool write(const SerializedMessage& m);
+  /**
+   * \brief Stops publishing through this segment, and tells its subscribers to reconnect without shared memory
+   */
+  void abandon();
+
+  /**
+   * \brief Attaches the subscriber to the reader reserved for it.  Only messages written after this
+   * are received
+   */
+  bool attach(int reader, uint32_t generation);
+  /**
+   * \brief Detaches the subscriber.  The segment stays mapped until the last message read is released
+   */
+  void detach();
+  /**
+   * \brief Takes the next message written for this reader, without copying it.  The slot is released
+   * when the last copy of m goes away
+   * \return false if there is no message to read
+   */
+  bool read(SerializedMessage& m);
+  /**
+   * \brief Blocks until a message may have been written, wake() is called or the timeout expires
+   */
+  void wait(const WallDuration& timeout);
+  /**
+   * \brief Wakes up every subscriber waiting on this segment
+   */
+  void wake();
+  /**
+   * \brief Returns false once the publisher has released this reader or exited
+   */
+  bool isWriterAlive();
+  /**
+   * \brief Returns true if the publisher has abandoned this segment with abandon()
+   */
+  bool isAbandoned();
+
+private:
+  TransportSHMSlot* getSlot(uint32_t seq);
+  void releaseSlots(uint32_t bit);
+  bool map(int fd, size_t size);
+
+  std::string name_;
+  bool owner_;
+
+  void* base_;
+  size_t size_;
+  TransportSHMHeader* header_;
+  uint32_t slot_stride_;
+
+  /// publisher only
+  boost::mutex write_mutex_;
+  WallTime reserved_time_[ROS_SHM_MAX_READERS];
+  WallTime checked_time_[ROS_SHM_MAX_READERS];
+
+  /// subscriber only
+  int reader_;
+  uint32_t generation_;
+  uint32_t next_seq_;
+  WallTime checked_time_writer_;
+
+  friend struct TransportSHMRelease;
+};
+
+} // namespace ros
+
+#endif // ROSCPP_TRANSPORT_SHM_H
@@ -108,6 +108,7 @@ public:
   // overrides from Transport
   virtual int32_t read(uint8_t* buffer, uint32_t size);
   virtual int32_t write(uint8_t* buffer, uint32_t size);
+  virtual int32_t writev(const TransportBuffer* buffers, uint32_t count);
 
   virtual void enableWrite();
   virtual void disableWrite();
@@ -42,6 +42,8 @@
 #include "ros/io.h"
 #include <ros/common.h>
 
+#include <vector>
+
 namespace ros
 {
 
@@ -121,7 +123,42 @@ public:
 
   int getMaxDatagramSize() const {return max_datagram_size_;}
 
+  /**
+   * \brief Sets the size of the socket receive buffer (SO_RCVBUF)
+   * \param size The size, in bytes.  The kernel caps it at net.core.rmem_max
+   * \return Whether setting the size was successful
+   */
+  bool setReceiveBufferSize(int size);
+
+  /**
+   * \brief Returns the number of messages discarded because some of their datagrams were lost
+   */
+  uint64_t getDroppedMessages() const {return dropped_messages_;}
+  /**
+   * \brief Returns the number of datagrams received out of order within their message
+   */
+  uint64_t getReorderedDatagrams() const {return reordered_datagrams_;}
+
 private:
+  /**
+   * \brief A message being reassembled from its datagrams
+   */
+  struct Assembly
+  {
+    uint8_t message_id;
+    // 0 until the first datagram of the message (ROS_UDP_DATA0) has been received
+    uint16_t total_blocks;
+    uint16_t received_blocks;
+    uint16_t next_block;
+    // the size of each block, 0 for those not received yet
+    std::vector<uint32_t> block_sizes;
+    std::vector<uint8_t> data;
+    // the size of the message, once complete
+    uint32_t size;
+    uint64_t started;
+    bool in_use;
+  };
+
   /**
    * \brief Initializes the assigned socket -- sets it to non-blocking and enables reading
    */
@@ -136,6 +173,25 @@ private:
 
   void socketUpdate(int events);
 
+  /**
+   * \brief Receives a batch of datagrams
+   * \return 1 if some were received, 0 if none are pending, -1 if the socket was closed
+   */
+  int receive();
+  /**
+   * \brief Makes the next complete message the one being read
+   * \return 1 if there is one, 0 if none is complete yet, -1 if the socket was closed
+   */
+  int nextMessage();
+  /**
+   * \brief Adds a datagram of a message made of several to its assembly
+   * \return The assembly, if the datagram completed it
+   */
+  Assembly* assemble(const TransportUDPHeader& header, const uint8_t* data, uint32_t size);
+  Assembly* startAssembly(uint8_t message_id);
+  void dropAssembly(uint8_t message_id);
+  uint32_t getPayloadSize() const;
+
   socket_fd_t sock_;
   bool closed_;
   boost::mutex close_mutex_;
@@ -156,19 +212,29 @@ private:
 
   uint32_t connection_id_;
   uint8_t current_message_id_;
-  uint16_t total_blocks_;
-  uint16_t last_block_;
 
   uint32_t max_datagram_size_;
 
-  uint8_t* data_buffer_;
-  uint8_t* data_start_;
-  uint32_t data_filled_;
-
-  uint8_t* reorder_buffer_;
-  uint8_t* reorder_start_;
-  TransportUDPHeader reorder_header_;
-  uint32_t reorder_bytes_;
+  // datagrams received by the last receive(), each in a slot of max_datagram_size_ bytes
+  uint32_t batch_size_;
+  std::vector<uint8_t> recv_buffer_;
+  std::vector<TransportUDPHeader> recv_headers_;
+  std::vector<uint32_t> recv_sizes_;
+  uint32_t recv_count_;
+  uint32_t recv_next_;
+
+  // the part of the message being read which is left, in either a receive slot or an assembly
+  const uint8_t* message_start_;
+  uint32_t message_left_;
+  int reading_assembly_;
+
+  // messages of several datagrams being reassembled, indexed by message id
+  std::vector<Assembly> assemblies_;
+  int16_t assembly_index_[256];
+  uint64_t assemblies_started_;
+
+  uint64_t dropped_messages_;
+  uint64_t reordered_datagrams_;
 };
 
 }
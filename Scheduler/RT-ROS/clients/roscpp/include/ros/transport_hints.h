@@ -131,6 +131,34 @@ public:
     return boost::lexical_cast<int>(it->second);
   }
 
+  /**
+   * \brief If a UDP transport is used, specifies the size of the socket receive buffer (SO_RCVBUF),
+   * so that bursts of datagrams are not dropped by the kernel before they are read.  The kernel
+   * caps it at net.core.rmem_max.
+   *
+   * \param size The size, in bytes
+   */
+  TransportHints& udpReceiveBufferSize(int size)
+  {
+    options_["udp_receive_buffer_size"] = boost::lexical_cast<std::string>(size);
+    return *this;
+  }
+
+  /**
+   * \brief Returns the UDP receive buffer size specified on this TransportHints, or 0 if
+   * no size was specified.
+   */
+  int getUDPReceiveBufferSize()
+  {
+    M_string::iterator it = options_.find("udp_receive_buffer_size");
+    if (it == options_.end())
+    {
+      return 0;
+    }
+
+    return boost::lexical_cast<int>(it->second);
+  }
+
   /**
    * \brief Specifies an unreliable transport.  Currently this means UDP.
    */
@@ -150,6 +178,43 @@ public:
     return *this;
   }
 
+  /**
+   * \brief Specifies the shared memory transport.  It is only used with a publisher in another process
+   * on the same host and of the same user; otherwise the next transport is, or TCP if none follows.
+   */
+  TransportHints& shm()
+  {
+    transports_.push_back("SHM");
+    return *this;
+  }
+
+  /**
+   * \brief If the shared memory transport is used, specifies the size of the largest message.
+   * Publishers whose segment is already mapped with smaller slots fall back to the next transport.
+   *
+   * \param size The size, in bytes
+   */
+  TransportHints& shmSlotSize(int size)
+  {
+    options_["shm_slot_size"] = boost::lexical_cast<std::string>(size);
+    return *this;
+  }
+
+  /**
+   * \brief Returns the shared memory slot size specified on this TransportHints, or 0 if
+   * no size was specified.
+   */
+  int getSHMSlotSize()
+  {
+    M_string::iterator it = options_.find("shm_slot_size");
+    if (it == options_.end())
+    {
+      return 0;
+    }
+
+    return boost::lexical_cast<int>(it->second);
+  }
+
   /**
    * \brief Returns a vector of transports, ordered by preference
    */
@@ -29,6 +29,7 @@
 #define ROSCPP_TRANSPORT_SUBSCRIBER_LINK_H
 #include "common.h"
 #include "subscriber_link.h"
+#include "connection.h"
 
 #include <boost/signals2/connection.hpp>
 
@@ -71,6 +72,8 @@ private:
   std::queue<SerializedMessage> outbox_;
   boost::mutex outbox_mutex_;
   bool queue_full_;
+  /// Messages taken from the outbox and being written together, while writing_message_ is set
+  V_WriteBuffer writing_buffers_;
 };
 typedef boost::shared_ptr<TransportSubscriberLink> TransportSubscriberLinkPtr;
 
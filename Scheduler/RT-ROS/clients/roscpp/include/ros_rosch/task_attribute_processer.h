@@ -1,6 +1,7 @@
 #ifndef TASK_ATTRIBUTE_PROCESSER_H
 #define TASK_ATTRIBUTE_PROCESSER_H
 
+#include "ros_rosch/type.h"
 #include <sched.h>
 #include <vector>
 
@@ -14,6 +15,7 @@ public:
   bool setAffinityToAllCore();
   void setCFS(std::vector<pid_t> v_pid);
   void setDefaultScheduling(std::vector<pid_t> v_pid);
+  bool setThreadAttribute(const ThreadInfo &thread_info);
 };
 }
 
@@ -12,13 +12,29 @@ typedef struct SchedInfo {
   int end_time;
 } SchedInfo;
 
+typedef struct GroupInfo {
+  std::string name;
+  int index; /* -1 if the node is in no group. */
+  int period; /* by ms */
+  int budget; /* by ms, or 0 if unlimited. */
+} GroupInfo;
+
+typedef struct ThreadInfo {
+  std::vector<int> v_core; /* empty to inherit the affinity of the node. */
+  int policy; /* SCHED_OTHER, SCHED_FIFO or SCHED_RR */
+  int priority;
+  std::vector<std::string> v_topic; /* empty for the callbacks of the other topics. */
+} ThreadInfo;
+
 typedef struct NodeInfo {
   std::string name;
   int index;
   int core;
+  GroupInfo group;
   std::vector<SchedInfo> v_sched_info;
   std::vector<std::string> v_subtopic;
   std::vector<std::string> v_pubtopic;
+  std::vector<ThreadInfo> v_thread_info; /* spinner threads, or empty */
 	bool is_single_process;
 	int period_count;
 } NodeInfo;
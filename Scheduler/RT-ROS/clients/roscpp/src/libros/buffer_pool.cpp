@@ -0,0 +1,142 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2016, Yukihiro Saito.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "ros/buffer_pool.h"
+
+#include <algorithm>
+
+namespace ros
+{
+
+/// The smallest size class, in bytes, as a power of two
+static const uint32_t MIN_SIZE_CLASS = 6;
+
+BufferPool::BufferPool(uint32_t max_cached, uint32_t max_size)
+: max_cached_(max_cached)
+, max_size_(std::min(max_size, 1U << 31))
+, free_(32)
+{
+}
+
+BufferPool::~BufferPool()
+{
+  for (size_t i = 0; i < free_.size(); ++i)
+  {
+    for (size_t j = 0; j < free_[i].size(); ++j)
+    {
+      delete[] free_[i][j];
+    }
+  }
+}
+
+boost::shared_array<uint8_t> BufferPool::acquire(uint32_t size)
+{
+  if (size > max_size_)
+  {
+    boost::mutex::scoped_lock lock(mutex_);
+    ++stats_.acquired;
+    ++stats_.allocated;
+    return boost::shared_array<uint8_t>(new uint8_t[size]);
+  }
+
+  uint32_t size_class = MIN_SIZE_CLASS;
+  while ((1U << size_class) < size)
+  {
+    ++size_class;
+  }
+
+  uint8_t* buffer = 0;
+  {
+    boost::mutex::scoped_lock lock(mutex_);
+    ++stats_.acquired;
+
+    V_Buffer& buffers = free_[size_class];
+    if (!buffers.empty())
+    {
+      buffer = buffers.back();
+      buffers.pop_back();
+      ++stats_.recycled;
+    }
+    else
+    {
+      ++stats_.allocated;
+    }
+  }
+
+  if (!buffer)
+  {
+    buffer = new uint8_t[1U << size_class];
+  }
+
+  return boost::shared_array<uint8_t>(buffer, Release(shared_from_this(), size_class));
+}
+
+void BufferPool::release(uint8_t* buffer, uint32_t size_class)
+{
+  {
+    boost::mutex::scoped_lock lock(mutex_);
+
+    V_Buffer& buffers = free_[size_class];
+    if (buffers.size() < max_cached_)
+    {
+      buffers.push_back(buffer);
+      return;
+    }
+
+    ++stats_.freed;
+  }
+
+  delete[] buffer;
+}
+
+BufferPool::Stats BufferPool::getStats()
+{
+  boost::mutex::scoped_lock lock(mutex_);
+  return stats_;
+}
+
+void BufferPool::Release::operator()(uint8_t* buffer)
+{
+  BufferPoolPtr pool = pool_.lock();
+  if (pool)
+  {
+    pool->release(buffer, size_class_);
+  }
+  else
+  {
+    delete[] buffer;
+  }
+}
+
+}
@@ -35,15 +35,68 @@
 #include "ros/callback_queue.h"
 #include "ros/assert.h"
 
+#include <algorithm>
+
 namespace ros
 {
 
 CallbackQueue::CallbackQueue(bool enabled)
 : calling_(0)
+, order_(FIFO)
+, next_seq_(0)
+, enabled_(enabled)
+{
+}
+
+CallbackQueue::CallbackQueue(bool enabled, Order order)
+: calling_(0)
+, order_(order)
+, next_seq_(0)
 , enabled_(enabled)
 {
 }
 
+bool CallbackQueue::LessUrgent::operator()(const CallbackInfo& a, const CallbackInfo& b) const
+{
+  // callbacks without a deadline come after those with one
+  bool deadline_differs = a.deadline != b.deadline;
+  bool a_later = b.deadline.isZero() ? false : (a.deadline.isZero() || a.deadline > b.deadline);
+
+  if (order == ByPriority)
+  {
+    if (a.priority != b.priority)
+    {
+      return a.priority < b.priority;
+    }
+    if (deadline_differs)
+    {
+      return a_later;
+    }
+  }
+  else
+  {
+    if (deadline_differs)
+    {
+      return a_later;
+    }
+    if (a.priority != b.priority)
+    {
+      return a.priority < b.priority;
+    }
+  }
+
+  return a.seq > b.seq;
+}
+
+void CallbackQueue::pushCallback(const CallbackInfo& info)
+{
+  callbacks_.push_back(info);
+  if (order_ != FIFO)
+  {
+    std::push_heap(callbacks_.begin(), callbacks_.end(), LessUrgent(order_));
+  }
+}
+
 CallbackQueue::~CallbackQueue()
 {
   disable();
@@ -100,6 +153,16 @@ void CallbackQueue::addCallback(const CallbackInterfacePtr& callback, uint64_t r
   info.callback = callback;
   info.removal_id = removal_id;
 
+  if (order_ != FIFO)
+  {
+    CallbackSchedParam param = callback->getSchedParam();
+    info.priority = param.priority;
+    if (!param.deadline.isZero())
+    {
+      info.deadline = WallTime::now() + param.deadline;
+    }
+  }
+
   {
     boost::mutex::scoped_lock lock(mutex_);
 
@@ -108,7 +171,8 @@ void CallbackQueue::addCallback(const CallbackInterfacePtr& callback, uint64_t r
       return;
     }
 
-    callbacks_.push_back(info);
+    info.seq = next_seq_++;
+    pushCallback(info);
   }
 
   {
@@ -180,6 +244,11 @@ void CallbackQueue::removeByID(uint64_t removal_id)
           ++it;
         }
       }
+
+      if (order_ != FIFO)
+      {
+        std::make_heap(callbacks_.begin(), callbacks_.end(), LessUrgent(order_));
+      }
     }
 
     if (tls_->calling_in_this_thread == id_info->id)
@@ -242,25 +311,59 @@ CallbackQueue::CallOneResult CallbackQueue::callOne(ros::WallDuration timeout)
       }
     }
 
-    D_CallbackInfo::iterator it = callbacks_.begin();
-    for (; it != callbacks_.end();)
+    if (order_ != FIFO)
     {
-      CallbackInfo& info = *it;
-
-      if (info.marked_for_removal)
+      // the most urgent callback is in front, and is nearly always ready
+      LessUrgent less_urgent(order_);
+      D_CallbackInfo::iterator best = callbacks_.end();
+      for (D_CallbackInfo::iterator it = callbacks_.begin(); it != callbacks_.end(); ++it)
       {
-        it = callbacks_.erase(it);
-        continue;
+        if (!it->marked_for_removal && it->callback->ready()
+            && (best == callbacks_.end() || less_urgent(*best, *it)))
+        {
+          best = it;
+          if (it == callbacks_.begin())
+          {
+            break;
+          }
+        }
       }
 
-      if (info.callback->ready())
+      if (best == callbacks_.begin())
+      {
+        cb_info = callbacks_.front();
+        std::pop_heap(callbacks_.begin(), callbacks_.end(), less_urgent);
+        callbacks_.pop_back();
+      }
+      else if (best != callbacks_.end())
       {
-        cb_info = info;
-        it = callbacks_.erase(it);
-        break;
+        cb_info = *best;
+        callbacks_.erase(best);
+        std::make_heap(callbacks_.begin(), callbacks_.end(), less_urgent);
       }
+    }
+    else
+    {
+      D_CallbackInfo::iterator it = callbacks_.begin();
+      for (; it != callbacks_.end();)
+      {
+        CallbackInfo& info = *it;
+
+        if (info.marked_for_removal)
+        {
+          it = callbacks_.erase(it);
+          continue;
+        }
 
-      ++it;
+        if (info.callback->ready())
+        {
+          cb_info = info;
+          it = callbacks_.erase(it);
+          break;
+        }
+
+        ++it;
+      }
     }
 
     if (!cb_info.callback)
@@ -315,7 +418,16 @@ void CallbackQueue::callAvailable(ros::WallDuration timeout)
 
     bool was_empty = tls->callbacks.empty();
 
-    tls->callbacks.insert(tls->callbacks.end(), callbacks_.begin(), callbacks_.end());
+    if (order_ != FIFO)
+    {
+      // sort_heap() leaves the most urgent callback at the back
+      std::sort_heap(callbacks_.begin(), callbacks_.end(), LessUrgent(order_));
+      tls->callbacks.insert(tls->callbacks.end(), callbacks_.rbegin(), callbacks_.rend());
+    }
+    else
+    {
+      tls->callbacks.insert(tls->callbacks.end(), callbacks_.begin(), callbacks_.end());
+    }
     callbacks_.clear();
 
     calling_ += tls->callbacks.size();
@@ -395,7 +507,7 @@ CallbackQueue::CallOneResult CallbackQueue::callOneCB(TLS* tls)
     if (result == CallbackInterface::TryAgain && !info.marked_for_removal)
     {
       boost::mutex::scoped_lock lock(mutex_);
-      callbacks_.push_back(info);
+      pushCallback(info);
 
       return TryAgain;
     }
@@ -44,9 +44,11 @@
 namespace ros {
 
 Connection::Connection()
-    : is_server_(false), dropped_(false), read_filled_(0), read_size_(0),
-      reading_(false), has_read_callback_(0), write_sent_(0), write_size_(0),
-      writing_(false), has_write_callback_(0), sending_header_error_(false) {}
+    : is_server_(false), dropped_(false),
+      large_buffer_pool_(new BufferPool(2, 0xffffffff)), read_filled_(0),
+      read_size_(0), reading_(false), has_read_callback_(0), write_sent_(0),
+      write_size_(0), writing_(false), has_write_callback_(0),
+      sending_header_error_(false) {}
 
 Connection::~Connection() {
   ROS_DEBUG_NAMED("superdebug", "Connection destructing, dropped=%s",
@@ -179,8 +181,28 @@ void Connection::writeTransport() {
   while (has_write_callback_ && can_write_more && !dropped_) {
     uint32_t to_write = write_size_ - write_sent_;
     ROS_DEBUG_NAMED("superdebug", "Connection writing %d bytes", to_write);
-    int32_t bytes_sent =
-        transport_->write(write_buffer_.get() + write_sent_, to_write);
+    int32_t bytes_sent;
+    if (write_buffers_.size() == 1) {
+      bytes_sent = transport_->write(
+          write_buffers_.front().buf.get() + write_sent_, to_write);
+    } else {
+      // hand the rest of every buffer to the transport at once
+      write_vecs_.clear();
+      uint32_t offset = write_sent_;
+      for (size_t i = 0; i < write_buffers_.size(); ++i) {
+        const WriteBuffer &b = write_buffers_[i];
+        if (offset >= b.size) {
+          offset -= b.size;
+          continue;
+        }
+        TransportBuffer v;
+        v.data = b.buf.get() + offset;
+        v.size = b.size - offset;
+        write_vecs_.push_back(v);
+        offset = 0;
+      }
+      bytes_sent = transport_->writev(&write_vecs_.front(), write_vecs_.size());
+    }
     ROS_DEBUG_NAMED("superdebug", "Connection wrote %d bytes", bytes_sent);
 
     if (bytes_sent < 0) {
@@ -204,7 +226,7 @@ void Connection::writeTransport() {
         // in it
         callback = write_callback_;
         write_callback_ = WriteFinishedFunc();
-        write_buffer_ = boost::shared_array<uint8_t>();
+        write_buffers_.clear();
         write_sent_ = 0;
         write_size_ = 0;
         has_write_callback_ = 0;
@@ -242,7 +264,13 @@ void Connection::read(uint32_t size, const ReadFinishedFunc &callback) {
     ROS_ASSERT(!read_callback_);
 
     read_callback_ = callback;
-    read_buffer_ = boost::shared_array<uint8_t>(new uint8_t[size]);
+    // large frames of a stream usually have the same size, so recycle them
+    // per connection
+    if (size >= READ_BUFFER_SIZE) {
+      read_buffer_ = large_buffer_pool_->acquire(size);
+    } else {
+      read_buffer_ = boost::shared_array<uint8_t>(new uint8_t[size]);
+    }
     read_size_ = size;
     read_filled_ = 0;
     has_read_callback_ = 1;
@@ -267,7 +295,8 @@ void Connection::write(const boost::shared_array<uint8_t> &buffer,
     ROS_ASSERT(!write_callback_);
 
     write_callback_ = callback;
-    write_buffer_ = buffer;
+    write_buffers_.clear();
+    write_buffers_.push_back(WriteBuffer(buffer, size));
     write_size_ = size;
     write_sent_ = 0;
     has_write_callback_ = 1;
@@ -281,6 +310,35 @@ void Connection::write(const boost::shared_array<uint8_t> &buffer,
   }
 }
 
+void Connection::writev(const V_WriteBuffer &buffers,
+                        const WriteFinishedFunc &callback, bool immediate) {
+  if (dropped_ || sending_header_error_) {
+    return;
+  }
+
+  {
+    boost::mutex::scoped_lock lock(write_callback_mutex_);
+
+    ROS_ASSERT(!write_callback_);
+
+    write_callback_ = callback;
+    write_buffers_ = buffers;
+    write_size_ = 0;
+    for (size_t i = 0; i < buffers.size(); ++i) {
+      write_size_ += buffers[i].size;
+    }
+    write_sent_ = 0;
+    has_write_callback_ = 1;
+  }
+
+  transport_->enableWrite();
+
+  if (immediate) {
+    // write immediately if possible
+    writeTransport();
+  }
+}
+
 void Connection::onDisconnect(const TransportPtr &transport) {
   ROS_ASSERT(transport == transport_);
 
@@ -323,13 +381,14 @@ void Connection::writeHeader(const M_string &key_vals,
   uint32_t len;
   Header::write(key_vals, buffer, len);
 
-  uint32_t msg_len = len + 4;
-  boost::shared_array<uint8_t> full_msg(new uint8_t[msg_len]);
-  memcpy(full_msg.get() + 4, buffer.get(), len);
-  *((uint32_t *)full_msg.get()) = len;
+  // send the length in front of the header without copying it
+  boost::shared_array<uint8_t> len_buf(new uint8_t[4]);
+  *((uint32_t *)len_buf.get()) = len;
 
-  write(full_msg, msg_len, boost::bind(&Connection::onHeaderWritten, this, _1),
-        false);
+  V_WriteBuffer buffers;
+  buffers.push_back(WriteBuffer(len_buf, 4));
+  buffers.push_back(WriteBuffer(buffer, len));
+  writev(buffers, boost::bind(&Connection::onHeaderWritten, this, _1), false);
 }
 
 void Connection::sendHeaderError(const std::string &error_msg) {
@@ -59,6 +59,7 @@
 #include <rosgraph_msgs/Clock.h>
 
 #include <algorithm>
+#include <climits>
 
 #include <signal.h>
 
@@ -447,6 +448,72 @@ end:
   }
 }
 
+#ifndef USE_LINUX_SYSTEM_CALL
+/* add the cores to the attributes for ros_rt_set_attr(). RESCH takes
+ * them as a bitmap of one long, so return false if a core is out of it,
+ * and let set_affinity() take the cores instead. */
+static bool affinity_attr(const std::vector<int> &v_core, struct rt_attr *attr)
+{
+  unsigned long cpus = 0;
+  for (int i = 0; i < (int)v_core.size(); ++i) {
+    int core = v_core.at(i);
+    if (core < 0 || core >= (int)(sizeof(cpus) * CHAR_BIT))
+      return false;
+    cpus |= 1UL << core;
+  }
+  if (cpus == 0)
+    return false;
+  attr->mask |= RT_ATTR_AFFINITY;
+  attr->affinity = cpus;
+  return true;
+}
+
+static struct timespec ms_to_timespec(int ms)
+{
+  struct timespec ts;
+  ts.tv_sec = ms / 1000;
+  ts.tv_nsec = (ms % 1000) * 1000000L;
+  return ts;
+}
+
+/* compose the current task into the component of the group, so that
+ * the nodes of the group cannot take more than the budget every period.
+ * only the node that creates the component sets its period and budget;
+ * setting them starts the budget over, so the nodes joining later must
+ * not refill it in the middle of a period. the budget is set first, as
+ * the component is refused to compose into until it has a period, and
+ * the joining nodes retry until then. */
+static bool compose_group(const GroupInfo &group)
+{
+  // how long a joining node waits for the creator to configure the group
+  const int compose_retries = 100;
+  const useconds_t compose_interval_us = 10000;
+
+  if (group.index < 0)
+    return true;
+  bool creator = rt_component_create(group.index) == group.index;
+  if (creator) {
+    if (!rt_component_budget(group.index, ms_to_timespec(group.budget)) ||
+        !rt_component_period(group.index, ms_to_timespec(group.period))) {
+      std::cerr << "[node(" << getpid() << ")] Failed to configure component "
+                << group.name << std::endl;
+      return false;
+    }
+  }
+  for (int i = 0; !rt_compose(group.index); ++i) {
+    if (creator || i >= compose_retries) {
+      std::cerr << "[node(" << getpid() << ")] Failed to compose into "
+                << group.name << std::endl;
+      return false;
+    }
+    usleep(compose_interval_us);
+  }
+  std::cout << "Group:" << group.name << " (" << group.budget << "/"
+            << group.period << " ms)" << std::endl;
+  return true;
+}
+#endif
+
 void init(const M_string &remappings, const std::string &name,
           uint32_t options) {
 
@@ -488,21 +555,42 @@ void init(const M_string &remappings, const std::string &name,
     std::vector<pid_t> v_pid;
     v_pid.push_back(0);
 
+    // with spinner_threads, the spinner applies the core sets and
+    // priorities to its threads instead of the whole node
+    const bool per_thread = !node_info.v_thread_info.empty();
+
 #ifndef USE_LINUX_SYSTEM_CALL
 		cpu_set_t mask;
 		CPU_ZERO(&mask);
 
 		ros_rt_init("temp");
 
-		// for distribution system
-		set_affinity(sched_node_manager.getUseCores());
-
-	  ros_rt_set_scheduler(SCHED_FP);
-		ros_rt_set_priority(sched_node_manager.getPriority());
+		if (!per_thread) {
+			// for distribution system
+			struct rt_attr attr;
+			memset(&attr, 0, sizeof(attr));
+			attr.mask = RT_ATTR_POLICY | RT_ATTR_PRIORITY;
+			attr.policy = SCHED_FP;
+			attr.priority = sched_node_manager.getPriority();
+			// this thread is the task registered by ros_rt_init()
+			if (!affinity_attr(sched_node_manager.getUseCores(), &attr))
+				set_affinity(sched_node_manager.getUseCores());
+			if (!ros_rt_set_attr(&attr)) {
+				std::cerr << "[node(" << getpid() << ")] Failed to set priority "
+				          << attr.priority << " and cores of the node" << std::endl;
+			}
+		}
+
+		if (!compose_group(node_info.group)) {
+			std::cerr << "[node(" << getpid() << ")] Running outside of group "
+			          << node_info.group.name << std::endl;
+		}
 #else
-		rosch::TaskAttributeProcesser task_attr_proc;
-    task_attr_proc.setCoreAffinity(sched_node_manager.getUseCores());
-    task_attr_proc.setRealtimePriority(v_pid, sched_node_manager.getPriority());
+		if (!per_thread) {
+			rosch::TaskAttributeProcesser task_attr_proc;
+			task_attr_proc.setCoreAffinity(sched_node_manager.getUseCores());
+			task_attr_proc.setRealtimePriority(v_pid, sched_node_manager.getPriority());
+		}
 #endif
     {
       std::cout << "==== Node Infomation ====" << std::endl
@@ -518,6 +606,10 @@ void init(const M_string &remappings, const std::string &name,
       for (; topic_itr != node_info.v_subtopic.end(); ++topic_itr) {
         std::cout << *topic_itr << std::endl;
       }
+      if (per_thread) {
+        std::cout << "Spinner Threads:" << node_info.v_thread_info.size()
+                  << std::endl;
+      }
       std::cout << "=========================" << std::endl;
     }
 #if 0
@@ -637,13 +729,22 @@ void removeROSArgs(int argc, const char *const *argv, V_string &args_out) {
 }
 
 void spin() {
+  if (SchedSpinner::isConfigured()) {
+    SchedSpinner s;
+    spin(s);
+    return;
+  }
+
   SingleThreadedSpinner s;
   spin(s);
 }
 
 void spin(Spinner &s) { s.spin(); }
 
-void spinOnce() { g_global_queue->callAvailable(ros::WallDuration()); }
+void spinOnce() {
+  g_global_queue->callAvailable(ros::WallDuration());
+  spinOnceSched();
+}
 
 void waitForShutdown() {
   while (ok()) {
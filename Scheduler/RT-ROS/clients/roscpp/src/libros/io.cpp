@@ -35,6 +35,7 @@
 ** Includes
 *****************************************************************************/
 
+#include "config.h"
 #include <ros/io.h>
 #include <ros/assert.h> // don't need if we dont call the pipe functions.
 #include <errno.h> // for EFAULT and co.
@@ -44,6 +45,13 @@
 #else
   #include <cstring> // strerror
   #include <fcntl.h> // for non-blocking configuration
+  #include <time.h> // clock_gettime for monotonic_time_ns
+#endif
+#ifdef HAVE_EPOLL
+  #include <sys/epoll.h>
+#endif
+#ifdef HAVE_TIMERFD
+  #include <sys/timerfd.h>
 #endif
 
 /*****************************************************************************
@@ -227,6 +235,221 @@ int poll_sockets(socket_pollfd *fds, nfds_t nfds, int timeout) {
 	return result;
 #endif // poll_sockets functions
 }
+
+/*****************************************************************************
+** Socket Watcher
+*****************************************************************************/
+/*
+ * The socket watcher keeps the set of sockets in the kernel (epoll), so that
+ * sockets and their events are registered once instead of being passed on
+ * every wait, and a wait only returns the sockets which are ready.  Where it
+ * is not available, create_socket_watcher() fails and poll_sockets() should
+ * be used instead.
+ */
+
+/**
+ * @brief Creates a socket watcher.
+ * @return int : the watcher on success, -1 if not available.
+ */
+int create_socket_watcher() {
+#if defined(HAVE_EPOLL)
+	return ::epoll_create1(EPOLL_CLOEXEC);
+#else
+	return -1;
+#endif
+}
+
+/**
+ * @brief Closes a socket watcher created by create_socket_watcher().
+ */
+void close_socket_watcher(int watcher) {
+#if defined(HAVE_EPOLL)
+	if (watcher >= 0) {
+		::close(watcher);
+	}
+#else
+	(void)watcher;
+#endif
+}
+
+/**
+ * @brief Starts watching the socket for the poll events.
+ *
+ * POLLERR and POLLHUP are always reported, as with poll().
+ * @return int : 0 on success, -1 on failure (errno is set).
+ */
+int add_socket_to_watcher(int watcher, socket_fd_t socket, int events) {
+#if defined(HAVE_EPOLL)
+	struct epoll_event ev;
+	std::memset(&ev, 0, sizeof(ev));
+	// EPOLLIN, EPOLLOUT, EPOLLPRI, EPOLLERR and EPOLLHUP share the values of their poll counterparts.
+	ev.events = events;
+	ev.data.fd = socket;
+	return ::epoll_ctl(watcher, EPOLL_CTL_ADD, socket, &ev);
+#else
+	(void)watcher; (void)socket; (void)events;
+	errno = ENOSYS;
+	return -1;
+#endif
+}
+
+/**
+ * @brief Stops watching the socket.
+ * @return int : 0 on success, -1 on failure (errno is set).
+ */
+int del_socket_from_watcher(int watcher, socket_fd_t socket) {
+#if defined(HAVE_EPOLL)
+	// a non-null event is required by kernels before 2.6.9.
+	struct epoll_event ev;
+	std::memset(&ev, 0, sizeof(ev));
+	return ::epoll_ctl(watcher, EPOLL_CTL_DEL, socket, &ev);
+#else
+	(void)watcher; (void)socket;
+	errno = ENOSYS;
+	return -1;
+#endif
+}
+
+/**
+ * @brief Replaces the poll events watched on the socket.
+ * @return int : 0 on success, -1 on failure (errno is set).
+ */
+int set_events_on_socket(int watcher, socket_fd_t socket, int events) {
+#if defined(HAVE_EPOLL)
+	struct epoll_event ev;
+	std::memset(&ev, 0, sizeof(ev));
+	ev.events = events;
+	ev.data.fd = socket;
+	return ::epoll_ctl(watcher, EPOLL_CTL_MOD, socket, &ev);
+#else
+	(void)watcher; (void)socket; (void)events;
+	errno = ENOSYS;
+	return -1;
+#endif
+}
+
+/**
+ * @brief Waits for events on the watched sockets.
+ *
+ * Only the sockets which are ready are stored in fds, with their poll events
+ * in revents.
+ * @return int : the number of entries stored in fds, 0 on timeout or
+ * interruption, -1 on failure (errno is set).
+ */
+int wait_socket_watcher(int watcher, socket_pollfd *fds, nfds_t nfds, int timeout) {
+#if defined(HAVE_EPOLL)
+	struct epoll_event evs[64];
+	int max_events = nfds < 64 ? (int)nfds : 64;
+	if (fds == NULL || max_events <= 0) {
+		errno = EINVAL;
+		return -1;
+	}
+	int result = ::epoll_wait(watcher, evs, max_events, timeout);
+	if (result < 0) {
+		// EINTR means that we got interrupted by a signal, and is not an error
+		if (errno == EINTR) {
+			result = 0;
+		}
+		return result;
+	}
+	for (int i = 0; i < result; ++i) {
+		fds[i].fd = evs[i].data.fd;
+		fds[i].events = 0;
+		fds[i].revents = evs[i].events;
+	}
+	return result;
+#else
+	(void)watcher; (void)fds; (void)nfds; (void)timeout;
+	errno = ENOSYS;
+	return -1;
+#endif
+}
+/*****************************************************************************
+** Timer Fd
+*****************************************************************************/
+/*
+ * A timer fd expires at an absolute time of CLOCK_MONOTONIC and then becomes
+ * readable, so that timers can be waited for in a poll set with nanosecond
+ * resolution.  Where it is not available, create_timer_fd() fails.
+ */
+
+/**
+ * @brief Creates a non blocking timer fd, disarmed.
+ * @return int : the timer fd on success, -1 if not available.
+ */
+int create_timer_fd() {
+#if defined(HAVE_TIMERFD)
+	return ::timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+#else
+	errno = ENOSYS;
+	return -1;
+#endif
+}
+
+/**
+ * @brief Closes a timer fd created by create_timer_fd().
+ */
+void close_timer_fd(int timer) {
+#if defined(HAVE_TIMERFD)
+	if (timer >= 0) {
+		::close(timer);
+	}
+#else
+	(void)timer;
+#endif
+}
+
+/**
+ * @brief Arms the timer fd to expire once at expiry_ns (CLOCK_MONOTONIC, see
+ * monotonic_time_ns()), or disarms it if expiry_ns is 0.  An expiry in the
+ * past expires at once.
+ * @return int : 0 on success, -1 on failure (errno is set).
+ */
+int set_timer_fd(int timer, int64_t expiry_ns) {
+#if defined(HAVE_TIMERFD)
+	struct itimerspec spec;
+	std::memset(&spec, 0, sizeof(spec));
+	spec.it_value.tv_sec = expiry_ns / 1000000000LL;
+	spec.it_value.tv_nsec = expiry_ns % 1000000000LL;
+	return ::timerfd_settime(timer, TFD_TIMER_ABSTIME, &spec, NULL);
+#else
+	(void)timer; (void)expiry_ns;
+	errno = ENOSYS;
+	return -1;
+#endif
+}
+
+/**
+ * @brief Clears the expiration of the timer fd, so that it is no longer readable.
+ * @return int : the number of expirations since the last read, 0 if none.
+ */
+int read_timer_fd(int timer) {
+#if defined(HAVE_TIMERFD)
+	uint64_t expirations = 0;
+	if (::read(timer, &expirations, sizeof(expirations)) != sizeof(expirations)) {
+		return 0;
+	}
+	return (int)expirations;
+#else
+	(void)timer;
+	return 0;
+#endif
+}
+
+/**
+ * @brief The current time of CLOCK_MONOTONIC, which timer fds expire on.
+ * @return int64_t : nanoseconds.
+ */
+int64_t monotonic_time_ns() {
+#ifdef WIN32
+	return 0;
+#else
+	struct timespec ts;
+	::clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+#endif
+}
+
 /*****************************************************************************
 ** Socket Utilities
 *****************************************************************************/
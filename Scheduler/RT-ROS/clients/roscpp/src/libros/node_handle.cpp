@@ -322,6 +322,10 @@ Subscriber NodeHandle::subscribe(SubscribeOptions& ops)
     {
       ops.callback_queue = callback_queue_;
     }
+    else if (CallbackQueue* sched_queue = getSchedCallbackQueue(ops.topic))
+    {
+      ops.callback_queue = sched_queue;
+    }
     else
     {
       ops.callback_queue = getGlobalCallbackQueue();
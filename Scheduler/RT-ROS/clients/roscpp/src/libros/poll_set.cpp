@@ -42,23 +42,49 @@
 #include <boost/bind.hpp>
 
 #include <fcntl.h>
+#include <cstdlib>
+#include <algorithm>
 
 namespace ros
 {
 
+/// The number of ready sockets handled by a single epoll wait
+static const size_t EPOLL_MAX_EVENTS = 64;
+
+static bool lessFD(const socket_pollfd& a, const socket_pollfd& b)
+{
+  return a.fd < b.fd;
+}
+
 PollSet::PollSet()
 : sockets_changed_(false)
+, epfd_(-1)
 {
 	if ( create_signal_pair(signal_pipe_) != 0 ) {
         ROS_FATAL("create_signal_pair() failed");
     ROS_BREAK();
   }
+
+  if (!getenv("ROSCPP_USE_POLL"))
+  {
+    epfd_ = create_socket_watcher();
+    if (epfd_ < 0)
+    {
+      ROSCPP_LOG_DEBUG("PollSet: epoll is not available, falling back to poll()");
+    }
+    else
+    {
+      ufds_.resize(EPOLL_MAX_EVENTS);
+    }
+  }
+
   addSocket(signal_pipe_[0], boost::bind(&PollSet::onLocalPipeEvents, this, _1));
   addEvents(signal_pipe_[0], POLLIN);
 }
 
 PollSet::~PollSet()
 {
+  close_socket_watcher(epfd_);
   close_signal_pair(signal_pipe_);
 }
 
@@ -80,6 +106,19 @@ bool PollSet::addSocket(int fd, const SocketUpdateFunc& update_func, const Trans
       return false;
     }
 
+    if (epfd_ >= 0)
+    {
+      // registered without events, so that only errors are reported until addEvents()
+      if (add_socket_to_watcher(epfd_, fd, 0) != 0)
+      {
+        ROS_ERROR("PollSet: Failed to add fd [%d] to epoll: %s", fd, last_socket_error_string());
+        socket_info_.erase(fd);
+        return false;
+      }
+
+      return true;
+    }
+
     sockets_changed_ = true;
   }
 
@@ -106,6 +145,17 @@ bool PollSet::delSocket(int fd)
       just_deleted_.push_back(fd);
     }
 
+    if (epfd_ >= 0)
+    {
+      // fails harmlessly if the socket has already been closed, which removes it from epoll
+      if (del_socket_from_watcher(epfd_, fd) != 0)
+      {
+        ROSCPP_LOG_DEBUG("PollSet: Failed to delete fd [%d] from epoll: %s", fd, last_socket_error_string());
+      }
+
+      return true;
+    }
+
     sockets_changed_ = true;
     signal();
 
@@ -132,6 +182,18 @@ bool PollSet::addEvents(int sock, int events)
 
   it->second.events_ |= events;
 
+  if (epfd_ >= 0)
+  {
+    if (set_events_on_socket(epfd_, sock, it->second.events_) != 0)
+    {
+      ROS_ERROR("PollSet: Failed to set events [%d] on fd [%d]: %s", it->second.events_, sock, last_socket_error_string());
+      return false;
+    }
+
+    return true;
+  }
+
+  sockets_changed_ = true;
   signal();
 
   return true;
@@ -152,6 +214,18 @@ bool PollSet::delEvents(int sock, int events)
     return false;
   }
 
+  if (epfd_ >= 0)
+  {
+    if (set_events_on_socket(epfd_, sock, it->second.events_) != 0)
+    {
+      ROS_ERROR("PollSet: Failed to set events [%d] on fd [%d]: %s", it->second.events_, sock, last_socket_error_string());
+      return false;
+    }
+
+    return true;
+  }
+
+  sockets_changed_ = true;
   signal();
 
   return true;
@@ -174,6 +248,24 @@ void PollSet::signal()
 
 void PollSet::update(int poll_timeout)
 {
+  if (epfd_ >= 0)
+  {
+    // Only the sockets which are ready come back, whatever the number being serviced
+    int ret = wait_socket_watcher(epfd_, &ufds_.front(), ufds_.size(), poll_timeout);
+    if (ret < 0)
+    {
+      ROS_ERROR_STREAM("epoll_wait failed with error " << last_socket_error_string());
+    }
+    else if (ret > 0)  // ret = 0 implies the wait timed out, nothing to do
+    {
+      // Keep the order of the poll() fallback, which services sockets by fd
+      std::sort(ufds_.begin(), ufds_.begin() + ret, lessFD);
+      dispatch(ret);
+    }
+
+    return;
+  }
+
   createNativePollset();
 
   // Poll across the sockets we're servicing
@@ -185,70 +277,75 @@ void PollSet::update(int poll_timeout)
     }
   else if (ret > 0)  // ret = 0 implies the poll timed out, nothing to do
   {
-    // We have one or more sockets to service
-    for(size_t i=0; i<ufds_count; i++)
+    dispatch(ufds_count);
+  }
+}
+
+void PollSet::dispatch(size_t count)
+{
+  // We have one or more sockets to service
+  for(size_t i=0; i<count; i++)
+  {
+    if (ufds_[i].revents == 0)
     {
-      if (ufds_[i].revents == 0)
+      continue;
+    }
+
+    SocketUpdateFunc func;
+    TransportPtr transport;
+    int events = 0;
+    {
+      boost::mutex::scoped_lock lock(socket_info_mutex_);
+      M_SocketInfo::iterator it = socket_info_.find(ufds_[i].fd);
+      // the socket has been entirely deleted
+      if (it == socket_info_.end())
       {
         continue;
       }
 
-      SocketUpdateFunc func;
-      TransportPtr transport;
-      int events = 0;
-      {
-        boost::mutex::scoped_lock lock(socket_info_mutex_);
-        M_SocketInfo::iterator it = socket_info_.find(ufds_[i].fd);
-        // the socket has been entirely deleted
-        if (it == socket_info_.end())
-        {
-          continue;
-        }
-
-        const SocketInfo& info = it->second;
+      const SocketInfo& info = it->second;
 
-        // Store off the function and transport in case the socket is deleted from another thread
-        func = info.func_;
-        transport = info.transport_;
-        events = info.events_;
-      }
+      // Store off the function and transport in case the socket is deleted from another thread
+      func = info.func_;
+      transport = info.transport_;
+      events = info.events_;
+    }
 
-      // If these are registered events for this socket, OR the events are ERR/HUP/NVAL,
-      // call through to the registered function
-      int revents = ufds_[i].revents;
-      if (func
-          && ((events & revents)
-              || (revents & POLLERR)
-              || (revents & POLLHUP)
-              || (revents & POLLNVAL)))
+    // If these are registered events for this socket, OR the events are ERR/HUP/NVAL,
+    // call through to the registered function
+    int revents = ufds_[i].revents;
+    if (func
+        && ((events & revents)
+            || (revents & POLLERR)
+            || (revents & POLLHUP)
+            || (revents & POLLNVAL)))
+    {
+      bool skip = false;
+      if (revents & (POLLNVAL|POLLERR|POLLHUP))
       {
-        bool skip = false;
-        if (revents & (POLLNVAL|POLLERR|POLLHUP))
-        {
-          // If a socket was just closed and then the file descriptor immediately reused, we can
-          // get in here with what we think is a valid socket (since it was just re-added to our set)
-          // but which is actually referring to the previous fd with the same #.  If this is the case,
-          // we ignore the first instance of one of these errors.  If it's a real error we'll
-          // hit it again next time through.
-          boost::mutex::scoped_lock lock(just_deleted_mutex_);
-          if (std::find(just_deleted_.begin(), just_deleted_.end(), ufds_[i].fd) != just_deleted_.end())
-          {
-            skip = true;
-          }
-        }
-
-        if (!skip)
+        // If a socket was just closed and then the file descriptor immediately reused, we can
+        // get in here with what we think is a valid socket (since it was just re-added to our set)
+        // but which is actually referring to the previous fd with the same #.  If this is the case,
+        // we ignore the first instance of one of these errors.  If it's a real error we'll
+        // hit it again next time through.
+        boost::mutex::scoped_lock lock(just_deleted_mutex_);
+        if (std::find(just_deleted_.begin(), just_deleted_.end(), ufds_[i].fd) != just_deleted_.end())
         {
-          func(revents & (events|POLLERR|POLLHUP|POLLNVAL));
+          skip = true;
         }
       }
 
-      ufds_[i].revents = 0;
+      if (!skip)
+      {
+        func(revents & (events|POLLERR|POLLHUP|POLLNVAL));
+      }
     }
 
-    boost::mutex::scoped_lock lock(just_deleted_mutex_);
-    just_deleted_.clear();
+    ufds_[i].revents = 0;
   }
+
+  boost::mutex::scoped_lock lock(just_deleted_mutex_);
+  just_deleted_.clear();
 }
 
 void PollSet::createNativePollset()
@@ -272,6 +369,8 @@ void PollSet::createNativePollset()
     pfd.events = info.events_;
     pfd.revents = 0;
   }
+
+  sockets_changed_ = false;
 }
 
 void PollSet::onLocalPipeEvents(int events)
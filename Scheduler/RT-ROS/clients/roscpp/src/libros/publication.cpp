@@ -28,6 +28,8 @@
 #include "ros/publication.h"
 #include "ros/subscriber_link.h"
 #include "ros/connection.h"
+#include "ros/shm_subscriber_link.h"
+#include "ros/transport/transport_shm.h"
 #include "ros/callback_queue_interface.h"
 #include "ros/single_subscriber_publisher.h"
 #include "ros/serialization.h"
@@ -89,7 +91,9 @@ Publication::Publication(const std::string &name,
   dropped_(false),
   latch_(latch),
   has_header_(has_header),
-  intraprocess_subscriber_count_(0)
+  intraprocess_subscriber_count_(0),
+  shm_subscriber_count_(0),
+  largest_message_(0)
 {
 }
 
@@ -152,6 +156,10 @@ void Publication::drop()
   }
 
   dropAllConnections();
+
+  boost::mutex::scoped_lock lock(subscriber_links_mutex_);
+  shm_.reset();
+  shm_subscriber_count_ = 0;
 }
 
 bool Publication::enqueueMessage(const SerializedMessage& m)
@@ -178,6 +186,24 @@ bool Publication::enqueueMessage(const SerializedMessage& m)
     ser::serialize(ostream, header);
   }
 
+  // written once for all the subscribers on this host
+  if (shm_ && shm_subscriber_count_ > 0)
+  {
+    if (m.num_bytes > shm_->getSlotSize())
+    {
+      // its subscribers reconnect over TCPROS, and the next segment is made large enough
+      ROS_WARN_THROTTLE(10.0, "Message of %u bytes on topic [%s] does not fit in shared memory slots of %u bytes, "
+                        "moving its shared memory subscribers to TCPROS", (uint32_t)m.num_bytes, name_.c_str(), shm_->getSlotSize());
+      shm_->abandon();
+      shm_.reset();
+    }
+    else
+    {
+      shm_->write(m);
+    }
+  }
+  largest_message_ = std::max<uint32_t>(largest_message_, m.num_bytes);
+
   for(V_SubscriberLink::iterator i = subscriber_links_.begin();
       i != subscriber_links_.end(); ++i)
   {
@@ -228,6 +254,11 @@ void Publication::addSubscriberLink(const SubscriberLinkPtr& sub_link)
     {
       ++intraprocess_subscriber_count_;
     }
+
+    if (sub_link->isSHM())
+    {
+      ++shm_subscriber_count_;
+    }
   }
 
   if (latch_ && last_message_.buf)
@@ -257,6 +288,11 @@ void Publication::removeSubscriberLink(const SubscriberLinkPtr& sub_link)
       --intraprocess_subscriber_count_;
     }
 
+    if (sub_link->isSHM())
+    {
+      --shm_subscriber_count_;
+    }
+
     V_SubscriberLink::iterator it = std::find(subscriber_links_.begin(), subscriber_links_.end(), sub_link);
     if (it != subscriber_links_.end())
     {
@@ -447,6 +483,8 @@ void Publication::publish(SerializedMessage& m)
 
 void Publication::processPublishQueue()
 {
+  dropDeadSHMLinks();
+
   V_SerializedMessage queue;
   {
     boost::mutex::scoped_lock lock(publish_queue_mutex_);
@@ -473,6 +511,73 @@ void Publication::processPublishQueue()
   }
 }
 
+TransportSHMPtr Publication::getSHMTransport(uint32_t slot_size)
+{
+  boost::mutex::scoped_lock lock(subscriber_links_mutex_);
+
+  if (dropped_)
+  {
+    return TransportSHMPtr();
+  }
+
+  // slots must hold the largest message published so far
+  slot_size = std::max(slot_size, largest_message_);
+  if (shm_ && shm_->getSlotSize() < slot_size && shm_subscriber_count_ == 0)
+  {
+    // a subscriber may still be attaching to it, which then reconnects over TCPROS
+    shm_->abandon();
+    shm_.reset();
+  }
+
+  if (!shm_)
+  {
+    TransportSHMPtr shm(new TransportSHM);
+    if (!shm->create(ROS_SHM_SLOT_COUNT, std::max<uint32_t>(slot_size, ROS_SHM_SLOT_SIZE)))
+    {
+      return TransportSHMPtr();
+    }
+
+    shm_ = shm;
+  }
+
+  if (shm_->getSlotSize() < slot_size)
+  {
+    return TransportSHMPtr();
+  }
+
+  return shm_;
+}
+
+void Publication::dropDeadSHMLinks()
+{
+  // 32-bit loads are atomic; a link added meanwhile is checked the next time
+  if (shm_subscriber_count_ == 0)
+  {
+    return;
+  }
+
+  V_SubscriberLink dead_links;
+  {
+    boost::mutex::scoped_lock lock(subscriber_links_mutex_);
+
+    for (V_SubscriberLink::iterator i = subscriber_links_.begin();
+         i != subscriber_links_.end(); ++i)
+    {
+      if ((*i)->isSHM() && !boost::static_pointer_cast<SHMSubscriberLink>(*i)->isAlive())
+      {
+        dead_links.push_back(*i);
+      }
+    }
+  }
+
+  // drop() removes the link, and so has to be called without the lock
+  for (V_SubscriberLink::iterator i = dead_links.begin();
+       i != dead_links.end(); ++i)
+  {
+    (*i)->drop();
+  }
+}
+
 bool Publication::validateHeader(const Header& header, std::string& error_msg)
 {
   std::string md5sum, topic, client_callerid;
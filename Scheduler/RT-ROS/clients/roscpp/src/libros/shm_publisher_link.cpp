@@ -0,0 +1,170 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2016, Yukihiro Saito.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "ros/shm_publisher_link.h"
+#include "ros/subscription.h"
+#include "ros/transport/transport_shm.h"
+#include "ros/connection_manager.h"
+#include "ros/file_log.h"
+
+#include <boost/bind.hpp>
+
+#include <sstream>
+
+namespace ros
+{
+
+SHMPublisherLink::SHMPublisherLink(const SubscriptionPtr& parent, const std::string& xmlrpc_uri, const TransportHints& transport_hints)
+: PublisherLink(parent, xmlrpc_uri, transport_hints)
+, dropping_(false)
+, dropped_(false)
+{
+}
+
+SHMPublisherLink::~SHMPublisherLink()
+{
+}
+
+bool SHMPublisherLink::initialize(const TransportSHMPtr& transport, int reader, uint32_t generation)
+{
+  if (!transport->attach(reader, generation))
+  {
+    return false;
+  }
+
+  transport_ = transport;
+  connection_id_ = ConnectionManager::instance()->getNewConnectionID();
+  receive_thread_ = boost::thread(boost::bind(&SHMPublisherLink::receiveThread, this));
+
+  return true;
+}
+
+void SHMPublisherLink::receiveThread()
+{
+  // keep ourselves alive until we are done, even once dropped by the subscription
+  PublisherLinkPtr self = shared_from_this();
+
+  while (!dropping_)
+  {
+    SerializedMessage m;
+    while (!dropping_ && transport_->read(m))
+    {
+      handleMessage(m, true, false);
+    }
+
+    if (dropping_ || !transport_->isWriterAlive())
+    {
+      break;
+    }
+
+    transport_->wait(WallDuration(0.1));
+  }
+
+  if (!dropping_)
+  {
+    ROSCPP_LOG_DEBUG("Shared memory publisher [%s] went away", getCallerID().c_str());
+    drop();
+
+    // its messages outgrew the segment
+    SubscriptionPtr parent = parent_.lock();
+    if (parent && transport_->isAbandoned())
+    {
+      ROSCPP_LOG_DEBUG("Shared memory segment [%s] abandoned by [%s], falling back to TCPROS", transport_->getName().c_str(), getCallerID().c_str());
+      parent->negotiateConnection(getPublisherXMLRPCURI(), false);
+    }
+  }
+}
+
+void SHMPublisherLink::drop()
+{
+  {
+    boost::mutex::scoped_lock lock(drop_mutex_);
+    if (dropped_)
+    {
+      return;
+    }
+
+    dropped_ = true;
+  }
+
+  dropping_ = true;
+  if (transport_)
+  {
+    if (receive_thread_.get_id() == boost::this_thread::get_id())
+    {
+      receive_thread_.detach();
+    }
+    else
+    {
+      transport_->wake();
+      receive_thread_.join();
+    }
+
+    transport_->detach();
+  }
+
+  if (SubscriptionPtr parent = parent_.lock())
+  {
+    ROSCPP_LOG_DEBUG("Connection to shared memory publisher on topic [%s] dropped", parent->getName().c_str());
+
+    parent->removePublisherLink(shared_from_this());
+  }
+}
+
+void SHMPublisherLink::handleMessage(const SerializedMessage& m, bool ser, bool nocopy)
+{
+  stats_.bytes_received_ += m.num_bytes;
+  stats_.messages_received_++;
+
+  SubscriptionPtr parent = parent_.lock();
+
+  if (parent)
+  {
+    stats_.drops_ += parent->handleMessage(m, ser, nocopy, header_.getValues(), shared_from_this());
+  }
+}
+
+std::string SHMPublisherLink::getTransportType()
+{
+  return std::string("SHMROS");
+}
+
+std::string SHMPublisherLink::getTransportInfo()
+{
+  std::stringstream ss;
+  ss << "SHMROS segment [" << (transport_ ? transport_->getName() : std::string()) << "]";
+  return ss.str();
+}
+
+} // namespace ros
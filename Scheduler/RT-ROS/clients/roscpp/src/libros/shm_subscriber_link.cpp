@@ -0,0 +1,115 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2016, Yukihiro Saito.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "ros/shm_subscriber_link.h"
+#include "ros/publication.h"
+#include "ros/transport/transport_shm.h"
+#include "ros/connection_manager.h"
+#include "ros/file_log.h"
+
+#include <sstream>
+
+namespace ros
+{
+
+SHMSubscriberLink::SHMSubscriberLink(const PublicationPtr& parent)
+: reader_(-1)
+, dropped_(false)
+{
+  ROS_ASSERT(parent);
+  parent_ = parent;
+  topic_ = parent->getName();
+}
+
+SHMSubscriberLink::~SHMSubscriberLink()
+{
+}
+
+void SHMSubscriberLink::initialize(const TransportSHMPtr& transport, int reader, const std::string& caller_id)
+{
+  transport_ = transport;
+  reader_ = reader;
+  connection_id_ = ConnectionManager::instance()->getNewConnectionID();
+  destination_caller_id_ = caller_id;
+}
+
+bool SHMSubscriberLink::isAlive()
+{
+  boost::mutex::scoped_lock lock(drop_mutex_);
+  return !dropped_ && transport_->isReaderAlive(reader_);
+}
+
+void SHMSubscriberLink::enqueueMessage(const SerializedMessage& m, bool ser, bool nocopy)
+{
+  // already written into the segment by the publication
+  stats_.messages_sent_++;
+  stats_.bytes_sent_ += m.num_bytes;
+  stats_.message_data_sent_ += m.num_bytes;
+}
+
+std::string SHMSubscriberLink::getTransportType()
+{
+  return std::string("SHMROS");
+}
+
+std::string SHMSubscriberLink::getTransportInfo()
+{
+  std::stringstream ss;
+  ss << "SHMROS segment [" << transport_->getName() << "] reader [" << reader_ << "] drops [" << transport_->getDrops() << "]";
+  return ss.str();
+}
+
+void SHMSubscriberLink::drop()
+{
+  {
+    boost::mutex::scoped_lock lock(drop_mutex_);
+    if (dropped_)
+    {
+      return;
+    }
+
+    dropped_ = true;
+  }
+
+  transport_->releaseReader(reader_);
+
+  if (PublicationPtr parent = parent_.lock())
+  {
+    ROSCPP_LOG_DEBUG("Connection to shared memory subscriber [%s] on topic [%s] dropped", destination_caller_id_.c_str(), topic_.c_str());
+
+    parent->removeSubscriberLink(shared_from_this());
+  }
+}
+
+} // namespace ros
@@ -29,11 +29,36 @@
 #include "ros/ros.h"
 #include "ros/callback_queue.h"
 
+#include "ros_rosch/publish_counter.h"
+#include "ros_rosch/task_attribute_processer.h"
+
 #include <boost/thread/thread.hpp>
 #include <boost/thread/recursive_mutex.hpp>
+#include <boost/thread/once.hpp>
+
+#include <algorithm>
+#include <vector>
 
 namespace {
   boost::recursive_mutex spinmutex;
+
+  // queues of the spinner threads which have topics, by thread index
+  std::vector<ros::CallbackQueuePtr> g_sched_queues;
+  std::vector<ThreadInfo> g_thread_info;
+  boost::once_flag g_sched_queues_once = BOOST_ONCE_INIT;
+
+  void initSchedQueues()
+  {
+    g_thread_info = rosch::SingletonSchedNodeManager::getInstance().getNodeInfo().v_thread_info;
+    g_sched_queues.resize(g_thread_info.size());
+    for (size_t i = 0; i < g_thread_info.size(); ++i)
+    {
+      if (!g_thread_info[i].v_topic.empty())
+      {
+        g_sched_queues[i].reset(new ros::CallbackQueue);
+      }
+    }
+  }
 }
 
 namespace ros
@@ -63,6 +88,111 @@ void SingleThreadedSpinner::spin(CallbackQueue* queue)
   }
 }
 
+bool SchedSpinner::isConfigured()
+{
+  boost::call_once(&initSchedQueues, g_sched_queues_once);
+  return !g_thread_info.empty();
+}
+
+CallbackQueue* getSchedCallbackQueue(const std::string& topic)
+{
+  boost::call_once(&initSchedQueues, g_sched_queues_once);
+  for (size_t i = 0; i < g_thread_info.size(); ++i)
+  {
+    const std::vector<std::string>& topics = g_thread_info[i].v_topic;
+    if (std::find(topics.begin(), topics.end(), topic) != topics.end())
+    {
+      return g_sched_queues[i].get();
+    }
+  }
+
+  return 0;
+}
+
+void spinOnceSched()
+{
+  boost::call_once(&initSchedQueues, g_sched_queues_once);
+  for (size_t i = 0; i < g_sched_queues.size(); ++i)
+  {
+    if (g_sched_queues[i])
+    {
+      g_sched_queues[i]->callAvailable(ros::WallDuration());
+    }
+  }
+}
+
+namespace
+{
+void schedThreadFunc(const ThreadInfo& thread_info, CallbackQueue* queue, bool use_call_available)
+{
+  disableAllSignalsInThisThread();
+
+  rosch::TaskAttributeProcesser task_attr_proc;
+  task_attr_proc.setThreadAttribute(thread_info);
+
+  WallDuration timeout(0.1);
+  ros::NodeHandle n;
+  while (n.ok())
+  {
+    if (use_call_available)
+    {
+      queue->callAvailable(timeout);
+    }
+    else
+    {
+      queue->callOne(timeout);
+    }
+  }
+}
+}
+
+void SchedSpinner::spin(CallbackQueue* queue)
+{
+  boost::recursive_mutex::scoped_try_lock spinlock(spinmutex);
+  if (!spinlock.owns_lock()) {
+    ROS_ERROR("SchedSpinner: You've attempted to call ros::spin "
+              "from multiple threads... "
+              "but this spinner is already multithreaded.");
+    return;
+  }
+
+  if (!queue)
+  {
+    queue = getGlobalCallbackQueue();
+  }
+
+  boost::call_once(&initSchedQueues, g_sched_queues_once);
+
+  if (g_thread_info.empty())
+  {
+    ROS_WARN("SchedSpinner: No spinner_threads for this node, spinning in this thread.");
+    ros::NodeHandle n;
+    while (n.ok())
+    {
+      queue->callAvailable(ros::WallDuration(0.1));
+    }
+    return;
+  }
+
+  std::vector<CallbackQueue*> queues;
+  for (size_t i = 0; i < g_thread_info.size(); ++i)
+  {
+    queues.push_back(g_sched_queues[i] ? g_sched_queues[i].get() : queue);
+  }
+
+  boost::thread_group threads;
+  for (size_t i = 0; i < queues.size(); ++i)
+  {
+    // threads sharing a queue take one callback at a time
+    bool use_call_available = std::count(queues.begin(), queues.end(), queues[i]) == 1;
+    threads.create_thread(boost::bind(schedThreadFunc, boost::cref(g_thread_info[i]), queues[i],
+                                      use_call_available));
+  }
+
+  ros::waitForShutdown();
+  threads.join_all();
+}
+
 MultiThreadedSpinner::MultiThreadedSpinner(uint32_t thread_count)
 : thread_count_(thread_count)
 {
@@ -30,32 +30,102 @@
 #include <rosgraph_msgs/TopicStatistics.h>
 #include "ros/this_node.h"
 #include "ros/message_traits.h"
-#include "std_msgs/Header.h"
 #include "ros/param.h"
+#include "ros/init.h"
+#include "ros/callback_queue.h"
+
+#include <boost/thread/thread.hpp>
+
+#include <algorithm>
+#include <sstream>
 
 namespace ros
 {
 
 StatisticsLogger::StatisticsLogger()
-: pub_frequency_(1.0)
+: enable_statistics(false)
+, sample_interval_(1)
+, hasHeader_(false)
+, pub_frequency_(1.0)
+{
+  for (int i = 0; i < MAX_CONNECTIONS; ++i)
+  {
+    connections_[i].state = 0;
+    connections_[i].busy = 0;
+  }
+}
+
+StatisticsLogger::~StatisticsLogger()
 {
+  // waits for a publish() in progress
+  timer_.stop();
 }
 
 void StatisticsLogger::init(const SubscriptionCallbackHelperPtr& helper) {
   hasHeader_ = helper->hasHeader();
   param::param("/enable_statistics", enable_statistics, false);
   param::param("/statistics_window_min_elements", min_elements, 10);
-  param::param("/statistics_window_max_elements", min_elements, 100);
+  param::param("/statistics_window_max_elements", max_elements, 100);
   param::param("/statistics_window_min_size", min_window, 4);
   param::param("/statistics_window_max_size", max_window, 64);
+  param::param("/statistics_sample_interval", sample_interval_, 1);
+  sample_interval_ = std::max(sample_interval_, 1);
+
+  if (enable_statistics && !timer_)
+  {
+    // windows are ended away from the threads receiving messages
+    ros::NodeHandle n("~");
+    n.setCallbackQueue(getInternalCallbackQueue().get());
+    timer_ = n.createTimer(ros::Duration(pub_frequency_), &StatisticsLogger::publish, this);
+  }
+}
+
+StatisticsLogger::StatData* StatisticsLogger::getStatData(const std::string& topic, const std::string& callerid)
+{
+  // callerid identifies the connection
+  for (int i = 0; i < MAX_CONNECTIONS; ++i)
+  {
+    StatData& stats = connections_[i];
+
+    if (stats.state == 0 && __sync_bool_compare_and_swap(&stats.state, 0, 1))
+    {
+      // this is the first time, we received something on this connection
+      stats.topic = topic;
+      stats.callerid = callerid;
+      stats.window_start = ros::Time::now();
+      stats.delivered_msgs = 0;
+      stats.dropped_msgs = 0;
+      stats.stat_bytes = 0;
+      stats.stat_bytes_last = 0;
+      stats.last_arrival = 0;
+      stats.period.reset();
+      stats.age.reset();
+      __sync_synchronize();
+      stats.state = 2;
+      return &stats;
+    }
+
+    // another thread sets it up, maybe for this connection
+    while (stats.state == 1)
+    {
+      boost::this_thread::yield();
+    }
+    __sync_synchronize();
+
+    if (stats.callerid == callerid)
+    {
+      return &stats;
+    }
+  }
+
+  ROS_DEBUG("Too many publishers on topic [%s] to log statistics for [%s]", topic.c_str(), callerid.c_str());
+  return NULL;
 }
 
 void StatisticsLogger::callback(const boost::shared_ptr<M_string>& connection_header,
                                 const std::string& topic, const std::string& callerid, const SerializedMessage& m, const uint64_t& bytes_sent,
                                 const ros::Time& received_time, bool dropped)
 {
-  struct StatData stats;
-
   if (!enable_statistics)
   {
     return;
@@ -67,39 +137,54 @@ void StatisticsLogger::callback(const boost::shared_ptr<M_string>& connection_he
     return;
   }
 
-  // callerid identifies the connection
-  std::map<std::string, struct StatData>::iterator stats_it = map_.find(callerid);
-  if (stats_it == map_.end())
+  StatData* stats = getStatData(topic, callerid);
+  if (!stats)
   {
-    // this is the first time, we received something on this connection
-    stats.stat_bytes_last = 0;
-    stats.dropped_msgs = 0;
-    stats.last_seq = 0;
-    stats.last_publish = ros::Time::now();
-    map_[callerid] = stats;
+    return;
   }
-  else
+
+  uint64_t delivered = __sync_add_and_fetch(&stats->delivered_msgs, 1);
+
+  if (dropped)
   {
-    stats = map_[callerid];
+    __sync_fetch_and_add(&stats->dropped_msgs, 1);
   }
 
-  stats.arrival_time_list.push_back(received_time);
+  stats->stat_bytes = bytes_sent;
 
-  if (dropped)
+  int64_t arrival = received_time.toNSec();
+  int64_t previous = __sync_lock_test_and_set(&stats->last_arrival, arrival);
+
+  // only time one message in sample_interval_
+  if (delivered % sample_interval_ != 0)
+  {
+    return;
+  }
+
+  // the window is being ended, this message is only counted
+  if (!__sync_bool_compare_and_swap(&stats->busy, 0, 1))
+  {
+    return;
+  }
+
+  if (previous != 0)
   {
-    stats.dropped_msgs++;
+    stats->period.add((arrival - previous) * 1e-9);
   }
 
-  // try to extract header, if the message has one. this fails sometimes,
+  // try to extract the stamp, if the message has a header. this fails sometimes,
   // therefore the try-catch
   if (hasHeader_)
   {
     try
     {
-      std_msgs::Header header;
+      // the stamp follows the sequence number, the frame id is left alone
+      uint32_t seq;
+      ros::Time stamp;
       ros::serialization::IStream stream(m.message_start, m.num_bytes - (m.message_start - m.buf.get()));
-      ros::serialization::deserialize(stream, header);
-      stats.age_list.push_back(received_time - header.stamp);
+      stream.next(seq);
+      stream.next(stamp);
+      stats->age.add((received_time - stamp).toSec());
     }
     catch (ros::serialization::StreamOverrunException& e)
     {
@@ -108,107 +193,85 @@ void StatisticsLogger::callback(const boost::shared_ptr<M_string>& connection_he
     }
   }
 
-  // should publish new statistics?
-  if (stats.last_publish + ros::Duration(pub_frequency_) < received_time)
+  __sync_lock_release(&stats->busy);
+}
+
+static std::string histogramString(const StatisticsMoments& moments)
+{
+  std::stringstream ss;
+  for (int i = 0; i < StatisticsMoments::HISTOGRAM_SIZE; ++i)
   {
-    ros::Time window_start = stats.last_publish;
-    stats.last_publish = received_time;
+    ss << (i ? " " : "") << moments.histogram[i];
+  }
 
-    // fill the message with the aggregated data
-    rosgraph_msgs::TopicStatistics msg;
-    msg.topic = topic;
-    msg.node_pub = callerid;
-    msg.node_sub = ros::this_node::getName();
-    msg.window_start = window_start;
-    msg.window_stop = received_time;
-    msg.delivered_msgs = stats.arrival_time_list.size();
-    msg.dropped_msgs = stats.dropped_msgs;
-    msg.traffic = bytes_sent - stats.stat_bytes_last;
+  return ss.str();
+}
 
-    // not all message types have this
-    if (stats.age_list.size() > 0)
-    {
-      msg.stamp_age_mean = ros::Duration(0);
-      msg.stamp_age_max = ros::Duration(0);
-
-      for(std::list<ros::Duration>::iterator it = stats.age_list.begin(); it != stats.age_list.end(); it++)
-      {
-        ros::Duration age = *it;
-        msg.stamp_age_mean += age;
-
-        if (age > msg.stamp_age_max)
-        {
-            msg.stamp_age_max = age;
-        }
-      }
-
-      msg.stamp_age_mean *= 1.0 / stats.age_list.size();
-
-      msg.stamp_age_stddev = ros::Duration(0);
-      for(std::list<ros::Duration>::iterator it = stats.age_list.begin(); it != stats.age_list.end(); it++)
-      {
-        ros::Duration t = msg.stamp_age_mean - *it;
-        msg.stamp_age_stddev += ros::Duration(t.toSec() * t.toSec());
-      }
-      msg.stamp_age_stddev = ros::Duration(sqrt(msg.stamp_age_stddev.toSec() / stats.age_list.size()));
+void StatisticsLogger::publish(const ros::TimerEvent& event)
+{
+  ros::Time window_stop = ros::Time::now();
+  uint64_t max_delivered = 0;
 
-    }
-    else
+  for (int i = 0; i < MAX_CONNECTIONS; ++i)
+  {
+    StatData& stats = connections_[i];
+    if (stats.state != 2)
     {
-      // in that case, set to NaN
-      msg.stamp_age_mean = ros::Duration(0);
-      msg.stamp_age_stddev = ros::Duration(0);
-      msg.stamp_age_max = ros::Duration(0);
+      continue;
     }
+    __sync_synchronize();
 
-    // first, calculate the mean period between messages in this connection
-    // we need at least two messages in the window for this.
-    if (stats.arrival_time_list.size() > 1)
+    // take the aggregates of the window, and start the next one
+    while (!__sync_bool_compare_and_swap(&stats.busy, 0, 1))
     {
-      msg.period_mean = ros::Duration(0);
-      msg.period_max = ros::Duration(0);
-
-      ros::Time prev;
-      for(std::list<ros::Time>::iterator it = stats.arrival_time_list.begin(); it != stats.arrival_time_list.end(); it++) {
-
-        if (it == stats.arrival_time_list.begin()) {
-          prev = *it;
-          continue;
-        }
-
-        ros::Duration period = *it - prev;
-        msg.period_mean += period;
-        if (period > msg.period_max)
-            msg.period_max = period;
-        prev = *it;
-      }
-      msg.period_mean *= 1.0 / (stats.arrival_time_list.size() - 1);
-
-      // then, calc the stddev
-      msg.period_stddev = ros::Duration(0);
-      for(std::list<ros::Time>::iterator it = stats.arrival_time_list.begin(); it != stats.arrival_time_list.end(); it++)
-      {
-        if (it == stats.arrival_time_list.begin())
-        {
-          prev = *it;
-          continue;
-        }
-        ros::Duration period = *it - prev;
-        ros::Duration t = msg.period_mean - period;
-        msg.period_stddev += ros::Duration(t.toSec() * t.toSec());
-        prev = *it;
-      }
-      msg.period_stddev = ros::Duration(sqrt(msg.period_stddev.toSec() / (stats.arrival_time_list.size() - 1)));
-
+      boost::this_thread::yield();
     }
-    else
+    StatisticsMoments period = stats.period;
+    StatisticsMoments age = stats.age;
+    stats.period.reset();
+    stats.age.reset();
+    __sync_lock_release(&stats.busy);
+
+    uint64_t delivered = __sync_fetch_and_and(&stats.delivered_msgs, 0);
+    uint64_t dropped = __sync_fetch_and_and(&stats.dropped_msgs, 0);
+    uint64_t bytes = stats.stat_bytes;
+
+    ros::Time window_start = stats.window_start;
+    stats.window_start = window_stop;
+    uint64_t traffic = bytes - stats.stat_bytes_last;
+    stats.stat_bytes_last = bytes;
+
+    // nothing came from this publisher
+    if (delivered == 0 && dropped == 0)
     {
-      // in that case, set to NaN
-      msg.period_mean = ros::Duration(0);
-      msg.period_stddev = ros::Duration(0);
-      msg.period_max = ros::Duration(0);
+      continue;
     }
 
+    max_delivered = std::max(max_delivered, delivered);
+
+    // fill the message with the aggregated data
+    rosgraph_msgs::TopicStatistics msg;
+    msg.topic = stats.topic;
+    msg.node_pub = stats.callerid;
+    msg.node_sub = ros::this_node::getName();
+    msg.window_start = window_start;
+    msg.window_stop = window_stop;
+    msg.delivered_msgs = delivered;
+    msg.dropped_msgs = dropped;
+    msg.traffic = traffic;
+
+    // all zero if the message type has no header
+    msg.stamp_age_mean = ros::Duration(age.mean);
+    msg.stamp_age_stddev = ros::Duration(age.stddev());
+    msg.stamp_age_max = ros::Duration(age.max);
+
+    // all zero without two messages in a row
+    msg.period_mean = ros::Duration(period.mean);
+    msg.period_stddev = ros::Duration(period.stddev());
+    msg.period_max = ros::Duration(period.max);
+
+    ROS_DEBUG("Statistics of [%s] from [%s]: stamp age histogram [%s], period histogram [%s]", stats.topic.c_str(), stats.callerid.c_str(), histogramString(age).c_str(), histogramString(period).c_str());
+
     if (!pub_.getTopic().length())
     {
       ros::NodeHandle n("~");
@@ -217,26 +280,28 @@ void StatisticsLogger::callback(const boost::shared_ptr<M_string>& connection_he
     }
 
     pub_.publish(msg);
+  }
 
-    // dynamic window resizing
-    if (stats.arrival_time_list.size() > max_elements && pub_frequency_ * 2 <= max_window)
-    {
-      pub_frequency_ *= 2;
-    }
-    if (stats.arrival_time_list.size() < min_elements && pub_frequency_ / 2 >= min_window)
-    {
-      pub_frequency_ /= 2;
-    }
+  if (max_delivered == 0)
+  {
+    return;
+  }
 
-    // clear the window
-    stats.age_list.clear();
-    stats.arrival_time_list.clear();
-    stats.dropped_msgs = 0;
-    stats.stat_bytes_last = bytes_sent;
+  // dynamic window resizing
+  double pub_frequency = pub_frequency_;
+  if (max_delivered > (uint64_t)max_elements && pub_frequency_ * 2 <= max_window)
+  {
+    pub_frequency_ *= 2;
+  }
+  if (max_delivered < (uint64_t)min_elements && pub_frequency_ / 2 >= min_window)
+  {
+    pub_frequency_ /= 2;
+  }
 
+  if (pub_frequency_ != pub_frequency)
+  {
+    timer_.setPeriod(ros::Duration(pub_frequency_));
   }
-  // store the stats for this connection
-  map_[callerid] = stats;
 }
 
 
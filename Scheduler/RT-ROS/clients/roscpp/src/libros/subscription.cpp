@@ -37,6 +37,8 @@
 #include <cerrno>
 #include <cstring>
 #include <typeinfo>
+#include <algorithm>
+#include <unistd.h>
 
 #include "ros/common.h"
 #include "ros/io.h"
@@ -45,9 +47,11 @@
 #include "ros/transport_publisher_link.h"
 #include "ros/intraprocess_publisher_link.h"
 #include "ros/intraprocess_subscriber_link.h"
+#include "ros/shm_publisher_link.h"
 #include "ros/connection.h"
 #include "ros/transport/transport_tcp.h"
 #include "ros/transport/transport_udp.h"
+#include "ros/transport/transport_shm.h"
 #include "ros/callback_queue_interface.h"
 #include "ros/this_node.h"
 #include "ros/network.h"
@@ -336,12 +340,13 @@ bool Subscription::pubUpdate(const V_string& new_pubs)
   return retval;
 }
 
-bool Subscription::negotiateConnection(const std::string& xmlrpc_uri)
+bool Subscription::negotiateConnection(const std::string& xmlrpc_uri, bool shm)
 {
   XmlRpcValue tcpros_array, protos_array, params;
-  XmlRpcValue udpros_array;
+  XmlRpcValue udpros_array, shmros_array;
   TransportUDPPtr udp_transport;
   int protos = 0;
+  bool tcp = false;
   V_string transports = transport_hints_.getTransports();
   if (transports.empty())
   {
@@ -355,10 +360,16 @@ bool Subscription::negotiateConnection(const std::string& xmlrpc_uri)
     if (*it == "UDP")
     {
       int max_datagram_size = transport_hints_.getMaxDatagramSize();
-      udp_transport = TransportUDPPtr(new TransportUDP(&PollManager::instance()->getPollSet()));
+      // the publisher splits messages into datagrams of the size asked for here, which are reassembled by blocks of it
+      udp_transport = TransportUDPPtr(new TransportUDP(&PollManager::instance()->getPollSet(), 0, max_datagram_size));
       if (!max_datagram_size)
         max_datagram_size = udp_transport->getMaxDatagramSize();
       udp_transport->createIncoming(0, false);
+      int receive_buffer_size = transport_hints_.getUDPReceiveBufferSize();
+      if (receive_buffer_size)
+      {
+        udp_transport->setReceiveBufferSize(receive_buffer_size);
+      }
       udpros_array[0] = "UDPROS";
       M_string m;
       m["topic"] = getName();
@@ -380,12 +391,44 @@ bool Subscription::negotiateConnection(const std::string& xmlrpc_uri)
     {
       tcpros_array[0] = std::string("TCPROS");
       protos_array[protos++] = tcpros_array;
+      tcp = true;
+    }
+    else if (*it == "SHM")
+    {
+      if (!shm)
+      {
+        continue;
+      }
+
+      shmros_array[0] = "SHMROS";
+      M_string m;
+      m["topic"] = getName();
+      m["md5sum"] = md5sum();
+      m["callerid"] = this_node::getName();
+      m["type"] = datatype();
+      boost::shared_array<uint8_t> buffer;
+      uint32_t len;
+      Header::write(m, buffer, len);
+      XmlRpcValue v(buffer.get(), len);
+      shmros_array[1] = v;
+      shmros_array[2] = TransportSHM::getHostID();
+      shmros_array[3] = (int)getpid();
+      shmros_array[4] = (int)geteuid();
+      shmros_array[5] = transport_hints_.getSHMSlotSize();
+
+      protos_array[protos++] = shmros_array;
     }
     else
     {
       ROS_WARN("Unsupported transport type hinted: %s, skipping", it->c_str());
     }
   }
+  // publishers on other hosts fall back to TCP
+  if (!tcp && std::find(transports.begin(), transports.end(), "SHM") != transports.end())
+  {
+    tcpros_array[0] = std::string("TCPROS");
+    protos_array[protos++] = tcpros_array;
+  }
   params[0] = this_node::getName();
   params[1] = name_;
   params[2] = protos_array;
@@ -587,6 +630,56 @@ void Subscription::pendingConnectionDone(const PendingConnectionPtr& conn, XmlRp
       return;
     }
   }
+  else if (proto_name == "SHMROS")
+  {
+    if (proto.size() != 5 ||
+        proto[1].getType() != XmlRpcValue::TypeString ||
+        proto[2].getType() != XmlRpcValue::TypeInt ||
+        proto[3].getType() != XmlRpcValue::TypeInt ||
+        proto[4].getType() != XmlRpcValue::TypeBase64)
+    {
+      ROSCPP_LOG_DEBUG("publisher implements SHMROS, but the " \
+                       "parameters aren't string,int,int,base64");
+      return;
+    }
+    std::string segment = proto[1];
+    int reader = proto[2];
+    int generation = proto[3];
+    std::vector<char> header_bytes = proto[4];
+    boost::shared_array<uint8_t> buffer = boost::shared_array<uint8_t>(new uint8_t[header_bytes.size()]);
+    memcpy(buffer.get(), &header_bytes[0], header_bytes.size());
+    Header h;
+    std::string err;
+    if (!h.parse(buffer, header_bytes.size(), err))
+    {
+      ROSCPP_LOG_DEBUG("Unable to parse SHMROS connection header: %s", err.c_str());
+      return;
+    }
+    ROSCPP_LOG_DEBUG("Connecting via shmros to topic [%s] through segment [%s] reader [%d]", name_.c_str(), segment.c_str(), reader);
+
+    std::string error_msg;
+    if (h.getValue("error", error_msg))
+    {
+      ROSCPP_LOG_DEBUG("Received error message in header for connection to [%s]: [%s]", xmlrpc_uri.c_str(), error_msg.c_str());
+      return;
+    }
+
+    TransportSHMPtr transport(new TransportSHM);
+    SHMPublisherLinkPtr pub_link(new SHMPublisherLink(shared_from_this(), xmlrpc_uri, transport_hints_));
+    if (transport->open(segment) && pub_link->setHeader(h) && pub_link->initialize(transport, reader, generation))
+    {
+      boost::mutex::scoped_lock lock(publisher_links_mutex_);
+      addPublisherLink(pub_link);
+
+      ROSCPP_LOG_DEBUG("Connected to publisher of topic [%s] through segment [%s]", name_.c_str(), segment.c_str());
+    }
+    else
+    {
+      // the publisher gives up on the reader when we do not attach in time
+      ROSCPP_LOG_DEBUG("Failed to attach to segment [%s] of topic [%s], falling back to TCPROS", segment.c_str(), name_.c_str());
+      negotiateConnection(xmlrpc_uri, false);
+    }
+  }
   else
   {
   	ROSCPP_LOG_DEBUG("Publisher offered unsupported transport [%s]", proto_name.c_str());
@@ -42,6 +42,7 @@
 #include "ros_rosch/publish_counter.h"
 #include "ros_rosch/task_attribute_processer.h"
 #include "ros_rosch/type.h"
+#include <algorithm>
 #include <boost/bind.hpp>
 #include <boost/thread.hpp>
 #include <boost/timer/timer.hpp>
@@ -64,7 +65,22 @@ SubscriptionQueue::SubscriptionQueue(const std::string &topic,
       ,
       sched_node_manager_(rosch::SingletonSchedNodeManager::getInstance())
 #endif
+      ,
+      sched_topic_(false)
 {
+  if (size_ > 0 && size_ <= MAX_RING_SIZE) {
+    ring_.reset(new LF_Item(size_));
+  }
+
+#ifdef ROSCHEDULER
+  NodeInfo node_info = sched_node_manager_.getNodeInfo();
+  sched_topic_ = std::find(node_info.v_subtopic.begin(),
+                           node_info.v_subtopic.end(),
+                           topic_) != node_info.v_subtopic.end();
+  if (node_info.group.period > 0) {
+    sched_deadline_ = WallDuration(node_info.group.period / 1000.0);
+  }
+#endif
 }
 
 SubscriptionQueue::~SubscriptionQueue() {}
@@ -75,50 +91,91 @@ void SubscriptionQueue::push(const SubscriptionCallbackHelperPtr &helper,
                              const VoidConstWPtr &tracked_object,
                              bool nonconst_need_copy, ros::Time receipt_time,
                              bool *was_full) {
-  boost::mutex::scoped_lock lock(queue_mutex_);
+  Item i;
+  i.helper = helper;
+  i.deserializer = deserializer;
+  i.has_tracked_object = has_tracked_object;
+  i.tracked_object = tracked_object;
+  i.nonconst_need_copy = nonconst_need_copy;
+  i.receipt_time = receipt_time;
 
-  if (was_full) {
-    *was_full = false;
-  }
+  bool dropped = false;
+
+  if (ring_) {
+    // make room by discarding the oldest message, unless a consumer gets to
+    // it first
+    while (ring_->size() >= (uint32_t)size_ || !ring_->push(i)) {
+      Item oldest;
+      if (ring_->pop(oldest)) {
+        dropped = true;
+      } else {
+        // the oldest message is still being pushed by another thread
+        boost::this_thread::yield();
+      }
+    }
+  } else {
+    boost::mutex::scoped_lock lock(queue_mutex_);
 
-  if (fullNoLock()) {
-    queue_.pop_front();
-    --queue_size_;
+    if (fullNoLock()) {
+      queue_.pop_front();
+      --queue_size_;
+      dropped = true;
+    }
+
+    queue_.push_back(i);
+    ++queue_size_;
+  }
 
+  if (dropped) {
     if (!full_) {
       ROS_DEBUG("Incoming queue full for topic \"%s\".  Discarding oldest "
                 "message (current queue size [%d])",
-                topic_.c_str(), (int)queue_.size());
+                topic_.c_str(), size_);
     }
 
     full_ = true;
-
-    if (was_full) {
-      *was_full = true;
-    }
   } else {
     full_ = false;
   }
 
-  Item i;
-  i.helper = helper;
-  i.deserializer = deserializer;
-  i.has_tracked_object = has_tracked_object;
-  i.tracked_object = tracked_object;
-  i.nonconst_need_copy = nonconst_need_copy;
-  i.receipt_time = receipt_time;
-  queue_.push_back(i);
-  ++queue_size_;
+  if (was_full) {
+    *was_full = dropped;
+  }
 }
 
 void SubscriptionQueue::clear() {
   boost::recursive_mutex::scoped_lock cb_lock(callback_mutex_);
+
+  if (ring_) {
+    Item i;
+    while (ring_->pop(i)) {
+    }
+    return;
+  }
+
   boost::mutex::scoped_lock queue_lock(queue_mutex_);
 
   queue_.clear();
   queue_size_ = 0;
 }
 
+bool SubscriptionQueue::pop(Item &i) {
+  if (ring_) {
+    return ring_->pop(i);
+  }
+
+  boost::mutex::scoped_lock lock(queue_mutex_);
+
+  if (queue_.empty()) {
+    return false;
+  }
+
+  swap(i, queue_.front());
+  queue_.pop_front();
+  --queue_size_;
+  return true;
+}
+
 CallbackInterface::CallResult SubscriptionQueue::call() {
   // The callback may result in our own destruction.  Therefore, we may need
   // to
@@ -138,29 +195,17 @@ CallbackInterface::CallResult SubscriptionQueue::call() {
   VoidConstPtr tracker;
   Item i;
 
-  {
-    boost::mutex::scoped_lock lock(queue_mutex_);
-
-    if (queue_.empty()) {
-      return CallbackInterface::Invalid;
-    }
+  if (!pop(i)) {
+    return CallbackInterface::Invalid;
+  }
 
-    i = queue_.front();
+  // the message goes with its tracked object
+  if (i.has_tracked_object) {
+    tracker = i.tracked_object.lock();
 
-    if (queue_.empty()) {
+    if (!tracker) {
       return CallbackInterface::Invalid;
     }
-
-    if (i.has_tracked_object) {
-      tracker = i.tracked_object.lock();
-
-      if (!tracker) {
-        return CallbackInterface::Invalid;
-      }
-    }
-
-    queue_.pop_front();
-    --queue_size_;
   }
 
   VoidConstPtr msg = i.deserializer->deserialize();
@@ -214,9 +259,9 @@ void SubscriptionQueue::waitAppThread() {
 
 #ifndef USE_LINUX_SYSTEM_CALL
 #ifdef HYPERPERIOD_MODE
-	cpu_set_t mask;
-	CPU_ZERO(&mask);
-
+	/* the affinity is for the thread waiting here, which may not be the
+	 * task registered with RESCH, so it cannot go with the priority into
+	 * one ros_rt_set_attr() call. */
 	set_affinity(sched_node_manager_.getUseCores());
 	ros_rt_set_priority(sched_node_manager_.getPriority());
 #endif
@@ -261,7 +306,23 @@ void SubscriptionQueue::appThread(Item i,
 
 bool SubscriptionQueue::ready() { return true; }
 
+CallbackSchedParam SubscriptionQueue::getSchedParam() {
+  CallbackSchedParam param;
+#ifdef ROSCHEDULER
+  if (sched_topic_) {
+    // per period, for nodes running as a single process
+    param.priority = std::max(sched_node_manager_.getPriority(), 0);
+    param.deadline = sched_deadline_;
+  }
+#endif
+  return param;
+}
+
 bool SubscriptionQueue::full() {
+  if (ring_) {
+    return ring_->size() >= (uint32_t)size_;
+  }
+
   boost::mutex::scoped_lock lock(queue_mutex_);
   return fullNoLock();
 }
@@ -36,6 +36,8 @@
 #include "ros/master.h"
 #include "ros/transport/transport_tcp.h"
 #include "ros/transport/transport_udp.h"
+#include "ros/transport/transport_shm.h"
+#include "ros/shm_subscriber_link.h"
 #include "ros/rosout_appender.h"
 #include "ros/init.h"
 #include "ros/file_log.h"
@@ -45,6 +47,8 @@
 
 #include <ros/console.h>
 
+#include <unistd.h>
+
 using namespace XmlRpc; // A battle to be fought later
 using namespace std; // sigh
 
@@ -689,6 +693,97 @@ bool TopicManager::requestTopic(const string &topic,
       ret[2] = udpros_params;
       return true;
     }
+    else if (proto_name == string("SHMROS"))
+    {
+      if (proto.size() != 6 ||
+          proto[1].getType() != XmlRpcValue::TypeBase64 ||
+          proto[2].getType() != XmlRpcValue::TypeString ||
+          proto[3].getType() != XmlRpcValue::TypeInt ||
+          proto[4].getType() != XmlRpcValue::TypeInt ||
+          proto[5].getType() != XmlRpcValue::TypeInt)
+      {
+        ROSCPP_LOG_DEBUG("Invalid protocol parameters for SHMROS");
+        return false;
+      }
+      std::vector<char> header_bytes = proto[1];
+      boost::shared_array<uint8_t> buffer = boost::shared_array<uint8_t>(new uint8_t[header_bytes.size()]);
+      memcpy(buffer.get(), &header_bytes[0], header_bytes.size());
+      Header h;
+      string err;
+      if (!h.parse(buffer, header_bytes.size(), err))
+      {
+        ROSCPP_LOG_DEBUG("Unable to parse SHMROS connection header: %s", err.c_str());
+        return false;
+      }
+
+      PublicationPtr pub_ptr = lookupPublication(topic);
+      if(!pub_ptr)
+      {
+        ROSCPP_LOG_DEBUG("Unable to find advertised topic %s for SHMROS connection", topic.c_str());
+        return false;
+      }
+
+      std::string error_msg;
+      if (!pub_ptr->validateHeader(h, error_msg))
+      {
+        ROSCPP_LOG_DEBUG("Error validating header for topic [%s]: %s", topic.c_str(), error_msg.c_str());
+        return false;
+      }
+
+      // from here on, anything shared memory cannot do falls back to the next protocol offered
+      std::string host_id = proto[2];
+      int pid = proto[3];
+      int uid = proto[4];
+      int slot_size = proto[5];
+      if (host_id != TransportSHM::getHostID() || uid != (int)geteuid())
+      {
+        ROSCPP_LOG_DEBUG("Subscriber of topic [%s] is on another host or of another user, skipping SHMROS", topic.c_str());
+        continue;
+      }
+      // the latched message is only sent to new subscribers through their own link
+      if (pub_ptr->isLatching())
+      {
+        ROSCPP_LOG_DEBUG("Topic [%s] is latched, skipping SHMROS", topic.c_str());
+        continue;
+      }
+
+      TransportSHMPtr transport = pub_ptr->getSHMTransport(slot_size);
+      uint32_t generation = 0;
+      int reader = transport ? transport->reserveReader(pid, generation) : -1;
+      if (reader < 0)
+      {
+        ROSCPP_LOG_DEBUG("No shared memory reader available for topic [%s], skipping SHMROS", topic.c_str());
+        continue;
+      }
+
+      std::string caller_id;
+      h.getValue("callerid", caller_id);
+      SHMSubscriberLinkPtr sub_link(new SHMSubscriberLink(pub_ptr));
+      sub_link->initialize(transport, reader, caller_id);
+      pub_ptr->addSubscriberLink(sub_link);
+
+      XmlRpcValue shmros_params;
+      shmros_params[0] = string("SHMROS");
+      shmros_params[1] = transport->getName();
+      shmros_params[2] = reader;
+      shmros_params[3] = int(generation);
+      M_string m;
+      m["topic"] = topic;
+      m["md5sum"] = pub_ptr->getMD5Sum();
+      m["type"] = pub_ptr->getDataType();
+      m["callerid"] = this_node::getName();
+      m["message_definition"] = pub_ptr->getMessageDefinition();
+      m["latching"] = "0";
+      boost::shared_array<uint8_t> msg_def_buffer;
+      uint32_t len;
+      Header::write(m, msg_def_buffer, len);
+      XmlRpcValue v(msg_def_buffer.get(), len);
+      shmros_params[4] = v;
+      ret[0] = int(1);
+      ret[1] = string();
+      ret[2] = shmros_params;
+      return true;
+    }
     else
     {
       ROSCPP_LOG_DEBUG( "an unsupported protocol was offered: [%s]",
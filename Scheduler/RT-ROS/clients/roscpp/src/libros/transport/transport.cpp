@@ -103,6 +103,19 @@ Transport::Transport()
 #endif
 }
 
+int32_t Transport::writev(const TransportBuffer* buffers, uint32_t count)
+{
+  for (uint32_t i = 0; i < count; ++i)
+  {
+    if (buffers[i].size > 0)
+    {
+      return write(buffers[i].data, buffers[i].size);
+    }
+  }
+
+  return 0;
+}
+
 bool Transport::isHostAllowed(const std::string &host) const
 {
   if (!only_localhost_allowed_)
@@ -0,0 +1,597 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2016, Yukihiro Saito.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "ros/transport/transport_shm.h"
+#include "ros/network.h"
+#include "ros/file_log.h"
+
+#include <ros/assert.h>
+
+#include <fstream>
+#include <sstream>
+#include <climits>
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+namespace ros
+{
+
+#define ROS_SHM_MAGIC 0x524f5348 // "ROSH"
+#define ROS_SHM_ALIGN 64
+/// How long a reserved reader may wait for its subscriber to attach, in seconds
+#define ROS_SHM_ATTACH_TIMEOUT 10.0
+/// How often the other side is checked to be still running, in seconds
+#define ROS_SHM_CHECK_INTERVAL 1.0
+
+enum
+{
+  SHM_READER_FREE,
+  SHM_READER_RESERVED,
+  SHM_READER_ATTACHED,
+  SHM_READER_CLOSED,
+};
+
+struct TransportSHMReader
+{
+  volatile uint32_t state_;
+  volatile uint32_t generation_;
+  volatile int32_t pid_;
+  uint32_t reserved_;
+};
+
+/**
+ * \brief The head of a segment.  Sequence numbers wrap around, so they are only compared by difference
+ */
+struct TransportSHMHeader
+{
+  uint32_t magic_;
+  uint32_t slot_count_;
+  uint32_t slot_size_;
+  uint32_t slot_stride_;
+  int32_t pid_;
+  volatile uint32_t closed_;
+  /// Readers attached, which the next message is written for
+  volatile uint32_t readers_mask_;
+  /// Sequence number of the next message
+  volatile uint32_t head_;
+  /// Incremented on every write, for subscribers to wait on
+  volatile uint32_t futex_;
+  volatile uint32_t waiters_;
+  volatile uint32_t drops_;
+  /// Set by abandon(), for subscribers to reconnect without shared memory
+  volatile uint32_t abandoned_;
+  TransportSHMReader readers_[ROS_SHM_MAX_READERS];
+};
+
+/**
+ * \brief A slot, followed by the serialized message it holds
+ */
+struct TransportSHMSlot
+{
+  /// Readers which have not released the message yet
+  volatile uint32_t readers_;
+  volatile uint32_t seq_;
+  volatile uint32_t size_;
+  uint32_t reserved_;
+};
+
+static inline size_t alignSize(size_t size)
+{
+  return (size + ROS_SHM_ALIGN - 1) & ~(size_t)(ROS_SHM_ALIGN - 1);
+}
+
+static inline int futex(volatile uint32_t* addr, int op, uint32_t val, const struct timespec* timeout)
+{
+  return syscall(SYS_futex, addr, op, val, timeout, NULL, 0);
+}
+
+static bool isProcessAlive(pid_t pid)
+{
+  return kill(pid, 0) == 0 || errno != ESRCH;
+}
+
+/**
+ * \brief Releases the slot of a message read, when its buffer goes away
+ */
+struct TransportSHMRelease
+{
+  TransportSHMRelease(const TransportSHMPtr& transport, TransportSHMSlot* slot, int reader, uint32_t generation)
+  : transport_(transport)
+  , slot_(slot)
+  , reader_(reader)
+  , generation_(generation)
+  {
+  }
+
+  void operator()(uint8_t*)
+  {
+    // the publisher may have released the reader and given it to someone else meanwhile
+    if (transport_->header_->readers_[reader_].generation_ == generation_)
+    {
+      __sync_fetch_and_and(&slot_->readers_, ~(1U << reader_));
+    }
+  }
+
+  TransportSHMPtr transport_;
+  TransportSHMSlot* slot_;
+  int reader_;
+  uint32_t generation_;
+};
+
+TransportSHM::TransportSHM()
+: owner_(false)
+, base_(0)
+, size_(0)
+, header_(0)
+, slot_stride_(0)
+, reader_(-1)
+, generation_(0)
+, next_seq_(0)
+{
+}
+
+TransportSHM::~TransportSHM()
+{
+  if (!base_)
+  {
+    return;
+  }
+
+  if (owner_)
+  {
+    header_->closed_ = 1;
+    wake();
+    shm_unlink(name_.c_str());
+  }
+  else
+  {
+    detach();
+  }
+
+  munmap(base_, size_);
+}
+
+const std::string& TransportSHM::getHostID()
+{
+  static std::string host_id;
+  static boost::mutex host_id_mutex;
+
+  boost::mutex::scoped_lock lock(host_id_mutex);
+  if (host_id.empty())
+  {
+    // unique to every boot of every host; fall back to the name we are reachable by
+    std::ifstream boot_id("/proc/sys/kernel/random/boot_id");
+    if (!(boot_id >> host_id))
+    {
+      host_id = network::getHost();
+    }
+  }
+
+  return host_id;
+}
+
+bool TransportSHM::map(int fd, size_t size)
+{
+  void* base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (base == MAP_FAILED)
+  {
+    ROS_ERROR("mmap() of shared memory segment [%s] failed with error [%s]", name_.c_str(), strerror(errno));
+    return false;
+  }
+
+  base_ = base;
+  size_ = size;
+  header_ = (TransportSHMHeader*)base;
+
+  return true;
+}
+
+bool TransportSHM::create(uint32_t slot_count, uint32_t slot_size)
+{
+  static volatile uint32_t segment_count = 0;
+
+  ROS_ASSERT(!base_);
+
+  if (slot_count == 0 || (slot_count & (slot_count - 1)))
+  {
+    ROS_ERROR("Shared memory slot count %u is not a power of two", slot_count);
+    return false;
+  }
+
+  std::stringstream ss;
+  ss << "/ros_shm_" << getpid() << "_" << __sync_fetch_and_add(&segment_count, 1);
+  name_ = ss.str();
+
+  size_t stride = alignSize(sizeof(TransportSHMSlot) + slot_size);
+  size_t size = alignSize(sizeof(TransportSHMHeader)) + stride * slot_count;
+
+  int fd = shm_open(name_.c_str(), O_RDWR | O_CREAT | O_EXCL, S_IRUSR | S_IWUSR);
+  if (fd == -1)
+  {
+    ROS_ERROR("shm_open() of [%s] failed with error [%s]", name_.c_str(), strerror(errno));
+    return false;
+  }
+
+  if (ftruncate(fd, size) == -1)
+  {
+    ROS_ERROR("ftruncate() of shared memory segment [%s] to %lu bytes failed with error [%s]", name_.c_str(), (unsigned long)size, strerror(errno));
+    ::close(fd);
+    shm_unlink(name_.c_str());
+    return false;
+  }
+
+  if (!map(fd, size))
+  {
+    shm_unlink(name_.c_str());
+    return false;
+  }
+
+  owner_ = true;
+  slot_stride_ = stride;
+
+  // ftruncate() has zeroed the rest
+  header_->slot_count_ = slot_count;
+  header_->slot_size_ = slot_size;
+  header_->slot_stride_ = stride;
+  header_->pid_ = getpid();
+  __sync_synchronize();
+  header_->magic_ = ROS_SHM_MAGIC;
+
+  ROSCPP_LOG_DEBUG("Created shared memory segment [%s] of %u slots of %u bytes", name_.c_str(), slot_count, slot_size);
+
+  return true;
+}
+
+bool TransportSHM::open(const std::string& name)
+{
+  ROS_ASSERT(!base_);
+
+  name_ = name;
+
+  int fd = shm_open(name_.c_str(), O_RDWR, 0);
+  if (fd == -1)
+  {
+    ROSCPP_LOG_DEBUG("shm_open() of [%s] failed with error [%s]", name_.c_str(), strerror(errno));
+    return false;
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) == -1 || (size_t)st.st_size < sizeof(TransportSHMHeader))
+  {
+    ROSCPP_LOG_DEBUG("Shared memory segment [%s] is too small", name_.c_str());
+    ::close(fd);
+    return false;
+  }
+
+  if (!map(fd, st.st_size))
+  {
+    return false;
+  }
+
+  slot_stride_ = header_->slot_stride_;
+  if (header_->magic_ != ROS_SHM_MAGIC ||
+      alignSize(sizeof(TransportSHMHeader)) + (size_t)slot_stride_ * header_->slot_count_ > size_)
+  {
+    ROSCPP_LOG_DEBUG("Shared memory segment [%s] is not valid", name_.c_str());
+    munmap(base_, size_);
+    base_ = 0;
+    header_ = 0;
+    return false;
+  }
+
+  return true;
+}
+
+uint32_t TransportSHM::getSlotSize()
+{
+  return header_->slot_size_;
+}
+
+uint32_t TransportSHM::getDrops()
+{
+  return header_->drops_;
+}
+
+TransportSHMSlot* TransportSHM::getSlot(uint32_t seq)
+{
+  uint8_t* slots = (uint8_t*)base_ + alignSize(sizeof(TransportSHMHeader));
+  return (TransportSHMSlot*)(slots + (size_t)(seq & (header_->slot_count_ - 1)) * slot_stride_);
+}
+
+void TransportSHM::releaseSlots(uint32_t bit)
+{
+  for (uint32_t i = 0; i < header_->slot_count_; ++i)
+  {
+    __sync_fetch_and_and(&getSlot(i)->readers_, ~bit);
+  }
+}
+
+int TransportSHM::reserveReader(pid_t pid, uint32_t& generation)
+{
+  ROS_ASSERT(owner_);
+
+  boost::mutex::scoped_lock lock(write_mutex_);
+  for (int i = 0; i < ROS_SHM_MAX_READERS; ++i)
+  {
+    TransportSHMReader& r = header_->readers_[i];
+    if (r.state_ != SHM_READER_FREE)
+    {
+      continue;
+    }
+
+    r.pid_ = pid;
+    generation = ++r.generation_;
+    __sync_synchronize();
+    r.state_ = SHM_READER_RESERVED;
+    reserved_time_[i] = WallTime::now();
+    checked_time_[i] = reserved_time_[i];
+
+    return i;
+  }
+
+  return -1;
+}
+
+void TransportSHM::releaseReader(int reader)
+{
+  ROS_ASSERT(owner_);
+  ROS_ASSERT(reader >= 0 && reader < ROS_SHM_MAX_READERS);
+
+  boost::mutex::scoped_lock lock(write_mutex_);
+  uint32_t bit = 1U << reader;
+  __sync_fetch_and_and(&header_->readers_mask_, ~bit);
+  releaseSlots(bit);
+
+  TransportSHMReader& r = header_->readers_[reader];
+  r.pid_ = 0;
+  __sync_synchronize();
+  r.state_ = SHM_READER_FREE;
+
+  // let the subscriber notice
+  wake();
+}
+
+bool TransportSHM::isReaderAlive(int reader)
+{
+  TransportSHMReader& r = header_->readers_[reader];
+  WallTime now = WallTime::now();
+
+  switch (r.state_)
+  {
+  case SHM_READER_RESERVED:
+    return now - reserved_time_[reader] < WallDuration(ROS_SHM_ATTACH_TIMEOUT);
+  case SHM_READER_ATTACHED:
+    if (now - checked_time_[reader] < WallDuration(ROS_SHM_CHECK_INTERVAL))
+    {
+      return true;
+    }
+    checked_time_[reader] = now;
+    return isProcessAlive(r.pid_);
+  default:
+    return false;
+  }
+}
+
+bool TransportSHM::write(const SerializedMessage& m)
+{
+  boost::mutex::scoped_lock lock(write_mutex_);
+
+  uint32_t readers = header_->readers_mask_;
+  if (!readers)
+  {
+    return true;
+  }
+
+  // skip the slots still held, so that a message kept long does not stall the others
+  uint32_t seq = header_->head_;
+  TransportSHMSlot* slot = 0;
+  for (uint32_t i = 0; i < header_->slot_count_; ++i, ++seq)
+  {
+    if (!getSlot(seq)->readers_)
+    {
+      slot = getSlot(seq);
+      break;
+    }
+  }
+
+  if (m.num_bytes > header_->slot_size_ || !slot)
+  {
+    __sync_fetch_and_add(&header_->drops_, 1);
+    return false;
+  }
+
+  memcpy(slot + 1, m.buf.get(), m.num_bytes);
+  slot->size_ = m.num_bytes;
+  slot->seq_ = seq;
+  __sync_synchronize();
+  slot->readers_ = readers;
+  __sync_synchronize();
+  header_->head_ = seq + 1;
+
+  __sync_fetch_and_add(&header_->futex_, 1);
+  if (header_->waiters_)
+  {
+    futex(&header_->futex_, FUTEX_WAKE, INT_MAX, NULL);
+  }
+
+  return true;
+}
+
+void TransportSHM::abandon()
+{
+  ROS_ASSERT(owner_);
+
+  header_->abandoned_ = 1;
+  __sync_synchronize();
+  header_->closed_ = 1;
+  wake();
+}
+
+bool TransportSHM::attach(int reader, uint32_t generation)
+{
+  ROS_ASSERT(!owner_);
+
+  if (reader < 0 || reader >= ROS_SHM_MAX_READERS)
+  {
+    return false;
+  }
+
+  TransportSHMReader& r = header_->readers_[reader];
+  if (r.generation_ != generation ||
+      !__sync_bool_compare_and_swap(&r.state_, SHM_READER_RESERVED, SHM_READER_ATTACHED))
+  {
+    return false;
+  }
+
+  reader_ = reader;
+  generation_ = generation;
+  r.pid_ = getpid();
+
+  // take the head before showing up in the mask, or messages written in between would never be released
+  next_seq_ = header_->head_;
+  __sync_fetch_and_or(&header_->readers_mask_, 1U << reader);
+
+  return true;
+}
+
+void TransportSHM::detach()
+{
+  if (reader_ < 0)
+  {
+    return;
+  }
+
+  TransportSHMReader& r = header_->readers_[reader_];
+  if (r.generation_ == generation_)
+  {
+    __sync_fetch_and_and(&header_->readers_mask_, ~(1U << reader_));
+    // the publisher releases the slots still held when it notices
+    __sync_bool_compare_and_swap(&r.state_, SHM_READER_ATTACHED, SHM_READER_CLOSED);
+  }
+
+  reader_ = -1;
+}
+
+bool TransportSHM::read(SerializedMessage& m)
+{
+  if (reader_ < 0)
+  {
+    return false;
+  }
+
+  uint32_t bit = 1U << reader_;
+  while ((int32_t)(header_->head_ - next_seq_) > 0)
+  {
+    uint32_t seq = next_seq_++;
+    TransportSHMSlot* slot = getSlot(seq);
+    __sync_synchronize();
+
+    // not written for us: skipped, or written before we attached
+    if (!(slot->readers_ & bit) || slot->seq_ != seq)
+    {
+      continue;
+    }
+
+    uint8_t* data = (uint8_t*)(slot + 1);
+    boost::shared_array<uint8_t> buf(data + 4, TransportSHMRelease(shared_from_this(), slot, reader_, generation_));
+    m = SerializedMessage(buf, slot->size_ - 4);
+
+    return true;
+  }
+
+  return false;
+}
+
+void TransportSHM::wait(const WallDuration& timeout)
+{
+  uint32_t val = header_->futex_;
+  __sync_synchronize();
+  if ((int32_t)(header_->head_ - next_seq_) > 0)
+  {
+    return;
+  }
+
+  struct timespec ts;
+  ts.tv_sec = timeout.sec;
+  ts.tv_nsec = timeout.nsec;
+
+  __sync_fetch_and_add(&header_->waiters_, 1);
+  futex(&header_->futex_, FUTEX_WAIT, val, &ts);
+  __sync_fetch_and_sub(&header_->waiters_, 1);
+}
+
+void TransportSHM::wake()
+{
+  __sync_fetch_and_add(&header_->futex_, 1);
+  futex(&header_->futex_, FUTEX_WAKE, INT_MAX, NULL);
+}
+
+bool TransportSHM::isWriterAlive()
+{
+  if (reader_ < 0 || header_->closed_)
+  {
+    return false;
+  }
+
+  TransportSHMReader& r = header_->readers_[reader_];
+  if (r.generation_ != generation_ || r.state_ != SHM_READER_ATTACHED)
+  {
+    return false;
+  }
+
+  WallTime now = WallTime::now();
+  if (now - checked_time_writer_ < WallDuration(ROS_SHM_CHECK_INTERVAL))
+  {
+    return true;
+  }
+  checked_time_writer_ = now;
+
+  return isProcessAlive(header_->pid_);
+}
+
+bool TransportSHM::isAbandoned()
+{
+  return header_->abandoned_;
+}
+
+} // namespace ros
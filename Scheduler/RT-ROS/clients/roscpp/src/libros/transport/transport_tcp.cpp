@@ -535,6 +535,59 @@ int32_t TransportTCP::write(uint8_t* buffer, uint32_t size)
   return num_bytes;
 }
 
+int32_t TransportTCP::writev(const TransportBuffer* buffers, uint32_t count)
+{
+#ifdef WIN32
+  return Transport::writev(buffers, count);
+#else
+  {
+    boost::recursive_mutex::scoped_lock lock(close_mutex_);
+
+    if (closed_)
+    {
+      ROSCPP_LOG_DEBUG("Tried to write on a closed socket [%d]", sock_);
+      return -1;
+    }
+  }
+
+  // never write more than INT_MAX since this is the maximum we can report back with the current return type
+  struct iovec iov[64];
+  int iovcnt = 0;
+  uint32_t writesize = 0;
+  for (uint32_t i = 0; i < count && iovcnt < 64 && writesize < static_cast<uint32_t>(INT_MAX); ++i)
+  {
+    if (buffers[i].size == 0)
+    {
+      continue;
+    }
+
+    uint32_t size = std::min(buffers[i].size, static_cast<uint32_t>(INT_MAX) - writesize);
+    iov[iovcnt].iov_base = buffers[i].data;
+    iov[iovcnt].iov_len = size;
+    ++iovcnt;
+    writesize += size;
+  }
+
+  ROS_ASSERT(writesize > 0);
+
+  int num_bytes = ::writev(sock_, iov, iovcnt);
+  if (num_bytes < 0)
+  {
+    if ( !last_socket_error_is_would_block() )
+    {
+      ROSCPP_LOG_DEBUG("writev() on socket [%d] failed with error [%s]", sock_, last_socket_error_string());
+      close();
+    }
+    else
+    {
+      num_bytes = 0;
+    }
+  }
+
+  return num_bytes;
+#endif
+}
+
 void TransportTCP::enableRead()
 {
   ROS_ASSERT(!(flags_ & SYNCHRONOUS));
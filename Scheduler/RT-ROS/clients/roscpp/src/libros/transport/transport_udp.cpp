@@ -35,10 +35,13 @@
 #include "ros/transport/transport_udp.h"
 #include "ros/poll_set.h"
 #include "ros/file_log.h"
+#include "config.h"
 
 #include <ros/assert.h>
 #include <boost/bind.hpp>
 
+#include <algorithm>
+
 #include <fcntl.h>
 #if defined(__APPLE__)
   // For readv() and writev()
@@ -49,10 +52,21 @@
   // For readv() and writev() on ANDROID
   #include <sys/uio.h>
 #endif
+#if defined(HAVE_RECVMMSG) || defined(HAVE_SENDMMSG)
+  // For recvmmsg() and sendmmsg()
+  #include <sys/socket.h>
+#endif
 
 namespace ros
 {
 
+// The most datagrams received or sent with one system call
+static const uint32_t UDP_MAX_BATCH = 32;
+// Receive batches are made smaller for large datagrams, to bound the memory of each transport
+static const uint32_t UDP_MAX_BATCH_BYTES = 256 * 1024;
+// The most messages reassembled at once, the oldest one is dropped to start another
+static const uint32_t UDP_MAX_ASSEMBLIES = 8;
+
 TransportUDP::TransportUDP(PollSet* poll_set, int flags, int max_datagram_size)
 : sock_(-1)
 , closed_(false)
@@ -65,27 +79,36 @@ TransportUDP::TransportUDP(PollSet* poll_set, int flags, int max_datagram_size)
 , flags_(flags)
 , connection_id_(0)
 , current_message_id_(0)
-, total_blocks_(0)
-, last_block_(0)
 , max_datagram_size_(max_datagram_size)
-, data_filled_(0)
-, reorder_buffer_(0)
-, reorder_bytes_(0)
+, batch_size_(1)
+, recv_count_(0)
+, recv_next_(0)
+, message_start_(0)
+, message_left_(0)
+, reading_assembly_(-1)
+, assemblies_(UDP_MAX_ASSEMBLIES)
+, assemblies_started_(0)
+, dropped_messages_(0)
+, reordered_datagrams_(0)
 {
   // This may eventually be machine dependent
   if (max_datagram_size_ == 0)
     max_datagram_size_ = 1500;
-  reorder_buffer_ = new uint8_t[max_datagram_size_];
-  reorder_start_ = reorder_buffer_;
-  data_buffer_ = new uint8_t[max_datagram_size_];
-  data_start_ = data_buffer_;
+
+#if defined(HAVE_RECVMMSG)
+  batch_size_ = std::max(std::min(UDP_MAX_BATCH_BYTES / max_datagram_size_, UDP_MAX_BATCH), (uint32_t)1);
+#endif
+
+  for (uint32_t i = 0; i < assemblies_.size(); ++i)
+  {
+    assemblies_[i].in_use = false;
+  }
+  std::fill(assembly_index_, assembly_index_ + 256, -1);
 }
 
 TransportUDP::~TransportUDP()
 {
   ROS_ASSERT_MSG(sock_ == ROS_INVALID_SOCKET, "TransportUDP socket [%d] was never closed", sock_);
-  delete [] reorder_buffer_;
-  delete [] data_buffer_;
 }
 
 bool TransportUDP::setSocket(int sock)
@@ -137,6 +160,7 @@ std::string TransportUDP::getTransportInfo()
 {
   std::stringstream str;
   str << "UDPROS connection on port " << local_port_ << " to [" << cached_remote_host_ << "]";
+  str << ", dropped messages [" << dropped_messages_ << "], reordered datagrams [" << reordered_datagrams_ << "]";
   return str.str();
 }
 
@@ -340,185 +364,384 @@ void TransportUDP::close()
   }
 }
 
-int32_t TransportUDP::read(uint8_t* buffer, uint32_t size)
+bool TransportUDP::setReceiveBufferSize(int size)
 {
+  if (setsockopt(sock_, SOL_SOCKET, SO_RCVBUF, reinterpret_cast<const char*>(&size), sizeof(size)) != 0)
   {
-    boost::mutex::scoped_lock lock(close_mutex_);
-    if (closed_)
+    ROS_ERROR("setsockopt(SO_RCVBUF) to [%d] bytes failed with error [%s]", size, last_socket_error_string());
+    return false;
+  }
+
+  ROSCPP_LOG_DEBUG("UDP socket [%d] receive buffer set to [%d] bytes", sock_, size);
+
+  return true;
+}
+
+uint32_t TransportUDP::getPayloadSize() const
+{
+  return max_datagram_size_ - sizeof(TransportUDPHeader);
+}
+
+int TransportUDP::receive()
+{
+  const uint32_t payload_size = getPayloadSize();
+
+  // only transports which are read from need the receive buffers
+  if (recv_buffer_.empty())
+  {
+    recv_buffer_.resize(batch_size_ * payload_size);
+    recv_headers_.resize(batch_size_);
+    recv_sizes_.resize(batch_size_);
+  }
+
+  recv_count_ = 0;
+  recv_next_ = 0;
+
+#if defined(HAVE_RECVMMSG)
+  struct iovec iov[UDP_MAX_BATCH][2];
+  struct mmsghdr msgs[UDP_MAX_BATCH];
+  memset(msgs, 0, sizeof(msgs[0]) * batch_size_);
+  for (uint32_t i = 0; i < batch_size_; ++i)
+  {
+    iov[i][0].iov_base = &recv_headers_[i];
+    iov[i][0].iov_len = sizeof(TransportUDPHeader);
+    iov[i][1].iov_base = &recv_buffer_[i * payload_size];
+    iov[i][1].iov_len = payload_size;
+    msgs[i].msg_hdr.msg_iov = iov[i];
+    msgs[i].msg_hdr.msg_iovlen = 2;
+  }
+
+  // Read the datagrams which are pending, waiting only for the first one if the socket is blocking
+  int count = recvmmsg(sock_, msgs, batch_size_, MSG_WAITFORONE, NULL);
+  for (int i = 0; i < count; ++i)
+  {
+    recv_sizes_[i] = msgs[i].msg_len;
+  }
+#elif defined(WIN32)
+  SSIZE_T count = 1;
+  DWORD received_bytes = 0;
+  DWORD flags = 0;
+  WSABUF iov[2];
+  iov[0].buf = reinterpret_cast<char*>(&recv_headers_[0]);
+  iov[0].len = sizeof(TransportUDPHeader);
+  iov[1].buf = reinterpret_cast<char*>(&recv_buffer_[0]);
+  iov[1].len = payload_size;
+  int rc  = WSARecv(sock_, iov, 2, &received_bytes, &flags, NULL, NULL);
+  if ( rc == SOCKET_ERROR) {
+    count = -1;
+  } else {
+    recv_sizes_[0] = received_bytes;
+  }
+#else
+  ssize_t count = 1;
+  struct iovec iov[2];
+  iov[0].iov_base = &recv_headers_[0];
+  iov[0].iov_len = sizeof(TransportUDPHeader);
+  iov[1].iov_base = &recv_buffer_[0];
+  iov[1].iov_len = payload_size;
+  // Read a datagram with header
+  ssize_t num_bytes = readv(sock_, iov, 2);
+  if (num_bytes < 0)
+  {
+    count = -1;
+  }
+  else
+  {
+    recv_sizes_[0] = num_bytes;
+  }
+#endif
+
+  if (count < 0)
+  {
+    if ( last_socket_error_is_would_block() )
     {
-      ROSCPP_LOG_DEBUG("Tried to read on a closed socket [%d]", sock_);
+      return 0;
+    }
+
+    ROSCPP_LOG_DEBUG("Receiving from socket [%d] failed with error [%s]", sock_, last_socket_error_string());
+    close();
+    return -1;
+  }
+
+  for (int i = 0; i < (int)count; ++i)
+  {
+    if (recv_sizes_[i] == 0)
+    {
+      ROSCPP_LOG_DEBUG("Socket [%d] received 0 bytes, closing", sock_);
+      close();
+      return -1;
+    }
+    else if (recv_sizes_[i] < sizeof(TransportUDPHeader))
+    {
+      ROS_ERROR("Socket [%d] received short header (%d bytes)", sock_, int(recv_sizes_[i]));
+      close();
       return -1;
     }
+
+    recv_sizes_[i] -= sizeof(TransportUDPHeader);
   }
 
-  ROS_ASSERT((int32_t)size > 0);
+  recv_count_ = count;
 
-  uint32_t bytes_read = 0;
+  return 1;
+}
 
-  while (bytes_read < size)
+int TransportUDP::nextMessage()
+{
+  // The last message has been read
+  if (reading_assembly_ >= 0)
   {
-    TransportUDPHeader header;
+    assemblies_[reading_assembly_].in_use = false;
+    reading_assembly_ = -1;
+  }
 
-    // Get the data either from the reorder buffer or the socket
-    // copy_bytes will contain the read size.
-    // from_previous is true if the data belongs to the previous UDP datagram.
-    uint32_t copy_bytes = 0;
-    bool from_previous = false;
-    if (reorder_bytes_)
+  while (true)
+  {
+    if (recv_next_ == recv_count_)
     {
-      if (reorder_start_ != reorder_buffer_)
+      int result = receive();
+      if (result <= 0)
       {
-        from_previous = true;
+        return result;
       }
-
-      copy_bytes = std::min(size - bytes_read, reorder_bytes_);
-      header = reorder_header_;
-      memcpy(buffer + bytes_read, reorder_start_, copy_bytes);
-      reorder_bytes_ -= copy_bytes;
-      reorder_start_ += copy_bytes;
     }
-    else
+
+    uint32_t slot = recv_next_++;
+    const TransportUDPHeader& header = recv_headers_[slot];
+    const uint8_t* data = &recv_buffer_[slot * getPayloadSize()];
+    uint32_t size = recv_sizes_[slot];
+
+    switch (header.op_)
     {
-      if (data_filled_ == 0)
-      {
-#if defined(WIN32)
-    	SSIZE_T num_bytes = 0;
-        DWORD received_bytes = 0;
-        DWORD flags = 0;
-        WSABUF iov[2];
-        iov[0].buf = reinterpret_cast<char*>(&header);
-        iov[0].len = sizeof(header);
-        iov[1].buf = reinterpret_cast<char*>(data_buffer_);
-        iov[1].len = max_datagram_size_ - sizeof(header);
-		int rc  = WSARecv(sock_, iov, 2, &received_bytes, &flags, NULL, NULL);
-		if ( rc == SOCKET_ERROR) {
-		  num_bytes = -1;
-		} else {
-			num_bytes = received_bytes;
-		}
-#else
-        ssize_t num_bytes;
-        struct iovec iov[2];
-        iov[0].iov_base = &header;
-        iov[0].iov_len = sizeof(header);
-        iov[1].iov_base = data_buffer_;
-        iov[1].iov_len = max_datagram_size_ - sizeof(header);
-        // Read a datagram with header
-        num_bytes = readv(sock_, iov, 2);
-#endif
-        if (num_bytes < 0)
+      case ROS_UDP_DATA0:
+        if (header.block_ == 1)
         {
-          if ( last_socket_error_is_would_block() )
-          {
-            num_bytes = 0;
-            break;
-          }
-          else
-          {
-            ROSCPP_LOG_DEBUG("readv() failed with error [%s]",  last_socket_error_string());
-            close();
-            break;
-          }
+          // A message of a single datagram is read from its receive slot, without being copied
+          dropAssembly(header.message_id_);
+          message_start_ = data;
+          message_left_ = size;
+          return 1;
         }
-        else if (num_bytes == 0)
-        {
-          ROSCPP_LOG_DEBUG("Socket [%d] received 0/%d bytes, closing", sock_, size);
-          close();
-          return -1;
-        }
-        else if (num_bytes < (unsigned) sizeof(header))
+        // no break, the first of several datagrams is assembled like the others
+      case ROS_UDP_DATAN:
+      {
+        Assembly* assembly = assemble(header, data, size);
+        if (assembly)
         {
-          ROS_ERROR("Socket [%d] received short header (%d bytes): %s", sock_, int(num_bytes),  last_socket_error_string());
-          close();
-          return -1;
+          message_start_ = &assembly->data[0];
+          message_left_ = assembly->size;
+          reading_assembly_ = assembly - &assemblies_[0];
+          return 1;
         }
-
-		num_bytes -= sizeof(header);
-        data_filled_ = num_bytes;
-        data_start_ = data_buffer_;
-      }
-      else
-      {
-        from_previous = true;
+        break;
       }
+      default:
+        ROS_ERROR("Unexpected UDP header OP [%d]", header.op_);
+        return -1;
+    }
+  }
+}
 
-      copy_bytes = std::min(size - bytes_read, data_filled_);
-      // Copy from the data buffer, whether it has data left in it from a previous datagram or
-      // was just filled by readv()
-      memcpy(buffer + bytes_read, data_start_, copy_bytes);
-      data_filled_ -= copy_bytes;
-      data_start_ += copy_bytes;
+TransportUDP::Assembly* TransportUDP::startAssembly(uint8_t message_id)
+{
+  // Take a free assembly, or the one of the oldest message still missing datagrams
+  int index = -1;
+  for (uint32_t i = 0; i < assemblies_.size(); ++i)
+  {
+    if (!assemblies_[i].in_use)
+    {
+      index = i;
+      break;
     }
 
+    if ((int)i != reading_assembly_ && (index < 0 || assemblies_[i].started < assemblies_[index].started))
+    {
+      index = i;
+    }
+  }
+  ROS_ASSERT(index >= 0);
 
-    if (from_previous)
+  Assembly& assembly = assemblies_[index];
+  if (assembly.in_use)
+  {
+    dropAssembly(assembly.message_id);
+  }
+
+  assembly.message_id = message_id;
+  assembly.total_blocks = 0;
+  assembly.received_blocks = 0;
+  assembly.next_block = 0;
+  assembly.block_sizes.clear();
+  assembly.data.clear();
+  assembly.size = 0;
+  assembly.started = assemblies_started_++;
+  assembly.in_use = true;
+  assembly_index_[message_id] = index;
+
+  return &assembly;
+}
+
+void TransportUDP::dropAssembly(uint8_t message_id)
+{
+  int16_t index = assembly_index_[message_id];
+  if (index < 0)
+  {
+    return;
+  }
+
+  Assembly& assembly = assemblies_[index];
+  ROS_DEBUG("Dropping message [%d] with [%d] of [%d] blocks received", message_id, assembly.received_blocks, assembly.total_blocks);
+  ++dropped_messages_;
+
+  assembly.in_use = false;
+  assembly_index_[message_id] = -1;
+}
+
+TransportUDP::Assembly* TransportUDP::assemble(const TransportUDPHeader& header, const uint8_t* data, uint32_t size)
+{
+  const uint32_t payload_size = getPayloadSize();
+  // The first datagram carries the number of blocks in its block field
+  const uint16_t block = header.op_ == ROS_UDP_DATA0 ? 0 : header.block_;
+
+  if (header.op_ == ROS_UDP_DATA0 && header.block_ == 0)
+  {
+    ROS_DEBUG("Received message [%d] of 0 blocks", header.message_id_);
+    return 0;
+  }
+
+  Assembly* assembly = 0;
+  int16_t index = assembly_index_[header.message_id_];
+  if (index >= 0)
+  {
+    assembly = &assemblies_[index];
+
+    // A block received twice belongs to a newer message, message ids wrap around
+    if (block < assembly->block_sizes.size() && assembly->block_sizes[block] != 0)
+    {
+      dropAssembly(header.message_id_);
+      assembly = 0;
+    }
+  }
+
+  if (!assembly)
+  {
+    assembly = startAssembly(header.message_id_);
+  }
+
+  if (block < assembly->next_block)
+  {
+    ++reordered_datagrams_;
+  }
+  else
+  {
+    assembly->next_block = block + 1;
+  }
+
+  if (header.op_ == ROS_UDP_DATA0)
+  {
+    assembly->total_blocks = header.block_;
+    assembly->data.reserve(assembly->total_blocks * payload_size);
+  }
+
+  if (assembly->block_sizes.size() <= block)
+  {
+    assembly->block_sizes.resize(block + 1, 0);
+    assembly->data.resize((block + 1) * payload_size);
+  }
+
+  // Each block goes straight to its place in the message
+  memcpy(&assembly->data[block * payload_size], data, size);
+  assembly->block_sizes[block] = size;
+  ++assembly->received_blocks;
+
+  if (assembly->total_blocks == 0 || assembly->received_blocks < assembly->total_blocks)
+  {
+    return 0;
+  }
+
+  // All the blocks are in, check that they make up the message
+  bool valid = assembly->block_sizes.size() == assembly->total_blocks;
+  for (uint32_t i = 0; valid && i + 1 < assembly->total_blocks; ++i)
+  {
+    valid = assembly->block_sizes[i] == payload_size;
+  }
+
+  if (!valid)
+  {
+    ROS_DEBUG("Received inconsistent blocks for message [%d]", header.message_id_);
+    dropAssembly(header.message_id_);
+    return 0;
+  }
+
+  assembly->size = (assembly->total_blocks - 1) * payload_size + assembly->block_sizes[assembly->total_blocks - 1];
+  // A message with the same id is a new one from now on
+  assembly_index_[header.message_id_] = -1;
+
+  return assembly;
+}
+
+int32_t TransportUDP::read(uint8_t* buffer, uint32_t size)
+{
+  {
+    boost::mutex::scoped_lock lock(close_mutex_);
+    if (closed_)
     {
-      // We are simply reading data from the last UDP datagram, nothing to
-      // parse
-      bytes_read += copy_bytes;
+      ROSCPP_LOG_DEBUG("Tried to read on a closed socket [%d]", sock_);
+      return -1;
     }
-    else
+  }
+
+  ROS_ASSERT((int32_t)size > 0);
+
+  uint32_t bytes_read = 0;
+
+  while (bytes_read < size)
+  {
+    if (message_left_ == 0)
     {
-      // This datagram is new, process header
-      switch (header.op_)
+      // A read never spans two messages, the next one may be from a message sent later
+      if (bytes_read > 0)
       {
-        case ROS_UDP_DATA0:
-          if (current_message_id_)
-          {
-            ROS_DEBUG("Received new message [%d:%d], while still working on [%d] (block %d of %d)", header.message_id_, header.block_, current_message_id_, last_block_ + 1, total_blocks_);
-            reorder_header_ = header;
-
-            // Copy the entire data buffer to the reorder buffer, as we will
-            // need to replay this UDP datagram in the next call.
-            reorder_bytes_ = data_filled_ + (data_start_ - data_buffer_);
-            memcpy(reorder_buffer_, data_buffer_, reorder_bytes_);
-            reorder_start_ = reorder_buffer_;
-            current_message_id_ = 0;
-            total_blocks_ = 0;
-            last_block_ = 0;
-
-            data_filled_ = 0;
-            data_start_ = data_buffer_;
-            return -1;
-          }
-          total_blocks_ = header.block_;
-          last_block_ = 0;
-          current_message_id_ = header.message_id_;
-          break;
-        case ROS_UDP_DATAN:
-          if (header.message_id_ != current_message_id_)
-          {
-            ROS_DEBUG("Message Id mismatch: %d != %d", header.message_id_, current_message_id_);
-            data_filled_ = 0; // discard datagram
-            return 0;
-          }
-          if (header.block_ != last_block_ + 1)
-          {
-            ROS_DEBUG("Expected block %d, received %d", last_block_ + 1, header.block_);
-            data_filled_ = 0; // discard datagram
-            return 0;
-          }
-          last_block_ = header.block_;
-
-          break;
-        default:
-          ROS_ERROR("Unexpected UDP header OP [%d]", header.op_);
-          return -1;
+        break;
       }
 
-      bytes_read += copy_bytes;
-
-      if (last_block_ == (total_blocks_ - 1))
+      int result = nextMessage();
+      if (result < 0)
+      {
+        return -1;
+      }
+      else if (result == 0)
       {
-        current_message_id_ = 0;
         break;
       }
     }
+
+    uint32_t copy_bytes = std::min(size - bytes_read, message_left_);
+    memcpy(buffer + bytes_read, message_start_, copy_bytes);
+    message_start_ += copy_bytes;
+    message_left_ -= copy_bytes;
+    bytes_read += copy_bytes;
   }
 
   return bytes_read;
 }
 
+static void initHeader(TransportUDPHeader& header, uint32_t connection_id, uint8_t message_id, uint32_t block, uint32_t total_blocks)
+{
+  header.connection_id_ = connection_id;
+  header.message_id_ = message_id;
+  if (block == 0)
+  {
+    header.op_ = ROS_UDP_DATA0;
+    header.block_ = total_blocks;
+  }
+  else
+  {
+    header.op_ = ROS_UDP_DATAN;
+    header.block_ = block;
+  }
+}
+
 int32_t TransportUDP::write(uint8_t* buffer, uint32_t size)
 {
   {
@@ -533,38 +756,49 @@ int32_t TransportUDP::write(uint8_t* buffer, uint32_t size)
 
   ROS_ASSERT((int32_t)size > 0);
 
-  const uint32_t max_payload_size = max_datagram_size_ - sizeof(TransportUDPHeader);
+  const uint32_t max_payload_size = getPayloadSize();
+  const uint32_t total_blocks = (size + max_payload_size - 1) / max_payload_size;
 
   uint32_t bytes_sent = 0;
   uint32_t this_block = 0;
   if (++current_message_id_ == 0)
     ++current_message_id_;
-  while (bytes_sent < size)
+  while (this_block < total_blocks)
   {
-    TransportUDPHeader header;
-    header.connection_id_ = connection_id_;
-    header.message_id_ = current_message_id_;
-    if (this_block == 0)
-    {
-      header.op_ = ROS_UDP_DATA0;
-      header.block_ = (size + max_payload_size - 1) / max_payload_size;
-    }
-    else
+#if defined(HAVE_SENDMMSG)
+    // Send the datagrams of the message in batches
+    TransportUDPHeader headers[UDP_MAX_BATCH];
+    struct iovec iov[UDP_MAX_BATCH][2];
+    struct mmsghdr msgs[UDP_MAX_BATCH];
+    uint32_t count = std::min(total_blocks - this_block, UDP_MAX_BATCH);
+    memset(msgs, 0, sizeof(msgs[0]) * count);
+    for (uint32_t i = 0; i < count; ++i)
     {
-      header.op_ = ROS_UDP_DATAN;
-      header.block_ = this_block;
+      uint32_t offset = (this_block + i) * max_payload_size;
+      initHeader(headers[i], connection_id_, current_message_id_, this_block + i, total_blocks);
+      iov[i][0].iov_base = &headers[i];
+      iov[i][0].iov_len = sizeof(TransportUDPHeader);
+      iov[i][1].iov_base = buffer + offset;
+      iov[i][1].iov_len = std::min(max_payload_size, size - offset);
+      msgs[i].msg_hdr.msg_iov = iov[i];
+      msgs[i].msg_hdr.msg_iovlen = 2;
     }
-    ++this_block;
+
+    int sent = sendmmsg(sock_, msgs, count, 0);
+#else
+    TransportUDPHeader headers[1];
+    initHeader(headers[0], connection_id_, current_message_id_, this_block, total_blocks);
+    uint32_t offset = this_block * max_payload_size;
 #if defined(WIN32)
     WSABUF iov[2];
 	DWORD sent_bytes;
 	SSIZE_T num_bytes = 0;
 	DWORD flags = 0;
 	int rc;
-	iov[0].buf = reinterpret_cast<char*>(&header);
-	iov[0].len = sizeof(header);
-	iov[1].buf = reinterpret_cast<char*>(buffer + bytes_sent);
-	iov[1].len = std::min(max_payload_size, size - bytes_sent);
+	iov[0].buf = reinterpret_cast<char*>(&headers[0]);
+	iov[0].len = sizeof(TransportUDPHeader);
+	iov[1].buf = reinterpret_cast<char*>(buffer + offset);
+	iov[1].len = std::min(max_payload_size, size - offset);
 	rc = WSASend(sock_, iov, 2, &sent_bytes, flags, NULL, NULL);
 	num_bytes = sent_bytes;
 	if (rc == SOCKET_ERROR) {
@@ -572,37 +806,45 @@ int32_t TransportUDP::write(uint8_t* buffer, uint32_t size)
 	}
 #else
     struct iovec iov[2];
-    iov[0].iov_base = &header;
-    iov[0].iov_len = sizeof(header);
-    iov[1].iov_base = buffer + bytes_sent;
-    iov[1].iov_len = std::min(max_payload_size, size - bytes_sent);
-    ssize_t num_bytes = writev(sock_, iov, 2);
+    iov[0].iov_base = &headers[0];
+    iov[0].iov_len = sizeof(TransportUDPHeader);
+    iov[1].iov_base = buffer + offset;
+    iov[1].iov_len = std::min(max_payload_size, size - offset);
+    ssize_t num_bytes = ::writev(sock_, iov, 2);
+#endif
+    int sent = num_bytes < 0 ? -1 : 1;
 #endif
     //usleep(100);
-    if (num_bytes < 0)
+    if (sent < 0)
     {
       if( !last_socket_error_is_would_block() ) // Actually EAGAIN or EWOULDBLOCK on posix
       {
-        ROSCPP_LOG_DEBUG("writev() failed with error [%s]", last_socket_error_string());
+        ROSCPP_LOG_DEBUG("Sending on socket [%d] failed with error [%s]", sock_, last_socket_error_string());
         close();
         break;
       }
-      else
-      {
-        num_bytes = 0;
-      }
-    }
-    else if (num_bytes < (unsigned) sizeof(header))
-    {
-      ROSCPP_LOG_DEBUG("Socket [%d] short write (%d bytes), closing", sock_, int(num_bytes));
-      close();
-      break;
+
+      // try the same datagrams again
+      continue;
     }
-    else
+
+    for (int i = 0; i < sent; ++i)
     {
-      num_bytes -= sizeof(header);
+#if defined(HAVE_SENDMMSG)
+      uint32_t datagram_bytes = msgs[i].msg_len;
+#else
+      uint32_t datagram_bytes = num_bytes;
+#endif
+      if (datagram_bytes < sizeof(TransportUDPHeader))
+      {
+        ROSCPP_LOG_DEBUG("Socket [%d] short write (%d bytes), closing", sock_, int(datagram_bytes));
+        close();
+        return bytes_sent;
+      }
+
+      bytes_sent += datagram_bytes - sizeof(TransportUDPHeader);
     }
-    bytes_sent += num_bytes;
+    this_block += sent;
   }
 
   return bytes_sent;
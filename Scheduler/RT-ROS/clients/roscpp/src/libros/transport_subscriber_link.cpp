@@ -41,6 +41,11 @@
 namespace ros
 {
 
+/// Queued messages written with a single call, at most
+static const size_t MAX_COALESCED_MESSAGES = 64;
+/// Further messages are only written together with the first while they fit in this many bytes
+static const uint32_t MAX_COALESCED_BYTES = 64 * 1024;
+
 TransportSubscriberLink::TransportSubscriberLink()
 : writing_message_(false)
 , header_written_(false)
@@ -146,9 +151,6 @@ void TransportSubscriberLink::onMessageWritten(const ConnectionPtr& conn)
 
 void TransportSubscriberLink::startMessageWrite(bool immediate_write)
 {
-  boost::shared_array<uint8_t> dummy;
-  SerializedMessage m(dummy, (uint32_t)0);
-
   {
     boost::mutex::scoped_lock lock(outbox_mutex_);
     if (writing_message_ || !header_written_)
@@ -156,17 +158,42 @@ void TransportSubscriberLink::startMessageWrite(bool immediate_write)
       return;
     }
 
-    if (!outbox_.empty())
+    // Small messages queued up while the previous write was in progress (e.g. /tf) go out
+    // together, with a single system call on transports which gather writes
+    writing_buffers_.clear();
+    uint32_t bytes = 0;
+    while (!outbox_.empty() && writing_buffers_.size() < MAX_COALESCED_MESSAGES)
     {
-      writing_message_ = true;
-      m = outbox_.front();
+      const SerializedMessage& m = outbox_.front();
+      if (!writing_buffers_.empty() && bytes + m.num_bytes > MAX_COALESCED_BYTES)
+      {
+        break;
+      }
+
+      if (m.num_bytes > 0)
+      {
+        writing_buffers_.push_back(WriteBuffer(m.buf, m.num_bytes));
+        bytes += m.num_bytes;
+      }
       outbox_.pop();
     }
+
+    if (writing_buffers_.empty())
+    {
+      return;
+    }
+
+    writing_message_ = true;
   }
 
-  if (m.num_bytes > 0)
+  // writing_buffers_ is left alone until onMessageWritten()
+  if (writing_buffers_.size() == 1)
+  {
+    connection_->write(writing_buffers_.front().buf, writing_buffers_.front().size, boost::bind(&TransportSubscriberLink::onMessageWritten, this, _1), immediate_write);
+  }
+  else
   {
-    connection_->write(m.buf, m.num_bytes, boost::bind(&TransportSubscriberLink::onMessageWritten, this, _1), immediate_write);
+    connection_->writev(writing_buffers_, boost::bind(&TransportSubscriberLink::onMessageWritten, this, _1), immediate_write);
   }
 }
 
@@ -2,6 +2,7 @@
 #include "ros_rosch/type.h"
 #include "yaml-cpp/yaml.h"
 #include <iostream>
+#include <sched.h>
 #include <map>
 #include <string>
 
@@ -20,19 +21,51 @@ void NodesInfo::loadConfig(const std::string &filename) {
   try {
     YAML::Node node_list;
     node_list = YAML::LoadFile(filename);
+
+    /* groups of nodes, which can be declared anywhere in the list. */
+    std::map<std::string, GroupInfo> groups;
+    for (unsigned int i(0); i < node_list.size(); i++) {
+      const YAML::Node groupname = node_list[i]["groupname"];
+      if (!groupname)
+        continue;
+      GroupInfo group_info;
+      group_info.name = groupname.as<std::string>();
+      group_info.index = groups.size();
+      group_info.period = node_list[i]["period"].as<int>();
+      group_info.budget = node_list[i]["budget"] ? node_list[i]["budget"].as<int>() : 0;
+      groups[group_info.name] = group_info;
+    }
+
     for (unsigned int i(0); i < node_list.size(); i++) {
+      if (!node_list[i]["nodename"])
+        continue;
       const YAML::Node name = node_list[i]["nodename"];
 //      const YAML::Node index = node_list[i]["nodeindex"];
       const YAML::Node core = node_list[i]["core"];
       const YAML::Node subtopic = node_list[i]["sub_topic"];
       const YAML::Node pubtopic = node_list[i]["pub_topic"];
       const YAML::Node sched_info = node_list[i]["sched_info"];
+      const YAML::Node spinner_threads = node_list[i]["spinner_threads"];
 
       NodeInfo node_info;
       node_info.name = name.as<std::string>();
       //      node_info.index = index.as<int>();
-      node_info.index = i;
+      node_info.index = v_node_info_.size();
       node_info.core = core.as<int>();
+
+      node_info.group.name = "";
+      node_info.group.index = -1;
+      node_info.group.period = 0;
+      node_info.group.budget = 0;
+      if (node_list[i]["group"]) {
+        const std::string group(node_list[i]["group"].as<std::string>());
+        std::map<std::string, GroupInfo>::const_iterator it = groups.find(group);
+        if (it != groups.end())
+          node_info.group = it->second;
+        else
+          std::cerr << "Group : " << group << ". cannot find group infomation."
+                    << std::endl;
+      }
 			
 			node_info.period_count = 0;
 			if(node_info.core >= 2)
@@ -63,6 +96,31 @@ void NodesInfo::loadConfig(const std::string &filename) {
    	    node_info.v_sched_info.push_back(sched_info_element);
       }
 
+      node_info.v_thread_info.resize(0);
+      for (int idx(0); spinner_threads && idx < spinner_threads.size(); ++idx) {
+        const YAML::Node thread = spinner_threads[idx];
+        const YAML::Node cores = thread["cores"];
+        const YAML::Node topics = thread["topics"];
+        ThreadInfo thread_info;
+        for (int c(0); cores && c < cores.size(); ++c) {
+          thread_info.v_core.push_back(cores[c].as<int>());
+        }
+        const std::string policy(
+            thread["policy"] ? thread["policy"].as<std::string>() : "other");
+        if (policy == "fifo")
+          thread_info.policy = SCHED_FIFO;
+        else if (policy == "rr")
+          thread_info.policy = SCHED_RR;
+        else
+          thread_info.policy = SCHED_OTHER;
+        thread_info.priority =
+            thread["priority"] ? thread["priority"].as<int>() : 0;
+        for (int t(0); topics && t < topics.size(); ++t) {
+          thread_info.v_topic.push_back(topics[t].as<std::string>());
+        }
+        node_info.v_thread_info.push_back(thread_info);
+      }
+
       v_node_info_.push_back(node_info);
     }
   } catch (YAML::Exception &e) {
@@ -106,9 +164,14 @@ void NodesInfo::createEmptyNodeInfo(NodeInfo *node_info) {
   node_info->name = "";
   node_info->index = -1;
   node_info->core = -1;
+  node_info->group.name = "";
+  node_info->group.index = -1;
+  node_info->group.period = 0;
+  node_info->group.budget = 0;
   node_info->v_sched_info.clear();
   node_info->v_subtopic.clear();
   node_info->v_pubtopic.clear();
+  node_info->v_thread_info.clear();
 }
 
 size_t NodesInfo::getNodeListSize(void) { return v_node_info_.size(); }
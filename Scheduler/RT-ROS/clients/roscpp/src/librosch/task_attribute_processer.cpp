@@ -1,6 +1,7 @@
 #define _GNU_SOURCE 1
 #include "ros_rosch/task_attribute_processer.h"
 #include <iostream>
+#include <pthread.h>
 #include <sched.h>
 #include <unistd.h>
 #include <vector>
@@ -76,3 +77,29 @@ void TaskAttributeProcesser::setDefaultScheduling(std::vector<pid_t> v_pid) {
   setAffinityToAllCore();
   setCFS(v_pid);
 }
+/* the core set and the scheduling class of the calling thread only,
+ * unlike the attributes of the node which all its threads inherit. */
+bool TaskAttributeProcesser::setThreadAttribute(const ThreadInfo &thread_info) {
+  bool ret = true;
+  if (thread_info.v_core.size() > 0) {
+    cpu_set_t mask;
+    CPU_ZERO(&mask);
+    for (int i = 0; i < (int)thread_info.v_core.size(); ++i) {
+      CPU_SET(thread_info.v_core.at(i), &mask);
+    }
+    if (pthread_setaffinity_np(pthread_self(), sizeof(mask), &mask) != 0) {
+      std::cerr << "Failed to set CPU affinity of thread" << std::endl;
+      ret = false;
+    }
+  }
+  struct sched_param sp;
+  sp.sched_priority =
+      thread_info.policy == SCHED_OTHER ? 0 : thread_info.priority;
+  if (pthread_setschedparam(pthread_self(), thread_info.policy, &sp) != 0) {
+    std::cerr << "Failed to set scheduling policy of thread:"
+              << thread_info.policy << "," << thread_info.priority
+              << std::endl;
+    ret = false;
+  }
+  return ret;
+}
@@ -50,6 +50,7 @@ struct ThroughputResult
   uint64_t message_size;
   uint32_t sender_threads;
   uint32_t receiver_threads;
+  uint32_t queue_size;
 
   uint64_t messages_sent;
   uint64_t messages_received;
@@ -62,7 +63,11 @@ struct ThroughputResult
   ros::WallTime test_end;
 };
 
-ThroughputResult throughput(double duration, uint32_t streams, uint32_t message_size, uint32_t sender_threads, uint32_t receiver_threads);
+/**
+ * \param queue_size Subscriber queue size: 0 (unbounded) queues messages in a locked deque, and sizes up to 4096
+ * in a lock-free ring
+ */
+ThroughputResult throughput(double duration, uint32_t streams, uint32_t message_size, uint32_t sender_threads, uint32_t receiver_threads, uint32_t queue_size = 0);
 
 struct LatencyResult
 {
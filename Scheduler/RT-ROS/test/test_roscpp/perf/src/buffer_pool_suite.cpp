@@ -0,0 +1,189 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2009, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Heap allocations and page faults taken to receive a stream of frames,
+ * with a buffer allocated per frame (as Connection::read() did) and with
+ * the buffers recycled by a BufferPool.
+ */
+
+#include <ros/buffer_pool.h>
+#include <ros/time.h>
+#include <ros/assert.h>
+
+#include <boost/shared_array.hpp>
+
+#include <sys/resource.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <fstream>
+#include <new>
+#include <vector>
+
+using namespace std;
+
+// Counts the heap allocations of this process, including the reference counts of shared_arrays
+static volatile uint64_t g_allocations = 0;
+
+void* operator new(size_t size)
+{
+  __sync_fetch_and_add(&g_allocations, 1);
+  void* p = malloc(size ? size : 1);
+  if (!p)
+  {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+
+void operator delete(void* p) throw()
+{
+  free(p);
+}
+
+void* operator new[](size_t size)
+{
+  return operator new(size);
+}
+
+void operator delete[](void* p) throw()
+{
+  operator delete(p);
+}
+
+struct BufferPoolResult
+{
+  std::string allocator;
+  uint32_t frame_size;
+  uint32_t frame_count;
+  double allocations_per_frame;
+  double page_faults_per_frame;
+  double time_per_frame;
+};
+typedef std::vector<BufferPoolResult> V_BufferPoolResult;
+
+long pageFaults()
+{
+  struct rusage usage;
+  ROS_ASSERT(getrusage(RUSAGE_SELF, &usage) == 0);
+  return usage.ru_minflt + usage.ru_majflt;
+}
+
+/**
+ * \brief Receives frame_count frames, as Connection::read() does for frames of READ_BUFFER_SIZE or more
+ */
+BufferPoolResult runTest(bool use_pool, uint32_t frame_size, uint32_t frame_count)
+{
+  ros::BufferPoolPtr large_pool(new ros::BufferPool(2, 0xffffffff));
+
+  BufferPoolResult r;
+  r.allocator = use_pool ? "pool" : "new[]";
+  r.frame_size = frame_size;
+  r.frame_count = frame_count;
+
+  uint64_t allocations = g_allocations;
+  long faults = pageFaults();
+  ros::WallTime start = ros::WallTime::now();
+
+  for (uint32_t i = 0; i < frame_count; ++i)
+  {
+    boost::shared_array<uint8_t> frame;
+    if (use_pool)
+    {
+      frame = large_pool->acquire(frame_size);
+    }
+    else
+    {
+      frame = boost::shared_array<uint8_t>(new uint8_t[frame_size]);
+    }
+
+    // as received from the socket
+    memset(frame.get(), i & 0xff, frame_size);
+    // released by the deserializer at the end of the scope
+  }
+
+  double d = (ros::WallTime::now() - start).toSec();
+  r.allocations_per_frame = (double)(g_allocations - allocations) / frame_count;
+  r.page_faults_per_frame = (double)(pageFaults() - faults) / frame_count;
+  r.time_per_frame = d / frame_count;
+
+  return r;
+}
+
+void printResult(std::ostream& out, uint32_t test_num, BufferPoolResult& r)
+{
+  out << "----------------------------------------------------------\n";
+  out << "Buffer Pool Test " << test_num << ": allocator [" << r.allocator << "], frame_size [" << r.frame_size << "], frame_count [" << r.frame_count << "]\n";
+  out << "\tAllocations Per Frame: " << r.allocations_per_frame << endl;
+  out << "\tPage Faults Per Frame: " << r.page_faults_per_frame << endl;
+  out << "\tTime Per Frame: " << r.time_per_frame << endl;
+}
+
+void addResult(V_BufferPoolResult& results, BufferPoolResult r, std::ostream& out, uint32_t i)
+{
+  results.push_back(r);
+  printResult(out, i, results.back());
+}
+
+int main(int argc, char** argv)
+{
+  std::ofstream out("buffer_pool_suite_out.txt", std::ios::out);
+  out << std::fixed;
+  out.precision(10);
+  cout << std::fixed;
+  cout.precision(10);
+
+  ROS_ASSERT(out.is_open());
+
+  V_BufferPoolResult results;
+  uint32_t i = 0;
+  //                           pool , frame size     , frame count
+  addResult(results, runTest(false, 64*1024        , 100000     ), out, i++);
+  addResult(results, runTest(true , 64*1024        , 100000     ), out, i++);
+  addResult(results, runTest(false, 640*480*3      , 1000       ), out, i++);
+  addResult(results, runTest(true , 640*480*3      , 1000       ), out, i++);
+  addResult(results, runTest(false, 1920*1080*3    , 300        ), out, i++);
+  addResult(results, runTest(true , 1920*1080*3    , 300        ), out, i++);
+
+  printf("\n\n\n***************************** Results *****************************\n\n");
+  i = 0;
+  V_BufferPoolResult::iterator it = results.begin();
+  V_BufferPoolResult::iterator end = results.end();
+  for (; it != end; ++it, ++i)
+  {
+    printResult(cout, i, *it);
+  }
+}
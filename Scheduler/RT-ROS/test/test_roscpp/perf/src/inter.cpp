@@ -1 +1,396 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2009, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
 
+#include "perf_roscpp/inter.h"
+#include "test_roscpp/ThroughputMessage.h"
+#include "test_roscpp/LatencyMessage.h"
+
+#include <ros/ros.h>
+#include <ros/callback_queue.h>
+
+#include <boost/thread.hpp>
+#include <boost/lexical_cast.hpp>
+
+#include <vector>
+#include <algorithm>
+#include <cstdlib>
+
+#include <signal.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#define PEER_ARG "__inter_peer"
+
+namespace perf_roscpp
+{
+namespace inter
+{
+
+static ros::TransportHints transportHints(const std::string& transport, uint32_t message_size)
+{
+  if (transport == "shm")
+  {
+    // leave room for the fields besides the array
+    return ros::TransportHints().shm().shmSlotSize(message_size + 1024).tcp().tcpNoDelay();
+  }
+  else if (transport == "udp")
+  {
+    // room for bursts of datagrams, so that a slow subscriber drops fewer messages
+    return ros::TransportHints().udp().udpReceiveBufferSize(4 * 1024 * 1024);
+  }
+
+  return ros::TransportHints().tcpNoDelay();
+}
+
+static pid_t spawnPeer(const std::string& test, uint32_t message_size, const std::string& transport)
+{
+  std::string size = boost::lexical_cast<std::string>(message_size);
+
+  pid_t pid = fork();
+  if (pid == 0)
+  {
+    execl("/proc/self/exe", "perf_roscpp_inter_peer", PEER_ARG, test.c_str(), size.c_str(), transport.c_str(), (char*)NULL);
+    _exit(1);
+  }
+  else if (pid < 0)
+  {
+    ROS_ERROR("fork() failed");
+  }
+
+  return pid;
+}
+
+static void killPeer(pid_t pid)
+{
+  if (pid > 0)
+  {
+    kill(pid, SIGTERM);
+    waitpid(pid, NULL, 0);
+  }
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+class ThroughputTest
+{
+public:
+  ThroughputTest(double test_duration, uint32_t message_size, const std::string& transport);
+
+  ThroughputResult run();
+
+private:
+  void callback(const test_roscpp::ThroughputMessageConstPtr& msg);
+
+  ros::CallbackQueue queue_;
+
+  double test_duration_;
+  uint32_t message_size_;
+  std::string transport_;
+
+  uint64_t messages_received_;
+  uint64_t bytes_received_;
+  ros::WallTime first_recv_time_;
+  ros::WallTime last_recv_time_;
+};
+
+ThroughputTest::ThroughputTest(double test_duration, uint32_t message_size, const std::string& transport)
+: test_duration_(test_duration)
+, message_size_(message_size)
+, transport_(transport)
+, messages_received_(0)
+, bytes_received_(0)
+{
+}
+
+void ThroughputTest::callback(const test_roscpp::ThroughputMessageConstPtr& msg)
+{
+  last_recv_time_ = ros::WallTime::now();
+  if (messages_received_ == 0)
+  {
+    first_recv_time_ = last_recv_time_;
+  }
+
+  bytes_received_ += ros::serialization::Serializer<test_roscpp::ThroughputMessage>::serializedLength(*msg) + 4; // 4 byte message length field
+  ++messages_received_;
+}
+
+ThroughputResult ThroughputTest::run()
+{
+  ThroughputResult r;
+  r.test_start = ros::WallTime::now();
+  r.transport = transport_;
+  r.test_duration = test_duration_;
+  r.message_size = message_size_;
+
+  ros::NodeHandle nh;
+  nh.setCallbackQueue(&queue_);
+  ros::Subscriber sub = nh.subscribe("inter_throughput_perf_test", 0, &ThroughputTest::callback, this, transportHints(transport_, message_size_));
+
+  pid_t pid = spawnPeer("throughput", message_size_, transport_);
+
+  ROS_INFO("Waiting for the first message");
+
+  ros::WallTime timeout = ros::WallTime::now() + ros::WallDuration(10.0);
+  while (messages_received_ == 0 && ros::WallTime::now() < timeout)
+  {
+    queue_.callAvailable(ros::WallDuration(0.01));
+  }
+
+  if (messages_received_ > 0)
+  {
+    ROS_INFO_STREAM("Receiving through [" << sub.getNumPublishers() << "] publisher(s)");
+
+    ros::WallTime end_time = first_recv_time_ + ros::WallDuration(test_duration_);
+    while (ros::WallTime::now() < end_time)
+    {
+      queue_.callAvailable(ros::WallDuration(0.01));
+    }
+  }
+  else
+  {
+    ROS_ERROR("No message received from the peer");
+  }
+
+  killPeer(pid);
+
+  r.test_end = ros::WallTime::now();
+  r.messages_received = messages_received_;
+  r.total_bytes_received = bytes_received_;
+  r.bytes_per_second = 0;
+  if (messages_received_ > 1)
+  {
+    r.bytes_per_second = (double)bytes_received_ / (last_recv_time_ - first_recv_time_).toSec();
+  }
+
+  ROS_INFO("Done collating results");
+
+  return r;
+}
+
+ThroughputResult throughput(double test_duration, uint32_t message_size, const std::string& transport)
+{
+  ROS_INFO_STREAM("*****************************************************");
+  ROS_INFO_STREAM("Running inter-process throughput test: transport [" << transport << "], test_duration [" << test_duration << "], message_size [" << message_size << "]");
+
+  ThroughputTest t(test_duration, message_size, transport);
+  return t.run();
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+class LatencyTest
+{
+public:
+  LatencyTest(uint32_t message_count, uint32_t message_size, const std::string& transport);
+
+  LatencyResult run();
+
+private:
+  void callback(const test_roscpp::LatencyMessageConstPtr& msg, ros::Publisher& pub);
+
+  std::vector<double> latencies_;
+  test_roscpp::LatencyMessagePtr last_msg_;
+
+  ros::CallbackQueue queue_;
+
+  uint32_t message_count_;
+  uint32_t message_size_;
+  std::string transport_;
+};
+
+LatencyTest::LatencyTest(uint32_t message_count, uint32_t message_size, const std::string& transport)
+: message_count_(message_count)
+, message_size_(message_size)
+, transport_(transport)
+{
+}
+
+void LatencyTest::callback(const test_roscpp::LatencyMessageConstPtr& msg, ros::Publisher& pub)
+{
+  latencies_.push_back(msg->receipt_time - msg->publish_time);
+
+  test_roscpp::LatencyMessagePtr reply = boost::const_pointer_cast<test_roscpp::LatencyMessage>(msg);
+  reply->publish_time = ros::WallTime::now().toSec();
+  ++reply->count;
+  last_msg_ = reply;
+
+  if (reply->count < message_count_)
+  {
+    pub.publish(reply);
+  }
+}
+
+LatencyResult LatencyTest::run()
+{
+  LatencyResult r;
+  r.test_start = ros::WallTime::now();
+  r.transport = transport_;
+  r.message_size = message_size_;
+
+  ros::NodeHandle nh;
+  nh.setCallbackQueue(&queue_);
+
+  ros::Publisher pub = nh.advertise<test_roscpp::LatencyMessage>("inter_latency_perf_test", 0);
+  ros::Subscriber sub = nh.subscribe<test_roscpp::LatencyMessage>("inter_latency_perf_test_return", 0, boost::bind(&LatencyTest::callback, this, _1, boost::ref(pub)), ros::VoidConstPtr(), transportHints(transport_, message_size_));
+
+  pid_t pid = spawnPeer("latency", message_size_, transport_);
+
+  ROS_INFO("Waiting for all connections to establish");
+
+  ros::WallTime timeout = ros::WallTime::now() + ros::WallDuration(10.0);
+  while ((pub.getNumSubscribers() == 0 || sub.getNumPublishers() == 0) && ros::WallTime::now() < timeout)
+  {
+    ros::WallDuration(0.001).sleep();
+  }
+
+  if (pub.getNumSubscribers() > 0 && sub.getNumPublishers() > 0)
+  {
+    ROS_INFO("All connections established");
+
+    last_msg_.reset(new test_roscpp::LatencyMessage);
+    last_msg_->array.resize(message_size_);
+    last_msg_->publish_time = ros::WallTime::now().toSec();
+    pub.publish(last_msg_);
+    while (last_msg_->count < message_count_)
+    {
+      queue_.callAvailable(ros::WallDuration(0.1));
+    }
+  }
+  else
+  {
+    ROS_ERROR("Could not connect to the peer");
+  }
+
+  killPeer(pid);
+
+  r.test_end = ros::WallTime::now();
+  r.total_message_count = latencies_.size();
+  r.latency_avg = 0;
+  r.latency_max = 0;
+  r.latency_min = 9999999999999ULL;
+
+  double latency_total = 0.0;
+  {
+    std::vector<double>::iterator lat_it = latencies_.begin();
+    std::vector<double>::iterator lat_end = latencies_.end();
+    for (; lat_it != lat_end; ++lat_it)
+    {
+      double latency = *lat_it;
+      r.latency_min = std::min(r.latency_min, latency);
+      r.latency_max = std::max(r.latency_max, latency);
+      latency_total += latency;
+    }
+  }
+
+  if (!latencies_.empty())
+  {
+    r.latency_avg = latency_total / latencies_.size();
+  }
+
+  ROS_INFO("Done collating results");
+
+  return r;
+}
+
+LatencyResult latency(uint32_t message_count, uint32_t message_size, const std::string& transport)
+{
+  ROS_INFO_STREAM("*****************************************************");
+  ROS_INFO_STREAM("Running inter-process latency test: transport [" << transport << "], message count [" << message_count << "], message_size [" << message_size << "]");
+
+  LatencyTest t(message_count, message_size, transport);
+  return t.run();
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static void echoCallback(const test_roscpp::LatencyMessageConstPtr& msg, ros::Publisher& pub)
+{
+  ros::WallTime receipt_time = ros::WallTime::now();
+  test_roscpp::LatencyMessagePtr reply = boost::const_pointer_cast<test_roscpp::LatencyMessage>(msg);
+  reply->receipt_time = receipt_time.toSec();
+  pub.publish(reply);
+}
+
+bool isPeer(int argc, char** argv)
+{
+  return argc == 5 && std::string(argv[1]) == PEER_ARG;
+}
+
+int peer(int argc, char** argv)
+{
+  if (!isPeer(argc, argv))
+  {
+    return 1;
+  }
+
+  std::string test = argv[2];
+  uint32_t message_size = atoi(argv[3]);
+  std::string transport = argv[4];
+
+  ros::NodeHandle nh;
+  if (test == "throughput")
+  {
+    ros::Publisher pub = nh.advertise<test_roscpp::ThroughputMessage>("inter_throughput_perf_test", 1);
+    test_roscpp::ThroughputMessagePtr msg(new test_roscpp::ThroughputMessage);
+    msg->array.resize(message_size);
+
+    while (ros::ok() && pub.getNumSubscribers() == 0)
+    {
+      ros::WallDuration(0.001).sleep();
+    }
+
+    // until killed by the test
+    while (ros::ok())
+    {
+      pub.publish(msg);
+      boost::this_thread::yield();
+    }
+  }
+  else if (test == "latency")
+  {
+    ros::Publisher pub = nh.advertise<test_roscpp::LatencyMessage>("inter_latency_perf_test_return", 0);
+    ros::Subscriber sub = nh.subscribe<test_roscpp::LatencyMessage>("inter_latency_perf_test", 0, boost::bind(echoCallback, _1, boost::ref(pub)), ros::VoidConstPtr(), transportHints(transport, message_size));
+    ros::spin();
+  }
+  else
+  {
+    ROS_ERROR("Unknown inter-process test [%s]", test.c_str());
+    return 1;
+  }
+
+  return 0;
+}
+
+} // namespace inter
+} // namespace perf_roscpp
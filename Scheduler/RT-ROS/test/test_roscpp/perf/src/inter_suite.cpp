@@ -0,0 +1,153 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2009, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "perf_roscpp/inter.h"
+
+#include <ros/ros.h>
+
+#include <cstdio>
+#include <iostream>
+#include <fstream>
+#include <vector>
+
+using namespace perf_roscpp;
+using namespace std;
+
+typedef std::vector<inter::ThroughputResult> V_ThroughputResult;
+typedef std::vector<inter::LatencyResult> V_LatencyResult;
+
+void printResult(std::ostream& out, uint32_t test_num, inter::ThroughputResult& r)
+{
+  out << "----------------------------------------------------------\n";
+  out << "Inter-Process Throughput Test " << test_num << ": transport [" << r.transport << "], test_duration [" << r.test_duration << "], message_size [" << r.message_size << "]\n";
+  out << "\tMessages Received: " << r.messages_received << endl;
+  out << "\tBytes Received: " << r.total_bytes_received << endl;
+  out << "\tBytes Per Second: " << r.bytes_per_second << " (" << r.bytes_per_second / (1024.0 * 1024.0) << " MB/s)" << endl;
+}
+
+void printResult(std::ostream& out, uint32_t test_num, inter::LatencyResult& r)
+{
+  out << "----------------------------------------------------------\n";
+  out << "Inter-Process Latency Test " << test_num << ": transport [" << r.transport << "], message_size [" << r.message_size << "]\n";
+  out << "\tMessage Count: " << r.total_message_count << endl;
+  out << "\tLatency Average: " << r.latency_avg << endl;
+  out << "\tLatency Min: " << r.latency_min << endl;
+  out << "\tLatency Max: " << r.latency_max << endl;
+}
+
+void addResult(V_ThroughputResult& results, inter::ThroughputResult r, std::ostream& out, uint32_t i)
+{
+  results.push_back(r);
+  printResult(out, i, results.back());
+}
+
+void addResult(V_LatencyResult& results, inter::LatencyResult r, std::ostream& out, uint32_t i)
+{
+  results.push_back(r);
+  printResult(out, i, results.back());
+}
+
+void runThroughputTests(std::ostream& out, V_ThroughputResult& results)
+{
+  uint32_t i = 0;
+  //                                   test duration, message size , transport
+  addResult(results, inter::throughput(1            , 100          , "tcp"    ), out, i++);
+  addResult(results, inter::throughput(1            , 100          , "shm"    ), out, i++);
+  addResult(results, inter::throughput(1            , 100          , "udp"    ), out, i++);
+  addResult(results, inter::throughput(1            , 1024*1024    , "tcp"    ), out, i++);
+  addResult(results, inter::throughput(1            , 1024*1024    , "shm"    ), out, i++);
+  addResult(results, inter::throughput(1            , 1024*1024    , "udp"    ), out, i++);
+  addResult(results, inter::throughput(1            , 1024*1024*10 , "tcp"    ), out, i++);
+  addResult(results, inter::throughput(1            , 1024*1024*10 , "shm"    ), out, i++);
+}
+
+void runLatencyTests(std::ostream& out, V_LatencyResult& results)
+{
+  uint32_t i = 0;
+  //                                message count, message size , transport
+  addResult(results, inter::latency(10000        , 1            , "tcp"    ), out, i++);
+  addResult(results, inter::latency(10000        , 1            , "shm"    ), out, i++);
+  addResult(results, inter::latency(1000         , 1024*1024    , "tcp"    ), out, i++);
+  addResult(results, inter::latency(1000         , 1024*1024    , "shm"    ), out, i++);
+}
+
+int main(int argc, char** argv)
+{
+  // the other end of a test, spawned by it
+  if (inter::isPeer(argc, argv))
+  {
+    ros::init(argc, argv, "perf_roscpp_inter_peer", ros::init_options::AnonymousName|ros::init_options::NoSigintHandler|ros::init_options::NoRosout);
+    return inter::peer(argc, argv);
+  }
+
+  std::ofstream out("inter_suite_out.txt", std::ios::out);
+  out << std::fixed;
+  out.precision(10);
+  cout << std::fixed;
+  cout.precision(10);
+
+  ROS_ASSERT(out.is_open());
+
+  ros::init(argc, argv, "perf_roscpp_inter_suite", ros::init_options::NoSigintHandler|ros::init_options::NoRosout);
+  ros::NodeHandle nh;
+
+  V_ThroughputResult throughput_results;
+  runThroughputTests(out, throughput_results);
+
+  V_LatencyResult latency_results;
+  runLatencyTests(out, latency_results);
+
+  printf("\n\n\n***************************** Results *****************************\n\n");
+  uint32_t i = 0;
+  {
+    V_ThroughputResult::iterator it = throughput_results.begin();
+    V_ThroughputResult::iterator end = throughput_results.end();
+    for (; it != end; ++it, ++i)
+    {
+      inter::ThroughputResult& r = *it;
+      printResult(cout, i, r);
+    }
+  }
+
+  i = 0;
+  {
+    V_LatencyResult::iterator it = latency_results.begin();
+    V_LatencyResult::iterator end = latency_results.end();
+    for (; it != end; ++it, ++i)
+    {
+      inter::LatencyResult& r = *it;
+      printResult(cout, i, r);
+    }
+  }
+}
@@ -51,7 +51,7 @@ namespace intra
 class ThroughputTest
 {
 public:
-  ThroughputTest(double test_duration, uint32_t streams, uint32_t message_size, uint32_t sender_threads, uint32_t receiver_threads);
+  ThroughputTest(double test_duration, uint32_t streams, uint32_t message_size, uint32_t sender_threads, uint32_t receiver_threads, uint32_t queue_size);
 
   ThroughputResult run();
 
@@ -94,14 +94,16 @@ private:
   uint32_t message_size_;
   uint32_t sender_threads_;
   uint32_t receiver_threads_;
+  uint32_t queue_size_;
 };
 
-ThroughputTest::ThroughputTest(double test_duration, uint32_t streams, uint32_t message_size, uint32_t sender_threads, uint32_t receiver_threads)
+ThroughputTest::ThroughputTest(double test_duration, uint32_t streams, uint32_t message_size, uint32_t sender_threads, uint32_t receiver_threads, uint32_t queue_size)
 : test_duration_(test_duration)
 , streams_(streams)
 , message_size_(message_size)
 , sender_threads_(sender_threads)
 , receiver_threads_(receiver_threads)
+, queue_size_(queue_size)
 {
 }
 
@@ -230,7 +232,7 @@ ThroughputResult ThroughputTest::run()
   {
     std::stringstream ss;
     ss << "throughput_perf_test_" << i;
-    subs.push_back(nh.subscribe(ss.str(), 0, &ThroughputTest::callback, this, ros::TransportHints().tcpNoDelay()));
+    subs.push_back(nh.subscribe(ss.str(), queue_size_, &ThroughputTest::callback, this, ros::TransportHints().tcpNoDelay()));
   }
 
   boost::barrier sender_all_connected(sender_threads_ + 1);
@@ -276,6 +278,7 @@ ThroughputResult ThroughputTest::run()
   r.total_bytes_sent = 0;
   r.test_duration = test_duration_;
   r.streams = streams_;
+  r.queue_size = queue_size_;
 
   ros::WallTime rec_end;
   {
@@ -311,12 +314,12 @@ ThroughputResult ThroughputTest::run()
   return r;
 }
 
-ThroughputResult throughput(double test_duration, uint32_t streams, uint32_t message_size, uint32_t sender_threads, uint32_t receiver_threads)
+ThroughputResult throughput(double test_duration, uint32_t streams, uint32_t message_size, uint32_t sender_threads, uint32_t receiver_threads, uint32_t queue_size)
 {
   ROS_INFO_STREAM("*****************************************************");
-  ROS_INFO_STREAM("Running throughput test: "<< "receiver_threads [" << receiver_threads << "], sender_threads [" << sender_threads << "], streams [" << streams << "], test_duration [" << test_duration << "], message_size [" << message_size << "]");
+  ROS_INFO_STREAM("Running throughput test: "<< "receiver_threads [" << receiver_threads << "], sender_threads [" << sender_threads << "], streams [" << streams << "], test_duration [" << test_duration << "], message_size [" << message_size << "], queue_size [" << queue_size << "]");
 
-  ThroughputTest t(test_duration, streams, message_size, sender_threads, receiver_threads);
+  ThroughputTest t(test_duration, streams, message_size, sender_threads, receiver_threads, queue_size);
   return t.run();
 }
 
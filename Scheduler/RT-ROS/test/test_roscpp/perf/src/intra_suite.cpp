@@ -52,7 +52,7 @@ void printResult(std::ostream& out, uint32_t test_num, intra::ThroughputResult&
 {
 
   out << "----------------------------------------------------------\n";
-  out << "Throughput Test " << test_num << ": receiver_threads [" << r.receiver_threads << "], sender_threads [" << r.sender_threads << "], streams [" << r.streams << "], test_duration [" << r.test_duration << "], message_size [" << r.message_size << "]\n";
+  out << "Throughput Test " << test_num << ": receiver_threads [" << r.receiver_threads << "], sender_threads [" << r.sender_threads << "], streams [" << r.streams << "], test_duration [" << r.test_duration << "], message_size [" << r.message_size << "], queue_size [" << r.queue_size << "]\n";
   out << "\tMessages Sent: " << r.messages_sent << endl;
   out << "\tMessages Received: " << r.messages_received << " (" << (double)r.messages_received / (double)r.messages_sent * 100.0 << "%)" << endl;
   out << "\tBytes Sent: " << r.total_bytes_sent << endl;
@@ -110,6 +110,13 @@ void runThroughputTests(std::ostream& out, V_ThroughputResult& results)
   addResult(results, intra::throughput(10           , 1      , 1024*1024*10 , 1           , 1              ), out, i++);
   addResult(results, intra::throughput(10           , 1      , 1024*1024*100, 1           , 1              ), out, i++);
 
+  // locked deque against lock-free ring, with several threads pushing and calling
+  //                                   test duration, streams, message size , send threads, receive threads, queue size
+  addResult(results, intra::throughput(10           , 1      , 100          , 1           , 1              , 0         ), out, i++);
+  addResult(results, intra::throughput(10           , 1      , 100          , 1           , 1              , 1000      ), out, i++);
+  addResult(results, intra::throughput(10           , 1      , 100          , 4           , 4              , 0         ), out, i++);
+  addResult(results, intra::throughput(10           , 1      , 100          , 4           , 4              , 1000      ), out, i++);
+
 #if 0
   addResult(results, intra::throughput(10           , 1      , 100          , 1           , 10             ), out, i++);
   addResult(results, intra::throughput(10           , 1      , 1024*1024*10 , 1           , 10             ), out, i++);
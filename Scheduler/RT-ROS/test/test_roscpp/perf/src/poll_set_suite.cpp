@@ -0,0 +1,234 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2009, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Cost of PollSet::update() for one busy connection among many idle ones,
+ * with the epoll backend and with the poll() fallback.
+ */
+
+#include <ros/poll_set.h>
+#include <ros/time.h>
+#include <ros/assert.h>
+
+#include <boost/bind.hpp>
+
+#include <sys/socket.h>
+#include <sys/resource.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <signal.h>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <fstream>
+#include <vector>
+
+using namespace std;
+
+struct PollSetResult
+{
+  std::string backend;
+  uint32_t idle_count;
+  uint32_t message_count;
+  double update_avg;
+  double update_min;
+  double update_max;
+};
+typedef std::vector<PollSetResult> V_PollSetResult;
+
+struct HotConnection
+{
+  HotConnection()
+  : received(0)
+  {}
+
+  void onEvents(int events)
+  {
+    if (events & POLLIN)
+    {
+      char b;
+      while (read(fd, &b, 1) > 0)
+      {
+        ++received;
+      }
+    }
+  }
+
+  int fd;
+  uint32_t received;
+};
+
+void idleEvents(int)
+{
+  ROS_BREAK();
+}
+
+/**
+ * \brief Lets this process open twice the given number of sockets, plus some
+ */
+void raiseFileLimit(uint32_t idle_count)
+{
+  struct rlimit lim;
+  ROS_ASSERT(getrlimit(RLIMIT_NOFILE, &lim) == 0);
+  rlim_t needed = idle_count * 2 + 64;
+  if (lim.rlim_cur < needed)
+  {
+    lim.rlim_cur = (lim.rlim_max == RLIM_INFINITY || lim.rlim_max > needed) ? needed : lim.rlim_max;
+    ROS_ASSERT(setrlimit(RLIMIT_NOFILE, &lim) == 0);
+  }
+}
+
+PollSetResult runTest(bool use_poll, uint32_t idle_count, uint32_t message_count)
+{
+  // read by the PollSet constructor
+  if (use_poll)
+  {
+    setenv("ROSCPP_USE_POLL", "1", 1);
+  }
+  else
+  {
+    unsetenv("ROSCPP_USE_POLL");
+  }
+
+  raiseFileLimit(idle_count);
+
+  ros::PollSet poll_set;
+
+  std::vector<int> idle_fds;
+  for (uint32_t i = 0; i < idle_count; ++i)
+  {
+    int pair[2];
+    ROS_ASSERT(socketpair(AF_UNIX, SOCK_STREAM, 0, pair) == 0);
+    idle_fds.push_back(pair[0]);
+    idle_fds.push_back(pair[1]);
+    poll_set.addSocket(pair[0], idleEvents);
+    poll_set.addEvents(pair[0], POLLIN);
+  }
+
+  int hot[2];
+  ROS_ASSERT(socketpair(AF_UNIX, SOCK_STREAM, 0, hot) == 0);
+  ROS_ASSERT(fcntl(hot[0], F_SETFL, O_NONBLOCK) == 0);
+  HotConnection conn;
+  conn.fd = hot[0];
+  poll_set.addSocket(hot[0], boost::bind(&HotConnection::onEvents, &conn, _1));
+  poll_set.addEvents(hot[0], POLLIN);
+
+  // let the poll() fallback build its set before timing
+  poll_set.update(0);
+
+  PollSetResult r;
+  r.backend = use_poll ? "poll" : "epoll";
+  r.idle_count = idle_count;
+  r.message_count = message_count;
+  r.update_min = 9999999999.0;
+  r.update_max = 0.0;
+
+  double total = 0.0;
+  for (uint32_t i = 0; i < message_count; ++i)
+  {
+    char b = 0;
+    ROS_ASSERT(write(hot[1], &b, 1) == 1);
+
+    ros::WallTime start = ros::WallTime::now();
+    while (conn.received == i)
+    {
+      poll_set.update(1000);
+    }
+    double d = (ros::WallTime::now() - start).toSec();
+
+    total += d;
+    r.update_min = std::min(r.update_min, d);
+    r.update_max = std::max(r.update_max, d);
+  }
+  r.update_avg = total / message_count;
+
+  poll_set.delSocket(hot[0]);
+  ::close(hot[0]);
+  ::close(hot[1]);
+  for (size_t i = 0; i < idle_fds.size(); i += 2)
+  {
+    poll_set.delSocket(idle_fds[i]);
+    ::close(idle_fds[i]);
+    ::close(idle_fds[i + 1]);
+  }
+
+  return r;
+}
+
+void printResult(std::ostream& out, uint32_t test_num, PollSetResult& r)
+{
+  out << "----------------------------------------------------------\n";
+  out << "PollSet Test " << test_num << ": backend [" << r.backend << "], idle_connections [" << r.idle_count << "], message_count [" << r.message_count << "]\n";
+  out << "\tUpdate Average: " << r.update_avg << endl;
+  out << "\tUpdate Min: " << r.update_min << endl;
+  out << "\tUpdate Max: " << r.update_max << endl;
+}
+
+void addResult(V_PollSetResult& results, PollSetResult r, std::ostream& out, uint32_t i)
+{
+  results.push_back(r);
+  printResult(out, i, results.back());
+}
+
+int main(int argc, char** argv)
+{
+  signal(SIGPIPE, SIG_IGN);
+
+  std::ofstream out("poll_set_suite_out.txt", std::ios::out);
+  out << std::fixed;
+  out.precision(10);
+  cout << std::fixed;
+  cout.precision(10);
+
+  ROS_ASSERT(out.is_open());
+
+  V_PollSetResult results;
+  uint32_t i = 0;
+  //                           poll , idle connections, message count
+  addResult(results, runTest(false, 0               , 100000       ), out, i++);
+  addResult(results, runTest(true , 0               , 100000       ), out, i++);
+  addResult(results, runTest(false, 100             , 100000       ), out, i++);
+  addResult(results, runTest(true , 100             , 100000       ), out, i++);
+  addResult(results, runTest(false, 1000            , 100000       ), out, i++);
+  addResult(results, runTest(true , 1000            , 100000       ), out, i++);
+
+  printf("\n\n\n***************************** Results *****************************\n\n");
+  i = 0;
+  V_PollSetResult::iterator it = results.begin();
+  V_PollSetResult::iterator end = results.end();
+  for (; it != end; ++it, ++i)
+  {
+    printResult(cout, i, *it);
+  }
+}
@@ -0,0 +1,182 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2009, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Release latency of periodic wall timers, the time from when a timer was
+ * expected until its callback runs, with and without busy threads competing
+ * for the CPUs.
+ */
+
+#include <ros/timer_manager.h>
+#include <ros/callback_queue.h>
+#include <ros/time.h>
+#include <ros/assert.h>
+
+#include <boost/bind.hpp>
+#include <boost/thread.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include <fstream>
+#include <vector>
+
+using namespace std;
+
+typedef ros::TimerManager<ros::WallTime, ros::WallDuration, ros::WallTimerEvent> WallTimerManager;
+
+struct JitterResult
+{
+  double period;
+  uint32_t load_threads;
+  uint32_t release_count;
+  double latency_p50;
+  double latency_p90;
+  double latency_p99;
+  double latency_max;
+};
+typedef std::vector<JitterResult> V_JitterResult;
+
+struct Releases
+{
+  void onTimer(const ros::WallTimerEvent& event)
+  {
+    latencies.push_back((event.current_real - event.current_expected).toSec());
+  }
+
+  std::vector<double> latencies;
+};
+
+void busyLoop(volatile bool* done)
+{
+  while (!*done)
+  {
+  }
+}
+
+double percentile(const std::vector<double>& sorted, double p)
+{
+  return sorted[std::min((size_t)(sorted.size() * p), sorted.size() - 1)];
+}
+
+JitterResult runTest(double period, uint32_t load_threads, uint32_t release_count)
+{
+  volatile bool done = false;
+  boost::thread_group load;
+  for (uint32_t i = 0; i < load_threads; ++i)
+  {
+    load.create_thread(boost::bind(busyLoop, &done));
+  }
+
+  Releases releases;
+  releases.latencies.reserve(release_count);
+
+  ros::CallbackQueue queue;
+  {
+    WallTimerManager manager;
+    int32_t handle = manager.add(ros::WallDuration(period), boost::bind(&Releases::onTimer, &releases, _1), &queue, ros::VoidConstPtr(), false);
+
+    while (releases.latencies.size() < release_count)
+    {
+      queue.callAvailable(ros::WallDuration(0.1));
+    }
+
+    manager.remove(handle);
+  }
+
+  done = true;
+  load.join_all();
+
+  std::vector<double>& l = releases.latencies;
+  std::sort(l.begin(), l.end());
+
+  JitterResult r;
+  r.period = period;
+  r.load_threads = load_threads;
+  r.release_count = l.size();
+  r.latency_p50 = percentile(l, 0.5);
+  r.latency_p90 = percentile(l, 0.9);
+  r.latency_p99 = percentile(l, 0.99);
+  r.latency_max = l.back();
+
+  return r;
+}
+
+void printResult(std::ostream& out, uint32_t test_num, JitterResult& r)
+{
+  out << "----------------------------------------------------------\n";
+  out << "Timer Jitter Test " << test_num << ": period [" << r.period << "], load_threads [" << r.load_threads << "], release_count [" << r.release_count << "]\n";
+  out << "\tLatency p50: " << r.latency_p50 << endl;
+  out << "\tLatency p90: " << r.latency_p90 << endl;
+  out << "\tLatency p99: " << r.latency_p99 << endl;
+  out << "\tLatency Max: " << r.latency_max << endl;
+}
+
+void addResult(V_JitterResult& results, JitterResult r, std::ostream& out, uint32_t i)
+{
+  results.push_back(r);
+  printResult(out, i, results.back());
+}
+
+int main(int argc, char** argv)
+{
+  std::ofstream out("timer_jitter_suite_out.txt", std::ios::out);
+  out << std::fixed;
+  out.precision(10);
+  cout << std::fixed;
+  cout.precision(10);
+
+  ROS_ASSERT(out.is_open());
+
+  // one busy thread per CPU, so that the timer thread has to be scheduled in
+  uint32_t cpus = std::max(boost::thread::hardware_concurrency(), 1U);
+
+  V_JitterResult results;
+  uint32_t i = 0;
+  //                           period, load threads, release count
+  addResult(results, runTest(0.001 , 0           , 5000         ), out, i++);
+  addResult(results, runTest(0.001 , cpus        , 5000         ), out, i++);
+  addResult(results, runTest(0.01  , 0           , 1000         ), out, i++);
+  addResult(results, runTest(0.01  , cpus        , 1000         ), out, i++);
+  addResult(results, runTest(0.1   , 0           , 100          ), out, i++);
+
+  printf("\n\n\n***************************** Results *****************************\n\n");
+  i = 0;
+  V_JitterResult::iterator it = results.begin();
+  V_JitterResult::iterator end = results.end();
+  for (; it != end; ++it, ++i)
+  {
+    printResult(cout, i, *it);
+  }
+}
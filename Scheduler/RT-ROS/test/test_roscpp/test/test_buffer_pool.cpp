@@ -0,0 +1,171 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2016, Yukihiro Saito.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Test the recycling of buffers by BufferPool
+ */
+
+#include <gtest/gtest.h>
+#include "ros/buffer_pool.h"
+
+#include <boost/thread.hpp>
+#include <boost/bind.hpp>
+
+using namespace ros;
+
+TEST(BufferPool, recycleSameClass)
+{
+  BufferPoolPtr pool(new BufferPool(2, 1024 * 1024));
+
+  uint8_t* first = 0;
+  {
+    boost::shared_array<uint8_t> buffer = pool->acquire(1000);
+    first = buffer.get();
+    buffer[999] = 1;
+  }
+
+  // 1000 and 1024 bytes share a class
+  boost::shared_array<uint8_t> buffer = pool->acquire(1024);
+  EXPECT_EQ(buffer.get(), first);
+
+  BufferPool::Stats stats = pool->getStats();
+  EXPECT_EQ(stats.acquired, 2U);
+  EXPECT_EQ(stats.allocated, 1U);
+  EXPECT_EQ(stats.recycled, 1U);
+
+  // another class
+  boost::shared_array<uint8_t> other = pool->acquire(1025);
+  EXPECT_NE(other.get(), first);
+  EXPECT_EQ(pool->getStats().allocated, 2U);
+}
+
+TEST(BufferPool, heldBuffersAreNotShared)
+{
+  BufferPoolPtr pool(new BufferPool(2, 1024 * 1024));
+
+  boost::shared_array<uint8_t> a = pool->acquire(100);
+  boost::shared_array<uint8_t> a_copy = a;
+  a.reset();
+
+  // a_copy still holds it
+  boost::shared_array<uint8_t> b = pool->acquire(100);
+  EXPECT_NE(a_copy.get(), b.get());
+  EXPECT_EQ(pool->getStats().recycled, 0U);
+}
+
+TEST(BufferPool, maxCached)
+{
+  BufferPoolPtr pool(new BufferPool(2, 1024 * 1024));
+
+  {
+    boost::shared_array<uint8_t> a = pool->acquire(4096);
+    boost::shared_array<uint8_t> b = pool->acquire(4096);
+    boost::shared_array<uint8_t> c = pool->acquire(4096);
+  }
+
+  BufferPool::Stats stats = pool->getStats();
+  EXPECT_EQ(stats.allocated, 3U);
+  EXPECT_EQ(stats.freed, 1U);
+
+  boost::shared_array<uint8_t> a = pool->acquire(4096);
+  boost::shared_array<uint8_t> b = pool->acquire(4096);
+  boost::shared_array<uint8_t> c = pool->acquire(4096);
+  stats = pool->getStats();
+  EXPECT_EQ(stats.allocated, 4U);
+  EXPECT_EQ(stats.recycled, 2U);
+}
+
+TEST(BufferPool, oversized)
+{
+  BufferPoolPtr pool(new BufferPool(2, 1024));
+
+  {
+    boost::shared_array<uint8_t> buffer = pool->acquire(2048);
+  }
+  boost::shared_array<uint8_t> buffer = pool->acquire(2048);
+
+  BufferPool::Stats stats = pool->getStats();
+  EXPECT_EQ(stats.allocated, 2U);
+  EXPECT_EQ(stats.recycled, 0U);
+}
+
+TEST(BufferPool, outlivesPool)
+{
+  boost::shared_array<uint8_t> buffer;
+  {
+    BufferPoolPtr pool(new BufferPool(2, 1024 * 1024));
+    buffer = pool->acquire(100000);
+  }
+
+  // released after the pool is gone
+  buffer[99999] = 1;
+  buffer.reset();
+}
+
+void acquireThread(const BufferPoolPtr& pool, boost::barrier* barrier)
+{
+  barrier->wait();
+
+  for (int i = 0; i < 10000; ++i)
+  {
+    boost::shared_array<uint8_t> buffer = pool->acquire(64 + i % 4096);
+    buffer[0] = 1;
+  }
+}
+
+TEST(BufferPool, multiThread)
+{
+  BufferPoolPtr pool(new BufferPool(4, 1024 * 1024));
+
+  const int thread_count = 10;
+  boost::barrier barrier(thread_count);
+  boost::thread_group tg;
+  for (int i = 0; i < thread_count; ++i)
+  {
+    tg.create_thread(boost::bind(acquireThread, pool, &barrier));
+  }
+  tg.join_all();
+
+  // 7 classes, from 64 to 4096 bytes, keep at most 4 buffers each
+  BufferPool::Stats stats = pool->getStats();
+  EXPECT_EQ(stats.acquired, 100000U);
+  EXPECT_EQ(stats.allocated + stats.recycled, stats.acquired);
+  EXPECT_LE(stats.allocated - stats.freed, 4U * 7U);
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -43,6 +43,9 @@
 #include <boost/thread.hpp>
 #include <boost/function.hpp>
 
+#include <algorithm>
+#include <vector>
+
 using namespace ros;
 
 class CountingCallback : public CallbackInterface
@@ -116,6 +119,154 @@ TEST(CallbackQueue, multipleCallbacksCallOne)
   }
 }
 
+class SchedCallback : public CallbackInterface
+{
+public:
+  SchedCallback(std::vector<int>* calls, int id, int32_t priority, double deadline, double run_time = 0.0)
+  : calls(calls)
+  , id(id)
+  , run_time(run_time)
+  {
+    param.priority = priority;
+    param.deadline = WallDuration(deadline);
+  }
+
+  virtual CallResult call()
+  {
+    calls->push_back(id);
+    return Success;
+  }
+
+  virtual CallbackSchedParam getSchedParam()
+  {
+    return param;
+  }
+
+  std::vector<int>* calls;
+  int id;
+  CallbackSchedParam param;
+  double run_time;
+};
+typedef boost::shared_ptr<SchedCallback> SchedCallbackPtr;
+
+TEST(CallbackQueue, fifoIgnoresSchedParam)
+{
+  std::vector<int> calls;
+  CallbackQueue queue;
+  queue.addCallback(SchedCallbackPtr(new SchedCallback(&calls, 0, 1, 3.0)));
+  queue.addCallback(SchedCallbackPtr(new SchedCallback(&calls, 1, 3, 1.0)));
+  queue.addCallback(SchedCallbackPtr(new SchedCallback(&calls, 2, 2, 2.0)));
+  queue.callAvailable();
+
+  ASSERT_EQ(calls.size(), 3U);
+  EXPECT_EQ(calls[0], 0);
+  EXPECT_EQ(calls[1], 1);
+  EXPECT_EQ(calls[2], 2);
+}
+
+TEST(CallbackQueue, byPriority)
+{
+  std::vector<int> calls;
+  CallbackQueue queue(true, CallbackQueue::ByPriority);
+  queue.addCallback(SchedCallbackPtr(new SchedCallback(&calls, 0, 1, 0.0)));
+  queue.addCallback(SchedCallbackPtr(new SchedCallback(&calls, 1, 3, 0.0)));
+  queue.addCallback(SchedCallbackPtr(new SchedCallback(&calls, 2, 2, 5.0)));
+  queue.addCallback(SchedCallbackPtr(new SchedCallback(&calls, 3, 2, 1.0)));
+  queue.addCallback(SchedCallbackPtr(new SchedCallback(&calls, 4, 1, 0.0)));
+
+  for (uint32_t i = 0; i < 5; ++i)
+  {
+    queue.callOne();
+  }
+
+  ASSERT_EQ(calls.size(), 5U);
+  EXPECT_EQ(calls[0], 1);
+  // equal priorities are called by deadline, and then in FIFO order
+  EXPECT_EQ(calls[1], 3);
+  EXPECT_EQ(calls[2], 2);
+  EXPECT_EQ(calls[3], 0);
+  EXPECT_EQ(calls[4], 4);
+}
+
+TEST(CallbackQueue, byDeadline)
+{
+  std::vector<int> calls;
+  CallbackQueue queue(true, CallbackQueue::ByDeadline);
+  queue.addCallback(SchedCallbackPtr(new SchedCallback(&calls, 0, 9, 0.0)));
+  queue.addCallback(SchedCallbackPtr(new SchedCallback(&calls, 1, 0, 10.0)));
+  queue.addCallback(SchedCallbackPtr(new SchedCallback(&calls, 2, 0, 1.0)));
+  queue.addCallback(SchedCallbackPtr(new SchedCallback(&calls, 3, 5, 5.0)));
+  queue.callAvailable();
+
+  ASSERT_EQ(calls.size(), 4U);
+  EXPECT_EQ(calls[0], 2);
+  EXPECT_EQ(calls[1], 3);
+  EXPECT_EQ(calls[2], 1);
+  // no deadline goes last, whatever its priority
+  EXPECT_EQ(calls[3], 0);
+}
+
+TEST(CallbackQueue, byDeadlineRemove)
+{
+  std::vector<int> calls;
+  CallbackQueue queue(true, CallbackQueue::ByDeadline);
+  for (int i = 0; i < 100; ++i)
+  {
+    queue.addCallback(SchedCallbackPtr(new SchedCallback(&calls, i, 0, 100.0 - i)), i % 2);
+  }
+  queue.removeByID(1);
+
+  while (!queue.isEmpty())
+  {
+    queue.callOne();
+  }
+
+  ASSERT_EQ(calls.size(), 50U);
+  for (int i = 0; i < 50; ++i)
+  {
+    EXPECT_EQ(calls[i], 98 - i * 2);
+  }
+}
+
+// Mixes short jobs with tight deadlines into a backlog of long jobs with loose ones, and sums up how late
+// each job finishes when the queue runs them back to back
+double maxLateness(CallbackQueue::Order order)
+{
+  std::vector<int> calls;
+  std::vector<SchedCallbackPtr> cbs;
+  CallbackQueue queue(true, order);
+  for (int i = 0; i < 20; ++i)
+  {
+    if (i % 4 == 3)
+    {
+      cbs.push_back(SchedCallbackPtr(new SchedCallback(&calls, i, 0, 0.01, 0.001)));
+    }
+    else
+    {
+      cbs.push_back(SchedCallbackPtr(new SchedCallback(&calls, i, 0, 1.0, 0.01)));
+    }
+    queue.addCallback(cbs.back());
+  }
+  queue.callAvailable();
+
+  double now = 0.0;
+  double max_lateness = 0.0;
+  for (size_t i = 0; i < calls.size(); ++i)
+  {
+    SchedCallback& cb = *cbs[calls[i]];
+    now += cb.run_time;
+    max_lateness = std::max(max_lateness, now - cb.param.deadline.toSec());
+  }
+
+  return max_lateness;
+}
+
+TEST(CallbackQueue, byDeadlineLateness)
+{
+  EXPECT_GT(maxLateness(CallbackQueue::FIFO), 0.1);
+  EXPECT_LE(maxLateness(CallbackQueue::ByDeadline), 0.0);
+}
+
 TEST(CallbackQueue, remove)
 {
   CountingCallbackPtr cb1(new CountingCallback);
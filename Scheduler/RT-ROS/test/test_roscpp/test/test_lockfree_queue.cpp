@@ -0,0 +1,202 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2016, Yukihiro Saito.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Test the lock-free ring behind bounded SubscriptionQueues
+ */
+
+#include <gtest/gtest.h>
+#include "ros/lockfree_queue.h"
+
+#include <boost/shared_ptr.hpp>
+#include <boost/thread.hpp>
+#include <boost/bind.hpp>
+
+#include <vector>
+
+using namespace ros;
+
+typedef boost::shared_ptr<uint32_t> UIntPtr;
+
+TEST(LockFreeQueue, capacityRoundsUp)
+{
+  EXPECT_EQ(LockFreeQueue<UIntPtr>(1).capacity(), 1U);
+  EXPECT_EQ(LockFreeQueue<UIntPtr>(3).capacity(), 4U);
+  EXPECT_EQ(LockFreeQueue<UIntPtr>(1000).capacity(), 1024U);
+}
+
+TEST(LockFreeQueue, fifo)
+{
+  LockFreeQueue<UIntPtr> queue(4);
+  for (uint32_t i = 0; i < 4; ++i)
+  {
+    UIntPtr item(new uint32_t(i));
+    ASSERT_TRUE(queue.push(item));
+    // swapped in, not copied
+    EXPECT_FALSE(item);
+  }
+  EXPECT_EQ(queue.size(), 4U);
+
+  UIntPtr extra(new uint32_t(4));
+  EXPECT_FALSE(queue.push(extra));
+  EXPECT_TRUE(extra);
+
+  // go around the ring a few times
+  for (uint32_t i = 0; i < 100; ++i)
+  {
+    UIntPtr item;
+    ASSERT_TRUE(queue.pop(item));
+    ASSERT_TRUE(item);
+    EXPECT_EQ(*item, i);
+
+    item.reset(new uint32_t(i + 4));
+    ASSERT_TRUE(queue.push(item));
+  }
+
+  UIntPtr item;
+  for (uint32_t i = 0; i < 4; ++i)
+  {
+    ASSERT_TRUE(queue.pop(item));
+  }
+  EXPECT_FALSE(queue.pop(item));
+  EXPECT_TRUE(queue.empty());
+}
+
+TEST(LockFreeQueue, popReleasesItems)
+{
+  LockFreeQueue<UIntPtr> queue(2);
+  UIntPtr tracked(new uint32_t(0));
+
+  UIntPtr item = tracked;
+  queue.push(item);
+  EXPECT_EQ(tracked.use_count(), 2);
+
+  // the previous value of item is released, and the slot keeps no reference
+  item = tracked;
+  queue.pop(item);
+  EXPECT_EQ(tracked.use_count(), 2);
+  item.reset();
+  EXPECT_EQ(tracked.use_count(), 1);
+}
+
+void pushThread(LockFreeQueue<UIntPtr>* queue, uint32_t producer, uint32_t count)
+{
+  for (uint32_t i = 0; i < count; ++i)
+  {
+    UIntPtr item(new uint32_t(producer << 24 | i));
+    while (!queue->push(item))
+    {
+      boost::this_thread::yield();
+    }
+  }
+}
+
+void popThread(LockFreeQueue<UIntPtr>* queue, uint32_t total, volatile uint32_t* popped,
+               std::vector<uint32_t>* last, bool* in_order)
+{
+  UIntPtr item;
+  while (*popped < total)
+  {
+    if (!queue->pop(item))
+    {
+      boost::this_thread::yield();
+      continue;
+    }
+
+    __sync_fetch_and_add(popped, 1);
+
+    // with a single consumer, each producer's items come out in order
+    if (last)
+    {
+      uint32_t producer = *item >> 24;
+      uint32_t seq = *item & 0xffffff;
+      if (seq != (*last)[producer])
+      {
+        *in_order = false;
+      }
+      (*last)[producer] = seq + 1;
+    }
+  }
+}
+
+TEST(LockFreeQueue, multipleProducersSingleConsumer)
+{
+  const uint32_t producers = 4;
+  const uint32_t count = 100000;
+  LockFreeQueue<UIntPtr> queue(16);
+
+  volatile uint32_t popped = 0;
+  std::vector<uint32_t> last(producers, 0);
+  bool in_order = true;
+
+  boost::thread_group tg;
+  for (uint32_t i = 0; i < producers; ++i)
+  {
+    tg.create_thread(boost::bind(pushThread, &queue, i, count));
+  }
+  boost::thread consumer(boost::bind(popThread, &queue, producers * count, &popped, &last, &in_order));
+  tg.join_all();
+  consumer.join();
+
+  EXPECT_EQ(popped, producers * count);
+  EXPECT_TRUE(in_order);
+  EXPECT_TRUE(queue.empty());
+}
+
+TEST(LockFreeQueue, multipleProducersMultipleConsumers)
+{
+  const uint32_t threads = 4;
+  const uint32_t count = 100000;
+  LockFreeQueue<UIntPtr> queue(16);
+
+  volatile uint32_t popped = 0;
+  bool in_order = true;
+
+  boost::thread_group tg;
+  for (uint32_t i = 0; i < threads; ++i)
+  {
+    tg.create_thread(boost::bind(pushThread, &queue, i, count));
+    tg.create_thread(boost::bind(popThread, &queue, threads * count, &popped, (std::vector<uint32_t>*)0, &in_order));
+  }
+  tg.join_all();
+
+  EXPECT_EQ(popped, threads * count);
+  EXPECT_TRUE(queue.empty());
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -372,6 +372,91 @@ TEST_F(Poller, updateWhileAddDel)
   ASSERT_TRUE(sh2.bytes_written_ > 0);
 }
 
+class IdleSockets
+{
+public:
+  IdleSockets(PollSet* ps, int count)
+  : ps_(ps)
+  {
+    for (int i = 0; i < count; ++i)
+    {
+      int pair[2];
+      if (socketpair(AF_UNIX, SOCK_STREAM, 0, pair) != 0)
+      {
+        break;
+      }
+      fcntl(pair[0], F_SETFL, O_NONBLOCK);
+      helpers_.push_back(boost::shared_ptr<SocketHelper>(new SocketHelper(pair[0])));
+      peers_.push_back(pair[1]);
+      ps_->addSocket(pair[0], boost::bind(&SocketHelper::processEvents, helpers_.back().get(), _1));
+      ps_->addEvents(pair[0], POLLIN);
+    }
+  }
+
+  ~IdleSockets()
+  {
+    for (size_t i = 0; i < helpers_.size(); ++i)
+    {
+      ps_->delSocket(helpers_[i]->socket_);
+      ::close(helpers_[i]->socket_);
+      ::close(peers_[i]);
+    }
+  }
+
+  PollSet* ps_;
+  std::vector<boost::shared_ptr<SocketHelper> > helpers_;
+  std::vector<int> peers_;
+};
+
+TEST_F(Poller, idleSockets)
+{
+  IdleSockets idle(&poll_set_, 100);
+  ASSERT_EQ(idle.helpers_.size(), 100U);
+
+  SocketHelper sh(sockets_[0]);
+  poll_set_.addSocket(sh.socket_, boost::bind(&SocketHelper::processEvents, &sh, _1));
+  poll_set_.addEvents(sh.socket_, POLLIN);
+
+  for (int i = 0; i < 10; ++i)
+  {
+    char b = 0;
+    ASSERT_EQ(write(sockets_[1], &b, 1), 1);
+    poll_set_.update(1);
+    ASSERT_EQ(sh.bytes_read_, i + 1);
+  }
+
+  // only the socket with data has been serviced
+  for (size_t i = 0; i < idle.helpers_.size(); ++i)
+  {
+    ASSERT_EQ(idle.helpers_[i]->bytes_read_, 0);
+  }
+
+  poll_set_.delSocket(sh.socket_);
+}
+
+TEST_F(Poller, manyReadySockets)
+{
+  // more sockets ready at once than a single wait returns
+  IdleSockets ready(&poll_set_, 200);
+  ASSERT_EQ(ready.helpers_.size(), 200U);
+
+  for (size_t i = 0; i < ready.peers_.size(); ++i)
+  {
+    char b = 0;
+    ASSERT_EQ(write(ready.peers_[i], &b, 1), 1);
+  }
+
+  for (int i = 0; i < 10; ++i)
+  {
+    poll_set_.update(1);
+  }
+
+  for (size_t i = 0; i < ready.helpers_.size(); ++i)
+  {
+    ASSERT_EQ(ready.helpers_[i]->bytes_read_, 1);
+  }
+}
+
 TEST_F(Poller, signal)
 {
   // first one clears out any calls to signal() caused by construction
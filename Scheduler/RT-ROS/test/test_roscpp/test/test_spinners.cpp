@@ -46,7 +46,12 @@
 #include "ros/spinner.h"
 #include "ros/init.h"
 #include "ros/node_handle.h"
+#include "ros/callback_queue.h"
+#include "ros_rosch/publish_counter.h"
+#include <std_msgs/Empty.h>
 #include <boost/thread.hpp>
+#include <pthread.h>
+#include <sched.h>
 
 using namespace ros;
 
@@ -140,6 +145,175 @@ TEST(Spinners, asyncfail)
   ros::waitForShutdown();
 }
 
+TEST(Spinners, sched)
+{
+  DOIT();
+  SchedSpinner s;
+  ros::spin(s);
+}
+
+TEST(Spinners, schedfail)
+{
+  DOIT();
+  boost::thread th(boost::bind(&ros::spin));
+  SchedSpinner s;
+  ros::spin(s);
+}
+
+/*
+ * The sched* tests below replace the spinner_threads of the ROSCH
+ * configuration after ros::init(), before anything looks them up.  The
+ * threads are read once per process, so these too have to be run one at
+ * a time.
+ */
+
+struct ThreadRecord
+{
+  boost::thread::id id;
+  int policy;
+  cpu_set_t cpus;
+  int count;
+};
+
+ThreadRecord recordThread()
+{
+  ThreadRecord r;
+  struct sched_param sp;
+  r.id = boost::this_thread::get_id();
+  pthread_getschedparam(pthread_self(), &r.policy, &sp);
+  pthread_getaffinity_np(pthread_self(), sizeof(r.cpus), &r.cpus);
+  r.count = 0;
+  return r;
+}
+
+/* count the calls, and fail if they come from more than one thread */
+void record(ThreadRecord& r)
+{
+  ThreadRecord now = recordThread();
+  if (r.count > 0)
+  {
+    EXPECT_EQ(r.id, now.id);
+  }
+  now.count = r.count + 1;
+  r = now;
+}
+
+ThreadRecord g_topic_calls;
+ThreadRecord g_queue_calls;
+Publisher g_pub;
+
+void topicCallback(const std_msgs::Empty::ConstPtr&)
+{
+  record(g_topic_calls);
+}
+
+void queueCallback(const ros::WallTimerEvent&)
+{
+  record(g_queue_calls);
+  g_pub.publish(std_msgs::Empty());
+}
+
+void setSchedThreads(const std::vector<ThreadInfo>& v_thread_info)
+{
+  rosch::SingletonSchedNodeManager& manager(rosch::SingletonSchedNodeManager::getInstance());
+  NodeInfo node_info(manager.getNodeInfo());
+  node_info.v_thread_info = v_thread_info;
+  manager.setNodeInfo(node_info);
+}
+
+ThreadInfo schedThread(int policy, const std::string& topic)
+{
+  ThreadInfo thread_info;
+  thread_info.policy = policy;
+  thread_info.priority = 0;
+  if (!topic.empty())
+  {
+    thread_info.v_topic.push_back(topic);
+  }
+  return thread_info;
+}
+
+/* Run a SchedSpinner on queue for two seconds, with a timer on queue
+ * publishing to /sched_topic, which node handles without a queue of
+ * their own subscribe to. */
+void spinSched(CallbackQueue& queue)
+{
+  NodeHandle nh;
+  NodeHandle queue_nh;
+  queue_nh.setCallbackQueue(&queue);
+
+  g_pub = nh.advertise<std_msgs::Empty>("sched_topic", 10);
+  Subscriber sub = nh.subscribe("sched_topic", 10, topicCallback);
+  ros::WallTimer pub_timer = queue_nh.createWallTimer(ros::WallDuration(0.1), &queueCallback);
+  ros::WallTimer shutdown_timer = queue_nh.createWallTimer(ros::WallDuration(2.0), &fire_shutdown);
+
+  SchedSpinner s;
+  s.spin(&queue);
+  g_pub.shutdown();
+}
+
+TEST(Spinners, schedqueues)
+{
+  ros::init(argc_, argv_, "test_spinners");
+
+  std::vector<ThreadInfo> v_thread_info;
+  v_thread_info.push_back(schedThread(SCHED_OTHER, "/sched_topic"));
+  v_thread_info.push_back(schedThread(SCHED_OTHER, ""));
+  setSchedThreads(v_thread_info);
+
+  CallbackQueue* sched_queue = getSchedCallbackQueue("/sched_topic");
+  ASSERT_TRUE(sched_queue != NULL);
+  EXPECT_NE(sched_queue, getGlobalCallbackQueue());
+  EXPECT_EQ(sched_queue, getSchedCallbackQueue("/sched_topic"));
+  EXPECT_TRUE(getSchedCallbackQueue("/other_topic") == NULL);
+  // topics are matched resolved
+  EXPECT_TRUE(getSchedCallbackQueue("sched_topic") == NULL);
+
+  CallbackQueue queue;
+  spinSched(queue);
+
+  // the topic is called from the thread listing it, the queue given from the other one
+  EXPECT_GT(g_topic_calls.count, 0);
+  EXPECT_GT(g_queue_calls.count, 0);
+  EXPECT_NE(g_topic_calls.id, g_queue_calls.id);
+  EXPECT_NE(g_topic_calls.id, boost::this_thread::get_id());
+  EXPECT_NE(g_queue_calls.id, boost::this_thread::get_id());
+}
+
+TEST(Spinners, schedattributes)
+{
+  ros::init(argc_, argv_, "test_spinners");
+
+  // SCHED_BATCH needs no privilege, unlike SCHED_FIFO and SCHED_RR
+  std::vector<ThreadInfo> v_thread_info;
+  v_thread_info.push_back(schedThread(SCHED_BATCH, "/sched_topic"));
+  v_thread_info.back().v_core.push_back(0);
+  v_thread_info.push_back(schedThread(SCHED_OTHER, ""));
+  setSchedThreads(v_thread_info);
+
+  ThreadRecord before = recordThread();
+  CallbackQueue queue;
+  spinSched(queue);
+  ThreadRecord after = recordThread();
+
+  ASSERT_GT(g_topic_calls.count, 0);
+  ASSERT_GT(g_queue_calls.count, 0);
+
+  // the thread with cores and a policy gets them
+  cpu_set_t core0;
+  CPU_ZERO(&core0);
+  CPU_SET(0, &core0);
+  EXPECT_EQ(SCHED_BATCH, g_topic_calls.policy);
+  EXPECT_TRUE(CPU_EQUAL(&core0, &g_topic_calls.cpus));
+
+  // the thread without cores keeps those of the node
+  EXPECT_EQ(SCHED_OTHER, g_queue_calls.policy);
+  EXPECT_TRUE(CPU_EQUAL(&before.cpus, &g_queue_calls.cpus));
+
+  // and the thread which called spin() is left alone
+  EXPECT_EQ(before.policy, after.policy);
+  EXPECT_TRUE(CPU_EQUAL(&before.cpus, &after.cpus));
+}
 
 int
 main(int argc, char** argv)
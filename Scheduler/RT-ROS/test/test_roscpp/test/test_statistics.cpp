@@ -0,0 +1,127 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2016, Yukihiro Saito.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Test the running aggregates behind StatisticsLogger
+ */
+
+#include <gtest/gtest.h>
+#include "ros/statistics.h"
+
+#include <cmath>
+#include <vector>
+
+using namespace ros;
+
+TEST(StatisticsMoments, empty)
+{
+  StatisticsMoments moments;
+  EXPECT_EQ(moments.count, 0U);
+  EXPECT_EQ(moments.mean, 0.0);
+  EXPECT_EQ(moments.stddev(), 0.0);
+  EXPECT_EQ(moments.max, 0.0);
+}
+
+TEST(StatisticsMoments, matchesTwoPasses)
+{
+  std::vector<double> samples;
+  for (int i = 0; i < 1000; ++i)
+  {
+    // periods around 10ms, with jitter
+    samples.push_back(0.01 + 0.001 * std::sin(i * 0.7) + 0.0001 * (i % 7));
+  }
+
+  StatisticsMoments moments;
+  double sum = 0.0;
+  double max = 0.0;
+  for (size_t i = 0; i < samples.size(); ++i)
+  {
+    moments.add(samples[i]);
+    sum += samples[i];
+    max = std::max(max, samples[i]);
+  }
+
+  double mean = sum / samples.size();
+  double variance = 0.0;
+  for (size_t i = 0; i < samples.size(); ++i)
+  {
+    variance += (samples[i] - mean) * (samples[i] - mean);
+  }
+  double stddev = std::sqrt(variance / samples.size());
+
+  EXPECT_EQ(moments.count, samples.size());
+  EXPECT_NEAR(moments.mean, mean, 1e-12);
+  EXPECT_NEAR(moments.stddev(), stddev, 1e-12);
+  EXPECT_EQ(moments.max, max);
+}
+
+TEST(StatisticsMoments, negativeMax)
+{
+  // ages are negative when the clocks of publisher and subscriber disagree
+  StatisticsMoments moments;
+  moments.add(-0.5);
+  moments.add(-0.2);
+  EXPECT_EQ(moments.max, -0.2);
+  EXPECT_EQ(moments.histogram[0], 2U);
+}
+
+TEST(StatisticsMoments, histogramBuckets)
+{
+  EXPECT_EQ(StatisticsMoments::getBucket(0.0), 0);
+  EXPECT_EQ(StatisticsMoments::getBucket(0.5e-6), 0);
+  EXPECT_EQ(StatisticsMoments::getBucket(1e-6), 1);
+  EXPECT_EQ(StatisticsMoments::getBucket(1.9e-6), 1);
+  EXPECT_EQ(StatisticsMoments::getBucket(2e-6), 2);
+  EXPECT_EQ(StatisticsMoments::getBucket(1e-3), 10);
+  EXPECT_EQ(StatisticsMoments::getBucket(1.0), 20);
+  EXPECT_EQ(StatisticsMoments::getBucket(3600.0), StatisticsMoments::HISTOGRAM_SIZE - 1);
+
+  StatisticsMoments moments;
+  moments.add(1e-3);
+  moments.add(1.5e-3);
+  moments.add(1.0);
+  EXPECT_EQ(moments.histogram[10], 1U);
+  EXPECT_EQ(moments.histogram[11], 1U);
+  EXPECT_EQ(moments.histogram[20], 1U);
+
+  moments.reset();
+  EXPECT_EQ(moments.count, 0U);
+  EXPECT_EQ(moments.histogram[10], 0U);
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
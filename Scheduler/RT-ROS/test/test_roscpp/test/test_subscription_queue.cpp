@@ -43,6 +43,9 @@
 #include <boost/shared_array.hpp>
 #include <boost/bind.hpp>
 #include <boost/thread.hpp>
+#include <boost/detail/atomic_count.hpp>
+
+#include <vector>
 
 using namespace ros;
 
@@ -280,6 +283,83 @@ TEST(SubscriptionQueue, nonConcurrentOrdering)
   ASSERT_EQ(helper->calls_, 2);
 }
 
+TEST(SubscriptionQueue, dropOldest)
+{
+  SubscriptionQueue queue("blah", 3, false);
+
+  std::vector<FakeSubHelperPtr> helpers;
+  for (int i = 0; i < 5; ++i)
+  {
+    FakeSubHelperPtr helper(new FakeSubHelper);
+    MessageDeserializerPtr des(new MessageDeserializer(helper, SerializedMessage(), boost::shared_ptr<M_string>()));
+    helpers.push_back(helper);
+
+    bool was_full = true;
+    queue.push(helper, des, false, VoidConstWPtr(), true, ros::Time(), &was_full);
+    ASSERT_EQ(was_full, i >= 3);
+  }
+
+  ASSERT_TRUE(queue.full());
+
+  for (int i = 0; i < 3; ++i)
+  {
+    ASSERT_EQ(queue.call(), CallbackInterface::Success);
+  }
+  ASSERT_EQ(queue.call(), CallbackInterface::Invalid);
+
+  // the two oldest messages were discarded
+  ASSERT_EQ(helpers[0]->calls_, 0);
+  ASSERT_EQ(helpers[1]->calls_, 0);
+  ASSERT_EQ(helpers[2]->calls_, 1);
+  ASSERT_EQ(helpers[3]->calls_, 1);
+  ASSERT_EQ(helpers[4]->calls_, 1);
+}
+
+void pushThread(SubscriptionQueue& queue, const FakeSubHelperPtr& helper, const MessageDeserializerPtr& des,
+                int count, boost::detail::atomic_count* dropped)
+{
+  for (int i = 0; i < count; ++i)
+  {
+    bool was_full = false;
+    queue.push(helper, des, false, VoidConstWPtr(), true, ros::Time(), &was_full);
+    if (was_full)
+    {
+      ++*dropped;
+    }
+  }
+}
+
+TEST(SubscriptionQueue, concurrentPushAndCall)
+{
+  SubscriptionQueue queue("blah", 10, true);
+  FakeSubHelperPtr helper(new FakeSubHelper);
+  MessageDeserializerPtr des(new MessageDeserializer(helper, SerializedMessage(), boost::shared_ptr<M_string>()));
+
+  const int threads = 4;
+  const int count = 10000;
+  boost::detail::atomic_count dropped(0);
+  boost::thread_group tg;
+  for (int i = 0; i < threads; ++i)
+  {
+    tg.create_thread(boost::bind(pushThread, boost::ref(queue), helper, des, count, &dropped));
+  }
+
+  int calls = 0;
+  while (calls + dropped < threads * count)
+  {
+    if (queue.call() == CallbackInterface::Success)
+    {
+      ++calls;
+    }
+  }
+  tg.join_all();
+
+  // every message was either called or reported as discarded
+  ASSERT_EQ(queue.call(), CallbackInterface::Invalid);
+  ASSERT_EQ(helper->calls_, calls);
+  ASSERT_EQ(calls + dropped, threads * count);
+}
+
 int main(int argc, char** argv)
 {
   testing::InitGoogleTest(&argc, argv);
@@ -118,6 +118,28 @@ TEST_F(Synchronous, writeThenReadPartial)
   ASSERT_STREQ((const char*)buf, msg.substr(0, 1).c_str());
 }
 
+TEST_F(Synchronous, writevThenRead)
+{
+  std::string len = "4";
+  std::string empty = "";
+  std::string msg = "test";
+  TransportBuffer buffers[3];
+  buffers[0].data = (uint8_t*)len.c_str();
+  buffers[0].size = len.length();
+  buffers[1].data = (uint8_t*)empty.c_str();
+  buffers[1].size = 0;
+  buffers[2].data = (uint8_t*)msg.c_str();
+  buffers[2].size = msg.length();
+  int32_t written = transports_[1]->writev(buffers, 3);
+  ASSERT_EQ(written, (int32_t)(len.length() + msg.length()));
+
+  uint8_t buf[6];
+  memset(buf, 0, sizeof(buf));
+  int32_t read = transports_[2]->read(buf, len.length() + msg.length());
+  ASSERT_EQ(read, (int32_t)(len.length() + msg.length()));
+  ASSERT_STREQ((const char*)buf, (len + msg).c_str());
+}
+
 void readThread(TransportTCPPtr transport, uint8_t* buf, uint32_t size, volatile int32_t* read_out, volatile bool* done_read)
 {
   while (*read_out < (int32_t)size)
@@ -182,6 +204,18 @@ TEST_F(Synchronous, writeAfterClose)
   ASSERT_EQ(written, -1);
 }
 
+TEST_F(Synchronous, writevAfterClose)
+{
+  transports_[1]->close();
+
+  std::string msg = "test";
+  TransportBuffer buffer;
+  buffer.data = (uint8_t*)msg.c_str();
+  buffer.size = msg.length();
+  int32_t written = transports_[1]->writev(&buffer, 1);
+  ASSERT_EQ(written, -1);
+}
+
 class Polled : public testing::Test
 {
 public:
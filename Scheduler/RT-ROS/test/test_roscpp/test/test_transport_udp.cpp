@@ -0,0 +1,235 @@
+/*
+ * Copyright (c) 2008, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * TransportUDP over the loopback interface
+ */
+
+#include <gtest/gtest.h>
+#include "ros/poll_set.h"
+#include "ros/transport/transport_udp.h"
+
+#include <boost/thread.hpp>
+
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+using namespace ros;
+
+class Loopback : public testing::Test
+{
+protected:
+
+  virtual void SetUp()
+  {
+    receiver_ = TransportUDPPtr(new TransportUDP(&poll_set_));
+    if (!receiver_->createIncoming(0, false))
+    {
+      FAIL();
+    }
+
+    sender_ = TransportUDPPtr(new TransportUDP(&poll_set_));
+    if (!sender_->connect("127.0.0.1", receiver_->getServerPort(), 1))
+    {
+      FAIL();
+    }
+
+    // datagrams made by hand, to lose and reorder them
+    raw_ = socket(AF_INET, SOCK_DGRAM, 0);
+    sockaddr_in sin;
+    memset(&sin, 0, sizeof(sin));
+    sin.sin_family = AF_INET;
+    sin.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    sin.sin_port = htons(receiver_->getServerPort());
+    ASSERT_EQ(::connect(raw_, (sockaddr*)&sin, sizeof(sin)), 0);
+  }
+
+  virtual void TearDown()
+  {
+    receiver_->close();
+    sender_->close();
+    ::close(raw_);
+  }
+
+  void sendRaw(uint8_t op, uint8_t message_id, uint16_t block, const std::string& payload)
+  {
+    TransportUDPHeader header;
+    header.connection_id_ = 1;
+    header.op_ = op;
+    header.message_id_ = message_id;
+    header.block_ = block;
+
+    struct iovec iov[2];
+    iov[0].iov_base = &header;
+    iov[0].iov_len = sizeof(header);
+    iov[1].iov_base = (void*)payload.data();
+    iov[1].iov_len = payload.size();
+    ASSERT_EQ(writev(raw_, iov, 2), (ssize_t)(sizeof(header) + payload.size()));
+  }
+
+  // the receiving socket is non-blocking
+  int32_t readMessage(uint8_t* buffer, uint32_t size)
+  {
+    for (int i = 0; i < 1000; ++i)
+    {
+      int32_t read = receiver_->read(buffer, size);
+      if (read != 0)
+      {
+        return read;
+      }
+
+      boost::this_thread::sleep(boost::posix_time::milliseconds(1));
+    }
+
+    return 0;
+  }
+
+  PollSet poll_set_;
+  TransportUDPPtr receiver_;
+  TransportUDPPtr sender_;
+  int raw_;
+};
+
+TEST_F(Loopback, writeThenRead)
+{
+  std::string msg = "test";
+  int32_t written = sender_->write((uint8_t*)msg.c_str(), msg.length());
+  ASSERT_EQ(written, (int32_t)msg.length());
+
+  uint8_t buf[5];
+  memset(buf, 0, sizeof(buf));
+  int32_t read = readMessage(buf, msg.length());
+  ASSERT_EQ(read, (int32_t)msg.length());
+  ASSERT_STREQ((const char*)buf, msg.c_str());
+}
+
+TEST_F(Loopback, readsStopAtMessageEnd)
+{
+  std::string msg1 = "first";
+  std::string msg2 = "second";
+  ASSERT_EQ(sender_->write((uint8_t*)msg1.c_str(), msg1.length()), (int32_t)msg1.length());
+  ASSERT_EQ(sender_->write((uint8_t*)msg2.c_str(), msg2.length()), (int32_t)msg2.length());
+
+  uint8_t buf[32];
+  memset(buf, 0, sizeof(buf));
+  ASSERT_EQ(readMessage(buf, 2), 2);
+  ASSERT_EQ(readMessage(buf + 2, sizeof(buf) - 2), (int32_t)msg1.length() - 2);
+  ASSERT_STREQ((const char*)buf, msg1.c_str());
+
+  memset(buf, 0, sizeof(buf));
+  ASSERT_EQ(readMessage(buf, sizeof(buf)), (int32_t)msg2.length());
+  ASSERT_STREQ((const char*)buf, msg2.c_str());
+}
+
+TEST_F(Loopback, writeThenReadManyDatagrams)
+{
+  receiver_->setReceiveBufferSize(1024 * 1024);
+
+  // more datagrams than are sent or received with one system call
+  std::stringstream ss;
+  for (int i = 0; i < 20000; ++i)
+  {
+    ss << i;
+  }
+  std::string msg = ss.str();
+
+  for (int i = 0; i < 3; ++i)
+  {
+    int32_t written = sender_->write((uint8_t*)msg.c_str(), msg.length());
+    ASSERT_EQ(written, (int32_t)msg.length());
+
+    std::vector<uint8_t> buf(msg.length() + 1, 0);
+    int32_t read = readMessage(&buf[0], msg.length());
+    ASSERT_EQ(read, (int32_t)msg.length());
+    ASSERT_STREQ((const char*)&buf[0], msg.c_str());
+  }
+
+  ASSERT_EQ(receiver_->getDroppedMessages(), 0U);
+}
+
+TEST_F(Loopback, reorderedDatagrams)
+{
+  const uint32_t payload_size = receiver_->getMaxDatagramSize() - sizeof(TransportUDPHeader);
+  std::string block0(payload_size, 'a');
+  std::string block1(payload_size, 'b');
+  std::string block2 = "c";
+
+  sendRaw(ROS_UDP_DATAN, 1, 2, block2);
+  sendRaw(ROS_UDP_DATAN, 1, 1, block1);
+  sendRaw(ROS_UDP_DATA0, 1, 3, block0);
+
+  std::string msg = block0 + block1 + block2;
+  std::vector<uint8_t> buf(msg.length() + 1, 0);
+  int32_t read = readMessage(&buf[0], msg.length());
+  ASSERT_EQ(read, (int32_t)msg.length());
+  ASSERT_STREQ((const char*)&buf[0], msg.c_str());
+
+  ASSERT_EQ(receiver_->getReorderedDatagrams(), 2U);
+  ASSERT_EQ(receiver_->getDroppedMessages(), 0U);
+}
+
+TEST_F(Loopback, lostDatagram)
+{
+  const uint32_t payload_size = receiver_->getMaxDatagramSize() - sizeof(TransportUDPHeader);
+
+  // the middle block never arrives
+  sendRaw(ROS_UDP_DATA0, 1, 3, std::string(payload_size, 'a'));
+  sendRaw(ROS_UDP_DATAN, 1, 2, "c");
+  sendRaw(ROS_UDP_DATA0, 2, 1, "next");
+
+  uint8_t buf[5];
+  memset(buf, 0, sizeof(buf));
+  ASSERT_EQ(readMessage(buf, 4), 4);
+  ASSERT_STREQ((const char*)buf, "next");
+
+  // the id comes around again
+  sendRaw(ROS_UDP_DATA0, 1, 1, "again");
+
+  uint8_t buf2[6];
+  memset(buf2, 0, sizeof(buf2));
+  ASSERT_EQ(readMessage(buf2, 5), 5);
+  ASSERT_STREQ((const char*)buf2, "again");
+
+  ASSERT_EQ(receiver_->getDroppedMessages(), 1U);
+}
+
+TEST_F(Loopback, readAfterClose)
+{
+  receiver_->close();
+
+  uint8_t buf[5];
+  int32_t read = receiver_->read(buf, 1);
+  ASSERT_EQ(read, -1);
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
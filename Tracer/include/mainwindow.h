@@ -1,8 +1,4 @@
 #include <QCheckBox>
-#include <QGraphicsItem>
-#include <QGraphicsScene>
-#include <QGraphicsView>
-#include <QGraphicsView>
 #include <QGroupBox>
 #include <QMainWindow>
 #include <QPushButton>
@@ -11,11 +7,9 @@
 #include <QtCore>
 #include <QtGui>
 #include <QtGui>
-#include "mysquare.h"
+#include "timeline_view.h"
 #include "tracer.h"
 
-//#define ANALYZE_DEADLINE_MISS
-
 class QMenu;
 class SecondDialog;
 
@@ -42,26 +36,21 @@ public:
 private:
   Ui::MainWindow *ui;
 
-  void viz_process(std::vector<trace_info_t> info, double zoom);
+  void viz_process(const std::vector<trace_info_t> &info);
 
   QString pass;
+  SchedViz::Tracer *tracer;
 
-  std::vector<MySquare *> process_info;
   std::vector<QLabel *> label_list;
-  std::vector<QLabel *> Node_list;
   std::vector<node_info_t> node_list;
-  std::vector<QGraphicsLineItem *> deadline_miss_list;
-  QGraphicsLineItem *deadline_miss;
 
-  QGraphicsView *CPU_view;
-  QGraphicsScene *CPU_scene;
-  QGraphicsView *Node_view;
-  QGraphicsScene *Node_scene;
-  MySquare *square;
+  TimelineView *CPU_view;
+  TimelineView *Node_view;
   QTextBrowser *browser;
   std::vector<int> pid_list;
 
   std::vector<trace_info_t> info;
+  std::vector<job_info_t> jobs;
   double ZOOM;
 
   QGroupBox *createCPUGroup();
@@ -79,6 +68,7 @@ private:
 
 public slots:
   void StartStopTrace(bool click);
+  void LoadTimeline();
   void ShowNodes(bool click);
   void quit();
   void setPass(const QString &);
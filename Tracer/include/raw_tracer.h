@@ -0,0 +1,109 @@
+#ifndef RAW_TRACER_H
+#define RAW_TRACER_H
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define SCHED_SWITCH_RECORD 1
+#define SCHED_WAKEUP_RECORD 2
+
+/* Compact per-CPU record decoded from trace_pipe_raw.
+ * For sched_wakeup, next_pid/next_prio hold the wakee and
+ * prev_state holds target_cpu. */
+typedef struct sched_record_t
+{
+  unsigned long long timestamp;  // ns
+  unsigned short cpu;
+  unsigned short type;
+  int prev_pid;
+  int prev_prio;
+  long long prev_state;
+  int next_pid;
+  int next_prio;
+
+  bool operator<(const sched_record_t& another) const
+  {
+    return timestamp < another.timestamp;
+  }
+} sched_record_t;
+
+typedef struct event_field_t
+{
+  std::string name;
+  int offset;
+  int size;
+  bool is_signed;
+} event_field_t;
+
+namespace SchedViz
+{
+/* Parsed content of events/<system>/<event>/format */
+class EventFormat
+{
+public:
+  EventFormat();
+  ~EventFormat();
+  bool load(const std::string& path);
+  const event_field_t* find(const std::string& name) const;
+  long long read(const char* data, const event_field_t* field) const;
+
+  int id;
+  std::string name;
+
+private:
+  std::vector<event_field_t> v_field_;
+};
+
+/* Captures per-CPU trace_pipe_raw buffers into binary files with splice(2)
+ * and decodes them back into sched_record_t without any text formatting. */
+class RawTracer
+{
+public:
+  RawTracer(const std::string& tracing_dir = "/sys/kernel/debug/tracing", const std::string& out_dir = "./ftrace_raw");
+  ~RawTracer();
+  bool start();
+  void stop();
+  bool is_running();
+  void set_out_dir(const std::string& out_dir);
+  std::string get_out_dir();
+  bool decode(std::vector<std::vector<sched_record_t> >& v_records);
+  int get_nr_cpus();
+
+private:
+  void capture_(int cpu, int raw_fd, int out_fd);
+  bool copy_file_(const std::string& src, const std::string& dst);
+  bool load_header_page_(const std::string& path);
+  void decode_page_(const char* page, int cpu, std::vector<sched_record_t>& v_record);
+  void decode_event_(const char* data, int length, unsigned long long timestamp, int cpu,
+                     std::vector<sched_record_t>& v_record);
+
+  std::string tracing_dir_;
+  std::string out_dir_;
+  int nr_cpus_;
+  long page_size_;
+  std::atomic<bool> running_;
+  std::vector<std::thread> v_thread_;
+
+  /* ring buffer page layout from events/header_page */
+  int ts_offset_;
+  int commit_offset_;
+  int commit_size_;
+  int data_offset_;
+
+  EventFormat switch_format_;
+  EventFormat wakeup_format_;
+  const event_field_t* common_type_;
+  const event_field_t* prev_pid_;
+  const event_field_t* prev_prio_;
+  const event_field_t* prev_state_;
+  const event_field_t* next_pid_;
+  const event_field_t* next_prio_;
+  const event_field_t* wakeup_pid_;
+  const event_field_t* wakeup_prio_;
+  const event_field_t* wakeup_cpu_;
+};
+}
+
+#endif  // RAW_TRACER_H
@@ -0,0 +1,66 @@
+#ifndef TIMELINE_INDEX_H
+#define TIMELINE_INDEX_H
+
+#include <vector>
+#include "tracer.h"
+
+/* A drawable element of a timeline row.
+ * index >= 0 refers to a single slice in the trace.
+ * index < 0 is a density bar aggregating slices narrower than a pixel,
+ * density being the busy fraction of [start, finish). */
+typedef struct timeline_item_t
+{
+  double start;
+  double finish;
+  double density;
+  int count;
+  int index;
+} timeline_item_t;
+
+namespace SchedViz
+{
+/* Time-sorted interval index of trace slices, one row per core or node.
+ * A query only touches the slices overlapping the visible range,
+ * and merges the ones narrower than min_width into density bars,
+ * so the number of items drawn is bounded by the view width.
+ * The trace passed to build_by_*() must outlive the index. */
+class TimelineIndex
+{
+public:
+  TimelineIndex();
+  ~TimelineIndex();
+  void build_by_core(const std::vector<trace_info_t>& v_info);
+  void build_by_node(const std::vector<trace_info_t>& v_info, const std::vector<node_info_t>& v_node);
+  void clear();
+
+  int get_nr_rows();
+  const trace_info_t& get_info(int index);
+  double get_begin_time();
+  double get_end_time();
+  void query(int row, double begin, double end, double min_width, std::vector<timeline_item_t>& v_item);
+  int find(int row, double time, double tolerance);
+
+private:
+  void build_(const std::vector<trace_info_t>& v_info, const std::vector<int>& v_row, int nr_rows);
+  bool add_(int index, double begin, double min_width, timeline_item_t& bar, bool& has_bar, long& bar_pixel,
+            std::vector<timeline_item_t>& v_item);
+
+  /* per row, slice indices sorted by start_time */
+  std::vector<std::vector<int> > v_row_slice_;
+  std::vector<std::vector<double> > v_row_start_;
+  /* per row, prefix sums of runtime in the same order */
+  std::vector<std::vector<double> > v_row_busy_;
+  std::vector<double> v_row_max_runtime_;
+  /* per row, the few slices longer than LONG_SLICE_FACTOR times the mean,
+   * kept apart so that they do not widen v_row_max_runtime_.
+   * v_row_long_reach_ is the running max of their finish time. */
+  std::vector<std::vector<int> > v_row_long_;
+  std::vector<std::vector<double> > v_row_long_start_;
+  std::vector<std::vector<double> > v_row_long_reach_;
+  const std::vector<trace_info_t>* v_info_;
+  double begin_time_;
+  double end_time_;
+};
+}
+
+#endif  // TIMELINE_INDEX_H
@@ -0,0 +1,33 @@
+#ifndef TIMELINE_IO_H
+#define TIMELINE_IO_H
+
+#include <string>
+#include <vector>
+#include "trace_analytics.h"
+#include "type.h"
+
+/* "SVTL" in a little endian uint32 */
+#define TIMELINE_MAGIC 0x4c545653
+#define TIMELINE_VERSION 1
+
+namespace SchedViz
+{
+/* Timeline files exchanged between tracer_cli and the GUI.
+ *
+ * The binary format is
+ *   header  : uint32 magic, uint32 version, uint32 nr_nodes, uint64 nr_slices
+ *   node    : uint32 pid, double deadline, string name,
+ *             uint32 nr_sub, string sub[], uint32 nr_pub, string pub[]
+ *   slice   : double start_time, double runtime, uint32 pid, int16 core, int16 prio
+ * where string is a uint32 length followed by the characters.
+ * The CSV format has one slice per line and no topics. */
+bool write_timeline_csv(const std::string& filename, const std::vector<trace_info_t>& v_info);
+bool write_timeline_binary(const std::string& filename, const std::vector<trace_info_t>& v_info,
+                           const std::vector<node_info_t>& v_node);
+/* Either format, told apart by the magic number */
+bool read_timeline(const std::string& filename, std::vector<trace_info_t>& v_info, std::vector<node_info_t>& v_node);
+bool write_summary_json(const std::string& filename, const std::vector<trace_info_t>& v_info,
+                        const std::vector<node_info_t>& v_node, const std::vector<node_stat_t>& v_stat);
+}
+
+#endif  // TIMELINE_IO_H
@@ -0,0 +1,54 @@
+#ifndef TIMELINE_VIEW_H
+#define TIMELINE_VIEW_H
+
+#include <QAbstractScrollArea>
+#include <QColor>
+#include <QTextBrowser>
+#include <map>
+#include <string>
+#include <vector>
+#include "timeline_index.h"
+#include "tracer.h"
+
+/* Virtualized timeline of trace slices.
+ * Only the visible time range is queried from TimelineIndex and painted
+ * directly, so the cost of a repaint depends on the view width and not
+ * on the number of context switches in the trace. */
+class TimelineView : public QAbstractScrollArea
+{
+public:
+  TimelineView(QTextBrowser *browser, QWidget *parent = 0);
+  ~TimelineView();
+
+  void set_trace_by_core(const std::vector<trace_info_t> &info);
+  void set_trace_by_node(const std::vector<trace_info_t> &info, const std::vector<node_info_t> &node_list);
+  void set_color(unsigned int pid, const QColor &color);
+  void add_marker(int row, double time);
+  void clear();
+
+  void set_zoom(double zoom);
+  double get_zoom();
+
+protected:
+  void paintEvent(QPaintEvent *event);
+  void resizeEvent(QResizeEvent *event);
+  void mousePressEvent(QMouseEvent *event);
+  void wheelEvent(QWheelEvent *event);
+  void scrollContentsBy(int dx, int dy);
+
+private:
+  void update_scroll_bars_();
+  double get_view_begin_();
+  void show_node_info_(const trace_info_t &node_info);
+
+  SchedViz::TimelineIndex index_;
+  std::vector<std::string> v_label_;
+  std::vector<std::vector<double> > v_marker_;
+  std::map<unsigned int, QColor> colors_;
+  std::vector<timeline_item_t> v_item_;
+  QTextBrowser *browser_;
+  double zoom_;  // pixels per second
+  int selected_;
+};
+
+#endif  // TIMELINE_VIEW_H
@@ -0,0 +1,88 @@
+#ifndef TRACE_ANALYTICS_H
+#define TRACE_ANALYTICS_H
+
+#include <map>
+#include <string>
+#include <vector>
+#include "raw_tracer.h"
+#include "type.h"
+
+/* number of log2 bins of response time, bin k covers [2^k, 2^(k+1)) us */
+#define RESPONSE_HISTOGRAM_BINS 32
+
+/* A job of a node: from its wakeup (release) to the switch-out that
+ * puts it to sleep (completion). Times are in seconds. */
+typedef struct job_info_t
+{
+  std::string name;
+  unsigned int pid;
+  int job;
+  double release;
+  double start;
+  double finish;
+  double response_time;
+  double exec_time;
+  double blocking_time;  // ready but not running
+  int preemptions;
+  int migrations;
+  bool deadline_miss;
+  double chain_latency;  // from the oldest source release, only for end nodes (-1 otherwise)
+} job_info_t;
+
+typedef struct node_stat_t
+{
+  std::string name;
+  int nr_jobs;
+  int nr_deadline_misses;
+  int preemptions;
+  int migrations;
+  double max_response_time;
+  double sum_response_time;
+  double max_chain_latency;
+  int v_histogram[RESPONSE_HISTOGRAM_BINS];
+} node_stat_t;
+
+namespace SchedViz
+{
+/* Single pass over the sched_switch/sched_wakeup records of all CPUs.
+ * Per-node state is O(1), so the cost is linear in the trace size. */
+class TraceAnalytics
+{
+public:
+  TraceAnalytics(const std::vector<node_info_t>& v_node_info);
+  ~TraceAnalytics();
+  void analyze(const std::vector<std::vector<sched_record_t> >& v_records);
+  std::vector<job_info_t> get_job_info();
+  std::vector<node_stat_t> get_node_stat();
+  bool write_job_csv(const std::string& filename);
+  bool write_histogram_csv(const std::string& filename);
+
+private:
+  typedef struct node_state_t
+  {
+    bool active;
+    bool running;
+    int last_cpu;
+    double run_start;
+    double origin;  // release of the oldest source job feeding this job
+    double last_origin;
+    job_info_t job;
+  } node_state_t;
+
+  void build_graph_();
+  void release_(int node, double time);
+  void switch_in_(int node, int cpu, double time);
+  void switch_out_(int node, double time, long long prev_state);
+  void complete_(int node, double time);
+
+  std::vector<node_info_t> v_node_info_;
+  std::map<unsigned int, int> pid_to_node_;
+  std::vector<std::vector<int> > v_pred_;
+  std::vector<bool> v_end_node_;
+  std::vector<node_state_t> v_state_;
+  std::vector<node_stat_t> v_stat_;
+  std::vector<job_info_t> v_job_;
+};
+}
+
+#endif  // TRACE_ANALYTICS_H
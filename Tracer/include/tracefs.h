@@ -0,0 +1,52 @@
+#ifndef TRACEFS_H
+#define TRACEFS_H
+
+#include <string>
+#include <vector>
+
+namespace SchedViz
+{
+/* Controls ftrace by writing the tracefs control files directly.
+ * Every file is opened once, so a setting costs a single write(2)
+ * instead of a fork/exec of "sudo sh -c echo". */
+class TraceFs
+{
+public:
+  TraceFs();
+  ~TraceFs();
+  bool open();
+  void close();
+  bool is_open();
+  std::string get_tracing_dir();
+
+  bool set_tracing_on(bool on);
+  bool clear_trace();
+  bool set_current_tracer(const std::string& tracer);
+  bool set_buffer_size_kb(int size_kb);
+  bool set_sched_events();
+  bool clear_events();
+  bool set_pid_filter(const std::vector<unsigned int>& v_pid);
+  bool clear_pid_filter();
+  bool dump_trace(const std::string& path);
+
+private:
+  enum
+  {
+    TRACING_ON,
+    TRACE,
+    CURRENT_TRACER,
+    BUFFER_SIZE_KB,
+    SET_EVENT,
+    SET_EVENT_PID,
+    NR_CONTROL_FILES
+  };
+
+  bool open_(int index, bool truncate);
+  bool write_(int index, const std::string& value);
+
+  std::string tracing_dir_;
+  int fd_[NR_CONTROL_FILES];
+};
+}
+
+#endif  // TRACEFS_H
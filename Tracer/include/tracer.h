@@ -7,54 +7,44 @@
 #include <string>
 #include <vector>
 #include "config.h"
+#include "raw_tracer.h"
+#include "trace_analytics.h"
+#include "tracefs.h"
+#include "type.h"
 #include "yaml-cpp/yaml.h"
 
-typedef struct node_info_t
-{
-  std::string name;
-  unsigned int pid;
-  double deadline;
-  std::vector<std::string> v_subtopic;
-  std::vector<std::string> v_pubtopic;
-} node_info_t;
-
-typedef struct trace_info_t
-{
-  std::string name;
-  std::vector<std::string> v_subtopic;
-  std::vector<std::string> v_pubtopic;
-  unsigned int pid;
-  int core;
-  double runtime;
-  double start_time;
-  int prio;
-  double deadline;
-
-  bool operator<(const trace_info_t& another) const
-  {
-    return start_time < another.start_time;
-  }
-} trace_info_t;
-
 namespace SchedViz
 {
 class Tracer
 {
 public:
   Tracer();
+  explicit Tracer(const std::string& config_path);
   ~Tracer();
   void setup(std::string);
   void reset(std::string);
   void start_ftrace(std::string);
+  void set_output_dir(const std::string& dir);
+  void lookup_pids();
+  bool parse_raw(const std::string& dir);
+  bool parse_log(const std::string& filename);
 
   std::vector<trace_info_t> get_info();
+  std::vector<job_info_t> get_job_info();
+  std::vector<node_stat_t> get_node_stat();
   std::vector<node_info_t> get_node_list();
   std::vector<node_info_t> v_node_info_;
   std::vector<trace_info_t> v_trace_info;
+  std::vector<job_info_t> v_job_info;
+  std::vector<node_stat_t> v_node_stat;
 
 private:
   void load_config_(const std::string& filename);
   Config config_;
+  TraceFs tracefs_;
+  RawTracer raw_tracer_;
+  bool raw_capture_;
+  std::string output_dir_;
 
   unsigned int get_pid(std::string name);
   void mount(bool, std::string);
@@ -65,8 +55,12 @@ private:
   void set_event(std::string, std::string);
   void output_log(std::string);
   void filter_pid(bool mode, std::string);
-  void extract_period();
-  void create_process_info(std::vector<std::string> find_prev_pids, std::vector<std::string> find_next_pids);
+  void save_node_pids_(const std::string& dir);
+  void load_node_pids_(const std::string& dir);
+  void extract_period(const std::string& filename);
+  void create_process_info(std::vector<std::string> find_prev_pids, std::vector<std::string> find_next_pids,
+                           const std::string& filename);
+  void create_process_info(const std::vector<std::vector<sched_record_t> >& v_records);
   std::vector<std::string> split(std::string str, std::string delim);
   std::string trim(const std::string& string);
   int ctoi(std::string s);
@@ -0,0 +1,34 @@
+#ifndef TYPE_H
+#define TYPE_H
+
+#include <string>
+#include <vector>
+
+typedef struct node_info_t
+{
+  std::string name;
+  unsigned int pid;
+  double deadline;
+  std::vector<std::string> v_subtopic;
+  std::vector<std::string> v_pubtopic;
+} node_info_t;
+
+typedef struct trace_info_t
+{
+  std::string name;
+  std::vector<std::string> v_subtopic;
+  std::vector<std::string> v_pubtopic;
+  unsigned int pid;
+  int core;
+  double runtime;
+  double start_time;
+  int prio;
+  double deadline;
+
+  bool operator<(const trace_info_t& another) const
+  {
+    return start_time < another.start_time;
+  }
+} trace_info_t;
+
+#endif  // TYPE_H
@@ -8,6 +8,6 @@ DEPENDPATH += .
 INCLUDEPATH += .
 
 # Input
-HEADERS += config.h mainwindow.h mysquare.h tracer.h
+HEADERS += config.h mainwindow.h raw_tracer.h timeline_index.h timeline_io.h timeline_view.h trace_analytics.h tracefs.h tracer.h type.h
 FORMS += mainwindow.ui
-SOURCES += config.cpp main.cpp mainwindow.cpp mysquare.cpp tracer.cpp
+SOURCES += config.cpp main.cpp mainwindow.cpp raw_tracer.cpp timeline_index.cpp timeline_io.cpp timeline_view.cpp trace_analytics.cpp tracefs.cpp tracer.cpp
@@ -2,17 +2,19 @@
 #include <QBoxLayout>
 #include <QColor>
 #include <QDialog>
+#include <QFileDialog>
 #include <QGroupBox>
 #include <QLabel>
 #include <QLineEdit>
 #include <QTextBrowser>
 #include <QtCore/QString>
 #include <string>
-#include "mysquare.h"
+#include "timeline_io.h"
+#include "timeline_view.h"
 #include "tracer.h"
 #include "ui_mainwindow.h"
 
-#define CORE 8
+#define ZOOM_STEP 2.0
 
 MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent), ui(new Ui::MainWindow)
 {
@@ -21,6 +23,8 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent), ui(new Ui::MainWi
   setGeometry(0, 0, 800, 500);
 
   setWindowTitle(tr("ROSHC: TRACER"));
+  /* the timeline views show slice details in the text browser */
+  QGroupBox *TextBrowserGroup = createTextBrowser();
   CPUGroup = createCPUGroup();
   NodeGroup = createNodeGroup();
   NodeListGroup = createNodeListGroup();
@@ -29,13 +33,14 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent), ui(new Ui::MainWi
   toplayout->addWidget(CPUGroup);
   toplayout->addWidget(NodeGroup);
   toplayout->addWidget(NodeListGroup);
-  toplayout->addWidget(createTextBrowser());
+  toplayout->addWidget(TextBrowserGroup);
   toplayout->addWidget(createButtonGroup());
 
   QWidget *window = new QWidget();
   window->setLayout(toplayout);
   ZOOM = 1000;
   mode = CPU_MODE;
+  tracer = NULL;
 
   NodeGroup->hide();
   NodeListGroup->hide();
@@ -44,6 +49,7 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent), ui(new Ui::MainWi
 
 MainWindow::~MainWindow()
 {
+  delete tracer;
   delete ui;
 }
 
@@ -86,33 +92,9 @@ QGroupBox *MainWindow::createCPUGroup()
   QVBoxLayout *toplayout = new QVBoxLayout;
   QHBoxLayout *graph = new QHBoxLayout;
 
-  QLabel *cpu0 = new QLabel("cpu 0");
-  QLabel *cpu1 = new QLabel("cpu 1");
-  QLabel *cpu2 = new QLabel("cpu 2");
-  QLabel *cpu3 = new QLabel("cpu 3");
-  QLabel *cpu4 = new QLabel("cpu 4");
-  QLabel *cpu5 = new QLabel("cpu 5");
-  QLabel *cpu6 = new QLabel("cpu 6");
-  QLabel *cpu7 = new QLabel("cpu 7");
-  QVBoxLayout *layout = new QVBoxLayout;
-
-  layout->setSpacing(20);
-  layout->addSpacing(10);
-  layout->addWidget(cpu0);
-  layout->addWidget(cpu1);
-  layout->addWidget(cpu2);
-  layout->addWidget(cpu3);
-  layout->addWidget(cpu4);
-  layout->addWidget(cpu5);
-  layout->addWidget(cpu6);
-  layout->addWidget(cpu7);
-  layout->addSpacing(20);
-  graph->addLayout(layout);
-
-  CPU_scene = new QGraphicsScene(this);
-  ui->graphicsView->setScene(CPU_scene);
-
-  CPU_view = new QGraphicsView(CPU_scene);
+  /* cpu labels are drawn by the view, one row per core found in the trace */
+  CPU_view = new TimelineView(browser);
+  CPU_view->setSizePolicy(QSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding));
   graph->addWidget(CPU_view);
 
   QHBoxLayout *buttons = new QHBoxLayout;
@@ -140,35 +122,18 @@ QGroupBox *MainWindow::createNodeGroup()
   QHBoxLayout *graph = new QHBoxLayout;
 
   SchedViz::Tracer tracer;
-  std::string node_name_;
-  QLabel *name_label;
 
-  /* create labelske */
+  /* node labels are drawn by the view */
+  tracer.lookup_pids();
   node_list = tracer.get_node_list();
-  QVBoxLayout *layout = new QVBoxLayout;
-
-  layout->setSpacing(20);
-  layout->addSpacing(10);
-
   for (int i(0); i < (int)node_list.size(); i++)
   {
-    node_name_ = node_list[i].name.c_str();
-    name_label = new QLabel(node_name_.c_str());
-    Node_list.push_back(name_label);
-    layout->addWidget(Node_list[i]);
     pid_list.push_back(node_list[i].pid);
   }
 
-  layout->addSpacing(20);
-  graph->addLayout(layout);
-
-  /* create scene */
-  Node_scene = new QGraphicsScene(this);
-  ui->graphicsView->setScene(Node_scene);
-
   /* create view */
-  Node_view = new QGraphicsView(Node_scene);
-  Node_view->setSizePolicy(QSizePolicy(QSizePolicy::Expanding, QSizePolicy::Minimum));
+  Node_view = new TimelineView(browser);
+  Node_view->setSizePolicy(QSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding));
   graph->addWidget(Node_view);
 
   /* create buttons */
@@ -230,12 +195,14 @@ QGroupBox *MainWindow::createButtonGroup()
   QPushButton *StartStopButton = new QPushButton("Start / Stop");
   QPushButton *CPUNodeButton = new QPushButton("CPU / Node");
   QPushButton *NodeListButton = new QPushButton("View Node List");
+  QPushButton *LoadButton = new QPushButton("Load");
   QPushButton *CloseButton = new QPushButton("Close");
   QHBoxLayout *layout = new QHBoxLayout;
 
   layout->addWidget(StartStopButton);
   layout->addWidget(CPUNodeButton);
   layout->addWidget(NodeListButton);
+  layout->addWidget(LoadButton);
   layout->addWidget(CloseButton);
   layout->addStretch(1);
   groupBox->setLayout(layout);
@@ -247,6 +214,7 @@ QGroupBox *MainWindow::createButtonGroup()
   QObject::connect(StartStopButton, SIGNAL(toggled(bool)), this, SLOT(StartStopTrace(bool)));
   QObject::connect(CPUNodeButton, SIGNAL(toggled(bool)), this, SLOT(changeCPUNode(bool)));
   QObject::connect(NodeListButton, SIGNAL(toggled(bool)), this, SLOT(ShowNodes(bool)));
+  QObject::connect(LoadButton, SIGNAL(clicked()), this, SLOT(LoadTimeline()));
   QObject::connect(CloseButton, SIGNAL(clicked()), this, SLOT(quit()));
 
   return groupBox;
@@ -254,16 +222,14 @@ QGroupBox *MainWindow::createButtonGroup()
 
 void MainWindow::changeCPUNode(bool click)
 {
-  int zoom = 1;
-
   if (click)
   {
     mode = NODE_MODE;
 
-    if (process_info.size() != 0)
+    if (info.size() != 0)
     {
       delete_viz_process();
-      viz_process(info, zoom);
+      viz_process(info);
     }
 
     CPUGroup->hide();
@@ -273,10 +239,10 @@ void MainWindow::changeCPUNode(bool click)
   {
     mode = CPU_MODE;
 
-    if (process_info.size() != 0)
+    if (info.size() != 0)
     {
       delete_viz_process();
-      viz_process(info, zoom);
+      viz_process(info);
     }
 
     NodeGroup->hide();
@@ -289,25 +255,60 @@ void MainWindow::StartStopTrace(bool click)
   if (click)
   {
     /* Preparation for second and subsequent procesing */
-    if (process_info.size() != 0)
+    if (info.size() != 0)
       delete_viz_process();
 
-    /* Start tracing */
-    SchedViz::Tracer tracer;
-    tracer.setup(pass.toStdString());
-    tracer.start_ftrace(pass.toStdString());
+    /* Start tracing
+     * The tracer lives until Stop since it owns the capture threads */
+    delete tracer;
+    tracer = new SchedViz::Tracer;
+    tracer->setup(pass.toStdString());
+    tracer->start_ftrace(pass.toStdString());
   }
   else
   {
     /* Get trace infomation */
-    int zoom = 1;
-    SchedViz::Tracer tracer;
-    tracer.reset(pass.toStdString());
-    info = tracer.get_info();
-    viz_process(info, zoom);
+    if (tracer == NULL)
+      return;
+    tracer->reset(pass.toStdString());
+    info = tracer->get_info();
+    jobs = tracer->get_job_info();
+    delete tracer;
+    tracer = NULL;
+    viz_process(info);
   }
 }
 
+/* Show a timeline written by tracer_cli */
+void MainWindow::LoadTimeline()
+{
+  QString filename = QFileDialog::getOpenFileName(this, "Load Timeline", ".", "Timeline (*.bin *.csv)");
+  std::vector<node_info_t> v_node;
+
+  if (filename.isEmpty())
+    return;
+
+  delete_viz_process();
+  jobs.clear();
+  if (!SchedViz::read_timeline(filename.toStdString(), info, v_node))
+  {
+    browser->setText("Cannot load " + filename);
+    return;
+  }
+
+  /* the nodes had other pids when the timeline was captured */
+  for (int i(0); i < (int)node_list.size(); i++)
+  {
+    for (int j(0); j < (int)v_node.size(); j++)
+    {
+      if (node_list[i].name == v_node[j].name)
+        node_list[i].pid = pid_list[i] = v_node[j].pid;
+    }
+  }
+
+  viz_process(info);
+}
+
 void MainWindow::ShowNodes(bool click)
 {
   if (click)
@@ -320,104 +321,46 @@ void MainWindow::ShowNodes(bool click)
   }
 }
 
-void MainWindow::viz_process(std::vector<trace_info_t> info, double zoom)
+void MainWindow::viz_process(const std::vector<trace_info_t> &info)
 {
-  double base_time = info[0].start_time;
-  double base_x = -50;
-  double base_y = 12;
-  double space = 38;
-  double width = 0;
-  double x = 0;
-  double y = 0;
-  int k = 0;
-  QGraphicsScene *scene;
-  ZOOM += zoom;
+  TimelineView *view;
 
   switch (mode)
   {
-    case CPU_MODE:
-      scene = CPU_scene;
-
-      /* Initialize geometry
-       * y = upper of QGraphicsScene
-       * */
-      scene->addRect(0, 0, 1, 10, QPen(Qt::white), QBrush(Qt::white));
-
-      /* Initialize geometry
-       * y = bottom of QGraphicsScene
-       * */
-      scene->addRect(0, 7 * 39, 1, 10, QPen(Qt::white), QBrush(Qt::white));
-      break;
-
     case NODE_MODE:
-      scene = Node_scene;
-
-      /* Initialize geometry
-       * y = upper of QGraphicsScene
-       * */
-      Node_scene->addRect(0, 0, 1, 10, QPen(Qt::white), QBrush(Qt::white));
-
-      /* Initialize geometry
-       * y = bottom of QGraphicsScene
-       * */
-      Node_scene->addRect(0, (node_list.size() - 1) * 39, 1, 10, QPen(Qt::white), QBrush(Qt::white));
+      view = Node_view;
+      view->set_trace_by_node(info, node_list);
       break;
 
+    case CPU_MODE:
     default:
-      scene = CPU_scene;
+      view = CPU_view;
+      view->set_trace_by_core(info);
       break;
   }
 
-  /* plot node */
-  for (int i(0); i < (int)info.size(); i++)
+  for (int i(0); i < (int)node_list.size(); i++)
   {
-    x = info[i].start_time - base_time;
-    width = info[i].runtime;
+    view->set_color(node_list[i].pid, get_color(node_list[i].pid));
+  }
 
-    switch (mode)
+  /* mark deadline misses found by the analytics */
+  if (mode == NODE_MODE)
+  {
+    for (int i(0); i < (int)jobs.size(); i++)
     {
-      case CPU_MODE:
-        y = base_y + (info[i].core * space);
-        break;
-      case NODE_MODE:
-        double finish_time;
-        double finish_time_prev;
-
-        /* Classify nodes */
-        for (int j(0); j < (int)node_list.size(); j++)
-        {
-          if (info[i].name == node_list[j].name)
-            y = base_y + (j * space);
-        }
-
-#ifdef ANALYZE_DEADLINE_MISS
-        /* analyze deadline miss */
-        finish_time = info[i].start_time + info[i].runtime;
-        finish_time_prev = info[i - 1].start_time + info[i - 1].runtime;
-
-        if (i != 0 && finish_time - finish_time_prev > info[i].deadline)
-        {
-          deadline_miss = new QGraphicsLineItem();
-          deadline_miss->setLine(x * ZOOM + base_x + info[i].runtime, y, x * ZOOM + base_x + info[i].runtime,
-                                 y - 10); /* length of line */
-
-          deadline_miss->setPen(QPen(Qt::red));
-          deadline_miss_list.push_back(deadline_miss);
-          scene->addItem(deadline_miss_list[k]);
-          k++;
-        }
-#endif
-        break;
-
-      default:
-        y = base_y;
+      if (!jobs[i].deadline_miss)
+        continue;
+
+      for (int j(0); j < (int)node_list.size(); j++)
+      {
+        if (jobs[i].name == node_list[j].name)
+          view->add_marker(j, jobs[i].finish);
+      }
     }
-
-    square = new MySquare(x * ZOOM + base_x, y, width * ZOOM, info[i], browser, get_color(info[i].pid));
-
-    process_info.push_back(square);
-    scene->addItem(process_info[i]);
   }
+
+  view->set_zoom(ZOOM);
 }
 
 QColor MainWindow::get_color(int pid)
@@ -434,34 +377,24 @@ QColor MainWindow::get_color(int pid)
 
 void MainWindow::zoom_in_process()
 {
-  delete_viz_process();
-  viz_process(info, 500);
+  ZOOM *= ZOOM_STEP;
+  CPU_view->set_zoom(ZOOM);
+  Node_view->set_zoom(ZOOM);
+  ZOOM = (mode == NODE_MODE) ? Node_view->get_zoom() : CPU_view->get_zoom();
 }
 
 void MainWindow::zoom_out_process()
 {
-  delete_viz_process();
-
-  if (ZOOM - 500 <= 0)
-    viz_process(info, 0);
-  else
-    viz_process(info, -500);
+  ZOOM /= ZOOM_STEP;
+  CPU_view->set_zoom(ZOOM);
+  Node_view->set_zoom(ZOOM);
+  ZOOM = (mode == NODE_MODE) ? Node_view->get_zoom() : CPU_view->get_zoom();
 }
 
 void MainWindow::delete_viz_process()
 {
-  for (int i(0); i < (int)process_info.size(); i++)
-  {
-    delete process_info[i];
-  }
-  process_info.resize(0);
-
-  for (int i(0); i < (int)deadline_miss_list.size(); i++)
-  {
-    delete deadline_miss_list[i];
-  }
-
-  deadline_miss_list.resize(0);
+  CPU_view->clear();
+  Node_view->clear();
 }
 
 void MainWindow::quit()
@@ -0,0 +1,482 @@
+#include "raw_tracer.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+/* interval of polling an empty trace_pipe_raw */
+#define READ_INTERVAL_US 1000
+
+/* ring buffer event types (kernel/trace/ring_buffer.c) */
+#define RINGBUF_TYPE_DATA_TYPE_LEN_MAX 28
+#define RINGBUF_TYPE_PADDING 29
+#define RINGBUF_TYPE_TIME_EXTEND 30
+#define RINGBUF_TYPE_TIME_STAMP 31
+#define RINGBUF_TYPE_LEN_MASK 0x1f
+#define RINGBUF_TIME_SHIFT 27
+#define RINGBUF_COMMIT_MASK 0xfffff
+
+using namespace SchedViz;
+
+EventFormat::EventFormat() : id(-1)
+{
+}
+
+EventFormat::~EventFormat()
+{
+}
+
+/* Parse lines such as
+ *   ID: 316
+ *   field:pid_t prev_pid;	offset:24;	size:4;	signed:1;
+ */
+bool EventFormat::load(const std::string &path)
+{
+  std::ifstream format(path.c_str());
+  std::string buf;
+
+  if (!format)
+    return false;
+
+  v_field_.clear();
+  while (std::getline(format, buf))
+  {
+    if (buf.compare(0, 5, "name:") == 0)
+    {
+      std::istringstream line(buf.substr(5));
+      line >> name;
+      continue;
+    }
+    if (buf.compare(0, 3, "ID:") == 0)
+    {
+      id = atoi(buf.substr(3).c_str());
+      continue;
+    }
+
+    std::string::size_type field_pos = buf.find("field:");
+    if (field_pos == std::string::npos)
+      continue;
+
+    std::string::size_type decl_end = buf.find(';', field_pos);
+    std::string::size_type offset_pos = buf.find("offset:");
+    std::string::size_type size_pos = buf.find("size:");
+    std::string::size_type signed_pos = buf.find("signed:");
+    if (decl_end == std::string::npos || offset_pos == std::string::npos || size_pos == std::string::npos)
+      continue;
+
+    /* the field name is the last word of the declaration, without array brackets */
+    std::string decl = buf.substr(field_pos + 6, decl_end - field_pos - 6);
+    std::string::size_type bracket = decl.find('[');
+    if (bracket != std::string::npos)
+      decl = decl.substr(0, bracket);
+    std::string::size_type name_pos = decl.find_last_of(" \t*");
+
+    event_field_t field;
+    field.name = (name_pos == std::string::npos) ? decl : decl.substr(name_pos + 1);
+    field.offset = atoi(buf.c_str() + offset_pos + 7);
+    field.size = atoi(buf.c_str() + size_pos + 5);
+    field.is_signed = (signed_pos != std::string::npos) ? atoi(buf.c_str() + signed_pos + 7) != 0 : false;
+
+    /* header_page describes "overwrite" at the same offset as "commit", keep the first one */
+    if (find(field.name) == NULL)
+      v_field_.push_back(field);
+  }
+
+  return !v_field_.empty();
+}
+
+const event_field_t *EventFormat::find(const std::string &name) const
+{
+  for (int i(0); i < (int)v_field_.size(); i++)
+  {
+    if (v_field_[i].name == name)
+      return &v_field_[i];
+  }
+  return NULL;
+}
+
+long long EventFormat::read(const char *data, const event_field_t *field) const
+{
+  switch (field->size)
+  {
+    case 1:
+    {
+      unsigned char v;
+      memcpy(&v, data + field->offset, sizeof(v));
+      return field->is_signed ? (long long)(signed char)v : (long long)v;
+    }
+    case 2:
+    {
+      unsigned short v;
+      memcpy(&v, data + field->offset, sizeof(v));
+      return field->is_signed ? (long long)(short)v : (long long)v;
+    }
+    case 4:
+    {
+      unsigned int v;
+      memcpy(&v, data + field->offset, sizeof(v));
+      return field->is_signed ? (long long)(int)v : (long long)v;
+    }
+    case 8:
+    {
+      long long v;
+      memcpy(&v, data + field->offset, sizeof(v));
+      return v;
+    }
+    default:
+      return 0;
+  }
+}
+
+RawTracer::RawTracer(const std::string &tracing_dir, const std::string &out_dir)
+  : tracing_dir_(tracing_dir)
+  , out_dir_(out_dir)
+  , running_(false)
+  , ts_offset_(0)
+  , commit_offset_(8)
+  , commit_size_(8)
+  , data_offset_(16)
+  , common_type_(NULL)
+  , prev_pid_(NULL)
+  , prev_prio_(NULL)
+  , prev_state_(NULL)
+  , next_pid_(NULL)
+  , next_prio_(NULL)
+  , wakeup_pid_(NULL)
+  , wakeup_prio_(NULL)
+  , wakeup_cpu_(NULL)
+{
+  nr_cpus_ = sysconf(_SC_NPROCESSORS_CONF);
+  page_size_ = sysconf(_SC_PAGESIZE);
+}
+
+RawTracer::~RawTracer()
+{
+  stop();
+}
+
+int RawTracer::get_nr_cpus()
+{
+  return nr_cpus_;
+}
+
+bool RawTracer::is_running()
+{
+  return running_;
+}
+
+void RawTracer::set_out_dir(const std::string &out_dir)
+{
+  out_dir_ = out_dir;
+}
+
+std::string RawTracer::get_out_dir()
+{
+  return out_dir_;
+}
+
+/* Open every per-CPU trace_pipe_raw and start one splice thread per CPU.
+ * The event format files are copied next to the raw data so that
+ * the capture can be decoded offline on another machine. */
+bool RawTracer::start()
+{
+  std::vector<int> v_raw_fd, v_out_fd;
+
+  if (running_)
+    return true;
+
+  mkdir(out_dir_.c_str(), 0755);
+  if (!copy_file_(tracing_dir_ + "/events/header_page", out_dir_ + "/header_page") ||
+      !copy_file_(tracing_dir_ + "/events/sched/sched_switch/format", out_dir_ + "/sched_switch.format"))
+  {
+    std::cerr << "RawTracer: cannot read event formats in " << tracing_dir_ << std::endl;
+    return false;
+  }
+  copy_file_(tracing_dir_ + "/events/sched/sched_wakeup/format", out_dir_ + "/sched_wakeup.format");
+
+  for (int cpu(0); cpu < nr_cpus_; cpu++)
+  {
+    std::ostringstream raw_path, out_path;
+    raw_path << tracing_dir_ << "/per_cpu/cpu" << cpu << "/trace_pipe_raw";
+    out_path << out_dir_ << "/cpu" << cpu << ".raw";
+
+    int raw_fd = open(raw_path.str().c_str(), O_RDONLY | O_NONBLOCK);
+    int out_fd = open(out_path.str().c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (raw_fd < 0 || out_fd < 0)
+    {
+      std::cerr << "RawTracer: cannot open " << raw_path.str() << ": " << strerror(errno) << std::endl;
+      if (raw_fd >= 0)
+        close(raw_fd);
+      if (out_fd >= 0)
+        close(out_fd);
+      for (int i(0); i < (int)v_raw_fd.size(); i++)
+      {
+        close(v_raw_fd[i]);
+        close(v_out_fd[i]);
+      }
+      return false;
+    }
+    v_raw_fd.push_back(raw_fd);
+    v_out_fd.push_back(out_fd);
+  }
+
+  running_ = true;
+  for (int cpu(0); cpu < nr_cpus_; cpu++)
+    v_thread_.push_back(std::thread(&RawTracer::capture_, this, cpu, v_raw_fd[cpu], v_out_fd[cpu]));
+
+  return true;
+}
+
+/* Stop splicing, flush the remaining partial pages and wait for all threads.
+ * tracing_on should be cleared before calling this. */
+void RawTracer::stop()
+{
+  running_ = false;
+  for (int i(0); i < (int)v_thread_.size(); i++)
+  {
+    if (v_thread_[i].joinable())
+      v_thread_[i].join();
+  }
+  v_thread_.clear();
+}
+
+void RawTracer::capture_(int cpu, int raw_fd, int out_fd)
+{
+  int fds[2];
+  ssize_t ret;
+
+  if (pipe(fds) < 0)
+  {
+    std::cerr << "RawTracer: pipe failed on cpu" << cpu << std::endl;
+    close(raw_fd);
+    close(out_fd);
+    return;
+  }
+
+  while (running_)
+  {
+    ret = splice(raw_fd, NULL, fds[1], NULL, page_size_, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+    if (ret <= 0)
+    {
+      if (ret < 0 && errno != EAGAIN && errno != EINTR)
+      {
+        std::cerr << "RawTracer: splice failed on cpu" << cpu << ": " << strerror(errno) << std::endl;
+        break;
+      }
+      usleep(READ_INTERVAL_US);
+      continue;
+    }
+
+    while (ret > 0)
+    {
+      ssize_t moved = splice(fds[0], NULL, out_fd, NULL, ret, SPLICE_F_MOVE);
+      if (moved <= 0)
+        break;
+      ret -= moved;
+    }
+  }
+
+  /* splice only hands out full pages, so the last partial page is read(2) */
+  std::vector<char> page(page_size_);
+  while ((ret = read(raw_fd, &page[0], page_size_)) > 0)
+  {
+    if (ret < page_size_)
+      memset(&page[ret], 0, page_size_ - ret);
+    if (write(out_fd, &page[0], page_size_) != page_size_)
+      break;
+  }
+
+  close(fds[0]);
+  close(fds[1]);
+  close(raw_fd);
+  close(out_fd);
+}
+
+bool RawTracer::copy_file_(const std::string &src, const std::string &dst)
+{
+  std::ifstream in(src.c_str(), std::ios::binary);
+  if (!in)
+    return false;
+
+  std::ofstream out(dst.c_str(), std::ios::binary);
+  out << in.rdbuf();
+  return true;
+}
+
+bool RawTracer::load_header_page_(const std::string &path)
+{
+  EventFormat header;
+  const event_field_t *field;
+
+  if (!header.load(path))
+    return false;
+
+  if ((field = header.find("timestamp")) != NULL)
+    ts_offset_ = field->offset;
+  if ((field = header.find("commit")) != NULL)
+  {
+    commit_offset_ = field->offset;
+    commit_size_ = field->size;
+  }
+  if ((field = header.find("data")) != NULL)
+  {
+    data_offset_ = field->offset;
+    page_size_ = field->offset + field->size;
+  }
+
+  return true;
+}
+
+/* Decode the capture in out_dir_ (live or a recorded fixture) into
+ * time-ordered records, one vector per CPU. */
+bool RawTracer::decode(std::vector<std::vector<sched_record_t> > &v_records)
+{
+  if (!load_header_page_(out_dir_ + "/header_page") || !switch_format_.load(out_dir_ + "/sched_switch.format"))
+  {
+    std::cerr << "RawTracer: no event formats in " << out_dir_ << std::endl;
+    return false;
+  }
+  wakeup_format_.load(out_dir_ + "/sched_wakeup.format");
+
+  common_type_ = switch_format_.find("common_type");
+  prev_pid_ = switch_format_.find("prev_pid");
+  prev_prio_ = switch_format_.find("prev_prio");
+  prev_state_ = switch_format_.find("prev_state");
+  next_pid_ = switch_format_.find("next_pid");
+  next_prio_ = switch_format_.find("next_prio");
+  wakeup_pid_ = wakeup_format_.find("pid");
+  wakeup_prio_ = wakeup_format_.find("prio");
+  wakeup_cpu_ = wakeup_format_.find("target_cpu");
+
+  if (common_type_ == NULL || prev_pid_ == NULL || next_pid_ == NULL)
+    return false;
+
+  v_records.clear();
+  for (int cpu(0);; cpu++)
+  {
+    std::ostringstream path;
+    path << out_dir_ << "/cpu" << cpu << ".raw";
+
+    std::ifstream raw(path.str().c_str(), std::ios::binary);
+    if (!raw)
+      break;
+
+    std::vector<sched_record_t> v_record;
+    std::vector<char> page(page_size_);
+    while (raw.read(&page[0], page_size_))
+      decode_page_(&page[0], cpu, v_record);
+
+    /* pages are consumed in order, but keep the guarantee explicit */
+    std::stable_sort(v_record.begin(), v_record.end());
+    v_records.push_back(v_record);
+  }
+
+  return !v_records.empty();
+}
+
+void RawTracer::decode_page_(const char *page, int cpu, std::vector<sched_record_t> &v_record)
+{
+  unsigned long long timestamp;
+  unsigned long long commit = 0;
+
+  memcpy(&timestamp, page + ts_offset_, sizeof(timestamp));
+  memcpy(&commit, page + commit_offset_, std::min(commit_size_, (int)sizeof(commit)));
+  commit &= RINGBUF_COMMIT_MASK;
+
+  const char *ptr = page + data_offset_;
+  const char *end = ptr + std::min((long)commit, page_size_ - data_offset_);
+
+  while (ptr + 4 <= end)
+  {
+    unsigned int header, array0 = 0;
+    memcpy(&header, ptr, sizeof(header));
+    unsigned int type_len = header & RINGBUF_TYPE_LEN_MASK;
+    unsigned long long delta = header >> 5;
+
+    if (ptr + 8 <= end)
+      memcpy(&array0, ptr + 4, sizeof(array0));
+
+    switch (type_len)
+    {
+      case RINGBUF_TYPE_PADDING:
+        /* a null padding event terminates the page */
+        if (delta == 0)
+          return;
+        timestamp += delta;
+        ptr += 4 + array0;
+        break;
+
+      case RINGBUF_TYPE_TIME_EXTEND:
+        timestamp += ((unsigned long long)array0 << RINGBUF_TIME_SHIFT) + delta;
+        ptr += 8;
+        break;
+
+      case RINGBUF_TYPE_TIME_STAMP:
+        timestamp = (timestamp & ~((1ULL << 59) - 1)) | ((unsigned long long)array0 << RINGBUF_TIME_SHIFT) | delta;
+        ptr += 8;
+        break;
+
+      case 0:
+        /* large event: array[0] holds the data length including itself */
+        if (array0 < 4)
+          return;
+        timestamp += delta;
+        if (ptr + 4 + array0 <= end)
+          decode_event_(ptr + 8, array0 - 4, timestamp, cpu, v_record);
+        ptr += 4 + array0;
+        break;
+
+      default:
+        timestamp += delta;
+        if (ptr + 4 + type_len * 4 <= end)
+          decode_event_(ptr + 4, type_len * 4, timestamp, cpu, v_record);
+        ptr += 4 + type_len * 4;
+        break;
+    }
+  }
+}
+
+void RawTracer::decode_event_(const char *data, int length, unsigned long long timestamp, int cpu,
+                              std::vector<sched_record_t> &v_record)
+{
+  if (common_type_->offset + common_type_->size > length)
+    return;
+
+  int type = switch_format_.read(data, common_type_);
+  sched_record_t record;
+
+  memset(&record, 0, sizeof(record));
+  record.timestamp = timestamp;
+  record.cpu = cpu;
+
+  if (type == switch_format_.id)
+  {
+    if (next_prio_ == NULL || next_prio_->offset + next_prio_->size > length)
+      return;
+    record.type = SCHED_SWITCH_RECORD;
+    record.prev_pid = switch_format_.read(data, prev_pid_);
+    record.prev_prio = prev_prio_ ? switch_format_.read(data, prev_prio_) : 0;
+    record.prev_state = prev_state_ ? switch_format_.read(data, prev_state_) : 0;
+    record.next_pid = switch_format_.read(data, next_pid_);
+    record.next_prio = switch_format_.read(data, next_prio_);
+    v_record.push_back(record);
+  }
+  else if (type == wakeup_format_.id && wakeup_pid_ != NULL)
+  {
+    if (wakeup_pid_->offset + wakeup_pid_->size > length)
+      return;
+    record.type = SCHED_WAKEUP_RECORD;
+    record.prev_pid = -1;
+    record.next_pid = wakeup_format_.read(data, wakeup_pid_);
+    record.next_prio = wakeup_prio_ ? wakeup_format_.read(data, wakeup_prio_) : 0;
+    record.prev_state = wakeup_cpu_ ? wakeup_format_.read(data, wakeup_cpu_) : cpu;
+    v_record.push_back(record);
+  }
+}
@@ -0,0 +1,318 @@
+#include "timeline_index.h"
+#include <math.h>
+#include <algorithm>
+
+using namespace SchedViz;
+
+namespace
+{
+/* Slices longer than this many times the mean runtime of their row go to
+ * the long list of the row. */
+const double LONG_SLICE_FACTOR = 4.0;
+
+/* First position at or after from whose value is not less than value.
+ * Gallops from the current position, since the next pixel is usually near. */
+int gallop_lower_bound(const std::vector<double>& v, int from, double value)
+{
+  int step = 1;
+  int size = v.size();
+
+  while (from + step < size && v[from + step] < value)
+    step *= 2;
+
+  return std::lower_bound(v.begin() + from + step / 2, v.begin() + std::min(from + step, size), value) - v.begin();
+}
+
+/* orders slice indices by start_time */
+struct compare_start
+{
+  const std::vector<trace_info_t>* v_info;
+  bool operator()(int a, int b) const
+  {
+    return (*v_info)[a].start_time < (*v_info)[b].start_time;
+  }
+};
+}
+
+TimelineIndex::TimelineIndex() : v_info_(NULL), begin_time_(0), end_time_(0)
+{
+}
+
+TimelineIndex::~TimelineIndex()
+{
+}
+
+void TimelineIndex::clear()
+{
+  v_row_slice_.clear();
+  v_row_start_.clear();
+  v_row_busy_.clear();
+  v_row_max_runtime_.clear();
+  v_row_long_.clear();
+  v_row_long_start_.clear();
+  v_row_long_reach_.clear();
+  v_info_ = NULL;
+  begin_time_ = 0;
+  end_time_ = 0;
+}
+
+/* One row per core, the number of cores is taken from the trace */
+void TimelineIndex::build_by_core(const std::vector<trace_info_t> &v_info)
+{
+  std::vector<int> v_row(v_info.size());
+  int nr_rows = 0;
+
+  for (int i(0); i < (int)v_info.size(); i++)
+  {
+    v_row[i] = v_info[i].core;
+    nr_rows = std::max(nr_rows, v_info[i].core + 1);
+  }
+
+  build_(v_info, v_row, nr_rows);
+}
+
+/* One row per node listed in tracer_rosch.yaml */
+void TimelineIndex::build_by_node(const std::vector<trace_info_t> &v_info, const std::vector<node_info_t> &v_node)
+{
+  std::vector<int> v_row(v_info.size(), -1);
+
+  for (int i(0); i < (int)v_info.size(); i++)
+  {
+    for (int j(0); j < (int)v_node.size(); j++)
+    {
+      if (v_info[i].name == v_node[j].name)
+      {
+        v_row[i] = j;
+        break;
+      }
+    }
+  }
+
+  build_(v_info, v_row, v_node.size());
+}
+
+void TimelineIndex::build_(const std::vector<trace_info_t> &v_info, const std::vector<int> &v_row, int nr_rows)
+{
+  compare_start compare;
+  std::vector<std::vector<int> > v_row_all(nr_rows);
+  std::vector<double> v_row_total(nr_rows, 0);
+
+  clear();
+  v_info_ = &v_info;
+  v_row_slice_.resize(nr_rows);
+  v_row_start_.resize(nr_rows);
+  v_row_busy_.resize(nr_rows);
+  v_row_max_runtime_.resize(nr_rows, 0);
+  v_row_long_.resize(nr_rows);
+  v_row_long_start_.resize(nr_rows);
+  v_row_long_reach_.resize(nr_rows);
+
+  if (!v_info.empty())
+  {
+    begin_time_ = v_info[0].start_time;
+    end_time_ = v_info[0].start_time;
+  }
+
+  for (int i(0); i < (int)v_info.size(); i++)
+  {
+    begin_time_ = std::min(begin_time_, v_info[i].start_time);
+    end_time_ = std::max(end_time_, v_info[i].start_time + v_info[i].runtime);
+
+    if (v_row[i] < 0 || v_row[i] >= nr_rows)
+      continue;
+    v_row_all[v_row[i]].push_back(i);
+    v_row_total[v_row[i]] += v_info[i].runtime;
+  }
+
+  compare.v_info = v_info_;
+  for (int row(0); row < nr_rows; row++)
+  {
+    std::vector<int> &v_all = v_row_all[row];
+    double threshold = v_all.empty() ? 0 : LONG_SLICE_FACTOR * v_row_total[row] / v_all.size();
+
+    std::sort(v_all.begin(), v_all.end(), compare);
+    v_row_busy_[row].push_back(0);
+    for (int i(0); i < (int)v_all.size(); i++)
+    {
+      const trace_info_t &slice = v_info[v_all[i]];
+      if (slice.runtime > threshold)
+      {
+        double reach = slice.start_time + slice.runtime;
+        if (!v_row_long_reach_[row].empty())
+          reach = std::max(reach, v_row_long_reach_[row].back());
+        v_row_long_[row].push_back(v_all[i]);
+        v_row_long_start_[row].push_back(slice.start_time);
+        v_row_long_reach_[row].push_back(reach);
+        continue;
+      }
+      v_row_slice_[row].push_back(v_all[i]);
+      v_row_start_[row].push_back(slice.start_time);
+      v_row_busy_[row].push_back(v_row_busy_[row].back() + slice.runtime);
+      v_row_max_runtime_[row] = std::max(v_row_max_runtime_[row], slice.runtime);
+    }
+  }
+}
+
+int TimelineIndex::get_nr_rows()
+{
+  return v_row_slice_.size();
+}
+
+const trace_info_t &TimelineIndex::get_info(int index)
+{
+  return v_info_->at(index);
+}
+
+double TimelineIndex::get_begin_time()
+{
+  return begin_time_;
+}
+
+double TimelineIndex::get_end_time()
+{
+  return end_time_;
+}
+
+/* Emit one slice into v_item, either as an item of its own or into the
+ * density bar of its pixel. Returns true if it went into the bar. */
+bool TimelineIndex::add_(int index, double begin, double min_width, timeline_item_t &bar, bool &has_bar,
+                         long &bar_pixel, std::vector<timeline_item_t> &v_item)
+{
+  double start = (*v_info_)[index].start_time;
+  double runtime = (*v_info_)[index].runtime;
+
+  if (runtime >= min_width)
+  {
+    if (has_bar)
+    {
+      v_item.push_back(bar);
+      has_bar = false;
+    }
+    timeline_item_t item = { start, start + runtime, 1.0, 1, index };
+    v_item.push_back(item);
+    return false;
+  }
+
+  long pixel = floor((start - begin) / min_width);
+  if (has_bar && pixel == bar_pixel)
+  {
+    bar.density = std::min(1.0, bar.density + runtime / min_width);
+    bar.count++;
+  }
+  else
+  {
+    if (has_bar)
+      v_item.push_back(bar);
+    timeline_item_t item = { begin + pixel * min_width, begin + (pixel + 1) * min_width,
+                             std::min(1.0, runtime / min_width), 1, -1 };
+    bar = item;
+    bar_pixel = pixel;
+    has_bar = true;
+  }
+  return true;
+}
+
+/* Collect the items of a row overlapping [begin, end).
+ * Slices shorter than min_width (the time covered by a pixel) are
+ * accumulated into one density bar per pixel. The slices of a row do
+ * not overlap, so all but the last slice starting in a pixel lie inside
+ * it and are accounted at once from the prefix sums. A query therefore
+ * costs O(pixels * log(slices)) however far the view is zoomed out.
+ * The search starts v_row_max_runtime_ before begin, which excludes the
+ * long slices; those are merged in from their own list, where the first
+ * one reaching begin is found from the running max of their finish. */
+void TimelineIndex::query(int row, double begin, double end, double min_width, std::vector<timeline_item_t> &v_item)
+{
+  timeline_item_t bar;
+  bool has_bar = false;
+  long bar_pixel = 0;
+
+  v_item.clear();
+  if (row < 0 || row >= (int)v_row_slice_.size() || min_width <= 0)
+    return;
+
+  const std::vector<double> &v_start = v_row_start_[row];
+  const std::vector<double> &v_busy = v_row_busy_[row];
+  const std::vector<double> &v_long_start = v_row_long_start_[row];
+  const std::vector<double> &v_long_reach = v_row_long_reach_[row];
+  int k = std::lower_bound(v_start.begin(), v_start.end(), begin - v_row_max_runtime_[row]) - v_start.begin();
+  int j = std::lower_bound(v_long_reach.begin(), v_long_reach.end(), begin) - v_long_reach.begin();
+
+  for (;;)
+  {
+    while (k < (int)v_start.size() && v_start[k] < end)
+    {
+      const trace_info_t &slice = (*v_info_)[v_row_slice_[row][k]];
+      if (slice.start_time + slice.runtime >= begin)
+        break;
+      k++;
+    }
+    while (j < (int)v_long_start.size() && v_long_start[j] < end)
+    {
+      const trace_info_t &slice = (*v_info_)[v_row_long_[row][j]];
+      if (slice.start_time + slice.runtime >= begin)
+        break;
+      j++;
+    }
+
+    bool has_short = k < (int)v_start.size() && v_start[k] < end;
+    bool has_long = j < (int)v_long_start.size() && v_long_start[j] < end;
+    if (!has_short && !has_long)
+      break;
+
+    if (has_long && (!has_short || v_long_start[j] <= v_start[k]))
+    {
+      add_(v_row_long_[row][j], begin, min_width, bar, has_bar, bar_pixel, v_item);
+      j++;
+      continue;
+    }
+
+    bool in_bar = add_(v_row_slice_[row][k], begin, min_width, bar, has_bar, bar_pixel, v_item);
+    k++;
+    if (!in_bar)
+      continue;
+
+    /* skip to the last slice starting in this pixel */
+    int last = gallop_lower_bound(v_start, k, bar.finish) - 1;
+    if (last > k)
+    {
+      bar.density = std::min(1.0, bar.density + (v_busy[last] - v_busy[k]) / min_width);
+      bar.count += last - k;
+      k = last;
+    }
+  }
+
+  if (has_bar)
+    v_item.push_back(bar);
+}
+
+/* Return the slice of a row running at time, or -1 */
+int TimelineIndex::find(int row, double time, double tolerance)
+{
+  if (row < 0 || row >= (int)v_row_slice_.size())
+    return -1;
+
+  const std::vector<double> &v_start = v_row_start_[row];
+  std::vector<double>::const_iterator it =
+      std::lower_bound(v_start.begin(), v_start.end(), time - v_row_max_runtime_[row] - tolerance);
+
+  for (int k(it - v_start.begin()); k < (int)v_start.size() && v_start[k] <= time + tolerance; k++)
+  {
+    int index = v_row_slice_[row][k];
+    if (time <= (*v_info_)[index].start_time + (*v_info_)[index].runtime + tolerance)
+      return index;
+  }
+
+  const std::vector<double> &v_long_start = v_row_long_start_[row];
+  const std::vector<double> &v_long_reach = v_row_long_reach_[row];
+  it = std::lower_bound(v_long_reach.begin(), v_long_reach.end(), time - tolerance);
+
+  for (int k(it - v_long_reach.begin()); k < (int)v_long_start.size() && v_long_start[k] <= time + tolerance; k++)
+  {
+    int index = v_row_long_[row][k];
+    if (time <= (*v_info_)[index].start_time + (*v_info_)[index].runtime + tolerance)
+      return index;
+  }
+
+  return -1;
+}
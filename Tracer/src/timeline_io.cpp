@@ -0,0 +1,331 @@
+#include "timeline_io.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <sstream>
+
+using namespace SchedViz;
+
+namespace
+{
+typedef struct timeline_slice_t
+{
+  double start_time;
+  double runtime;
+  uint32_t pid;
+  int16_t core;
+  int16_t prio;
+} timeline_slice_t;
+
+template <typename T>
+void write_value(std::ofstream &out, T value)
+{
+  out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+template <typename T>
+bool read_value(std::ifstream &in, T &value)
+{
+  return (bool)in.read(reinterpret_cast<char*>(&value), sizeof(value));
+}
+
+void write_string(std::ofstream &out, const std::string &str)
+{
+  write_value<uint32_t>(out, str.size());
+  out.write(str.data(), str.size());
+}
+
+bool read_string(std::ifstream &in, std::string &str)
+{
+  uint32_t len;
+
+  if (!read_value(in, len))
+    return false;
+  str.resize(len);
+  return len == 0 || (bool)in.read(&str[0], len);
+}
+
+bool read_strings(std::ifstream &in, std::vector<std::string> &v_str)
+{
+  uint32_t nr;
+
+  if (!read_value(in, nr))
+    return false;
+  v_str.resize(nr);
+  for (uint32_t i(0); i < nr; i++)
+  {
+    if (!read_string(in, v_str[i]))
+      return false;
+  }
+  return true;
+}
+
+std::string escape_json(const std::string &str)
+{
+  std::ostringstream ss;
+
+  for (int i(0); i < (int)str.size(); i++)
+  {
+    unsigned char c = str[i];
+    if (c == '"' || c == '\\')
+      ss << '\\' << c;
+    else if (c < 0x20)
+    {
+      char buf[8];
+      snprintf(buf, sizeof(buf), "\\u%04x", c);
+      ss << buf;
+    }
+    else
+      ss << c;
+  }
+  return ss.str();
+}
+
+/* Slices only know their pid, the name and topics come from the node table */
+void fill_node_info(std::vector<trace_info_t> &v_info, const std::vector<node_info_t> &v_node)
+{
+  std::map<unsigned int, const node_info_t*> pid_to_node;
+
+  for (int i(0); i < (int)v_node.size(); i++)
+    pid_to_node[v_node[i].pid] = &v_node[i];
+
+  for (int i(0); i < (int)v_info.size(); i++)
+  {
+    std::map<unsigned int, const node_info_t*>::iterator it = pid_to_node.find(v_info[i].pid);
+    if (it == pid_to_node.end())
+      continue;
+    v_info[i].name = it->second->name;
+    v_info[i].deadline = it->second->deadline;
+    v_info[i].v_subtopic = it->second->v_subtopic;
+    v_info[i].v_pubtopic = it->second->v_pubtopic;
+  }
+}
+
+bool read_timeline_binary(std::ifstream &in, std::vector<trace_info_t> &v_info, std::vector<node_info_t> &v_node)
+{
+  uint32_t magic, version, nr_nodes;
+  uint64_t nr_slices;
+
+  if (!read_value(in, magic) || !read_value(in, version) || !read_value(in, nr_nodes) || !read_value(in, nr_slices))
+    return false;
+  if (magic != TIMELINE_MAGIC || version != TIMELINE_VERSION)
+    return false;
+
+  v_node.resize(nr_nodes);
+  for (uint32_t i(0); i < nr_nodes; i++)
+  {
+    node_info_t &node = v_node[i];
+    uint32_t pid;
+    if (!read_value(in, pid) || !read_value(in, node.deadline) || !read_string(in, node.name) ||
+        !read_strings(in, node.v_subtopic) || !read_strings(in, node.v_pubtopic))
+      return false;
+    node.pid = pid;
+  }
+
+  std::vector<timeline_slice_t> v_slice(nr_slices);
+  if (nr_slices > 0 && !in.read(reinterpret_cast<char*>(&v_slice[0]), nr_slices * sizeof(timeline_slice_t)))
+    return false;
+
+  v_info.resize(nr_slices);
+  for (uint64_t i(0); i < nr_slices; i++)
+  {
+    v_info[i].start_time = v_slice[i].start_time;
+    v_info[i].runtime = v_slice[i].runtime;
+    v_info[i].pid = v_slice[i].pid;
+    v_info[i].core = v_slice[i].core;
+    v_info[i].prio = v_slice[i].prio;
+    v_info[i].deadline = 0;
+  }
+  fill_node_info(v_info, v_node);
+
+  return true;
+}
+
+/* name,pid,core,prio,start_time,runtime,deadline */
+bool read_timeline_csv(std::ifstream &in, std::vector<trace_info_t> &v_info, std::vector<node_info_t> &v_node)
+{
+  std::map<unsigned int, int> pid_to_node;
+  std::string buf;
+
+  std::getline(in, buf);  // header
+  while (std::getline(in, buf))
+  {
+    std::vector<std::string> v_field;
+    std::istringstream line(buf);
+    std::string field;
+
+    while (std::getline(line, field, ','))
+      v_field.push_back(field);
+    if (v_field.size() < 7)
+      continue;
+
+    trace_info_t info;
+    info.name = v_field[0];
+    info.pid = strtoul(v_field[1].c_str(), NULL, 10);
+    info.core = atoi(v_field[2].c_str());
+    info.prio = atoi(v_field[3].c_str());
+    info.start_time = atof(v_field[4].c_str());
+    info.runtime = atof(v_field[5].c_str());
+    info.deadline = atof(v_field[6].c_str());
+    v_info.push_back(info);
+
+    if (pid_to_node.find(info.pid) == pid_to_node.end())
+    {
+      node_info_t node;
+      node.name = info.name;
+      node.pid = info.pid;
+      node.deadline = info.deadline;
+      pid_to_node[info.pid] = v_node.size();
+      v_node.push_back(node);
+    }
+  }
+
+  return true;
+}
+}
+
+bool SchedViz::write_timeline_csv(const std::string &filename, const std::vector<trace_info_t> &v_info)
+{
+  std::ofstream out(filename.c_str());
+
+  if (!out)
+    return false;
+
+  out << "name,pid,core,prio,start_time,runtime,deadline\n";
+  out.setf(std::ios::fixed);
+  out.precision(9);
+  for (int i(0); i < (int)v_info.size(); i++)
+  {
+    const trace_info_t &info = v_info[i];
+    out << info.name << "," << info.pid << "," << info.core << "," << info.prio << "," << info.start_time << ","
+        << info.runtime << "," << info.deadline << "\n";
+  }
+
+  return (bool)out;
+}
+
+bool SchedViz::write_timeline_binary(const std::string &filename, const std::vector<trace_info_t> &v_info,
+                                     const std::vector<node_info_t> &v_node)
+{
+  std::ofstream out(filename.c_str(), std::ios::binary);
+  std::vector<timeline_slice_t> v_slice(v_info.size());
+
+  if (!out)
+    return false;
+
+  write_value<uint32_t>(out, TIMELINE_MAGIC);
+  write_value<uint32_t>(out, TIMELINE_VERSION);
+  write_value<uint32_t>(out, v_node.size());
+  write_value<uint64_t>(out, v_info.size());
+
+  for (int i(0); i < (int)v_node.size(); i++)
+  {
+    const node_info_t &node = v_node[i];
+    write_value<uint32_t>(out, node.pid);
+    write_value<double>(out, node.deadline);
+    write_string(out, node.name);
+    write_value<uint32_t>(out, node.v_subtopic.size());
+    for (int j(0); j < (int)node.v_subtopic.size(); j++)
+      write_string(out, node.v_subtopic[j]);
+    write_value<uint32_t>(out, node.v_pubtopic.size());
+    for (int j(0); j < (int)node.v_pubtopic.size(); j++)
+      write_string(out, node.v_pubtopic[j]);
+  }
+
+  for (int i(0); i < (int)v_info.size(); i++)
+  {
+    v_slice[i].start_time = v_info[i].start_time;
+    v_slice[i].runtime = v_info[i].runtime;
+    v_slice[i].pid = v_info[i].pid;
+    v_slice[i].core = v_info[i].core;
+    v_slice[i].prio = v_info[i].prio;
+  }
+  if (!v_slice.empty())
+    out.write(reinterpret_cast<const char*>(&v_slice[0]), v_slice.size() * sizeof(timeline_slice_t));
+
+  return (bool)out;
+}
+
+bool SchedViz::read_timeline(const std::string &filename, std::vector<trace_info_t> &v_info,
+                             std::vector<node_info_t> &v_node)
+{
+  std::ifstream in(filename.c_str(), std::ios::binary);
+  uint32_t magic = 0;
+
+  v_info.clear();
+  v_node.clear();
+  if (!in)
+    return false;
+
+  read_value(in, magic);
+  in.clear();
+  in.seekg(0);
+
+  if (magic == TIMELINE_MAGIC)
+    return read_timeline_binary(in, v_info, v_node);
+  return read_timeline_csv(in, v_info, v_node);
+}
+
+/* Per-node totals of the timeline, plus the job statistics when available */
+bool SchedViz::write_summary_json(const std::string &filename, const std::vector<trace_info_t> &v_info,
+                                  const std::vector<node_info_t> &v_node, const std::vector<node_stat_t> &v_stat)
+{
+  std::ofstream out(filename.c_str());
+  double begin_time = 0, end_time = 0;
+
+  if (!out)
+    return false;
+
+  for (int i(0); i < (int)v_info.size(); i++)
+  {
+    if (i == 0 || v_info[i].start_time < begin_time)
+      begin_time = v_info[i].start_time;
+    end_time = std::max(end_time, v_info[i].start_time + v_info[i].runtime);
+  }
+
+  out.setf(std::ios::fixed);
+  out.precision(9);
+  out << "{\n"
+      << "  \"begin_time\": " << begin_time << ",\n"
+      << "  \"duration\": " << (end_time - begin_time) << ",\n"
+      << "  \"nr_slices\": " << v_info.size() << ",\n"
+      << "  \"nodes\": [";
+
+  for (int i(0); i < (int)v_node.size(); i++)
+  {
+    const node_info_t &node = v_node[i];
+    double runtime = 0;
+    int nr_slices = 0;
+
+    for (int j(0); j < (int)v_info.size(); j++)
+    {
+      if (v_info[j].pid != node.pid)
+        continue;
+      runtime += v_info[j].runtime;
+      nr_slices++;
+    }
+
+    out << (i == 0 ? "\n" : ",\n") << "    {\"name\": \"" << escape_json(node.name) << "\", \"pid\": " << node.pid
+        << ", \"deadline_ms\": " << node.deadline << ", \"nr_slices\": " << nr_slices << ", \"runtime\": " << runtime;
+
+    for (int j(0); j < (int)v_stat.size(); j++)
+    {
+      const node_stat_t &stat = v_stat[j];
+      if (stat.name != node.name)
+        continue;
+      out << ", \"jobs\": " << stat.nr_jobs << ", \"deadline_misses\": " << stat.nr_deadline_misses
+          << ", \"preemptions\": " << stat.preemptions << ", \"migrations\": " << stat.migrations
+          << ", \"max_response_time\": " << stat.max_response_time
+          << ", \"mean_response_time\": " << (stat.nr_jobs > 0 ? stat.sum_response_time / stat.nr_jobs : 0)
+          << ", \"max_chain_latency\": " << std::max(0.0, stat.max_chain_latency);
+      break;
+    }
+    out << "}";
+  }
+  out << (v_node.empty() ? "]\n" : "\n  ]\n") << "}\n";
+
+  return (bool)out;
+}
@@ -0,0 +1,248 @@
+#include "timeline_view.h"
+#include <QMouseEvent>
+#include <QPaintEvent>
+#include <QPainter>
+#include <QScrollBar>
+#include <QWheelEvent>
+#include <limits.h>
+#include <algorithm>
+#include <sstream>
+
+#define LABEL_WIDTH 80
+#define TOP_MARGIN 12
+#define ROW_SPACE 38
+#define BAR_HEIGHT 10
+/* slices narrower than this are aggregated into density bars */
+#define MIN_SLICE_PIXELS 2.0
+#define ZOOM_STEP 1.25
+
+TimelineView::TimelineView(QTextBrowser *browser, QWidget *parent)
+  : QAbstractScrollArea(parent), browser_(browser), zoom_(1000), selected_(-1)
+{
+  setMinimumHeight(TOP_MARGIN + ROW_SPACE * 2);
+  viewport()->setBackgroundRole(QPalette::Base);
+}
+
+TimelineView::~TimelineView()
+{
+}
+
+void TimelineView::set_trace_by_core(const std::vector<trace_info_t> &info)
+{
+  index_.build_by_core(info);
+
+  v_label_.clear();
+  for (int i(0); i < index_.get_nr_rows(); i++)
+  {
+    std::ostringstream label;
+    label << "cpu " << i;
+    v_label_.push_back(label.str());
+  }
+
+  v_marker_.assign(index_.get_nr_rows(), std::vector<double>());
+  selected_ = -1;
+  update_scroll_bars_();
+  viewport()->update();
+}
+
+void TimelineView::set_trace_by_node(const std::vector<trace_info_t> &info, const std::vector<node_info_t> &node_list)
+{
+  index_.build_by_node(info, node_list);
+
+  v_label_.clear();
+  for (int i(0); i < (int)node_list.size(); i++)
+    v_label_.push_back(node_list[i].name);
+
+  v_marker_.assign(index_.get_nr_rows(), std::vector<double>());
+  selected_ = -1;
+  update_scroll_bars_();
+  viewport()->update();
+}
+
+void TimelineView::set_color(unsigned int pid, const QColor &color)
+{
+  colors_[pid] = color;
+}
+
+/* Draw a vertical line on a row, e.g. at a deadline miss */
+void TimelineView::add_marker(int row, double time)
+{
+  if (row < 0 || row >= (int)v_marker_.size())
+    return;
+  v_marker_[row].push_back(time);
+}
+
+void TimelineView::clear()
+{
+  index_.clear();
+  v_label_.clear();
+  v_marker_.clear();
+  selected_ = -1;
+  update_scroll_bars_();
+  viewport()->update();
+}
+
+/* Keep the time at the center of the view while zooming */
+void TimelineView::set_zoom(double zoom)
+{
+  double width = std::max(1, viewport()->width() - LABEL_WIDTH);
+  double duration = index_.get_end_time() - index_.get_begin_time();
+  double center = get_view_begin_() + width / 2 / zoom_;
+
+  /* the scroll bar range is an int of pixels */
+  if (duration > 0)
+    zoom = std::min(zoom, (INT_MAX / 2) / duration);
+  zoom_ = std::max(zoom, 1e-3);
+
+  update_scroll_bars_();
+  horizontalScrollBar()->setValue((int)((center - index_.get_begin_time()) * zoom_ - width / 2));
+  viewport()->update();
+}
+
+double TimelineView::get_zoom()
+{
+  return zoom_;
+}
+
+double TimelineView::get_view_begin_()
+{
+  return index_.get_begin_time() + horizontalScrollBar()->value() / zoom_;
+}
+
+void TimelineView::update_scroll_bars_()
+{
+  double width = viewport()->width() - LABEL_WIDTH;
+  double total_width = (index_.get_end_time() - index_.get_begin_time()) * zoom_;
+  int total_height = TOP_MARGIN + index_.get_nr_rows() * ROW_SPACE;
+
+  horizontalScrollBar()->setRange(0, (int)std::max(0.0, total_width - width));
+  horizontalScrollBar()->setPageStep((int)std::max(1.0, width));
+  horizontalScrollBar()->setSingleStep((int)std::max(1.0, width / 20));
+  verticalScrollBar()->setRange(0, std::max(0, total_height - viewport()->height()));
+  verticalScrollBar()->setPageStep(viewport()->height());
+  verticalScrollBar()->setSingleStep(ROW_SPACE);
+}
+
+void TimelineView::paintEvent(QPaintEvent *)
+{
+  QPainter painter(viewport());
+  int width = viewport()->width() - LABEL_WIDTH;
+  int y_offset = TOP_MARGIN - verticalScrollBar()->value();
+  double begin = get_view_begin_();
+  double end = begin + width / zoom_;
+  double min_width = MIN_SLICE_PIXELS / zoom_;
+
+  painter.fillRect(viewport()->rect(), Qt::white);
+
+  for (int row(0); row < index_.get_nr_rows(); row++)
+  {
+    int y = y_offset + row * ROW_SPACE;
+    if (y + ROW_SPACE < 0 || y > viewport()->height())
+      continue;
+
+    painter.setClipping(false);
+    painter.setPen(Qt::black);
+    painter.drawText(4, y + BAR_HEIGHT, QString::fromStdString(v_label_[row]));
+    painter.setClipRect(LABEL_WIDTH, 0, width, viewport()->height());
+
+    /* only the slices overlapping [begin, end) are visited */
+    index_.query(row, begin, end, min_width, v_item_);
+    for (int i(0); i < (int)v_item_.size(); i++)
+    {
+      const timeline_item_t &item = v_item_[i];
+      double x = LABEL_WIDTH + (item.start - begin) * zoom_;
+      double w = std::max(1.0, (item.finish - item.start) * zoom_);
+      QRectF rec(x, y, w, BAR_HEIGHT);
+
+      if (item.index < 0)
+      {
+        /* darker for busier pixels */
+        QColor density(Qt::darkGray);
+        density.setAlphaF(0.25 + 0.75 * item.density);
+        painter.fillRect(rec, density);
+        continue;
+      }
+
+      const trace_info_t &node_info = index_.get_info(item.index);
+      QColor color = (item.index == selected_) ? QColor(Qt::red) : colors_[node_info.pid];
+      painter.fillRect(rec, color);
+      if (w >= 2 * MIN_SLICE_PIXELS)
+        painter.drawRect(rec);
+    }
+
+    painter.setPen(Qt::red);
+    for (int i(0); i < (int)v_marker_[row].size(); i++)
+    {
+      double x = LABEL_WIDTH + (v_marker_[row][i] - begin) * zoom_;
+      if (x >= LABEL_WIDTH && x <= LABEL_WIDTH + width)
+        painter.drawLine(QPointF(x, y), QPointF(x, y - BAR_HEIGHT));
+    }
+  }
+}
+
+void TimelineView::resizeEvent(QResizeEvent *event)
+{
+  update_scroll_bars_();
+  QAbstractScrollArea::resizeEvent(event);
+}
+
+void TimelineView::scrollContentsBy(int, int)
+{
+  viewport()->update();
+}
+
+void TimelineView::mousePressEvent(QMouseEvent *event)
+{
+  int y = event->pos().y() - TOP_MARGIN + verticalScrollBar()->value();
+  int row = y / ROW_SPACE;
+  double time = get_view_begin_() + (event->pos().x() - LABEL_WIDTH) / zoom_;
+
+  if (y < 0 || y % ROW_SPACE > BAR_HEIGHT || event->pos().x() < LABEL_WIDTH)
+    return;
+
+  selected_ = index_.find(row, time, MIN_SLICE_PIXELS / zoom_);
+  if (selected_ >= 0)
+    show_node_info_(index_.get_info(selected_));
+  viewport()->update();
+}
+
+/* Ctrl + wheel zooms, wheel alone scrolls */
+void TimelineView::wheelEvent(QWheelEvent *event)
+{
+  if (event->modifiers() & Qt::ControlModifier)
+  {
+    set_zoom(event->delta() > 0 ? zoom_ * ZOOM_STEP : zoom_ / ZOOM_STEP);
+    event->accept();
+    return;
+  }
+  QAbstractScrollArea::wheelEvent(event);
+}
+
+void TimelineView::show_node_info_(const trace_info_t &node_info)
+{
+  std::stringstream ss;
+  std::stringstream sub_topic;
+  std::stringstream pub_topic;
+
+  for (int i(0); i < (int)node_info.v_subtopic.size(); i++)
+  {
+    sub_topic << node_info.v_subtopic.at(i) << ", ";
+  }
+
+  for (int i(0); i < (int)node_info.v_pubtopic.size(); i++)
+  {
+    pub_topic << node_info.v_pubtopic.at(i) << ", ";
+  }
+
+  ss << "Name: " << node_info.name << "\n"
+     << "PID: " << node_info.pid << "\n"
+     << "Prio " << node_info.prio << "\n"
+     << "Core: " << node_info.core << "\n"
+     << "Runtime: " << node_info.runtime << "\n"
+     << "Start Time: " << std::fixed << node_info.start_time << "\n"
+     << "Finish Time: " << node_info.start_time + node_info.runtime << "\n"
+     << "sub Topics: " << sub_topic.str() << "\n"
+     << "pub Topic: " << pub_topic.str();
+
+  browser_->setText(QString::fromStdString(ss.str()));
+}
@@ -0,0 +1,287 @@
+#include "trace_analytics.h"
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <queue>
+
+/* prev_state of a task switched out while still runnable (preempted).
+ * Newer kernels report it as TASK_REPORT_MAX, older ones as TASK_STATE_MAX,
+ * both of which have no bit of the sleeping states set. */
+#define TASK_STATE_SLEEPING_MASK 0xff
+
+using namespace SchedViz;
+
+TraceAnalytics::TraceAnalytics(const std::vector<node_info_t> &v_node_info) : v_node_info_(v_node_info)
+{
+  for (int i(0); i < (int)v_node_info_.size(); i++)
+    pid_to_node_[v_node_info_[i].pid] = i;
+
+  build_graph_();
+}
+
+TraceAnalytics::~TraceAnalytics()
+{
+}
+
+/* node A precedes node B when A publishes a topic B subscribes */
+void TraceAnalytics::build_graph_()
+{
+  int nr_nodes = v_node_info_.size();
+
+  v_pred_.assign(nr_nodes, std::vector<int>());
+  v_end_node_.assign(nr_nodes, true);
+
+  for (int a(0); a < nr_nodes; a++)
+  {
+    for (int b(0); b < nr_nodes; b++)
+    {
+      if (a == b)
+        continue;
+
+      const std::vector<std::string> &v_pubtopic = v_node_info_[a].v_pubtopic;
+      const std::vector<std::string> &v_subtopic = v_node_info_[b].v_subtopic;
+      for (int i(0); i < (int)v_pubtopic.size(); i++)
+      {
+        if (std::find(v_subtopic.begin(), v_subtopic.end(), v_pubtopic[i]) != v_subtopic.end())
+        {
+          v_pred_[b].push_back(a);
+          v_end_node_[a] = false;
+          break;
+        }
+      }
+    }
+  }
+}
+
+/* Merge the per-CPU records in time order and run the per-node state machines */
+void TraceAnalytics::analyze(const std::vector<std::vector<sched_record_t> > &v_records)
+{
+  typedef std::pair<unsigned long long, int> head_t;  // timestamp, cpu
+  std::priority_queue<head_t, std::vector<head_t>, std::greater<head_t> > heads;
+  std::vector<int> v_pos(v_records.size(), 0);
+
+  node_state_t init_state;
+  init_state.active = false;
+  init_state.running = false;
+  init_state.last_cpu = -1;
+  init_state.run_start = 0;
+  init_state.origin = -1;
+  init_state.last_origin = -1;
+
+  v_state_.assign(v_node_info_.size(), init_state);
+  v_stat_.resize(v_node_info_.size());
+  for (int i(0); i < (int)v_stat_.size(); i++)
+  {
+    memset(v_stat_[i].v_histogram, 0, sizeof(v_stat_[i].v_histogram));
+    v_stat_[i].name = v_node_info_[i].name;
+    v_stat_[i].nr_jobs = 0;
+    v_stat_[i].nr_deadline_misses = 0;
+    v_stat_[i].preemptions = 0;
+    v_stat_[i].migrations = 0;
+    v_stat_[i].max_response_time = 0;
+    v_stat_[i].sum_response_time = 0;
+    v_stat_[i].max_chain_latency = 0;
+  }
+  v_job_.clear();
+
+  for (int cpu(0); cpu < (int)v_records.size(); cpu++)
+  {
+    if (!v_records[cpu].empty())
+      heads.push(head_t(v_records[cpu][0].timestamp, cpu));
+  }
+
+  while (!heads.empty())
+  {
+    int cpu = heads.top().second;
+    const sched_record_t &record = v_records[cpu][v_pos[cpu]];
+    double time = record.timestamp / 1000000000.0;
+    std::map<unsigned int, int>::iterator it;
+
+    heads.pop();
+    if (++v_pos[cpu] < (int)v_records[cpu].size())
+      heads.push(head_t(v_records[cpu][v_pos[cpu]].timestamp, cpu));
+
+    switch (record.type)
+    {
+      case SCHED_WAKEUP_RECORD:
+        if ((it = pid_to_node_.find(record.next_pid)) != pid_to_node_.end())
+          release_(it->second, time);
+        break;
+
+      case SCHED_SWITCH_RECORD:
+        if ((it = pid_to_node_.find(record.prev_pid)) != pid_to_node_.end())
+          switch_out_(it->second, time, record.prev_state);
+        if ((it = pid_to_node_.find(record.next_pid)) != pid_to_node_.end())
+          switch_in_(it->second, record.cpu, time);
+        break;
+
+      default:
+        break;
+    }
+  }
+}
+
+void TraceAnalytics::release_(int node, double time)
+{
+  node_state_t &state = v_state_[node];
+
+  /* a wakeup of a job already released does not start a new one */
+  if (state.active)
+    return;
+
+  state.active = true;
+  state.job.name = v_node_info_[node].name;
+  state.job.pid = v_node_info_[node].pid;
+  state.job.release = time;
+  state.job.start = -1;
+  state.job.finish = -1;
+  state.job.exec_time = 0;
+  state.job.preemptions = 0;
+  state.job.migrations = 0;
+  state.job.chain_latency = -1;
+
+  /* the input of this job is as old as the oldest latest output of its predecessors */
+  state.origin = v_pred_[node].empty() ? time : -1;
+  for (int i(0); i < (int)v_pred_[node].size(); i++)
+  {
+    double pred_origin = v_state_[v_pred_[node][i]].last_origin;
+    if (pred_origin < 0)
+    {
+      state.origin = -1;
+      break;
+    }
+    if (state.origin < 0 || pred_origin < state.origin)
+      state.origin = pred_origin;
+  }
+}
+
+void TraceAnalytics::switch_in_(int node, int cpu, double time)
+{
+  node_state_t &state = v_state_[node];
+
+  /* no wakeup was seen, e.g. at the beginning of the trace */
+  if (!state.active)
+    release_(node, time);
+
+  if (state.running)
+    return;
+
+  if (state.job.start < 0)
+    state.job.start = time;
+  else if (cpu != state.last_cpu)
+    state.job.migrations++;
+
+  state.last_cpu = cpu;
+  state.run_start = time;
+  state.running = true;
+}
+
+void TraceAnalytics::switch_out_(int node, double time, long long prev_state)
+{
+  node_state_t &state = v_state_[node];
+
+  if (!state.running)
+    return;
+
+  state.job.exec_time += time - state.run_start;
+  state.running = false;
+
+  if ((prev_state & TASK_STATE_SLEEPING_MASK) == 0)
+    state.job.preemptions++;
+  else
+    complete_(node, time);
+}
+
+void TraceAnalytics::complete_(int node, double time)
+{
+  node_state_t &state = v_state_[node];
+  node_stat_t &stat = v_stat_[node];
+  job_info_t &job = state.job;
+  double deadline = v_node_info_[node].deadline;  // ms, 0 means none
+  double response_us;
+  int bin;
+
+  job.job = stat.nr_jobs;
+  job.finish = time;
+  job.response_time = time - job.release;
+  job.blocking_time = std::max(0.0, job.response_time - job.exec_time);
+  job.deadline_miss = deadline > 0 && job.response_time * 1000 > deadline;
+  if (v_end_node_[node] && state.origin >= 0)
+    job.chain_latency = time - state.origin;
+
+  state.last_origin = state.origin;
+  state.active = false;
+
+  response_us = job.response_time * 1000000;
+  bin = (response_us < 2) ? 0 : std::min(RESPONSE_HISTOGRAM_BINS - 1, (int)floor(log2(response_us)));
+
+  stat.nr_jobs++;
+  stat.nr_deadline_misses += job.deadline_miss ? 1 : 0;
+  stat.preemptions += job.preemptions;
+  stat.migrations += job.migrations;
+  stat.max_response_time = std::max(stat.max_response_time, job.response_time);
+  stat.sum_response_time += job.response_time;
+  stat.max_chain_latency = std::max(stat.max_chain_latency, job.chain_latency);
+  stat.v_histogram[bin]++;
+
+  v_job_.push_back(job);
+}
+
+std::vector<job_info_t> TraceAnalytics::get_job_info()
+{
+  return v_job_;
+}
+
+std::vector<node_stat_t> TraceAnalytics::get_node_stat()
+{
+  return v_stat_;
+}
+
+bool TraceAnalytics::write_job_csv(const std::string &filename)
+{
+  std::ofstream out(filename.c_str());
+
+  if (!out)
+    return false;
+
+  out << "name,pid,job,release,start,finish,response_time,exec_time,blocking_time,preemptions,migrations,"
+         "deadline_miss,chain_latency\n";
+  out.setf(std::ios::fixed);
+  out.precision(9);
+  for (int i(0); i < (int)v_job_.size(); i++)
+  {
+    const job_info_t &job = v_job_[i];
+    out << job.name << "," << job.pid << "," << job.job << "," << job.release << "," << job.start << ","
+        << job.finish << "," << job.response_time << "," << job.exec_time << "," << job.blocking_time << ","
+        << job.preemptions << "," << job.migrations << "," << (job.deadline_miss ? 1 : 0) << ","
+        << job.chain_latency << "\n";
+  }
+
+  return true;
+}
+
+/* bin 0 also holds response times below 1 us */
+bool TraceAnalytics::write_histogram_csv(const std::string &filename)
+{
+  std::ofstream out(filename.c_str());
+
+  if (!out)
+    return false;
+
+  out << "name,lower_us,upper_us,count\n";
+  for (int i(0); i < (int)v_stat_.size(); i++)
+  {
+    for (int bin(0); bin < RESPONSE_HISTOGRAM_BINS; bin++)
+    {
+      if (v_stat_[i].v_histogram[bin] == 0)
+        continue;
+      out << v_stat_[i].name << "," << (bin == 0 ? 0 : (1ULL << bin)) << "," << (1ULL << (bin + 1)) << ","
+          << v_stat_[i].v_histogram[bin] << "\n";
+    }
+  }
+
+  return true;
+}
@@ -0,0 +1,190 @@
+#include "tracefs.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+using namespace SchedViz;
+
+static const char *control_files[] = { "tracing_on", "trace", "current_tracer", "buffer_size_kb", "set_event",
+                                       "set_event_pid" };
+
+TraceFs::TraceFs()
+{
+  struct stat st;
+
+  /* tracefs has its own mount point since Linux 4.1 */
+  if (stat("/sys/kernel/tracing/trace", &st) == 0)
+    tracing_dir_ = "/sys/kernel/tracing";
+  else
+    tracing_dir_ = "/sys/kernel/debug/tracing";
+
+  for (int i(0); i < NR_CONTROL_FILES; i++)
+    fd_[i] = -1;
+}
+
+TraceFs::~TraceFs()
+{
+  close();
+}
+
+std::string TraceFs::get_tracing_dir()
+{
+  return tracing_dir_;
+}
+
+bool TraceFs::is_open()
+{
+  return fd_[TRACING_ON] >= 0;
+}
+
+/* Open all control files. Returns false when tracefs is not mounted
+ * or the process is not allowed to write it. set_event_pid is optional
+ * since it only exists on Linux 4.4 and later. */
+bool TraceFs::open()
+{
+  if (is_open())
+    return true;
+
+  for (int i(0); i < NR_CONTROL_FILES; i++)
+  {
+    /* opening set_event and trace with O_TRUNC clears them */
+    if (!open_(i, i != BUFFER_SIZE_KB && i != CURRENT_TRACER && i != TRACING_ON) && i != SET_EVENT_PID)
+    {
+      close();
+      return false;
+    }
+  }
+
+  return true;
+}
+
+void TraceFs::close()
+{
+  for (int i(0); i < NR_CONTROL_FILES; i++)
+  {
+    if (fd_[i] >= 0)
+      ::close(fd_[i]);
+    fd_[i] = -1;
+  }
+}
+
+bool TraceFs::open_(int index, bool truncate)
+{
+  std::string path = tracing_dir_ + "/" + control_files[index];
+
+  if (fd_[index] >= 0)
+    ::close(fd_[index]);
+
+  fd_[index] = ::open(path.c_str(), O_WRONLY | (truncate ? O_TRUNC : 0));
+  if (fd_[index] < 0)
+  {
+    if (errno != ENOENT || index != SET_EVENT_PID)
+      std::cerr << "TraceFs: cannot open " << path << ": " << strerror(errno) << std::endl;
+    return false;
+  }
+
+  return true;
+}
+
+/* The kernel parses one token per write for some files (e.g. set_event)
+ * and reports a short count, so keep writing until everything is consumed. */
+bool TraceFs::write_(int index, const std::string &value)
+{
+  const char *buf = value.c_str();
+  size_t len = value.size();
+
+  if (fd_[index] < 0)
+    return false;
+
+  while (len > 0)
+  {
+    ssize_t ret = ::write(fd_[index], buf, len);
+    if (ret < 0)
+    {
+      if (errno == EINTR)
+        continue;
+      std::cerr << "TraceFs: write to " << control_files[index] << " failed: " << strerror(errno) << std::endl;
+      return false;
+    }
+    if (ret == 0)
+      break;
+    buf += ret;
+    len -= ret;
+  }
+
+  return true;
+}
+
+bool TraceFs::set_tracing_on(bool on)
+{
+  return write_(TRACING_ON, on ? "1" : "0");
+}
+
+bool TraceFs::clear_trace()
+{
+  return open_(TRACE, true);
+}
+
+bool TraceFs::set_current_tracer(const std::string &tracer)
+{
+  return write_(CURRENT_TRACER, tracer);
+}
+
+/* buffer_size_kb is the size of the ring buffer of each CPU */
+bool TraceFs::set_buffer_size_kb(int size_kb)
+{
+  std::ostringstream size;
+  size << size_kb;
+  return write_(BUFFER_SIZE_KB, size.str());
+}
+
+/* Enable only the events the Tracer decodes */
+bool TraceFs::set_sched_events()
+{
+  return clear_events() && write_(SET_EVENT, "sched:sched_switch sched:sched_wakeup\n");
+}
+
+bool TraceFs::clear_events()
+{
+  return open_(SET_EVENT, true);
+}
+
+/* All PIDs are set in a single write */
+bool TraceFs::set_pid_filter(const std::vector<unsigned int> &v_pid)
+{
+  std::ostringstream pids;
+
+  if (!clear_pid_filter())
+    return false;
+
+  for (int i(0); i < (int)v_pid.size(); i++)
+  {
+    if (v_pid[i] != 0)
+      pids << v_pid[i] << " ";
+  }
+  pids << "\n";
+
+  return write_(SET_EVENT_PID, pids.str());
+}
+
+bool TraceFs::clear_pid_filter()
+{
+  return open_(SET_EVENT_PID, true);
+}
+
+bool TraceFs::dump_trace(const std::string &path)
+{
+  std::ifstream in((tracing_dir_ + "/trace").c_str());
+  if (!in)
+    return false;
+
+  std::ofstream out(path.c_str());
+  out << in.rdbuf();
+  return true;
+}
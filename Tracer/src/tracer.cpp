@@ -5,6 +5,7 @@
 #include <sys/types.h>
 #include <time.h>
 #include <unistd.h>
+#include <algorithm>
 #include <fstream>
 #include <iostream>
 #include <iostream>
@@ -13,14 +14,31 @@
 #include "string"
 #include "yaml-cpp/yaml.h"
 
+/* size of the ring buffer of each CPU */
+#define TRACE_BUFFER_SIZE_KB 8192
+
 using namespace SchedViz;
 
-Tracer::Tracer() : config_()
+Tracer::Tracer()
+  : config_(), tracefs_(), raw_tracer_(tracefs_.get_tracing_dir()), raw_capture_(false), output_dir_(".")
 {
   std::string filename(config_.get_configpath());
   load_config_(filename);
 }
 
+Tracer::Tracer(const std::string &config_path)
+  : config_(), tracefs_(), raw_tracer_(tracefs_.get_tracing_dir()), raw_capture_(false), output_dir_(".")
+{
+  load_config_(config_path);
+}
+
+/* Where the capture, the text log and the analytics are written */
+void Tracer::set_output_dir(const std::string &dir)
+{
+  output_dir_ = dir;
+  raw_tracer_.set_out_dir(dir + "/ftrace_raw");
+}
+
 Tracer::~Tracer()
 {
 }
@@ -55,7 +73,8 @@ void Tracer::load_config_(const std::string &filename)
       }
 
       node_info.deadline = node_deadline.as<double>();
-      node_info.pid = get_pid(node_info.name);
+      /* looked up when capturing, or loaded with a previous capture */
+      node_info.pid = 0;
       v_node_info_.push_back(node_info);
     }
   }
@@ -65,6 +84,13 @@ void Tracer::load_config_(const std::string &filename)
   }
 }
 
+/* Ask the running ROS master for the PIDs of the configured nodes */
+void Tracer::lookup_pids()
+{
+  for (int i(0); i < (int)v_node_info_.size(); i++)
+    v_node_info_.at(i).pid = get_pid(v_node_info_.at(i).name);
+}
+
 unsigned int Tracer::get_pid(std::string topic)
 {
   std::string cmd = "rosnode info ";
@@ -94,23 +120,71 @@ unsigned int Tracer::get_pid(std::string topic)
 
 void Tracer::setup(std::string userPass)
 {
+  lookup_pids();
+
+  /* Write the control files directly when tracefs is accessible */
+  if (tracefs_.open())
+  {
+    std::vector<unsigned int> v_pid;
+    for (int i(0); i < (int)v_node_info_.size(); i++)
+      v_pid.push_back(v_node_info_.at(i).pid);
+
+    tracefs_.set_tracing_on(false);
+    tracefs_.clear_trace();
+    tracefs_.set_current_tracer("nop");
+    tracefs_.set_buffer_size_kb(TRACE_BUFFER_SIZE_KB);
+    tracefs_.set_sched_events();
+    tracefs_.set_pid_filter(v_pid);
+    return;
+  }
+
   Tracer::mount(true, userPass);
   Tracer::set_tracing_on(0, userPass);
   Tracer::set_trace(0, userPass);
   Tracer::set_events_enable(1, userPass);
   Tracer::filter_pid(true, userPass);
-  Tracer::set_event((std::string) "sched:sched_switch", userPass);
-  Tracer::set_current_tracer((std::string) "function", userPass);
+  Tracer::set_event((std::string) "sched:sched_switch sched:sched_wakeup", userPass);
+  Tracer::set_current_tracer((std::string) "nop", userPass);
 }
 
 void Tracer::reset(std::string userPass)
 {
+  if (tracefs_.is_open())
+  {
+    tracefs_.set_tracing_on(false);
+
+    if (raw_capture_)
+      raw_tracer_.stop();
+    else
+      Tracer::output_log(userPass);
+
+    tracefs_.clear_events();
+    tracefs_.clear_pid_filter();
+    tracefs_.close();
+
+    if (raw_capture_)
+      Tracer::parse_raw(raw_tracer_.get_out_dir());
+    else
+      Tracer::extract_period(output_dir_ + "/ftrace.log");
+    return;
+  }
+
   Tracer::set_tracing_on(0, userPass);
   Tracer::set_events_enable(0, userPass);
-  Tracer::output_log(userPass);
+
+  /* The binary capture drains the per-CPU buffers itself */
+  if (raw_capture_)
+    raw_tracer_.stop();
+  else
+    Tracer::output_log(userPass);
+
   Tracer::filter_pid(false, userPass);
   Tracer::mount(false, userPass);
-  Tracer::extract_period();
+
+  if (raw_capture_)
+    Tracer::parse_raw(raw_tracer_.get_out_dir());
+  else
+    Tracer::extract_period(output_dir_ + "/ftrace.log");
 }
 
 void Tracer::mount(bool mode, std::string userPass)
@@ -284,6 +358,17 @@ void Tracer::set_event(std::string mode, std::string userPass)
 void Tracer::start_ftrace(std::string userPass)
 {
   int ret = 0;
+
+  /* Prefer binary per-CPU capture, fall back to dumping the text trace */
+  raw_capture_ = raw_tracer_.start();
+  save_node_pids_(raw_capture_ ? raw_tracer_.get_out_dir() : output_dir_);
+
+  if (tracefs_.is_open())
+  {
+    tracefs_.set_tracing_on(true);
+    return;
+  }
+
   std::string start_com = "echo ";
   std::string second_com = "| sudo -S sh -c \"echo \'1\' > /sys/kernel/debug/tracing/tracing_on\"";
   start_com += (userPass + second_com);
@@ -302,8 +387,12 @@ void Tracer::start_ftrace(std::string userPass)
 void Tracer::output_log(std::string userPass)
 {
   int ret = 0;
+
+  if (tracefs_.is_open() && tracefs_.dump_trace(output_dir_ + "/ftrace.log"))
+    return;
+
   std::string first_com = "echo ";
-  std::string second_com = "| sudo -S sh -c \"cat /sys/kernel/debug/tracing/trace > ./ftrace.log\"";
+  std::string second_com = "| sudo -S sh -c \"cat /sys/kernel/debug/tracing/trace > " + output_dir_ + "/ftrace.log\"";
   first_com += userPass + second_com;
   ret = system(first_com.c_str());
 
@@ -384,7 +473,25 @@ void Tracer::filter_pid(bool mode, std::string userPass)
   }
 }
 
-void Tracer::extract_period()
+/* Parse an ftrace text log (the fallback capture) */
+bool Tracer::parse_log(const std::string &filename)
+{
+  std::ifstream log(filename.c_str());
+  if (!log)
+    return false;
+
+  /* the PIDs are saved next to the log when capturing */
+  std::string::size_type slash = filename.find_last_of('/');
+  load_node_pids_(slash == std::string::npos ? std::string(".") : filename.substr(0, slash));
+
+  v_trace_info.clear();
+  v_job_info.clear();
+  v_node_stat.clear();
+  Tracer::extract_period(filename);
+  return true;
+}
+
+void Tracer::extract_period(const std::string &filename)
 {
   std::vector<std::string> find_prev_pids;
   std::vector<std::string> find_next_pids;
@@ -407,10 +514,11 @@ void Tracer::extract_period()
     find_next_pids.push_back(next_pid.str());
   }
 
-  create_process_info(find_prev_pids, find_next_pids);
+  create_process_info(find_prev_pids, find_next_pids, filename);
 }
 
-void Tracer::create_process_info(std::vector<std::string> find_prev_pid, std::vector<std::string> find_next_pid)
+void Tracer::create_process_info(std::vector<std::string> find_prev_pid, std::vector<std::string> find_next_pid,
+                                 const std::string &filename)
 {
   std::string buf;
   std::string delim = " \t\v\r\n";
@@ -422,7 +530,7 @@ void Tracer::create_process_info(std::vector<std::string> find_prev_pid, std::ve
   // Loop by the number of pid
   for (int i(0); i < (int)find_prev_pid.size(); i++)
   {
-    std::ifstream _trace_log("./ftrace.log");
+    std::ifstream _trace_log(filename.c_str());
 
     while (std::getline(_trace_log, buf))
     {
@@ -507,6 +615,115 @@ void Tracer::create_process_info(std::vector<std::string> find_prev_pid, std::ve
 #endif
 }
 
+/* Decode a binary capture (live or recorded) and analyze it */
+bool Tracer::parse_raw(const std::string &dir)
+{
+  RawTracer raw_tracer(tracefs_.get_tracing_dir(), dir);
+  std::vector<std::vector<sched_record_t> > v_records;
+
+  if (!raw_tracer.decode(v_records))
+  {
+    std::cerr << "failed to decode the binary trace in " << dir << std::endl;
+    return false;
+  }
+
+  /* PIDs recorded at capture time */
+  load_node_pids_(dir);
+
+  v_trace_info.clear();
+  create_process_info(v_records);
+
+  /* Jobs, response times and chain latencies from the same records */
+  TraceAnalytics analytics(v_node_info_);
+  analytics.analyze(v_records);
+  v_job_info = analytics.get_job_info();
+  v_node_stat = analytics.get_node_stat();
+  analytics.write_job_csv(output_dir_ + "/trace_jobs.csv");
+  analytics.write_histogram_csv(output_dir_ + "/trace_histogram.csv");
+
+  for (int i(0); i < (int)v_node_stat.size(); i++)
+  {
+    std::cout << v_node_stat[i].name << ": jobs " << v_node_stat[i].nr_jobs << ", deadline misses "
+              << v_node_stat[i].nr_deadline_misses << ", max response " << v_node_stat[i].max_response_time << " s"
+              << std::endl;
+  }
+
+  return true;
+}
+
+void Tracer::save_node_pids_(const std::string &dir)
+{
+  std::ofstream out((dir + "/nodes.csv").c_str());
+
+  for (int i(0); i < (int)v_node_info_.size(); i++)
+    out << v_node_info_.at(i).name << "," << v_node_info_.at(i).pid << "\n";
+}
+
+void Tracer::load_node_pids_(const std::string &dir)
+{
+  std::ifstream in((dir + "/nodes.csv").c_str());
+  std::string buf;
+
+  while (std::getline(in, buf))
+  {
+    std::string::size_type comma = buf.find_last_of(',');
+    if (comma == std::string::npos)
+      continue;
+
+    for (int i(0); i < (int)v_node_info_.size(); i++)
+    {
+      if (v_node_info_.at(i).name == buf.substr(0, comma))
+        v_node_info_.at(i).pid = strtoul(buf.c_str() + comma + 1, NULL, 10);
+    }
+  }
+}
+
+void Tracer::create_process_info(const std::vector<std::vector<sched_record_t> > &v_records)
+{
+  for (int cpu(0); cpu < (int)v_records.size(); cpu++)
+  {
+    const std::vector<sched_record_t> &v_record = v_records[cpu];
+    trace_info_t trace_info;
+    int running_pid = -1;
+
+    for (int i(0); i < (int)v_record.size(); i++)
+    {
+      if (v_record[i].type != SCHED_SWITCH_RECORD)
+        continue;
+
+      /* Finish the slice of a node switched out */
+      if (running_pid > 0 && v_record[i].prev_pid == running_pid)
+      {
+        double finish_time = v_record[i].timestamp / 1000000000.0;
+        trace_info.runtime = (finish_time - trace_info.start_time > 0) ? finish_time - trace_info.start_time : 0;
+        v_trace_info.push_back(trace_info);
+        running_pid = -1;
+      }
+
+      /* Start the slice of a node switched in */
+      for (int j(0); j < (int)v_node_info_.size(); j++)
+      {
+        if ((unsigned int)v_record[i].next_pid == v_node_info_.at(j).pid)
+        {
+          trace_info.name = v_node_info_.at(j).name;
+          trace_info.v_subtopic = v_node_info_.at(j).v_subtopic;
+          trace_info.v_pubtopic = v_node_info_.at(j).v_pubtopic;
+          trace_info.deadline = v_node_info_.at(j).deadline;
+          trace_info.pid = v_record[i].next_pid;
+          trace_info.prio = v_record[i].next_prio;
+          trace_info.core = cpu;
+          trace_info.start_time = v_record[i].timestamp / 1000000000.0;
+          running_pid = v_record[i].next_pid;
+          break;
+        }
+      }
+    }
+  }
+
+  /* sort by start_time */
+  std::sort(v_trace_info.begin(), v_trace_info.end());
+}
+
 // Separate trace.log by spaces
 std::vector<std::string> Tracer::split(std::string str, std::string delim)
 {
@@ -581,6 +798,16 @@ std::vector<trace_info_t> Tracer::get_info()
   return v_trace_info;
 }
 
+std::vector<job_info_t> Tracer::get_job_info()
+{
+  return v_job_info;
+}
+
+std::vector<node_stat_t> Tracer::get_node_stat()
+{
+  return v_node_stat;
+}
+
 std::vector<node_info_t> Tracer::get_node_list()
 {
   return v_node_info_;
@@ -0,0 +1,150 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <termios.h>
+#include <unistd.h>
+#include <iostream>
+#include <string>
+#include "config.h"
+#include "timeline_io.h"
+#include "tracefs.h"
+#include "tracer.h"
+
+/* Headless front end of the Tracer: capture for a while or parse a
+ * previous capture, then write the timeline and a JSON summary that
+ * the GUI and scripts can load. */
+
+static void usage(const char *name)
+{
+  std::cerr << "usage: " << name << " [-d seconds | -r raw_dir | -l ftrace_log] [options]\n"
+            << "  -d seconds   capture the nodes of the configuration for this long\n"
+            << "  -r raw_dir   parse a binary capture (e.g. ./ftrace_raw)\n"
+            << "  -l file      parse an ftrace text log (e.g. ./ftrace.log)\n"
+            << "  -c file      node configuration (default: tracer_rosch.yaml)\n"
+            << "  -o dir       output directory (default: .)\n"
+            << "  -f format    timeline format, bin or csv (default: bin)\n"
+            << "When tracefs is not writable, -d takes the sudo password from TRACER_PASSWORD\n"
+            << "or reads it from the standard input." << std::endl;
+}
+
+/* The sudo password for the legacy capture through "sudo sh -c". It is
+ * never taken from the command line, where ps and the shell history
+ * can see it. */
+static std::string read_password(const std::string &tracing_dir)
+{
+  const char *env = getenv("TRACER_PASSWORD");
+  std::string password;
+
+  if (access((tracing_dir + "/tracing_on").c_str(), W_OK) == 0)
+    return password;
+  if (env)
+    return env;
+
+  struct termios tio;
+  bool tty = isatty(STDIN_FILENO) && tcgetattr(STDIN_FILENO, &tio) == 0;
+  if (tty)
+  {
+    struct termios noecho = tio;
+    noecho.c_lflag &= ~ECHO;
+    tcsetattr(STDIN_FILENO, TCSAFLUSH, &noecho);
+    std::cerr << "sudo password: " << std::flush;
+  }
+  std::getline(std::cin, password);
+  if (tty)
+  {
+    tcsetattr(STDIN_FILENO, TCSAFLUSH, &tio);
+    std::cerr << std::endl;
+  }
+
+  return password;
+}
+
+int main(int argc, char *argv[])
+{
+  std::string config_path, raw_dir, log_file;
+  std::string output_dir(".");
+  std::string format("bin");
+  double duration = 0;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "d:r:l:c:o:f:h")) != -1)
+  {
+    switch (opt)
+    {
+      case 'd':
+        duration = atof(optarg);
+        break;
+      case 'r':
+        raw_dir = optarg;
+        break;
+      case 'l':
+        log_file = optarg;
+        break;
+      case 'c':
+        config_path = optarg;
+        break;
+      case 'o':
+        output_dir = optarg;
+        break;
+      case 'f':
+        format = optarg;
+        break;
+      default:
+        usage(argv[0]);
+        return opt == 'h' ? 0 : 1;
+    }
+  }
+
+  if ((duration > 0) + !raw_dir.empty() + !log_file.empty() != 1 || (format != "bin" && format != "csv"))
+  {
+    usage(argv[0]);
+    return 1;
+  }
+
+  if (config_path.empty())
+  {
+    SchedViz::Config config;
+    config_path = config.get_configpath();
+  }
+
+  mkdir(output_dir.c_str(), 0755);
+  SchedViz::Tracer tracer(config_path);
+  tracer.set_output_dir(output_dir);
+
+  if (duration > 0)
+  {
+    SchedViz::TraceFs tracefs;
+    std::string password = read_password(tracefs.get_tracing_dir());
+
+    tracer.setup(password);
+    tracer.start_ftrace(password);
+    usleep((useconds_t)(duration * 1000000));
+    tracer.reset(password);
+  }
+  else if (!raw_dir.empty() && !tracer.parse_raw(raw_dir))
+  {
+    return 1;
+  }
+  else if (!log_file.empty() && !tracer.parse_log(log_file))
+  {
+    std::cerr << "cannot read " << log_file << std::endl;
+    return 1;
+  }
+
+  std::vector<trace_info_t> v_info = tracer.get_info();
+  std::vector<node_info_t> v_node = tracer.get_node_list();
+  std::string timeline = output_dir + "/timeline." + format;
+  bool ok = (format == "bin") ? SchedViz::write_timeline_binary(timeline, v_info, v_node) :
+                                SchedViz::write_timeline_csv(timeline, v_info);
+
+  if (!ok || !SchedViz::write_summary_json(output_dir + "/summary.json", v_info, v_node, tracer.get_node_stat()))
+  {
+    std::cerr << "cannot write the results to " << output_dir << std::endl;
+    return 1;
+  }
+
+  std::cout << v_info.size() << " slices written to " << timeline << std::endl;
+
+  return 0;
+}